@@ -1,5 +1,6 @@
 #import "IOSAppDelegate.h"      // Header
 #import "RelayrControllers.h"   // HtH
+#import "HtHLifecycleMonitor.h" // HtH
 #import <Relayr/Relayr.h>       // Relayr.framework
 
 @interface IOSAppDelegate ()
@@ -18,4 +19,15 @@
     [RelayrApp persistAppInFileSystem:app];
 }
 
+- (void)applicationDidEnterBackground:(UIApplication*)application
+{
+    [[HtHLifecycleMonitor sharedMonitor] enterBackground];
+}
+
+- (void)applicationWillEnterForeground:(UIApplication*)application
+{
+    RelayrUser* user = ((UIViewController <RelayrControllers>*)self.window.rootViewController).user;
+    [[HtHLifecycleMonitor sharedMonitor] enterForegroundWithUser:user completion:nil];
+}
+
 @end
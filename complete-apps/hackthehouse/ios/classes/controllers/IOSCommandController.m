@@ -1,5 +1,6 @@
 #import "IOSCommandController.h"    // Header
 #import <Relayr/Relayr.h>           // Relayr.framework
+#import "HtHDeviceShadow.h"         // HtH
 
 @interface IOSCommandController ()
 @property (weak,nonatomic) IBOutlet UILabel* meaningLabel;
@@ -11,6 +12,9 @@
 @end
 
 @implementation IOSCommandController
+{
+    HtHDeviceShadow* _shadow;   // Held so the reported state survives between the commands sent from this screen
+}
 
 #pragma mark - Public API
 
@@ -18,6 +22,9 @@
 {
     [super viewDidLoad];
     _meaningLabel.text = [NSString stringWithFormat:@"Send value to %@ command", _command.meaning];
+
+    RelayrDeviceModel* model = _command.deviceModel;
+    if ([model isKindOfClass:[RelayrDevice class]]) { _shadow = [HtHDeviceShadow shadowForDevice:(RelayrDevice*)model]; }
 }
 
 #pragma mark - Private functionality
@@ -49,8 +56,18 @@
     }
     else { valueResult = string; }
     
-    [_command sendValue:valueResult withCompletion:^(NSError* error) {
-        if (!error) { printf("Command was send successfully!"); }
+    if (!_shadow || !_command.meaning)
+    {
+        [_command sendValue:valueResult withCompletion:^(NSError* error) {
+            if (!error) { printf("Command was send successfully!"); }
+            else { printf("The following error happened when trying to send a command:\n\t%s", error.localizedDescription.UTF8String); }
+        }];
+        return YES;
+    }
+    
+    [_shadow setDesiredValue:valueResult forMeaning:_command.meaning completion:^(HtHShadowOutcome outcome, NSTimeInterval latency, NSError* error) {
+        if (outcome == HtHShadowOutcomeSuppressed) { printf("The device already has that value; no command was sent."); }
+        else if (!error) { printf("Command was applied in %.0f ms!", latency * 1000.0); }
         else { printf("The following error happened when trying to send a command:\n\t%s", error.localizedDescription.UTF8String); }
     }];
     
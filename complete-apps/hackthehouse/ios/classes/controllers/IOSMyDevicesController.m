@@ -2,6 +2,9 @@
 #import "RelayrControllers.h"           // HtH
 #import "IOSCapabilitiesController.h"   // HtH
 #import "IOSMainNavController.h"        // HtH
+#import "HtHVisibleSubscriptions.h"     // HtH
+#import "HtHSample.h"                   // HtH
+#import "HtHUnits.h"                    // HtH
 
 #define HtHSegueID_NoDevices        @"Segue_NoDevices"
 #define HtHSegueID_SomeDevices      @"Segue_Devices"
@@ -14,6 +17,7 @@
 @implementation IOSMyDevicesController
 {
     NSArray* _myDevices;      // They are actually RelayrTransmitters and RelayrDevices
+    HtHVisibleSubscriptions* _liveValues;
 }
 
 #pragma mark - Public API
@@ -35,9 +39,35 @@
     // Set tableview and request data
     self.tableView.rowHeight = 80.0f;
     self.tableView.separatorStyle = UITableViewCellSeparatorStyleNone;
+
+    // Only the rows on screen receive live values
+    __weak IOSMyDevicesController* weakSelf = self;
+    _liveValues = [[HtHVisibleSubscriptions alloc] initWithTableView:self.tableView devices:^NSArray*(NSIndexPath* indexPath) {
+        return [weakSelf devicesForIndexPath:indexPath];
+    } update:^(NSIndexPath* indexPath, NSArray* samples) {
+        UITableViewCell* cell = [weakSelf.tableView cellForRowAtIndexPath:indexPath];
+        if (cell) { [weakSelf configureDetailOfCell:cell withSamples:samples atIndexPath:indexPath]; }
+    }];
     [self refreshRequest:nil];
 }
 
+- (void)viewDidAppear:(BOOL)animated
+{
+    [super viewDidAppear:animated];
+    [_liveValues updateVisibility];
+}
+
+- (void)viewDidDisappear:(BOOL)animated
+{
+    [super viewDidDisappear:animated];
+    [_liveValues releaseAll];
+}
+
+- (void)dealloc
+{
+    [_liveValues invalidate];
+}
+
 - (UINavigationController <RelayrControllers>*)navigationController
 {
     return (UINavigationController <RelayrControllers>*)super.navigationController;
@@ -83,27 +113,59 @@
     if ([myDevice isKindOfClass:[RelayrTransmitter class]]) {
         RelayrTransmitter* transmitter = (RelayrTransmitter*)myDevice;
         cell.textLabel.text = transmitter.name;
-        cell.detailTextLabel.text = transmitter.uid;
     } else if ([myDevice isKindOfClass:[RelayrDevice class]]) {
         RelayrDevice* device = (RelayrDevice*)myDevice;
         cell.textLabel.text = device.name;
-        cell.detailTextLabel.text = device.uid;
     }
+    [self configureDetailOfCell:cell withSamples:[_liveValues samplesForIndexPath:indexPath] atIndexPath:indexPath];
     return cell;
 }
 
+#pragma mark Scroll view delegate
+
+- (void)scrollViewDidScroll:(UIScrollView*)scrollView
+{
+    [_liveValues setNeedsUpdateVisibility];
+}
+
 #pragma mark - Private functionality
 
 - (void)refreshRequest:(UIRefreshControl*)sender
 {
     __weak UITableView* weakTableView = self.tableView;
+    __weak HtHVisibleSubscriptions* weakLiveValues = _liveValues;
     return [self.navigationController.user queryCloudForIoTs:^(NSError* error) {
         [sender endRefreshing];
         if (error) { return; } // TODO: Show text to user...
         [weakTableView reloadData];
+        [weakLiveValues updateVisibility];
     }];
 }
 
+- (NSArray*)devicesForIndexPath:(NSIndexPath*)indexPath
+{
+    if (indexPath.row >= _myDevices.count) { return nil; }
+
+    id myDevice = _myDevices[indexPath.row];
+    if ([myDevice isKindOfClass:[RelayrTransmitter class]]) { return ((RelayrTransmitter*)myDevice).devices.allObjects; }
+    return ([myDevice isKindOfClass:[RelayrDevice class]]) ? @[myDevice] : nil;
+}
+
+// The identifier is shown until the first live values arrive.
+- (void)configureDetailOfCell:(UITableViewCell*)cell withSamples:(NSArray*)samples atIndexPath:(NSIndexPath*)indexPath
+{
+    NSMutableArray* values = [[NSMutableArray alloc] init];
+    for (HtHSample* sample in samples)
+    {
+        if (isnan(sample.doubleValue)) { continue; }
+        NSString* symbol = (sample.unit.length) ? [HtHUnits symbolForUnit:sample.unit] : nil;
+        [values addObject:[NSString stringWithFormat:@"%@ %.1f%@", sample.meaning, sample.doubleValue, (symbol) ? symbol : @""]];
+    }
+
+    if (values.count) { cell.detailTextLabel.text = [values componentsJoinedByString:@" · "]; return; }
+    cell.detailTextLabel.text = [_myDevices[indexPath.row] uid];
+}
+
 - (NSArray*)arrayTransmittersAndUniqueDevices
 {
     RelayrUser* user = self.navigationController.user;
@@ -1,4 +1,6 @@
 #import "IOSReadingController.h"    // Header
+#import "HtHReadingHub.h"           // HtH
+#import "HtHUnits.h"                // HtH
 #import <Relayr/Relayr.h>           // Relayr.framework
 
 @interface IOSReadingController ()
@@ -7,6 +9,9 @@
 @end
 
 @implementation IOSReadingController
+{
+    HtHSubscription* _subscription;
+}
 
 #pragma mark - Public API
 
@@ -19,9 +24,9 @@
 - (void)viewWillAppear:(BOOL)animated
 {
     __weak IOSReadingController* weakSelf = self;
-    [_reading subscribeWithBlock:^(RelayrDevice* device, RelayrReading* reading, BOOL* unsubscribe) {
-        weakSelf.meaningLabel.text = [NSString stringWithFormat:@"Value received from %@ reading", _reading.meaning];
-        weakSelf.valueLabel.text = [self transformValue:reading.value withUnit:reading.unit];
+    _subscription = [[HtHReadingHub sharedHub] subscribeToReading:_reading withBlock:^(HtHSample* sample, BOOL* unsubscribe) {
+        weakSelf.meaningLabel.text = [NSString stringWithFormat:@"Value received from %@ reading", sample.meaning];
+        weakSelf.valueLabel.text = [weakSelf transformValue:sample.value withUnit:sample.unit];
     } error:^(NSError* error) {
         weakSelf.meaningLabel.text = [NSString stringWithFormat:@"There was an error subscribing to %@ reading. Please, try again.", _reading.meaning];
         weakSelf.valueLabel.text = @"--";
@@ -30,7 +35,8 @@
 
 - (void)viewWillDisappear:(BOOL)animated
 {
-    [_reading unsubscribeToAll];
+    [[HtHReadingHub sharedHub] unsubscribe:_subscription];
+    _subscription = nil;
 }
 
 #pragma mark - Private functionality
@@ -45,7 +51,8 @@
         if ([unit isEqualToString:@"boolean"]) {
             return (numberValue.boolValue) ? @"ON" : @"OFF";
         } else {
-            return numberValue.stringValue;
+            NSString* symbol = [HtHUnits symbolForUnit:unit];
+            return (symbol.length) ? [NSString stringWithFormat:@"%@ %@", numberValue.stringValue, symbol] : numberValue.stringValue;
         }
     } else if ([value isKindOfClass:[NSString class]]) {
         NSString* arrayValue = value;
@@ -0,0 +1,53 @@
+@import Foundation;     // Apple
+#import "HtHSink.h"     // HtH
+@class HtHReadingLog;   // HtH
+@class HtHSample;       // HtH
+
+/*!
+ *  @abstract Sink that folds samples into fixed time windows and only forwards the aggregates to another sink.
+ *  @discussion Every series (<code>deviceID/path/meaning</code>) has one open window; a window closes when a later sample of its series arrives or when the series' watermark is <code>allowedLateness</code> seconds past its end. The watermark of a series is the timestamp of its newest sample plus the wall-clock time passed since it arrived, so it follows the device's own clock and still advances while the series is quiet; a device whose clock runs ahead never closes the windows of other series. Closed windows become aggregate samples whose value is a dictionary (keys: count, last, window and, for numeric readings, min, max and mean) timestamped at the start of the window, and they are forwarded in batches of up to <code>batchSize</code>, waiting at most <code>maximumDelay</code> for a batch to fill up. Uplink traffic thus scales with the number of windows instead of the sample rate. A timer (every second) closes the windows of quiet series and sends the batches that are due, so aggregates still leave when no new samples arrive.
+ *  Raw samples stay in the reading log (for its retention period) and can be retrieved on demand with <code>rawSamplesForAggregate:</code>. Open windows and unsent aggregates are persisted after every batch, so nothing is lost when the connector's cursor moves on. Samples older than the last one folded into their series (redeliveries or late arrivals) are skipped, which makes retried batches harmless; samples falling in a window of their series that was already closed are counted as late and dropped, so no window is ever forwarded twice.
+ */
+@interface HtHAggregatingSink : NSObject <HtHSink>
+
+/*!
+ *  @abstract Creates an aggregating sink.
+ *
+ *  @param name Name of the state file (in the Application Support directory). Use a different name for every connector.
+ *  @param sink The destination of the aggregates.
+ *  @param window Length of the windows in seconds (e.g.: 60).
+ *  @param log Reading log holding the raw samples. It can be <code>nil</code> if raw retrieval is not needed.
+ */
+- (instancetype)initWithName:(NSString*)name sink:(id <HtHSink>)sink window:(NSTimeInterval)window log:(HtHReadingLog*)log;
+
+@property (readonly,nonatomic) NSString* name;
+@property (readonly,nonatomic) id <HtHSink> sink;
+@property (readonly,nonatomic) NSTimeInterval window;
+
+/*!
+ *  @abstract Seconds a window stays open after its end waiting for samples of its series. Default: 5.
+ */
+@property (atomic) NSTimeInterval allowedLateness;
+
+/*!
+ *  @abstract Maximum aggregates per batch forwarded. Default: 200.
+ */
+@property (atomic) NSUInteger batchSize;
+
+/*!
+ *  @abstract Maximum seconds a closed window waits for its batch to fill up. Default: 60.
+ */
+@property (atomic) NSTimeInterval maximumDelay;
+
+/*!
+ *  @abstract Raw samples of the series and window of an aggregate produced by this sink, read from the log.
+ *	@return Array of <code>HtHSample</code> objects or <code>nil</code> if there is no log.
+ */
+- (NSArray*)rawSamplesForAggregate:(HtHSample*)aggregate;
+
+/*!
+ *  @abstract Counters: samples folded, skipped and late, windows open, aggregates forwarded and pending, batches and failures.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,382 @@
+#import "HtHAggregatingSink.h"  // Header
+#import "HtHSample.h"           // HtH
+#import "HtHReadingLog.h"       // HtH
+#import <Relayr/Relayr.h>       // Relayr.framework
+
+#define HtHAggregatingSink_allowedLateness  5.0
+#define HtHAggregatingSink_batchSize        200
+#define HtHAggregatingSink_maximumDelay     60.0
+#define HtHAggregatingSink_directory        @"Aggregates"
+#define HtHAggregatingSink_rawPageSize      1000
+#define HtHAggregatingSink_tickInterval     1.0
+
+// Samples (and aggregates) are persisted with their JSON representation.
+static HtHSample* HtHAggregatingSinkSampleFromJSON(NSDictionary* json)
+{
+    if (![json isKindOfClass:[NSDictionary class]] || ![json[@"deviceID"] isKindOfClass:[NSString class]] || ![json[@"timestamp"] isKindOfClass:[NSNumber class]]) { return nil; }
+    id const value = ([json[@"value"] isKindOfClass:[NSNull class]]) ? nil : json[@"value"];
+    return [[HtHSample alloc] initWithDeviceID:json[@"deviceID"] meaning:json[@"meaning"] path:json[@"path"] unit:json[@"unit"] value:value date:[NSDate dateWithTimeIntervalSince1970:[json[@"timestamp"] doubleValue]]];
+}
+
+// Running aggregate of a series within one window. It is only touched on the sink's queue.
+@interface HtHAggregateWindow : NSObject
+@property (strong,nonatomic) HtHSample* first;          // Series (device, meaning, path and unit) of the window
+@property (nonatomic) NSTimeInterval start;
+@property (nonatomic) NSUInteger count;
+@property (nonatomic) NSUInteger numericCount;
+@property (nonatomic) double minimum;
+@property (nonatomic) double maximum;
+@property (nonatomic) double sum;
+@property (strong,nonatomic) id last;
+@end
+
+@implementation HtHAggregateWindow
+
+- (void)foldSample:(HtHSample*)sample
+{
+    _count++;
+    _last = sample.value;
+
+    double const value = sample.doubleValue;
+    if (isnan(value)) { return; }
+    _minimum = (_numericCount) ? MIN(_minimum, value) : value;
+    _maximum = (_numericCount) ? MAX(_maximum, value) : value;
+    _sum += value;
+    _numericCount++;
+}
+
+- (HtHSample*)aggregateWithWindow:(NSTimeInterval)window
+{
+    NSMutableDictionary* value = [NSMutableDictionary dictionaryWithDictionary:@{ @"count" : @(_count), @"window" : @(window), @"last" : (_last) ? _last : [NSNull null] }];
+    if (_numericCount)
+    {
+        value[@"min"] = @(_minimum);
+        value[@"max"] = @(_maximum);
+        value[@"mean"] = @(_sum / _numericCount);
+    }
+    return [[HtHSample alloc] initWithDeviceID:_first.deviceID meaning:_first.meaning path:_first.path unit:_first.unit value:value date:[NSDate dateWithTimeIntervalSince1970:_start]];
+}
+
+- (NSDictionary*)JSONRepresentation
+{
+    NSMutableDictionary* result = [NSMutableDictionary dictionaryWithDictionary:_first.dictionaryRepresentation];
+    [result addEntriesFromDictionary:@{ @"start" : @(_start), @"count" : @(_count), @"numericCount" : @(_numericCount), @"min" : @(_minimum), @"max" : @(_maximum), @"sum" : @(_sum) }];
+    result[@"last"] = (_last) ? _last : [NSNull null];
+    return result;
+}
+
++ (instancetype)windowWithJSON:(NSDictionary*)json
+{
+    HtHSample* first = HtHAggregatingSinkSampleFromJSON(json);
+    if (!first || ![json[@"start"] isKindOfClass:[NSNumber class]]) { return nil; }
+
+    HtHAggregateWindow* window = [[HtHAggregateWindow alloc] init];
+    window.first = first;
+    window.start = [json[@"start"] doubleValue];
+    window.count = [json[@"count"] unsignedIntegerValue];
+    window.numericCount = [json[@"numericCount"] unsignedIntegerValue];
+    window.minimum = [json[@"min"] doubleValue];
+    window.maximum = [json[@"max"] doubleValue];
+    window.sum = [json[@"sum"] doubleValue];
+    window.last = ([json[@"last"] isKindOfClass:[NSNull class]]) ? nil : json[@"last"];
+    return window;
+}
+
+@end
+
+@implementation HtHAggregatingSink
+{
+    dispatch_queue_t _queue;
+    dispatch_source_t _timer;
+    HtHReadingLog* _log;
+    NSURL* _fileURL;
+    NSMutableDictionary* _windows;      // series key -> HtHAggregateWindow
+    NSMutableDictionary* _folded;       // series key -> NSNumber (timestamp of the last sample folded)
+    NSMutableDictionary* _arrivals;     // series key -> NSNumber (wall-clock time when the last sample was folded)
+    NSMutableDictionary* _closed;       // series key -> NSNumber (start of the last window closed)
+    NSMutableArray* _pending;           // HtHSample aggregates not forwarded yet
+    CFAbsoluteTime _pendingSince;       // When the oldest pending aggregate was closed (0 if none).
+    BOOL _forwarding;                   // A batch is being written to the sink.
+
+    NSUInteger _foldedCount;
+    NSUInteger _skippedCount;
+    NSUInteger _lateCount;
+    NSUInteger _forwardedCount;
+    NSUInteger _batchesCount;
+    NSUInteger _failuresCount;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithName:(NSString*)name sink:(id <HtHSink>)sink window:(NSTimeInterval)window log:(HtHReadingLog*)log
+{
+    if (!name.length || !sink || window <= 0.0) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _name = name.copy;
+        _sink = sink;
+        _window = window;
+        _log = log;
+        _queue = dispatch_queue_create("io.relayr.hth.aggregate", DISPATCH_QUEUE_SERIAL);
+        _allowedLateness = HtHAggregatingSink_allowedLateness;
+        _batchSize = HtHAggregatingSink_batchSize;
+        _maximumDelay = HtHAggregatingSink_maximumDelay;
+
+        NSURL* support = [[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask].firstObject;
+        NSURL* directory = [support URLByAppendingPathComponent:HtHAggregatingSink_directory isDirectory:YES];
+        [[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        _fileURL = [directory URLByAppendingPathComponent:[_name stringByAppendingPathExtension:@"json"]];
+        [self loadState];
+
+        // The connector only calls the sink when there are new samples; the timer closes the windows of quiet series and sends the batches that are due.
+        __weak HtHAggregatingSink* weakSelf = self;
+        uint64_t const interval = (uint64_t)(HtHAggregatingSink_tickInterval * NSEC_PER_SEC);
+        _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+        dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval, interval / 10);
+        dispatch_source_set_event_handler(_timer, ^{ [weakSelf tick]; });
+        dispatch_resume(_timer);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_timer) { dispatch_source_cancel(_timer); }
+}
+
+- (BOOL)writeSamples:(NSArray*)samples error:(NSError**)error
+{
+    dispatch_sync(_queue, ^{
+        [self foldSamples:samples];
+        [self saveState];
+    });
+
+    // Sinks are called from the connector's private queue, thus it is fine to block it while the aggregates are forwarded.
+    // The connector retries the raw batch later; its samples were already folded, so only the aggregates are sent again.
+    return [self forwardDueBatches:error];
+}
+
+- (void)close
+{
+    if ([_sink respondsToSelector:@selector(close)]) { [_sink close]; }
+}
+
+- (NSArray*)rawSamplesForAggregate:(HtHSample*)aggregate
+{
+    if (!_log || !aggregate) { return nil; }
+
+    NSTimeInterval const start = aggregate.timestamp;
+    NSTimeInterval const window = ([aggregate.value isKindOfClass:[NSDictionary class]] && [aggregate.value[@"window"] isKindOfClass:[NSNumber class]]) ? [aggregate.value[@"window"] doubleValue] : _window;
+    NSTimeInterval const end = start + window;
+    // The log is in arrival order, so reading goes on until samples are clearly past the window.
+    NSTimeInterval const horizon = end + window + self.allowedLateness;
+
+    NSMutableArray* result = [[NSMutableArray alloc] init];
+    uint64_t offset = [_log offsetForDate:[NSDate dateWithTimeIntervalSince1970:start]];
+    while (YES)
+    {
+        NSArray* samples = [_log samplesFromOffset:offset limit:HtHAggregatingSink_rawPageSize nextOffset:&offset];
+        if (!samples.count) { break; }
+
+        BOOL past = NO;
+        for (HtHSample* sample in samples)
+        {
+            if (sample.timestamp >= horizon) { past = YES; break; }
+            if (sample.timestamp >= start && sample.timestamp < end && [sample.seriesKey isEqualToString:aggregate.seriesKey]) { [result addObject:sample]; }
+        }
+        if (past) { break; }
+    }
+    return result;
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        NSString* prefix = [@"aggregate." stringByAppendingString:_name];
+        result = @{
+            [prefix stringByAppendingString:@".folded"]     : @(_foldedCount),
+            [prefix stringByAppendingString:@".skipped"]    : @(_skippedCount),
+            [prefix stringByAppendingString:@".late"]       : @(_lateCount),
+            [prefix stringByAppendingString:@".open"]       : @(_windows.count),
+            [prefix stringByAppendingString:@".forwarded"]  : @(_forwardedCount),
+            [prefix stringByAppendingString:@".pending"]    : @(_pending.count),
+            [prefix stringByAppendingString:@".batches"]    : @(_batchesCount),
+            [prefix stringByAppendingString:@".failures"]   : @(_failuresCount)
+        };
+    });
+    return result;
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the sink's queue.
+- (void)foldSamples:(NSArray*)samples
+{
+    NSTimeInterval const window = _window;
+    NSTimeInterval const now = [NSDate date].timeIntervalSince1970;
+    for (HtHSample* sample in samples)
+    {
+        NSString* key = sample.seriesKey;
+        NSNumber* folded = _folded[key];
+        if (folded && sample.timestamp <= folded.doubleValue) { _skippedCount++; continue; }
+
+        // A window closed by the watermark is not reopened: its aggregate may already be forwarded.
+        NSTimeInterval const start = floor(sample.timestamp / window) * window;
+        NSNumber* closed = _closed[key];
+        if (closed && start <= closed.doubleValue) { _lateCount++; continue; }
+
+        HtHAggregateWindow* current = _windows[key];
+        if (current && current.start != start) { [self closeWindowOfSeries:key]; current = nil; }
+        if (!current)
+        {
+            current = [[HtHAggregateWindow alloc] init];
+            current.first = sample;
+            current.start = start;
+            _windows[key] = current;
+        }
+
+        [current foldSample:sample];
+        _folded[key] = @(sample.timestamp);
+        _arrivals[key] = @(now);
+        _foldedCount++;
+    }
+
+    [self closeWindowsPastWatermark];
+}
+
+// It must be called from the sink's queue. It closes the windows whose end plus the allowed lateness is not later than the watermark of their series and returns how many were closed.
+- (NSUInteger)closeWindowsPastWatermark
+{
+    NSTimeInterval const window = _window;
+    NSTimeInterval const lateness = self.allowedLateness;
+    NSTimeInterval const now = [NSDate date].timeIntervalSince1970;
+    NSUInteger count = 0;
+    for (NSString* key in _windows.allKeys)
+    {
+        // Every series is judged by its own clock: its newest timestamp, advanced by the wall-clock time passed since it arrived.
+        NSTimeInterval const arrival = [_arrivals[key] doubleValue];
+        NSTimeInterval const watermark = [_folded[key] doubleValue] + ((now > arrival) ? now - arrival : 0.0);
+        if (((HtHAggregateWindow*)_windows[key]).start + window + lateness > watermark) { continue; }
+        [self closeWindowOfSeries:key];
+        count++;
+    }
+    return count;
+}
+
+// It must be called from the sink's queue. The watermarks keep advancing with the wall clock, so the last window of a series that went quiet is forwarded without waiting for new samples.
+- (void)tick
+{
+    if ([self closeWindowsPastWatermark]) { [self saveState]; }
+    if (_forwarding || ![self dueBatch]) { return; }
+
+    __weak HtHAggregatingSink* weakSelf = self;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{ [weakSelf forwardDueBatches:nil]; });
+}
+
+// It must not be called from the sink's queue (writing to the destination sink blocks). Only one caller forwards at a time; the others leave the pending aggregates to it.
+- (BOOL)forwardDueBatches:(NSError**)error
+{
+    __block NSArray* batch;
+    dispatch_sync(_queue, ^{
+        if (_forwarding) { return; }
+        batch = [self dueBatch];
+        _forwarding = (batch.count > 0);
+    });
+
+    while (batch.count)
+    {
+        NSError* writeError;
+        BOOL const written = [_sink writeSamples:batch error:&writeError];
+
+        dispatch_sync(_queue, ^{
+            if (!written)
+            {
+                // The failed aggregates wait (at most maximumDelay) for the next attempt.
+                _failuresCount++;
+                _pendingSince = CFAbsoluteTimeGetCurrent();
+                _forwarding = NO;
+                batch = nil;
+                return;
+            }
+            [_pending removeObjectsInRange:NSMakeRange(0, batch.count)];
+            if (!_pending.count) { _pendingSince = 0.0; }
+            _forwardedCount += batch.count;
+            _batchesCount++;
+            [self saveState];
+
+            batch = [self dueBatch];
+            _forwarding = (batch.count > 0);
+        });
+
+        if (!written) { if (error) { *error = (writeError) ? writeError : RelayrErrorUnknwon; } return NO; }
+    }
+    return YES;
+}
+
+// It must be called from the sink's queue.
+- (void)closeWindowOfSeries:(NSString*)key
+{
+    HtHAggregateWindow* window = _windows[key];
+    if (!window) { return; }
+    [_windows removeObjectForKey:key];
+    _closed[key] = @(window.start);
+
+    HtHSample* aggregate = [window aggregateWithWindow:_window];
+    if (!aggregate) { return; }
+    if (!_pending.count) { _pendingSince = CFAbsoluteTimeGetCurrent(); }
+    [_pending addObject:aggregate];
+}
+
+// It must be called from the sink's queue. It returns the next batch if it is full or its oldest aggregate waited long enough.
+- (NSArray*)dueBatch
+{
+    NSUInteger const size = MAX(self.batchSize, (NSUInteger)1);
+    if (!_pending.count) { return nil; }
+    if (_pending.count < size && CFAbsoluteTimeGetCurrent() - _pendingSince < self.maximumDelay) { return nil; }
+    return [_pending subarrayWithRange:NSMakeRange(0, MIN(size, _pending.count))];
+}
+
+- (void)loadState
+{
+    NSData* data = [NSData dataWithContentsOfURL:_fileURL];
+    NSDictionary* state = (data) ? [NSJSONSerialization JSONObjectWithData:data options:kNilOptions error:nil] : nil;
+    if (![state isKindOfClass:[NSDictionary class]]) { state = nil; }
+
+    _windows = [[NSMutableDictionary alloc] init];
+    for (NSDictionary* json in ([state[@"windows"] isKindOfClass:[NSArray class]]) ? state[@"windows"] : nil)
+    {
+        HtHAggregateWindow* window = [HtHAggregateWindow windowWithJSON:json];
+        if (window) { _windows[window.first.seriesKey] = window; }
+    }
+
+    _pending = [[NSMutableArray alloc] init];
+    for (NSDictionary* json in ([state[@"pending"] isKindOfClass:[NSArray class]]) ? state[@"pending"] : nil)
+    {
+        HtHSample* aggregate = HtHAggregatingSinkSampleFromJSON(json);
+        if (aggregate) { [_pending addObject:aggregate]; }
+    }
+    _pendingSince = (_pending.count) ? CFAbsoluteTimeGetCurrent() : 0.0;
+
+    _folded = ([state[@"folded"] isKindOfClass:[NSDictionary class]]) ? [state[@"folded"] mutableCopy] : [[NSMutableDictionary alloc] init];
+    _arrivals = ([state[@"arrivals"] isKindOfClass:[NSDictionary class]]) ? [state[@"arrivals"] mutableCopy] : [[NSMutableDictionary alloc] init];
+    _closed = ([state[@"closed"] isKindOfClass:[NSDictionary class]]) ? [state[@"closed"] mutableCopy] : [[NSMutableDictionary alloc] init];
+}
+
+// It must be called from the sink's queue.
+- (void)saveState
+{
+    NSMutableArray* windows = [[NSMutableArray alloc] initWithCapacity:_windows.count];
+    for (HtHAggregateWindow* window in _windows.allValues) { [windows addObject:window.JSONRepresentation]; }
+
+    NSMutableArray* pending = [[NSMutableArray alloc] initWithCapacity:_pending.count];
+    for (HtHSample* aggregate in _pending) { [pending addObject:aggregate.dictionaryRepresentation]; }
+
+    NSDictionary* state = @{ @"windows" : windows, @"pending" : pending, @"folded" : _folded, @"arrivals" : _arrivals, @"closed" : _closed };
+    NSData* data = [NSJSONSerialization dataWithJSONObject:state options:kNilOptions error:nil];
+    [data writeToURL:_fileURL atomically:YES];
+}
+
+@end
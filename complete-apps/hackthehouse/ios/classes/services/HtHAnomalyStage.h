@@ -0,0 +1,64 @@
+@import Foundation;         // Apple
+#import "HtHReadingStage.h" // HtH
+
+/*!
+ *  @abstract Meaning of the samples emitted by <code>HtHAnomalyStage</code>.
+ *  @discussion Their value is a dictionary with the keys <code>kHtHAnomalyKeyMeaning</code>, <code>kHtHAnomalyKeyKind</code>, <code>kHtHAnomalyKeyValue</code> and <code>kHtHAnomalyKeyScore</code>. The device, path and date are the ones of the offending sample.
+ */
+FOUNDATION_EXPORT NSString* const kHtHAnomalyMeaning;
+
+FOUNDATION_EXPORT NSString* const kHtHAnomalyKeyMeaning;
+FOUNDATION_EXPORT NSString* const kHtHAnomalyKeyKind;
+FOUNDATION_EXPORT NSString* const kHtHAnomalyKeyValue;
+FOUNDATION_EXPORT NSString* const kHtHAnomalyKeyScore;
+
+/*!
+ *  @abstract Anomaly kinds: value too far from the rolling mean, value changing too fast, and value not changing for too long.
+ */
+FOUNDATION_EXPORT NSString* const kHtHAnomalyKindDeviation;
+FOUNDATION_EXPORT NSString* const kHtHAnomalyKindRate;
+FOUNDATION_EXPORT NSString* const kHtHAnomalyKindStuck;
+
+/*!
+ *  @abstract Checks every numeric series for anomalies and emits an extra sample (meaning <code>kHtHAnomalyMeaning</code>) for each anomaly found.
+ *  @discussion Each series keeps a fixed-size state: exponentially weighted mean and mean absolute deviation, last value and timestamp, and the start of the current run of identical values.
+ *  Deviation scores are <code>|x - mean| / (1.2533 * deviation)</code>, a robust z-score that outliers barely move (outliers are clamped before updating the state). The scale never drops below 1% of <code>|mean|</code> plus the meaning's minimum scale, so a series that was constant during the warm-up is not flagged forever; while the deviation is below that floor values are not clamped, letting the baseline follow a level shift.
+ *  Samples of the same series within a batch are scored and rate checked with vectorised (Accelerate) kernels.
+ *  Subscribe to anomalies with <code>-[HtHReadingHub subscribeToDevice:meaning:withBlock:error:]</code> passing <code>kHtHAnomalyMeaning</code>.
+ */
+@interface HtHAnomalyStage : NSObject <HtHReadingStage>
+
+/*!
+ *  @abstract Score above which a sample is considered anomalous. Default: 4.
+ */
+@property (atomic) double deviationThreshold;
+
+/*!
+ *  @abstract Weight of a new sample in the rolling statistics. Default: 0.05.
+ */
+@property (atomic) double smoothing;
+
+/*!
+ *  @abstract Number of samples a series needs before deviations are reported. Default: 30.
+ */
+@property (atomic) NSUInteger warmup;
+
+/*!
+ *  @abstract Maximum absolute change per second allowed per meaning (<code>NSString</code> -> <code>NSNumber</code>).
+ */
+@property (atomic,copy) NSDictionary* rateLimits;
+
+/*!
+ *  @abstract Seconds a value can stay identical per meaning before being reported as stuck (<code>NSString</code> -> <code>NSNumber</code>).
+ */
+@property (atomic,copy) NSDictionary* stuckDurations;
+
+/*!
+ *  @abstract Smallest deviation scale per meaning, in the unit of its values (<code>NSString</code> -> <code>NSNumber</code>). Meanings not listed use 0.001.
+ */
+@property (atomic,copy) NSDictionary* minimumScales;
+
+@property (readonly,nonatomic) NSUInteger checkedCount;
+@property (readonly,nonatomic) NSUInteger anomaliesCount;
+
+@end
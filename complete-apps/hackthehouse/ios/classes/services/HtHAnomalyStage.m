@@ -0,0 +1,218 @@
+#import "HtHAnomalyStage.h" // Header
+#import "HtHSample.h"       // HtH
+@import Accelerate;         // Apple
+
+NSString* const kHtHAnomalyMeaning          = @"anomaly";
+NSString* const kHtHAnomalyKeyMeaning       = @"meaning";
+NSString* const kHtHAnomalyKeyKind          = @"kind";
+NSString* const kHtHAnomalyKeyValue         = @"value";
+NSString* const kHtHAnomalyKeyScore         = @"score";
+NSString* const kHtHAnomalyKindDeviation    = @"deviation";
+NSString* const kHtHAnomalyKindRate         = @"rate";
+NSString* const kHtHAnomalyKindStuck        = @"stuck";
+
+#define HtHAnomalyStage_madToSigma      1.2533
+#define HtHAnomalyStage_minScale        1e-3
+#define HtHAnomalyStage_relativeScale   0.01
+
+typedef struct {
+    double mean;
+    double deviation;
+    double lastValue;
+    double lastTimestamp;
+    double stuckSince;
+    uint64_t count;
+    bool stuckReported;
+} HtHAnomalyState;
+
+@implementation HtHAnomalyStage
+{
+    NSMutableDictionary* _indexes;  // seriesKey -> NSNumber (index in _states)
+    NSMutableData* _states;         // HtHAnomalyState array
+    NSMutableData* _values;
+    NSMutableData* _timestamps;
+    NSMutableData* _scores;
+    NSMutableData* _rates;
+    NSMutableData* _deltaTimes;
+}
+
+#pragma mark - Public API
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _deviationThreshold = 4.0;
+        _smoothing = 0.05;
+        _warmup = 30;
+        _rateLimits = @{};
+        _stuckDurations = @{};
+        _minimumScales = @{};
+        _indexes = [[NSMutableDictionary alloc] init];
+        _states = [[NSMutableData alloc] init];
+        _values = [[NSMutableData alloc] init];
+        _timestamps = [[NSMutableData alloc] init];
+        _scores = [[NSMutableData alloc] init];
+        _rates = [[NSMutableData alloc] init];
+        _deltaTimes = [[NSMutableData alloc] init];
+    }
+    return self;
+}
+
+- (void)stageSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    // Group the numeric samples per series, keeping their order.
+    NSMutableDictionary* groups = [[NSMutableDictionary alloc] init];
+    [samples enumerateObjectsUsingBlock:^(HtHSample* sample, NSUInteger idx, BOOL* stop) {
+        if (isnan(sample.doubleValue) || [sample.meaning isEqualToString:kHtHAnomalyMeaning]) { return; }
+
+        NSMutableIndexSet* indexes = groups[sample.seriesKey];
+        if (!indexes) { indexes = [[NSMutableIndexSet alloc] init]; groups[sample.seriesKey] = indexes; }
+        [indexes addIndex:idx];
+    }];
+    if (!groups.count) { return output(samples); }
+
+    NSMutableArray* anomalies = [[NSMutableArray alloc] init];
+    NSDictionary* rateLimits = self.rateLimits;
+    NSDictionary* stuckDurations = self.stuckDurations;
+    NSDictionary* minimumScales = self.minimumScales;
+
+    [groups enumerateKeysAndObjectsUsingBlock:^(NSString* seriesKey, NSIndexSet* indexes, BOOL* stop) {
+        HtHSample* first = samples[indexes.firstIndex];
+        [self checkSeries:seriesKey samples:[samples objectsAtIndexes:indexes] rateLimit:rateLimits[first.meaning] stuckDuration:stuckDurations[first.meaning] minimumScale:minimumScales[first.meaning] anomalies:anomalies];
+    }];
+
+    _anomaliesCount += anomalies.count;
+    output((anomalies.count) ? [samples arrayByAddingObjectsFromArray:anomalies] : samples);
+}
+
+- (NSDictionary*)metrics
+{
+    return @{
+        @"anomaly.series"       : @(_indexes.count),
+        @"anomaly.checked"      : @(_checkedCount),
+        @"anomaly.anomalies"    : @(_anomaliesCount)
+    };
+}
+
+#pragma mark - Private functionality
+
+- (void)checkSeries:(NSString*)seriesKey samples:(NSArray*)samples rateLimit:(NSNumber*)rateLimit stuckDuration:(NSNumber*)stuckDuration minimumScale:(NSNumber*)minimumScale anomalies:(NSMutableArray*)anomalies
+{
+    vDSP_Length const count = samples.count;
+    HtHAnomalyState* state = [self stateForSeries:seriesKey];
+
+    _values.length = count * sizeof(double);
+    _timestamps.length = count * sizeof(double);
+    _scores.length = count * sizeof(double);
+    _rates.length = count * sizeof(double);
+    _deltaTimes.length = count * sizeof(double);
+    double* values = _values.mutableBytes;
+    double* timestamps = _timestamps.mutableBytes;
+    double* scores = _scores.mutableBytes;
+    double* rates = _rates.mutableBytes;
+    double* deltaTimes = _deltaTimes.mutableBytes;
+
+    for (vDSP_Length i=0; i<count; ++i)
+    {
+        HtHSample* sample = samples[i];
+        values[i] = sample.doubleValue;
+        timestamps[i] = sample.timestamp;
+    }
+    _checkedCount += count;
+
+    // Deviation scores against the statistics at the start of the batch: |x - mean| / scale.
+    BOOL const checkDeviation = state->count >= self.warmup;
+    double const threshold = self.deviationThreshold;
+    // The floor keeps a series that was constant during the warm-up (deviation 0) from scoring every later change as an anomaly.
+    double const floorScale = HtHAnomalyStage_relativeScale * fabs(state->mean) + ((minimumScale) ? minimumScale.doubleValue : HtHAnomalyStage_minScale);
+    double const deviationScale = HtHAnomalyStage_madToSigma * state->deviation;
+    double const scale = MAX(deviationScale, floorScale);
+    if (checkDeviation)
+    {
+        double negativeMean = -state->mean, inverseScale = 1.0 / scale;
+        vDSP_vsaddD(values, 1, &negativeMean, scores, 1, count);
+        vDSP_vabsD(scores, 1, scores, 1, count);
+        vDSP_vsmulD(scores, 1, &inverseScale, scores, 1, count);
+    }
+
+    // Rates: |x[i] - x[i-1]| / (t[i] - t[i-1]), where x[-1] is the last value of the previous batch.
+    BOOL const checkRate = rateLimit && state->count > 0;
+    if (checkRate)
+    {
+        rates[0] = values[0] - state->lastValue;
+        deltaTimes[0] = timestamps[0] - state->lastTimestamp;
+        if (count > 1)
+        {
+            vDSP_vsubD(values, 1, values + 1, 1, rates + 1, 1, count - 1);
+            vDSP_vsubD(timestamps, 1, timestamps + 1, 1, deltaTimes + 1, 1, count - 1);
+        }
+        vDSP_vabsD(rates, 1, rates, 1, count);
+        for (vDSP_Length i=0; i<count; ++i) { rates[i] = (deltaTimes[i] > 0.0) ? rates[i] / deltaTimes[i] : 0.0; }
+    }
+
+    double const limit = rateLimit.doubleValue;
+    double const stuckLimit = stuckDuration.doubleValue;
+    double const alpha = self.smoothing;
+
+    for (vDSP_Length i=0; i<count; ++i)
+    {
+        HtHSample* sample = samples[i];
+        double const value = values[i];
+
+        if (checkDeviation && scores[i] > threshold) { [anomalies addObject:[self anomalyOfKind:kHtHAnomalyKindDeviation sample:sample score:scores[i]]]; }
+        if (checkRate && rates[i] > limit) { [anomalies addObject:[self anomalyOfKind:kHtHAnomalyKindRate sample:sample score:rates[i]]]; }
+
+        if (stuckLimit > 0.0)
+        {
+            if (state->count && value == state->lastValue)
+            {
+                if (!state->stuckReported && timestamps[i] - state->stuckSince >= stuckLimit)
+                {
+                    state->stuckReported = true;
+                    [anomalies addObject:[self anomalyOfKind:kHtHAnomalyKindStuck sample:sample score:timestamps[i] - state->stuckSince]];
+                }
+            }
+            else { state->stuckSince = timestamps[i]; state->stuckReported = false; }
+        }
+
+        // Outliers are clamped before they update the rolling statistics, unless the deviation is still below the floor (the baseline must be able to follow a level shift).
+        double const bound = threshold * scale;
+        double const clamped = (checkDeviation && deviationScale >= floorScale) ? MIN(MAX(value, state->mean - bound), state->mean + bound) : value;
+        if (!state->count) { state->mean = value; state->deviation = 0.0; }
+        else
+        {
+            state->deviation = (1.0 - alpha) * state->deviation + alpha * fabs(clamped - state->mean);
+            state->mean = (1.0 - alpha) * state->mean + alpha * clamped;
+        }
+        state->lastValue = value;
+        state->lastTimestamp = timestamps[i];
+        state->count++;
+    }
+}
+
+- (HtHAnomalyState*)stateForSeries:(NSString*)seriesKey
+{
+    NSNumber* index = _indexes[seriesKey];
+    if (!index)
+    {
+        index = @(_states.length / sizeof(HtHAnomalyState));
+        _indexes[seriesKey] = index;
+        [_states increaseLengthBy:sizeof(HtHAnomalyState)];   // Zero filled.
+    }
+    return ((HtHAnomalyState*)_states.mutableBytes) + index.unsignedIntegerValue;
+}
+
+- (HtHSample*)anomalyOfKind:(NSString*)kind sample:(HtHSample*)sample score:(double)score
+{
+    NSDictionary* value = @{
+        kHtHAnomalyKeyMeaning   : (sample.meaning) ? sample.meaning : @"",
+        kHtHAnomalyKeyKind      : kind,
+        kHtHAnomalyKeyValue     : sample.value,
+        kHtHAnomalyKeyScore     : @(score)
+    };
+    return [[HtHSample alloc] initWithDeviceID:sample.deviceID meaning:kHtHAnomalyMeaning path:sample.path unit:nil value:value date:sample.date];
+}
+
+@end
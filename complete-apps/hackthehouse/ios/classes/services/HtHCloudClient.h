@@ -0,0 +1,99 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+#import "HtHCloudObject.h"  // HtH
+@class HtHHTTPCache;        // HtH
+
+/*!
+ *  @abstract Lightweight client of the relayr REST API acting on behalf of a user.
+ *  @discussion It complements <code>RelayrUser</code> queries with projected variants: only the requested fields are asked for (and decoded), and the entities returned are <code>HtHCloudObject</code> instances that fetch the rest of their fields lazily. The same entity is always represented by the same instance.
+ *  JSON is decoded on a background queue; completion blocks are executed on the main queue unless stated otherwise.
+ */
+@interface HtHCloudClient : NSObject
+
+/*!
+ *  @abstract Client shared by everybody querying on behalf of the user passed.
+ */
++ (instancetype)clientForUser:(RelayrUser*)user;
+
+- (instancetype)initWithUser:(RelayrUser*)user;
+
+@property (readonly,weak,nonatomic) RelayrUser* user;
+
+/*!
+ *  @abstract Host of the relayr API. Default: <code>https://api.relayr.io</code>.
+ */
+@property (copy,atomic) NSURL* host;
+
+/*!
+ *  @abstract Fetches the devices of the user with only the fields passed (plus the identifier).
+ *
+ *  @param fields Set of field names (e.g.: <code>kHtHFieldName</code>). <code>nil</code> fetches complete entities.
+ *  @param completion Block with an array of <code>HtHDeviceSummary</code> objects.
+ */
+- (void)queryDevicesWithFields:(NSSet*)fields completion:(void (^)(NSError* error, NSArray* devices))completion;
+
+/*!
+ *  @abstract Fetches the transmitters of the user with only the fields passed (plus the identifier).
+ *
+ *  @param completion Block with an array of <code>HtHTransmitterSummary</code> objects.
+ */
+- (void)queryTransmittersWithFields:(NSSet*)fields completion:(void (^)(NSError* error, NSArray* transmitters))completion;
+
+/*!
+ *  @abstract Maximum number of requests in flight during paged queries. Default: 6.
+ */
+@property (atomic) NSUInteger maximumConcurrentRequests;
+
+/*!
+ *  @abstract Maximum number of entities requested per page (<code>limit</code>/<code>offset</code> query parameters). Default: 100.
+ *  @discussion Collection queries (<code>queryDevicesWithFields:completion:</code>, <code>queryTransmittersWithFields:completion:</code> and the device graph) request pages until one comes back with fewer entities. Paging also stops when a page repeats entities listed by an earlier page or adds none (the server ignored the paging parameters), or after 1000 pages of a collection; repeated entities are dropped.
+ */
+@property (atomic) NSUInteger pageSize;
+
+/*!
+ *  @abstract Fetches the whole device graph of the user in pages of at most <code>pageSize</code> entities: pages of the transmitter list, and pages of the devices of every transmitter listed, with up to <code>maximumConcurrentRequests</code> pages in flight.
+ *  @discussion Every page is decoded on a background queue as soon as it arrives and merged into the transmitter it belongs to, so the refresh time is bound by bandwidth instead of the latency of each request. A failed page doesn't stop the rest; its error is reported in the completion.
+ *
+ *  @param transmitterFields Fields fetched for transmitters (see <code>queryTransmittersWithFields:completion:</code>).
+ *  @param deviceFields Fields fetched for devices (see <code>queryDevicesWithFields:completion:</code>).
+ *  @param progress Block executed after every page with the number of pages completed and the total known so far (it grows as pages reveal more). It can be <code>nil</code>.
+ *  @param completion Block with an array of <code>HtHTransmitterSummary</code> objects (with their <code>devices</code>) and the first error found (if any).
+ */
+- (void)queryIoTsWithTransmitterFields:(NSSet*)transmitterFields deviceFields:(NSSet*)deviceFields progress:(void (^)(NSUInteger completed, NSUInteger total))progress completion:(void (^)(NSError* error, NSArray* transmitters))completion;
+
+/*!
+ *  @abstract Fetches the catalogue of device models (readings, commands and firmware versions of every model).
+ *  @discussion The catalogue rarely changes, so it is normally revalidated against <code>cache</code> (a <code>304</code> costs no payload), or answered from it while the server's <code>max-age</code> lasts.
+ *
+ *  @param completion Block with an array of JSON dictionaries.
+ */
+- (void)queryDeviceModelsWithCompletion:(void (^)(NSError* error, NSArray* deviceModels))completion;
+
+/*!
+ *  @abstract Fetches the description of a single device model.
+ */
+- (void)queryDeviceModelWithID:(NSString*)modelID completion:(void (^)(NSError* error, NSDictionary* deviceModel))completion;
+
+/*!
+ *  @abstract Fetches the samples a device sent during a time interval (oldest first). History responses are never cached.
+ *
+ *  @param completion Block with an array of <code>HtHSample</code> objects.
+ */
+- (void)queryHistoryOfDeviceID:(NSString*)deviceID from:(NSDate*)start to:(NSDate*)end completion:(void (^)(NSError* error, NSArray* samples))completion;
+
+/*!
+ *  @abstract Response cache used by every <code>GET</code> request. Default: <code>[HtHHTTPCache sharedCache]</code>.
+ *  @discussion Fresh responses are answered without touching the network, stale ones are revalidated with conditional requests (a <code>304</code> costs no payload). Stale responses whose server sent <code>stale-while-revalidate</code> are answered right away within that window; the revalidation then only refreshes the cache, so the caller gets the stale data and the next request the revalidated one. Set it to <code>nil</code> to always hit the server.
+ */
+@property (strong,atomic) HtHHTTPCache* cache;
+
+/*!
+ *  @abstract Performs an authenticated <code>GET</code> request and decodes its JSON response.
+ *
+ *  @param path Path relative to <code>host</code> (e.g.: <code>/devices/1234</code>).
+ *  @param query Query parameters (<code>NSString</code> -> <code>NSString</code>). It can be <code>nil</code>.
+ *  @param completion Block executed on a background queue with the decoded JSON object. It is executed once, and it may be answered from <code>cache</code> (possibly with a stale response, see <code>cache</code>).
+ */
+- (void)GETPath:(NSString*)path query:(NSDictionary*)query completion:(void (^)(NSError* error, id json))completion;
+
+@end
@@ -0,0 +1,461 @@
+#import "HtHCloudClient.h"  // Header
+#import "HtHHTTPCache.h"    // HtH
+#import "HtHSample.h"       // HtH
+
+#define HtHCloudClient_host                     @"https://api.relayr.io"
+#define HtHCloudClient_pathDevices              @"/users/%@/devices"
+#define HtHCloudClient_pathTransmitters         @"/users/%@/transmitters"
+#define HtHCloudClient_pathDevice               @"/devices/%@"
+#define HtHCloudClient_pathTransmitter          @"/transmitters/%@"
+#define HtHCloudClient_pathTransmitterDevices   @"/transmitters/%@/devices"
+#define HtHCloudClient_pathDeviceModels         @"/device-models"
+#define HtHCloudClient_pathDeviceModel          @"/device-models/%@"
+#define HtHCloudClient_pathDeviceHistory        @"/devices/%@/readings"
+#define HtHCloudClient_historyLimit             10000
+#define HtHCloudClient_concurrentRequests       6
+#define HtHCloudClient_pageSize                 100
+#define HtHCloudClient_maximumPages             1000
+#define HtHCloudClient_connectionsPerHost       16
+#define HtHCloudClient_fieldsParameter          @"fields"
+#define HtHCloudClient_limitParameter           @"limit"
+#define HtHCloudClient_offsetParameter          @"offset"
+
+// Page of a paged query: a slice of the transmitter list (transmitter nil) or of the devices of a transmitter.
+@interface HtHPageRequest : NSObject
+@property (strong,nonatomic) HtHTransmitterSummary* transmitter;
+@property (nonatomic) NSUInteger offset;
+@property (strong,nonatomic) NSMutableSet* seenIDs; // Identifiers listed by the earlier pages of the collection.
+@end
+
+@implementation HtHPageRequest
+@end
+
+// State of a paged query. It is only touched on the main queue.
+@interface HtHPagedFetch : NSObject
+@property (strong,nonatomic) NSString* userID;
+@property (strong,nonatomic) NSSet* transmitterFields;
+@property (strong,nonatomic) NSSet* deviceFields;
+@property (nonatomic) NSUInteger pageSize;
+@property (strong,nonatomic) NSMutableArray* transmitters;
+@property (strong,nonatomic) NSMapTable* devices;   // HtHTransmitterSummary -> NSMutableArray of HtHDeviceSummary
+@property (strong,nonatomic) NSMutableArray* queued;    // HtHPageRequest
+@property (nonatomic) NSUInteger inflight;
+@property (nonatomic) NSUInteger completed;
+@property (strong,nonatomic) NSError* error;
+@property (copy,nonatomic) void (^progress)(NSUInteger completed, NSUInteger total);
+@property (copy,nonatomic) void (^completion)(NSError* error, NSArray* transmitters);
+@end
+
+@implementation HtHPagedFetch
+@end
+
+@implementation HtHCloudClient
+{
+    NSURLSession* _session;
+    dispatch_queue_t _decodingQueue;
+    NSMapTable* _objects;   // path -> HtHCloudObject (weak, so entities nobody uses go away)
+}
+
+#pragma mark - Public API
+
++ (instancetype)clientForUser:(RelayrUser*)user
+{
+    if (!user) { return nil; }
+
+    static NSMapTable* clients;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ clients = [NSMapTable weakToStrongObjectsMapTable]; });
+
+    @synchronized(clients)
+    {
+        HtHCloudClient* client = [clients objectForKey:user];
+        if (!client) { client = [[HtHCloudClient alloc] initWithUser:user]; [clients setObject:client forKey:user]; }
+        return client;
+    }
+}
+
+- (instancetype)initWithUser:(RelayrUser*)user
+{
+    if (!user) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _user = user;
+        _host = [NSURL URLWithString:HtHCloudClient_host];
+        _decodingQueue = dispatch_queue_create("io.relayr.hth.cloud", DISPATCH_QUEUE_CONCURRENT);
+        _objects = [NSMapTable strongToWeakObjectsMapTable];
+        _maximumConcurrentRequests = HtHCloudClient_concurrentRequests;
+        _pageSize = HtHCloudClient_pageSize;
+        _cache = [HtHHTTPCache sharedCache];
+
+        NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+        configuration.URLCache = nil;   // Revalidation is handled by HtHHTTPCache, so 304 responses must reach the client.
+        configuration.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+        configuration.HTTPAdditionalHeaders = @{ @"User-Agent" : [RelayrCloud userAgentString], @"Accept" : @"application/json" };
+        configuration.HTTPMaximumConnectionsPerHost = HtHCloudClient_connectionsPerHost;  // The real limit is maximumConcurrentRequests.
+        _session = [NSURLSession sessionWithConfiguration:configuration];
+    }
+    return self;
+}
+
+- (void)queryDevicesWithFields:(NSSet*)fields completion:(void (^)(NSError* error, NSArray* devices))completion
+{
+    [self queryCollection:HtHCloudClient_pathDevices entityPath:HtHCloudClient_pathDevice entityClass:[HtHDeviceSummary class] fields:fields completion:completion];
+}
+
+- (void)queryTransmittersWithFields:(NSSet*)fields completion:(void (^)(NSError* error, NSArray* transmitters))completion
+{
+    [self queryCollection:HtHCloudClient_pathTransmitters entityPath:HtHCloudClient_pathTransmitter entityClass:[HtHTransmitterSummary class] fields:fields completion:completion];
+}
+
+- (void)queryIoTsWithTransmitterFields:(NSSet*)transmitterFields deviceFields:(NSSet*)deviceFields progress:(void (^)(NSUInteger completed, NSUInteger total))progress completion:(void (^)(NSError* error, NSArray* transmitters))completion
+{
+    NSString* userID = self.user.uid;
+    if (!userID) { if (completion) { completion(RelayrErrorMissingArgument, nil); } return; }
+
+    HtHPagedFetch* fetch = [[HtHPagedFetch alloc] init];
+    fetch.userID = userID;
+    fetch.transmitterFields = transmitterFields;
+    fetch.deviceFields = deviceFields;
+    fetch.pageSize = MAX(self.pageSize, (NSUInteger)1);
+    fetch.transmitters = [[NSMutableArray alloc] init];
+    fetch.devices = [NSMapTable strongToStrongObjectsMapTable];
+    fetch.queued = [NSMutableArray arrayWithObject:[[HtHPageRequest alloc] init]];
+    fetch.progress = progress;
+    fetch.completion = completion;
+
+    if (progress) { progress(0, 1); }
+    [self pumpFetch:fetch];
+}
+
+- (void)queryDeviceModelsWithCompletion:(void (^)(NSError* error, NSArray* deviceModels))completion
+{
+    [self GETPath:HtHCloudClient_pathDeviceModels query:nil completion:^(NSError* error, id json) {
+        if (!completion) { return; }
+        if (!error && ![json isKindOfClass:[NSArray class]]) { error = RelayrErrorWebRequestFailure; }
+        dispatch_async(dispatch_get_main_queue(), ^{ completion(error, (error) ? nil : json); });
+    }];
+}
+
+- (void)queryDeviceModelWithID:(NSString*)modelID completion:(void (^)(NSError* error, NSDictionary* deviceModel))completion
+{
+    if (!modelID.length) { if (completion) { completion(RelayrErrorMissingArgument, nil); } return; }
+
+    [self GETPath:[NSString stringWithFormat:HtHCloudClient_pathDeviceModel, modelID] query:nil completion:^(NSError* error, id json) {
+        if (!completion) { return; }
+        if (!error && ![json isKindOfClass:[NSDictionary class]]) { error = RelayrErrorWebRequestFailure; }
+        dispatch_async(dispatch_get_main_queue(), ^{ completion(error, (error) ? nil : json); });
+    }];
+}
+
+- (void)queryHistoryOfDeviceID:(NSString*)deviceID from:(NSDate*)start to:(NSDate*)end completion:(void (^)(NSError* error, NSArray* samples))completion
+{
+    if (!deviceID.length || !start || !end) { if (completion) { completion(RelayrErrorMissingArgument, nil); } return; }
+
+    NSDictionary* query = @{
+        @"start" : [NSString stringWithFormat:@"%lld", (long long)(start.timeIntervalSince1970 * 1000.0)],
+        @"end"   : [NSString stringWithFormat:@"%lld", (long long)(end.timeIntervalSince1970 * 1000.0)],
+        @"limit" : [NSString stringWithFormat:@"%d", HtHCloudClient_historyLimit]
+    };
+
+    // Every gap is a different query, so history is never worth caching.
+    [self GETPath:[NSString stringWithFormat:HtHCloudClient_pathDeviceHistory, deviceID] query:query cache:nil completion:^(NSError* error, id json) {
+        NSArray* samples = (error) ? nil : [HtHCloudClient samplesFromHistoryJSON:json deviceID:deviceID];
+        if (!error && !samples) { error = RelayrErrorWebRequestFailure; }
+        if (completion) { dispatch_async(dispatch_get_main_queue(), ^{ completion(error, samples); }); }
+    }];
+}
+
+- (void)GETPath:(NSString*)path query:(NSDictionary*)query completion:(void (^)(NSError* error, id json))completion
+{
+    [self GETPath:path query:query cache:self.cache completion:completion];
+}
+
+#pragma mark - Private functionality
+
+- (void)GETPath:(NSString*)path query:(NSDictionary*)query cache:(HtHHTTPCache*)cache completion:(void (^)(NSError* error, id json))completion
+{
+    NSMutableURLRequest* request = [self requestForPath:path query:query];
+    if (!request) { if (completion) { dispatch_async(_decodingQueue, ^{ completion(RelayrErrorMissingArgument, nil); }); } return; }
+
+    if (!cache) { return [self sendRequest:request cached:nil cache:nil key:nil completion:completion]; }
+
+    // The cache reads its files on its own queue, so the caller (usually the main queue) never waits on the disk.
+    NSString* key = [HtHHTTPCache keyForRequest:request];
+    [cache responseForKey:key completion:^(HtHCachedResponse* cached) {
+        [self sendRequest:request cached:cached cache:cache key:key completion:completion];
+    }];
+}
+
+// It can be called from any queue. Fresh cached responses are answered without touching the network, the rest are (re)validated with the server.
+- (void)sendRequest:(NSMutableURLRequest*)request cached:(HtHCachedResponse*)cached cache:(HtHHTTPCache*)cache key:(NSString*)key completion:(void (^)(NSError* error, id json))completion
+{
+    if (cached.isFresh) { return [self decodeData:cached.data error:nil completion:completion]; }
+
+    // Stale responses the server allows to serve while revalidating are answered right away. The completion is executed only once, so the revalidated response only refreshes the cache for the next request.
+    if (cached.isUsableWhileRevalidating) { [self decodeData:cached.data error:nil completion:completion]; completion = nil; }
+    [cached addConditionalHeadersToRequest:request];
+
+    [[_session dataTaskWithRequest:request completionHandler:^(NSData* data, NSURLResponse* response, NSError* error) {
+        NSHTTPURLResponse* httpResponse = (NSHTTPURLResponse*)response;
+        NSInteger const status = httpResponse.statusCode;
+
+        if (!error && status == 304 && cached)
+        {
+            [cache refreshResponse:httpResponse forKey:key];
+            data = cached.data;
+        }
+        else if (error || status < 200 || status >= 300)
+        {
+            error = (error) ? error : RelayrErrorWebRequestFailure;
+        }
+        else
+        {
+            [cache storeData:data response:httpResponse forKey:key];
+        }
+
+        [self decodeData:data error:error completion:completion];
+    }] resume];
+}
+
+- (NSMutableURLRequest*)requestForPath:(NSString*)path query:(NSDictionary*)query
+{
+    NSString* token = self.user.token;
+    if (!path.length || !token.length) { return nil; }
+
+    NSURLComponents* components = [NSURLComponents componentsWithURL:[self.host URLByAppendingPathComponent:path] resolvingAgainstBaseURL:NO];
+    if (query.count)
+    {
+        NSMutableArray* items = [[NSMutableArray alloc] initWithCapacity:query.count];
+        [query enumerateKeysAndObjectsUsingBlock:^(NSString* name, NSString* value, BOOL* stop) { [items addObject:[NSURLQueryItem queryItemWithName:name value:value]]; }];
+        components.queryItems = items;
+    }
+
+    NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:components.URL];
+    [request setValue:[NSString stringWithFormat:@"Bearer %@", token] forHTTPHeaderField:@"Authorization"];
+    return request;
+}
+
+- (void)queryCollection:(NSString*)collectionFormat entityPath:(NSString*)entityFormat entityClass:(Class)entityClass fields:(NSSet*)fields completion:(void (^)(NSError* error, NSArray* entities))completion
+{
+    NSString* userID = self.user.uid;
+    if (!userID) { if (completion) { completion(RelayrErrorMissingArgument, nil); } return; }
+
+    NSString* path = [NSString stringWithFormat:collectionFormat, userID];
+    [self GETEntriesOfPath:path fields:fields offset:0 pageSize:MAX(self.pageSize, (NSUInteger)1) entries:[[NSMutableArray alloc] init] seenIDs:[[NSMutableSet alloc] init] completion:^(NSError* error, NSArray* entries) {
+        if (error)
+        {
+            if (completion) { dispatch_async(dispatch_get_main_queue(), ^{ completion(error, nil); }); }
+            return;
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NSArray* entities = [self entitiesFromEntries:entries entityPath:entityFormat entityClass:entityClass fields:fields];
+            if (completion) { completion(nil, entities); }
+        });
+    }];
+}
+
+// It runs on a background queue. Pages are requested one after the other and their projected entries accumulated.
+- (void)GETEntriesOfPath:(NSString*)path fields:(NSSet*)fields offset:(NSUInteger)offset pageSize:(NSUInteger)pageSize entries:(NSMutableArray*)entries seenIDs:(NSMutableSet*)seenIDs completion:(void (^)(NSError* error, NSArray* entries))completion
+{
+    [self GETPath:path query:[HtHCloudClient queryForFields:fields offset:offset limit:pageSize] completion:^(NSError* error, id json) {
+        if (error || ![json isKindOfClass:[NSArray class]]) { return completion((error) ? error : RelayrErrorWebRequestFailure, nil); }
+
+        NSArray* pageEntries = [self entriesFromJSON:json fields:fields];
+        NSArray* newEntries = [HtHCloudClient entries:pageEntries unseenIn:seenIDs];
+        [entries addObjectsFromArray:newEntries];
+        if (![HtHCloudClient mayHaveMorePages:json pageSize:pageSize offset:offset entries:pageEntries newEntries:newEntries]) { return completion(nil, entries); }
+        [self GETEntriesOfPath:path fields:fields offset:offset + pageSize pageSize:pageSize entries:entries seenIDs:seenIDs completion:completion];
+    }];
+}
+
+// It must be called on the main queue. It starts queued pages while there is room for them, and completes the query once nothing is left.
+- (void)pumpFetch:(HtHPagedFetch*)fetch
+{
+    NSUInteger const concurrency = MAX(self.maximumConcurrentRequests, (NSUInteger)1);
+    while (fetch.inflight < concurrency && fetch.queued.count)
+    {
+        HtHPageRequest* page = fetch.queued.firstObject;
+        [fetch.queued removeObjectAtIndex:0];
+        fetch.inflight++;
+        [self fetchPage:page of:fetch];
+    }
+
+    if (fetch.inflight || fetch.queued.count || !fetch.completion) { return; }
+    void (^completion)(NSError*, NSArray*) = fetch.completion;
+    fetch.completion = nil;
+    completion(fetch.error, fetch.transmitters.copy);
+}
+
+// It must be called on the main queue. Every finished page queues the following one of the same collection (if any) and the device pages of the transmitters it listed.
+- (void)fetchPage:(HtHPageRequest*)page of:(HtHPagedFetch*)fetch
+{
+    HtHTransmitterSummary* transmitter = page.transmitter;
+    NSSet* fields = (transmitter) ? fetch.deviceFields : fetch.transmitterFields;
+    NSString* path = (transmitter) ? [NSString stringWithFormat:HtHCloudClient_pathTransmitterDevices, transmitter.uid] : [NSString stringWithFormat:HtHCloudClient_pathTransmitters, fetch.userID];
+    NSUInteger const pageSize = fetch.pageSize;
+
+    [self GETPath:path query:[HtHCloudClient queryForFields:fields offset:page.offset limit:pageSize] completion:^(NSError* error, id json) {
+        NSArray* pageEntries = ([json isKindOfClass:[NSArray class]]) ? [self entriesFromJSON:json fields:fields] : nil;
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            fetch.inflight--;
+            fetch.completed++;
+
+            // The pages of a collection are requested one after the other, so its identifiers are only touched by one page at a time.
+            NSMutableSet* seenIDs = (page.seenIDs) ? page.seenIDs : [[NSMutableSet alloc] init];
+            NSArray* entries = (pageEntries) ? [HtHCloudClient entries:pageEntries unseenIn:seenIDs] : nil;
+            BOOL const hasMore = entries && [HtHCloudClient mayHaveMorePages:json pageSize:pageSize offset:page.offset entries:pageEntries newEntries:entries];
+
+            HtHPageRequest* next = (hasMore) ? [[HtHPageRequest alloc] init] : nil;
+            next.transmitter = transmitter;
+            next.offset = page.offset + pageSize;
+            next.seenIDs = seenIDs;
+
+            if (!entries)
+            {
+                if (!fetch.error) { fetch.error = (error) ? error : RelayrErrorWebRequestFailure; }
+            }
+            else if (!transmitter)
+            {
+                NSArray* transmitters = [self entitiesFromEntries:entries entityPath:HtHCloudClient_pathTransmitter entityClass:[HtHTransmitterSummary class] fields:fields];
+                [fetch.transmitters addObjectsFromArray:transmitters];
+                for (HtHTransmitterSummary* listed in transmitters)
+                {
+                    HtHPageRequest* devicesPage = [[HtHPageRequest alloc] init];
+                    devicesPage.transmitter = listed;
+                    [fetch.queued addObject:devicesPage];
+                }
+                // The rest of the transmitter list goes first, so the device pages are known as soon as possible.
+                if (next) { [fetch.queued insertObject:next atIndex:0]; }
+            }
+            else
+            {
+                NSMutableArray* devices = [fetch.devices objectForKey:transmitter];
+                if (!devices) { devices = [[NSMutableArray alloc] init]; [fetch.devices setObject:devices forKey:transmitter]; }
+                [devices addObjectsFromArray:[self entitiesFromEntries:entries entityPath:HtHCloudClient_pathDevice entityClass:[HtHDeviceSummary class] fields:fields]];
+                [transmitter mergeDevices:devices];
+                if (next) { [fetch.queued addObject:next]; }
+            }
+
+            if (fetch.progress) { fetch.progress(fetch.completed, fetch.completed + fetch.inflight + fetch.queued.count); }
+            [self pumpFetch:fetch];
+        });
+    }];
+}
+
+// The projection is sent to the server (which may shrink the payload) and applied while decoding anyway.
++ (NSDictionary*)queryForFields:(NSSet*)fields offset:(NSUInteger)offset limit:(NSUInteger)limit
+{
+    NSMutableDictionary* query = [NSMutableDictionary dictionaryWithDictionary:@{
+        HtHCloudClient_limitParameter   : [NSString stringWithFormat:@"%lu", (unsigned long)limit],
+        HtHCloudClient_offsetParameter  : [NSString stringWithFormat:@"%lu", (unsigned long)offset]
+    }];
+    if (fields) { query[HtHCloudClient_fieldsParameter] = [[@[@"id"] arrayByAddingObjectsFromArray:fields.allObjects] componentsJoinedByString:@","]; }
+    return query;
+}
+
+// Entries whose identifier wasn't listed before (the identifiers are added to the set).
++ (NSArray*)entries:(NSArray*)entries unseenIn:(NSMutableSet*)seenIDs
+{
+    NSMutableArray* result = [[NSMutableArray alloc] initWithCapacity:entries.count];
+    for (NSDictionary* entry in entries)
+    {
+        if ([seenIDs containsObject:entry[@"id"]]) { continue; }
+        [seenIDs addObject:entry[@"id"]];
+        [result addObject:entry];
+    }
+    return result;
+}
+
+// A full page may be followed by more. A shorter one is the last, and so is a longer one (the server sent the whole collection).
+// A server that ignores the paging parameters can also answer full pages forever: a page repeating entries of earlier pages, or adding none, is the last, and the number of pages is capped anyway.
++ (BOOL)mayHaveMorePages:(NSArray*)json pageSize:(NSUInteger)pageSize offset:(NSUInteger)offset entries:(NSArray*)entries newEntries:(NSArray*)newEntries
+{
+    if (json.count != pageSize || !newEntries.count || newEntries.count != entries.count) { return NO; }
+    return offset / pageSize + 1 < HtHCloudClient_maximumPages;
+}
+
+- (void)decodeData:(NSData*)data error:(NSError*)error completion:(void (^)(NSError* error, id json))completion
+{
+    if (!completion) { return; }
+
+    dispatch_async(_decodingQueue, ^{
+        if (error) { return completion(error, nil); }
+
+        NSError* decodingError;
+        id json = (data.length) ? [NSJSONSerialization JSONObjectWithData:data options:kNilOptions error:&decodingError] : nil;
+        completion(decodingError, json);
+    });
+}
+
+// It runs on a background queue. History comes either as a flat list of points or grouped by series (meaning/path with its points), wrapped in a "data" member.
++ (NSArray*)samplesFromHistoryJSON:(id)json deviceID:(NSString*)deviceID
+{
+    if ([json isKindOfClass:[NSDictionary class]]) { json = json[@"data"]; }
+    if (![json isKindOfClass:[NSArray class]]) { return nil; }
+
+    NSMutableArray* samples = [[NSMutableArray alloc] init];
+    for (NSDictionary* entry in json)
+    {
+        if (![entry isKindOfClass:[NSDictionary class]]) { continue; }
+
+        NSArray* points = ([entry[@"points"] isKindOfClass:[NSArray class]]) ? entry[@"points"] : @[entry];
+        for (NSDictionary* point in points)
+        {
+            if (![point isKindOfClass:[NSDictionary class]]) { continue; }
+
+            NSString* meaning = (point[@"meaning"]) ? point[@"meaning"] : entry[@"meaning"];
+            NSString* path = (point[@"path"]) ? point[@"path"] : entry[@"path"];
+            NSNumber* timestamp = (point[@"timestamp"]) ? point[@"timestamp"] : point[@"ts"];
+            id value = point[@"value"];
+            if (![meaning isKindOfClass:[NSString class]] || ![timestamp isKindOfClass:[NSNumber class]] || !value || value == [NSNull null]) { continue; }
+
+            NSDate* date = [NSDate dateWithTimeIntervalSince1970:timestamp.doubleValue / 1000.0];
+            HtHSample* sample = [[HtHSample alloc] initWithDeviceID:deviceID meaning:meaning path:([path isKindOfClass:[NSString class]]) ? path : nil unit:nil value:value date:date];
+            if (sample) { [samples addObject:sample]; }
+        }
+    }
+    return samples;
+}
+
+// It runs on a background queue. Only the projected keys are kept, so large accounts don't retain the whole payload.
+- (NSArray*)entriesFromJSON:(NSArray*)json fields:(NSSet*)fields
+{
+    NSArray* keys = (fields) ? [@[@"id"] arrayByAddingObjectsFromArray:fields.allObjects] : nil;
+    NSMutableArray* entries = [[NSMutableArray alloc] initWithCapacity:json.count];
+    for (NSDictionary* entry in json)
+    {
+        if (![entry isKindOfClass:[NSDictionary class]] || ![entry[@"id"] isKindOfClass:[NSString class]]) { continue; }
+        [entries addObject:(keys) ? [entry dictionaryWithValuesForKeys:keys] : entry];
+    }
+    return entries;
+}
+
+// It must be called on the main queue.
+- (NSArray*)entitiesFromEntries:(NSArray*)entries entityPath:(NSString*)entityFormat entityClass:(Class)entityClass fields:(NSSet*)fields
+{
+    NSMutableArray* entities = [[NSMutableArray alloc] initWithCapacity:entries.count];
+    for (NSDictionary* entry in entries)
+    {
+        HtHCloudObject* entity = [self entityWithPath:[NSString stringWithFormat:entityFormat, entry[@"id"]] uid:entry[@"id"] class:entityClass];
+        [entity mergeJSON:entry fields:fields];
+        [entities addObject:entity];
+    }
+    return entities;
+}
+
+// It returns the existing instance representing the entity (if any).
+- (HtHCloudObject*)entityWithPath:(NSString*)path uid:(NSString*)uid class:(Class)entityClass
+{
+    @synchronized(_objects)
+    {
+        HtHCloudObject* entity = [_objects objectForKey:path];
+        if (!entity) { entity = [[entityClass alloc] initWithClient:self path:path uid:uid]; [_objects setObject:entity forKey:path]; }
+        return entity;
+    }
+}
+
+@end
@@ -0,0 +1,90 @@
+@import Foundation;     // Apple
+@class HtHCloudClient;  // HtH
+
+FOUNDATION_EXPORT NSString* const kHtHFieldName;            // NSString
+FOUNDATION_EXPORT NSString* const kHtHFieldOwner;           // NSString
+FOUNDATION_EXPORT NSString* const kHtHFieldSecret;          // NSString
+FOUNDATION_EXPORT NSString* const kHtHFieldModel;           // NSString (device model identifier)
+FOUNDATION_EXPORT NSString* const kHtHFieldFirmwareVersion; // NSString
+FOUNDATION_EXPORT NSString* const kHtHFieldPublic;          // NSNumber (boolean)
+
+/*!
+ *  @abstract Partially populated relayr cloud entity (device or transmitter).
+ *  @discussion Objects are created with the fields requested in a projected query. Asking for a field that wasn't loaded returns <code>nil</code> and fetches the whole entity in the background; once it arrives, the corresponding properties change in a Key-Value Observing compliant way (on the main queue). If the fetch fails, faulting fields doesn't fetch again until an exponential backoff (2 s doubling up to 5 min) elapses; <code>loadWithCompletion:</code> always fetches.
+ */
+@interface HtHCloudObject : NSObject
+
+- (instancetype)initWithClient:(HtHCloudClient*)client path:(NSString*)path uid:(NSString*)uid;
+
+@property (readonly,weak,nonatomic) HtHCloudClient* client;
+
+/*!
+ *  @abstract Relative path of the entity in the relayr API (e.g.: <code>/devices/1234</code>).
+ */
+@property (readonly,nonatomic) NSString* path;
+@property (readonly,nonatomic) NSString* uid;
+
+/*!
+ *  @abstract Fields currently populated.
+ */
+@property (readonly,nonatomic) NSSet* loadedFields;
+
+/*!
+ *  @abstract Whether all fields are populated.
+ */
+@property (readonly,nonatomic,getter=isComplete) BOOL complete;
+
+/*!
+ *  @abstract Returns the value of a field, fetching the entity if the field isn't loaded.
+ */
+- (id)objectForField:(NSString*)field;
+
+- (id)objectForKeyedSubscript:(NSString*)field;
+
+/*!
+ *  @abstract Fetches the whole entity (if it isn't complete yet).
+ *
+ *  @param completion Block executed on the main queue once the entity is complete or the fetch failed. It can be <code>nil</code>.
+ */
+- (void)loadWithCompletion:(void (^)(NSError* error))completion;
+
+/*!
+ *  @abstract Merges JSON fields received from the cloud. It must be called on the main queue.
+ *
+ *  @param json Dictionary as returned by the relayr API.
+ *  @param fields Fields to take from the dictionary, or <code>nil</code> to take them all (and mark the entity as complete).
+ */
+- (void)mergeJSON:(NSDictionary*)json fields:(NSSet*)fields;
+
+@end
+
+/*!
+ *  @abstract Device as returned by a projected query.
+ */
+@interface HtHDeviceSummary : HtHCloudObject
+@property (readonly,nonatomic) NSString* name;
+@property (readonly,nonatomic) NSString* owner;
+@property (readonly,nonatomic) NSString* secret;
+@property (readonly,nonatomic) NSString* model;
+@property (readonly,nonatomic) NSString* firmwareVersion;
+@property (readonly,nonatomic) NSNumber* isPublic;
+@end
+
+/*!
+ *  @abstract Transmitter as returned by a projected query.
+ */
+@interface HtHTransmitterSummary : HtHCloudObject
+@property (readonly,nonatomic) NSString* name;
+@property (readonly,nonatomic) NSString* owner;
+@property (readonly,nonatomic) NSString* secret;
+
+/*!
+ *  @abstract <code>HtHDeviceSummary</code> objects connected to the transmitter, or <code>nil</code> if they haven't been fetched.
+ */
+@property (readonly,nonatomic) NSArray* devices;
+
+/*!
+ *  @abstract Replaces the devices of the transmitter. It must be called on the main queue.
+ */
+- (void)mergeDevices:(NSArray*)devices;
+@end
@@ -0,0 +1,189 @@
+#import "HtHCloudObject.h"      // Header
+#import "HtHCloudClient.h"      // HtH
+#import "HtHMemoryAccounting.h" // HtH
+
+#define HtHCloudObject_minimumBackoff   2.0
+#define HtHCloudObject_maximumBackoff   300.0
+
+NSString* const kHtHFieldName               = @"name";
+NSString* const kHtHFieldOwner              = @"owner";
+NSString* const kHtHFieldSecret             = @"secret";
+NSString* const kHtHFieldModel              = @"model";
+NSString* const kHtHFieldFirmwareVersion    = @"firmwareVersion";
+NSString* const kHtHFieldPublic             = @"public";
+
+@implementation HtHCloudObject
+{
+    NSMutableDictionary* _values;
+    NSMutableSet* _loaded;
+    NSMutableArray* _completions;   // Non nil while the entity is being fetched.
+    NSUInteger _failures;           // Consecutive failed fetches. Only touched on the main queue.
+    CFAbsoluteTime _retryAfter;     // Faulting fields doesn't fetch again before this time. Only touched on the main queue.
+    NSUInteger _footprint;          // Bytes accounted under HtHMemorySubsystemDeviceGraph.
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithClient:(HtHCloudClient*)client path:(NSString*)path uid:(NSString*)uid
+{
+    if (!client || !path.length || !uid.length) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _client = client;
+        _path = path.copy;
+        _uid = uid.copy;
+        _values = [[NSMutableDictionary alloc] init];
+        _loaded = [[NSMutableSet alloc] init];
+        _footprint = HtHMemoryObjectSize(self) + HtHMemoryObjectSize(_values) + HtHMemoryObjectSize(_loaded);
+        HtHMemoryAccount(HtHMemorySubsystemDeviceGraph, (int64_t)_footprint, 1);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    HtHMemoryAccount(HtHMemorySubsystemDeviceGraph, -(int64_t)_footprint, -1);
+}
+
+- (NSSet*)loadedFields
+{
+    @synchronized(self) { return _loaded.copy; }
+}
+
+- (BOOL)isComplete
+{
+    @synchronized(self) { return _complete; }
+}
+
+- (id)objectForField:(NSString*)field
+{
+    if (!field) { return nil; }
+
+    BOOL loaded;
+    id result;
+    @synchronized(self)
+    {
+        loaded = _complete || [_loaded containsObject:field];
+        result = _values[field];
+    }
+
+    if (!loaded) { dispatch_async(dispatch_get_main_queue(), ^{ [self faultFetch]; }); }
+    return result;
+}
+
+- (id)objectForKeyedSubscript:(NSString*)field
+{
+    return [self objectForField:field];
+}
+
+- (void)loadWithCompletion:(void (^)(NSError* error))completion
+{
+    if (![NSThread isMainThread]) { dispatch_async(dispatch_get_main_queue(), ^{ [self loadWithCompletion:completion]; }); return; }
+    if (self.isComplete) { if (completion) { completion(nil); } return; }
+
+    // Faulting many fields of the same object only launches one request.
+    if (_completions) { if (completion) { [_completions addObject:[completion copy]]; } return; }
+    _completions = (completion) ? [NSMutableArray arrayWithObject:[completion copy]] : [[NSMutableArray alloc] init];
+
+    HtHCloudClient* client = _client;
+    if (!client) { return [self finishLoadWithError:RelayrErrorMissingObjectPointer]; }
+
+    [client GETPath:_path query:nil completion:^(NSError* error, id json) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (!error && [json isKindOfClass:[NSDictionary class]]) { [self mergeJSON:json fields:nil]; }
+            [self finishLoadWithError:(error) ? error : ([json isKindOfClass:[NSDictionary class]]) ? nil : RelayrErrorWebRequestFailure];
+        });
+    }];
+}
+
+- (void)mergeJSON:(NSDictionary*)json fields:(NSSet*)fields
+{
+    NSMutableDictionary* values = [[NSMutableDictionary alloc] init];
+    [json enumerateKeysAndObjectsUsingBlock:^(NSString* field, id value, BOOL* stop) {
+        if (fields && ![fields containsObject:field]) { return; }
+        if ([field isEqualToString:kHtHFieldModel] && [value isKindOfClass:[NSDictionary class]]) { value = value[@"id"]; }
+        if (value && value != [NSNull null]) { values[field] = value; }
+    }];
+
+    NSMutableArray* keys = [[NSMutableArray alloc] initWithCapacity:values.count];
+    for (NSString* field in (fields) ? fields : values.allKeys) { [keys addObject:[self.class propertyForField:field]]; }
+
+    for (NSString* key in keys) { [self willChangeValueForKey:key]; }
+    @synchronized(self)
+    {
+        [_values addEntriesFromDictionary:values];
+        if (fields) { [_loaded unionSet:fields]; } else { _complete = YES; [_loaded addObjectsFromArray:values.allKeys]; }
+
+        NSUInteger footprint = HtHMemoryObjectSize(self) + HtHMemoryObjectSize(_values) + HtHMemoryObjectSize(_loaded);
+        for (id value in _values.allValues) { footprint += HtHMemoryObjectSize(value); }
+        HtHMemoryAccount(HtHMemorySubsystemDeviceGraph, (int64_t)footprint - (int64_t)_footprint, 0);
+        _footprint = footprint;
+    }
+    for (NSString* key in keys.reverseObjectEnumerator) { [self didChangeValueForKey:key]; }
+}
+
+#pragma mark - Private functionality
+
++ (NSString*)propertyForField:(NSString*)field
+{
+    return ([field isEqualToString:kHtHFieldPublic]) ? @"isPublic" : field;
+}
+
+// After a failed fetch, faulting fields waits for an exponential backoff, so many cells reading an unreachable entity don't turn into a storm of requests.
+- (void)faultFetch
+{
+    if (!_completions && CFAbsoluteTimeGetCurrent() < _retryAfter) { return; }
+    [self loadWithCompletion:nil];
+}
+
+- (void)finishLoadWithError:(NSError*)error
+{
+    if (error)
+    {
+        _failures++;
+        _retryAfter = CFAbsoluteTimeGetCurrent() + MIN(HtHCloudObject_minimumBackoff * pow(2.0, (double)(_failures - 1)), HtHCloudObject_maximumBackoff);
+    }
+    else { _failures = 0; _retryAfter = 0.0; }
+
+    NSArray* completions = _completions;
+    _completions = nil;
+    for (void (^completion)(NSError*) in completions) { completion(error); }
+}
+
+@end
+
+@implementation HtHDeviceSummary
+
+- (NSString*)name               { return [self objectForField:kHtHFieldName]; }
+- (NSString*)owner              { return [self objectForField:kHtHFieldOwner]; }
+- (NSString*)secret             { return [self objectForField:kHtHFieldSecret]; }
+- (NSString*)model              { return [self objectForField:kHtHFieldModel]; }
+- (NSString*)firmwareVersion    { return [self objectForField:kHtHFieldFirmwareVersion]; }
+- (NSNumber*)isPublic           { return [self objectForField:kHtHFieldPublic]; }
+
+@end
+
+@implementation HtHTransmitterSummary
+{
+    NSArray* _devices;
+}
+
+- (NSString*)name               { return [self objectForField:kHtHFieldName]; }
+- (NSString*)owner              { return [self objectForField:kHtHFieldOwner]; }
+- (NSString*)secret             { return [self objectForField:kHtHFieldSecret]; }
+
+- (NSArray*)devices
+{
+    @synchronized(self) { return _devices; }
+}
+
+- (void)mergeDevices:(NSArray*)devices
+{
+    [self willChangeValueForKey:@"devices"];
+    @synchronized(self) { _devices = devices.copy; }
+    [self didChangeValueForKey:@"devices"];
+}
+
+@end
@@ -0,0 +1,98 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+@class HtHLocalServer;      // HtH
+
+/*!
+ *  @abstract Gateway instance of a cluster partitioning the device fleet of a user.
+ *  @discussion Instances sharing a directory find each other through their <code>HtHLocalServer</code> sockets (<code>directory/identifier.sock</code>). Devices are assigned to the live instances with an <code>HtHHashRing</code>: every instance only keeps the upstream subscriptions (and shadows) of the devices it owns, and when an instance joins or leaves, only the devices of the arcs it takes or gives back move.
+ *  Queries fan out to all members and commands are forwarded to the owner of the device. Completion blocks are executed on the main queue.
+ */
+@interface HtHClusterNode : NSObject
+
+/*!
+ *  @abstract Creates a cluster node.
+ *
+ *  @param user Signed-in user whose devices are partitioned. Every member must be signed in with the same user.
+ *  @param identifier Unique identifier of the instance within the cluster.
+ *  @param directory Directory shared by all members of the cluster.
+ */
+- (instancetype)initWithUser:(RelayrUser*)user identifier:(NSString*)identifier directory:(NSString*)directory;
+
+@property (readonly,weak,nonatomic) RelayrUser* user;
+@property (readonly,nonatomic) NSString* identifier;
+@property (readonly,nonatomic) NSString* directory;
+
+/*!
+ *  @abstract Server through which the other members reach the devices owned by this instance.
+ */
+@property (readonly,nonatomic) HtHLocalServer* server;
+
+/*!
+ *  @abstract Points of every member in the hash ring. All members must use the same value. Default: 256.
+ *  @discussion More points even out the arcs: with 16 members and 100,000 devices, the busiest member owns about 1.5 times the mean with 64 points and about 1.1 times with 256 (see <code>HtHHashRing</code>'s <code>simulateMembers:keys:virtualNodes:</code>).
+ */
+@property (atomic) NSUInteger virtualNodes;
+
+/*!
+ *  @abstract Seconds between scans of the cluster directory looking for members joining or leaving. Default: 2 seconds.
+ */
+@property (atomic) NSTimeInterval probeInterval;
+
+/*!
+ *  @abstract Block executed on the main queue with the device identifiers gained and lost after every rebalance. It can be <code>nil</code>.
+ */
+@property (copy,atomic) void (^ownershipChangedBlock)(NSSet* gained, NSSet* lost);
+
+/*!
+ *  @abstract Starts serving the owned devices and probing for other members.
+ */
+- (BOOL)start:(NSError**)error;
+
+/*!
+ *  @abstract Leaves the cluster: the owned devices are released and the other members take them over on their next probe.
+ */
+- (void)stop;
+
+/*!
+ *  @abstract Identifiers of the live members (this instance included), sorted.
+ */
+@property (readonly,atomic) NSArray* members;
+
+/*!
+ *  @abstract Member owning a device or <code>nil</code> if the node is not running.
+ */
+- (NSString*)ownerOfDeviceID:(NSString*)deviceID;
+
+- (BOOL)ownsDeviceID:(NSString*)deviceID;
+
+/*!
+ *  @abstract Identifiers of the devices whose upstream subscriptions are held by this instance.
+ */
+@property (readonly,atomic) NSSet* ownedDeviceIDs;
+
+/*!
+ *  @abstract Recomputes the owned devices. It must be called from the main queue after the device graph of the user changes.
+ *  @discussion Gained devices are subscribed and their shadows held. Lost devices have their upstream subscription, their shadow and the streams opened on them through <code>server</code> released.
+ */
+- (void)rebalance;
+
+/*!
+ *  @abstract Fetches the devices owned by all members.
+ *
+ *  @param completion Block with an array of dictionaries (see <code>HtHLocalClient</code>) and the first error of a member (if any). Members failing to answer don't stop the rest.
+ */
+- (void)queryDevicesWithCompletion:(void (^)(NSError* error, NSArray* devices))completion;
+
+/*!
+ *  @abstract Sends a command through the shadow of the device kept by its owner (forwarding it if it is another member).
+ *
+ *  @param completion Block with the outcome (an <code>HtHShadowOutcome</code>) of the command.
+ */
+- (void)sendValue:(id)value toDeviceID:(NSString*)deviceID meaning:(NSString*)meaning completion:(void (^)(NSError* error, NSUInteger outcome))completion;
+
+/*!
+ *  @abstract Counters: members, devices owned, commands forwarded and rebalances.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,302 @@
+#import "HtHClusterNode.h"  // Header
+#import "HtHHashRing.h"     // HtH
+#import "HtHLocalServer.h"  // HtH
+#import "HtHLocalClient.h"  // HtH
+#import "HtHReadingHub.h"   // HtH
+#import "HtHDeviceShadow.h" // HtH
+
+#define HtHClusterNode_virtualNodes     256
+#define HtHClusterNode_probeInterval    2.0
+#define HtHClusterNode_socketExtension  @"sock"
+
+@implementation HtHClusterNode
+{
+    dispatch_queue_t _queue;
+    dispatch_source_t _timer;
+    HtHHashRing* _ring;
+    NSMutableDictionary* _peers;        // member identifier -> HtHLocalClient
+    NSSet* _ownedIDs;
+
+    NSMutableDictionary* _owned;        // device identifier -> HtHSubscription (main queue only)
+    NSMutableDictionary* _shadows;      // device identifier -> HtHDeviceShadow (main queue only)
+
+    NSUInteger _forwardedCount;
+    NSUInteger _rebalancesCount;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithUser:(RelayrUser*)user identifier:(NSString*)identifier directory:(NSString*)directory
+{
+    if (!user || !identifier.length || !directory.length) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _user = user;
+        _identifier = identifier.copy;
+        _directory = directory.copy;
+        _server = [[HtHLocalServer alloc] initWithUser:user socketPath:[self socketPathOfMember:_identifier]];
+        _queue = dispatch_queue_create("io.relayr.hth.cluster", DISPATCH_QUEUE_SERIAL);
+        _peers = [[NSMutableDictionary alloc] init];
+        _ownedIDs = [NSSet set];
+        _owned = [[NSMutableDictionary alloc] init];
+        _shadows = [[NSMutableDictionary alloc] init];
+        _virtualNodes = HtHClusterNode_virtualNodes;
+        _probeInterval = HtHClusterNode_probeInterval;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_timer) { dispatch_source_cancel(_timer); }
+    for (HtHLocalClient* client in _peers.allValues) { [client disconnect]; }
+    for (HtHSubscription* subscription in _owned.allValues) { [[HtHReadingHub sharedHub] unsubscribe:subscription]; }
+    [_server stop];
+}
+
+- (BOOL)start:(NSError**)error
+{
+    __block BOOL running = NO;
+    dispatch_sync(_queue, ^{ running = (_timer != nil); });
+    if (running) { return YES; }
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:_directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    __weak HtHClusterNode* weakSelf = self;
+    _server.deviceFilter = ^BOOL(NSString* deviceID) { return [weakSelf ownsDeviceID:deviceID]; };
+    if (![_server start:error]) { return NO; }
+
+    dispatch_sync(_queue, ^{
+        _ring = nil;
+        _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+        uint64_t const interval = (uint64_t)(MAX(self.probeInterval, 0.1) * NSEC_PER_SEC);
+        dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, 0), interval, interval / 10);
+        dispatch_source_set_event_handler(_timer, ^{ [weakSelf probe]; });
+        dispatch_resume(_timer);
+    });
+    return YES;
+}
+
+- (void)stop
+{
+    dispatch_sync(_queue, ^{
+        if (_timer) { dispatch_source_cancel(_timer); _timer = nil; }
+        for (HtHLocalClient* client in _peers.allValues) { [client disconnect]; }
+        [_peers removeAllObjects];
+        _ring = nil;
+    });
+    [_server stop];
+
+    dispatch_async(dispatch_get_main_queue(), ^{ [self rebalance]; });
+}
+
+- (NSArray*)members
+{
+    __block NSArray* result;
+    dispatch_sync(_queue, ^{ result = (_ring) ? _ring.members : @[]; });
+    return result;
+}
+
+- (NSString*)ownerOfDeviceID:(NSString*)deviceID
+{
+    if (!deviceID.length) { return nil; }
+
+    __block NSString* result;
+    dispatch_sync(_queue, ^{ result = [_ring memberForKey:deviceID]; });
+    return result;
+}
+
+- (BOOL)ownsDeviceID:(NSString*)deviceID
+{
+    return [[self ownerOfDeviceID:deviceID] isEqualToString:_identifier];
+}
+
+- (NSSet*)ownedDeviceIDs
+{
+    __block NSSet* result;
+    dispatch_sync(_queue, ^{ result = _ownedIDs; });
+    return result;
+}
+
+- (void)rebalance
+{
+    NSMutableSet* desired = [[NSMutableSet alloc] init];
+    NSMutableDictionary* devices = [[NSMutableDictionary alloc] init];
+    for (RelayrDevice* device in self.user.devices)
+    {
+        if (!device.uid || ![self ownsDeviceID:device.uid]) { continue; }
+        [desired addObject:device.uid];
+        devices[device.uid] = device;
+    }
+
+    NSMutableSet* lost = [NSMutableSet setWithArray:_owned.allKeys];
+    [lost minusSet:desired];
+    NSMutableSet* gained = desired.mutableCopy;
+    [gained minusSet:[NSSet setWithArray:_owned.allKeys]];
+    if (!gained.count && !lost.count) { return; }
+
+    // Devices moving to another member are let go entirely: their upstream, their shadow (it is released once its commands in flight finish) and the streams local consumers opened on them.
+    for (NSString* deviceID in lost)
+    {
+        [[HtHReadingHub sharedHub] unsubscribe:_owned[deviceID]];
+        [_owned removeObjectForKey:deviceID];
+        [_shadows removeObjectForKey:deviceID];
+    }
+    if (lost.count) { [_server dropSubscriptionsOfDeviceIDs:lost]; }
+
+    // The subscription only keeps the upstream of the device alive; its samples reach the stages and sinks of the hub. The shadow keeps the reported state between commands.
+    for (NSString* deviceID in gained)
+    {
+        HtHSubscription* subscription = [[HtHReadingHub sharedHub] subscribeToDevice:devices[deviceID] meaning:nil subscriptionClass:HtHSubscriptionClassArchive withBlock:^(HtHSample* sample, BOOL* unsubscribe) {} error:nil];
+        if (!subscription) { [gained removeObject:deviceID]; continue; }
+        subscription.backgroundPolicy = HtHBackgroundPolicyKeep;
+        _owned[deviceID] = subscription;
+
+        HtHDeviceShadow* shadow = [HtHDeviceShadow shadowForDevice:devices[deviceID]];
+        if (shadow) { _shadows[deviceID] = shadow; }
+    }
+
+    NSSet* owned = [NSSet setWithArray:_owned.allKeys];
+    dispatch_sync(_queue, ^{ _ownedIDs = owned; });
+
+    void (^block)(NSSet*, NSSet*) = self.ownershipChangedBlock;
+    if (block) { block(gained, lost); }
+}
+
+- (void)queryDevicesWithCompletion:(void (^)(NSError* error, NSArray* devices))completion
+{
+    if (!completion) { return; }
+
+    __block NSArray* clients;
+    dispatch_sync(_queue, ^{ clients = _peers.allValues; });
+
+    NSMutableArray* result = [[NSMutableArray alloc] init];
+    NSMutableSet* identifiers = [[NSMutableSet alloc] init];
+    __block NSError* firstError;
+    dispatch_group_t group = dispatch_group_create();
+
+    // Devices owned by this instance are answered by its own server through a client, like those of any other member.
+    HtHLocalClient* local = [[HtHLocalClient alloc] initWithSocketPath:_server.socketPath];
+    NSError* error;
+    if ([local connect:&error]) { clients = [clients arrayByAddingObject:local]; } else { firstError = error; }
+
+    for (HtHLocalClient* client in clients)
+    {
+        dispatch_group_enter(group);
+        [client queryDevicesWithCompletion:^(NSError* error, NSArray* devices) {
+            if (error && !firstError) { firstError = error; }
+            for (NSDictionary* device in devices)
+            {
+                NSString* identifier = device[@"id"];
+                if (!identifier || [identifiers containsObject:identifier]) { continue; }
+                [identifiers addObject:identifier];
+                [result addObject:device];
+            }
+            dispatch_group_leave(group);
+        }];
+    }
+
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        [local disconnect];
+        completion(firstError, result);
+    });
+}
+
+- (void)sendValue:(id)value toDeviceID:(NSString*)deviceID meaning:(NSString*)meaning completion:(void (^)(NSError* error, NSUInteger outcome))completion
+{
+    if (!value || !deviceID.length || !meaning.length) { if (completion) { completion(RelayrErrorMissingArgument, HtHShadowOutcomeFailed); } return; }
+
+    __block NSString* owner;
+    __block HtHLocalClient* client;
+    dispatch_sync(_queue, ^{
+        owner = [_ring memberForKey:deviceID];
+        client = (owner) ? _peers[owner] : nil;
+        if (client) { _forwardedCount++; }
+    });
+
+    if (client) { return [client sendValue:value toDeviceID:deviceID meaning:meaning completion:completion]; }
+
+    RelayrDevice* device;
+    if ([owner isEqualToString:_identifier])
+    {
+        for (RelayrDevice* candidate in self.user.devices) { if ([candidate.uid isEqualToString:deviceID]) { device = candidate; break; } }
+    }
+
+    HtHDeviceShadow* shadow = (device) ? _shadows[deviceID] : nil;
+    if (!shadow && device) { shadow = [HtHDeviceShadow shadowForDevice:device]; }
+    if (!shadow)
+    {
+        NSError* error = (owner) ? RelayrErrorMissingExpectedValue : RelayrErrorNoServiceAvailable;
+        if (completion) { dispatch_async(dispatch_get_main_queue(), ^{ completion(error, HtHShadowOutcomeFailed); }); }
+        return;
+    }
+
+    [shadow setDesiredValue:value forMeaning:meaning completion:^(HtHShadowOutcome outcome, NSTimeInterval latency, NSError* error) {
+        if (completion) { completion(error, outcome); }
+    }];
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        result = @{
+            @"cluster.members"      : @(_ring.members.count),
+            @"cluster.owned"        : @(_ownedIDs.count),
+            @"cluster.forwarded"    : @(_forwardedCount),
+            @"cluster.rebalances"   : @(_rebalancesCount)
+        };
+    });
+    return result;
+}
+
+#pragma mark - Private functionality
+
+- (NSString*)socketPathOfMember:(NSString*)identifier
+{
+    return [_directory stringByAppendingPathComponent:[identifier stringByAppendingPathExtension:HtHClusterNode_socketExtension]];
+}
+
+// It must be called from the node's queue.
+- (void)probe
+{
+    if (!_timer) { return; }
+
+    NSMutableSet* found = [[NSMutableSet alloc] init];
+    for (NSString* file in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_directory error:nil])
+    {
+        if (![file.pathExtension isEqualToString:HtHClusterNode_socketExtension]) { continue; }
+        NSString* identifier = file.stringByDeletingPathExtension;
+        if (identifier.length && ![identifier isEqualToString:_identifier]) { [found addObject:identifier]; }
+    }
+
+    // Peers whose socket vanished or whose connection dropped leave the ring.
+    for (NSString* identifier in _peers.allKeys)
+    {
+        HtHLocalClient* client = _peers[identifier];
+        if ([found containsObject:identifier] && client.connected) { continue; }
+        [client disconnect];
+        [_peers removeObjectForKey:identifier];
+    }
+
+    // Sockets left behind by crashed instances refuse the connection, so they never join.
+    for (NSString* identifier in found)
+    {
+        if (_peers[identifier]) { continue; }
+        HtHLocalClient* client = [[HtHLocalClient alloc] initWithSocketPath:[self socketPathOfMember:identifier]];
+        if ([client connect:nil]) { _peers[identifier] = client; }
+    }
+
+    NSArray* members = [_peers.allKeys arrayByAddingObject:_identifier];
+    if (_ring && [[NSSet setWithArray:_ring.members] isEqualToSet:[NSSet setWithArray:members]]) { return; }
+
+    _ring = [[HtHHashRing alloc] initWithMembers:members virtualNodes:MAX(self.virtualNodes, (NSUInteger)1)];
+    _rebalancesCount++;
+
+    __weak HtHClusterNode* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{ [weakSelf rebalance]; });
+}
+
+@end
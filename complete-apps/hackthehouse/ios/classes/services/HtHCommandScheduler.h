@@ -0,0 +1,67 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract A command to be sent to a device at a specific time (and optionally repeated).
+ */
+@interface HtHScheduledCommand : NSObject
+
+/*!
+ *  @abstract Creates a scheduled command.
+ *
+ *  @param device Device receiving the command.
+ *  @param meaning Meaning of the command (e.g.: <code>led</code>).
+ *  @param value Value sent.
+ *  @param fireDate First time the command is sent.
+ *  @param repeatInterval Seconds between executions. Zero (or negative) to execute only once.
+ *  @param critical Critical commands are executed on time; the rest are spread over the scheduler's <code>spreadWindow</code> to avoid bursts.
+ */
+- (instancetype)initWithDevice:(RelayrDevice*)device meaning:(NSString*)meaning value:(id)value fireDate:(NSDate*)fireDate repeatInterval:(NSTimeInterval)repeatInterval critical:(BOOL)critical;
+
+@property (readonly,nonatomic) RelayrDevice* device;
+@property (readonly,nonatomic) NSString* meaning;
+@property (readonly,nonatomic) id value;
+@property (readonly,nonatomic) NSDate* fireDate;
+@property (readonly,nonatomic) NSTimeInterval repeatInterval;
+@property (readonly,nonatomic,getter=isCritical) BOOL critical;
+
+@end
+
+/*!
+ *  @abstract Executes scheduled commands locally.
+ *  @discussion Commands are kept in a binary heap ordered by execution time and a single wall clock timer fires for the earliest one, thus thousands of commands cost a single timer.
+ *  <code>prewarmInterval</code> seconds before a command is due, the device is subscribed through the <code>HtHReadingHub</code> (in the <code>HtHSubscriptionClassArchive</code> class) so its connection is up when the command is sent. Commands are sent through the device's <code>HtHDeviceShadow</code>, so values the device already has are not sent again.
+ */
+@interface HtHCommandScheduler : NSObject
+
++ (instancetype)sharedScheduler;
+
+/*!
+ *  @abstract Seconds over which non critical commands are spread (each command always gets the same offset, also across launches). Default: 30.
+ */
+@property (atomic) NSTimeInterval spreadWindow;
+
+/*!
+ *  @abstract Seconds before execution when the device connection is warmed up. Default: 5.
+ */
+@property (atomic) NSTimeInterval prewarmInterval;
+
+/*!
+ *  @abstract Schedules a command.
+ *	@return An opaque token to cancel the command.
+ */
+- (id)scheduleCommand:(HtHScheduledCommand*)command;
+
+- (void)cancelCommand:(id)token;
+
+/*!
+ *  @abstract Number of scheduled commands.
+ */
+@property (readonly,nonatomic) NSUInteger count;
+
+/*!
+ *  @abstract Counters (executed, failed, pending) and execution lag statistics (mean, 95th percentile and maximum seconds between the due time and the actual execution).
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
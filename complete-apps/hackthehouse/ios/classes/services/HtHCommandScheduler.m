@@ -0,0 +1,312 @@
+#import "HtHCommandScheduler.h" // Header
+#import "HtHDeviceShadow.h"     // HtH
+#import "HtHHashRing.h"         // HtH
+#import "HtHReadingHub.h"       // HtH
+
+#define HtHCommandScheduler_spreadWindow    30.0
+#define HtHCommandScheduler_prewarmInterval 5.0
+#define HtHCommandScheduler_timerLeeway     (5 * NSEC_PER_MSEC)
+#define HtHCommandScheduler_lagCapacity     256
+
+@implementation HtHScheduledCommand
+
+- (instancetype)initWithDevice:(RelayrDevice*)device meaning:(NSString*)meaning value:(id)value fireDate:(NSDate*)fireDate repeatInterval:(NSTimeInterval)repeatInterval critical:(BOOL)critical
+{
+    if (!device.uid || !meaning.length || !value || !fireDate) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _device = device;
+        _meaning = meaning.copy;
+        _value = value;
+        _fireDate = fireDate;
+        _repeatInterval = (repeatInterval > 0.0) ? repeatInterval : 0.0;
+        _critical = critical;
+    }
+    return self;
+}
+
+@end
+
+// Heap entries are plain structs; cancelled or rescheduled commands leave stale entries that are skipped when popped.
+typedef struct {
+    double time;            // Seconds since 1970.
+    double occurrence;      // Occurrence of the item the entry was pushed for.
+    uint64_t identifier;
+    BOOL prewarm;
+} HtHTimerEntry;
+
+@interface HtHSchedulerItem : NSObject
+@property (strong,nonatomic) HtHScheduledCommand* command;
+@property (nonatomic) double offset;        // Spread applied to every occurrence.
+@property (nonatomic) double occurrence;    // Nominal time of the next occurrence (seconds since 1970).
+@property (strong,nonatomic) HtHSubscription* prewarm;
+@end
+
+@implementation HtHSchedulerItem
+@end
+
+@implementation HtHCommandScheduler
+{
+    dispatch_queue_t _queue;
+    dispatch_source_t _timer;
+    HtHTimerEntry* _heap;
+    NSUInteger _heapCount;
+    NSUInteger _heapCapacity;
+    NSMutableDictionary* _items;    // NSNumber (identifier) -> HtHSchedulerItem
+    uint64_t _lastIdentifier;
+    double _armedTime;
+
+    NSUInteger _executedCount;
+    NSUInteger _failedCount;
+    double _lags[HtHCommandScheduler_lagCapacity];
+    NSUInteger _lagsCount;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedScheduler
+{
+    static HtHCommandScheduler* scheduler;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ scheduler = [[HtHCommandScheduler alloc] init]; });
+    return scheduler;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _queue = dispatch_queue_create("io.relayr.hth.scheduler", DISPATCH_QUEUE_SERIAL);
+        _items = [[NSMutableDictionary alloc] init];
+        _spreadWindow = HtHCommandScheduler_spreadWindow;
+        _prewarmInterval = HtHCommandScheduler_prewarmInterval;
+        _armedTime = DBL_MAX;
+
+        __weak HtHCommandScheduler* weakSelf = self;
+        _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+        dispatch_source_set_event_handler(_timer, ^{ [weakSelf timerFired]; });
+        dispatch_source_set_timer(_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+        dispatch_resume(_timer);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    dispatch_source_cancel(_timer);
+    free(_heap);
+}
+
+- (id)scheduleCommand:(HtHScheduledCommand*)command
+{
+    if (!command) { return nil; }
+
+    // The offset depends only on the command (through a fixed hash, not NSString's), so a recurring command keeps its slot inside the window, even across launches.
+    NSString* key = [NSString stringWithFormat:@"%@/%@", command.device.uid, command.meaning];
+    double const offset = (command.isCritical) ? 0.0 : (double)([HtHHashRing hashForString:key] % 1000) / 1000.0 * self.spreadWindow;
+
+    __block NSNumber* token;
+    dispatch_sync(_queue, ^{
+        token = @(++_lastIdentifier);
+
+        HtHSchedulerItem* item = [[HtHSchedulerItem alloc] init];
+        item.command = command;
+        item.offset = offset;
+        item.occurrence = command.fireDate.timeIntervalSince1970;
+        _items[token] = item;
+
+        [self pushItem:item identifier:token.unsignedLongLongValue];
+        [self armTimer];
+    });
+    return token;
+}
+
+- (void)cancelCommand:(id)token
+{
+    if (![token isKindOfClass:[NSNumber class]]) { return; }
+
+    dispatch_async(_queue, ^{
+        HtHSchedulerItem* item = _items[token];
+        if (!item) { return; }
+        if (item.prewarm) { [[HtHReadingHub sharedHub] unsubscribe:item.prewarm]; }
+        [_items removeObjectForKey:token];
+    });
+}
+
+- (NSUInteger)count
+{
+    __block NSUInteger result;
+    dispatch_sync(_queue, ^{ result = _items.count; });
+    return result;
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        NSUInteger const count = MIN(_lagsCount, (NSUInteger)HtHCommandScheduler_lagCapacity);
+        double sorted[HtHCommandScheduler_lagCapacity];
+        memcpy(sorted, _lags, count * sizeof(double));
+        qsort_b(sorted, count, sizeof(double), ^int(void const* a, void const* b) {
+            double const x = *(double const*)a, y = *(double const*)b;
+            return (x > y) - (x < y);
+        });
+
+        double mean = 0.0;
+        for (NSUInteger i = 0; i < count; ++i) { mean += sorted[i]; }
+
+        result = @{
+            @"scheduler.executed"   : @(_executedCount),
+            @"scheduler.failed"     : @(_failedCount),
+            @"scheduler.pending"    : @(_items.count),
+            @"scheduler.lag.mean"   : @((count) ? mean / count : 0.0),
+            @"scheduler.lag.p95"    : @((count) ? sorted[MIN((NSUInteger)(count * 0.95), count - 1)] : 0.0),
+            @"scheduler.lag.max"    : @((count) ? sorted[count - 1] : 0.0)
+        };
+    });
+    return result;
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the scheduler's queue.
+- (void)pushItem:(HtHSchedulerItem*)item identifier:(uint64_t)identifier
+{
+    double const time = item.occurrence + item.offset;
+    NSTimeInterval const prewarm = self.prewarmInterval;
+    if (prewarm > 0.0) { [self heapPush:(HtHTimerEntry){ .time = time - prewarm, .occurrence = item.occurrence, .identifier = identifier, .prewarm = YES }]; }
+    [self heapPush:(HtHTimerEntry){ .time = time, .occurrence = item.occurrence, .identifier = identifier, .prewarm = NO }];
+}
+
+// It must be called from the scheduler's queue.
+- (void)armTimer
+{
+    double const next = (_heapCount) ? _heap[0].time : DBL_MAX;
+    if (next == _armedTime) { return; }
+    _armedTime = next;
+
+    if (next == DBL_MAX) { return dispatch_source_set_timer(_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0); }
+
+    // Wall clock time, so the schedule holds across device sleep and clock changes.
+    struct timespec when;
+    when.tv_sec = (time_t)floor(next);
+    when.tv_nsec = (long)((next - floor(next)) * NSEC_PER_SEC);
+    dispatch_source_set_timer(_timer, dispatch_walltime(&when, 0), DISPATCH_TIME_FOREVER, HtHCommandScheduler_timerLeeway);
+}
+
+- (void)timerFired
+{
+    _armedTime = DBL_MAX;
+    double const now = [NSDate date].timeIntervalSince1970;
+
+    while (_heapCount && _heap[0].time <= now)
+    {
+        HtHTimerEntry const entry = [self heapPop];
+        NSNumber* token = @(entry.identifier);
+        HtHSchedulerItem* item = _items[token];
+        if (!item || entry.occurrence != item.occurrence) { continue; }     // Cancelled or stale entry.
+        if (entry.prewarm) { [self prewarmItem:item]; continue; }
+
+        [self executeItem:item lag:now - entry.time];
+
+        RelayrDevice* device = item.command.device;
+        NSTimeInterval const interval = item.command.repeatInterval;
+        if (interval <= 0.0 || !device)
+        {
+            [_items removeObjectForKey:token];
+            continue;
+        }
+
+        // Missed occurrences (e.g.: the app was suspended) are skipped, not replayed in a burst.
+        double const periods = MAX(floor((now - item.occurrence) / interval) + 1.0, 1.0);
+        item.occurrence += periods * interval;
+        [self pushItem:item identifier:entry.identifier];
+    }
+
+    [self armTimer];
+}
+
+// It must be called from the scheduler's queue.
+- (void)prewarmItem:(HtHSchedulerItem*)item
+{
+    RelayrDevice* device = item.command.device;
+    if (item.prewarm || !device) { return; }
+    // It only keeps the connection warm; its samples can be shed first.
+    item.prewarm = [[HtHReadingHub sharedHub] subscribeToDevice:device meaning:nil subscriptionClass:HtHSubscriptionClassArchive withBlock:^(HtHSample* sample, BOOL* unsubscribe) {} error:nil];
+}
+
+// It must be called from the scheduler's queue.
+- (void)executeItem:(HtHSchedulerItem*)item lag:(double)lag
+{
+    HtHScheduledCommand* command = item.command;
+    _lags[_lagsCount++ % HtHCommandScheduler_lagCapacity] = MAX(lag, 0.0);
+
+    HtHSubscription* prewarm = item.prewarm;
+    item.prewarm = nil;
+
+    HtHDeviceShadow* shadow = [HtHDeviceShadow shadowForDevice:command.device];
+    if (!shadow) { _failedCount++; [[HtHReadingHub sharedHub] unsubscribe:prewarm]; return; }
+
+    __weak HtHCommandScheduler* weakSelf = self;
+    [shadow setDesiredValue:command.value forMeaning:command.meaning completion:^(HtHShadowOutcome outcome, NSTimeInterval latency, NSError* error) {
+        [[HtHReadingHub sharedHub] unsubscribe:prewarm];
+
+        HtHCommandScheduler* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+        dispatch_async(strongSelf->_queue, ^{
+            if (outcome == HtHShadowOutcomeFailed) { strongSelf->_failedCount++; } else { strongSelf->_executedCount++; }
+        });
+    }];
+}
+
+#pragma mark Heap
+
+static inline BOOL HtHTimerEntryPrecedes(HtHTimerEntry const* a, HtHTimerEntry const* b)
+{
+    return (a->time < b->time) || (a->time == b->time && a->identifier < b->identifier);
+}
+
+// It must be called from the scheduler's queue.
+- (void)heapPush:(HtHTimerEntry)entry
+{
+    if (_heapCount == _heapCapacity)
+    {
+        _heapCapacity = (_heapCapacity) ? _heapCapacity * 2 : 64;
+        _heap = reallocf(_heap, _heapCapacity * sizeof(HtHTimerEntry));
+    }
+
+    NSUInteger index = _heapCount++;
+    while (index > 0)
+    {
+        NSUInteger const parent = (index - 1) / 2;
+        if (!HtHTimerEntryPrecedes(&entry, &_heap[parent])) { break; }
+        _heap[index] = _heap[parent];
+        index = parent;
+    }
+    _heap[index] = entry;
+}
+
+// It must be called from the scheduler's queue (and only with a non empty heap).
+- (HtHTimerEntry)heapPop
+{
+    HtHTimerEntry const result = _heap[0];
+    HtHTimerEntry const last = _heap[--_heapCount];
+
+    NSUInteger index = 0;
+    for (;;)
+    {
+        NSUInteger child = 2 * index + 1;
+        if (child >= _heapCount) { break; }
+        if (child + 1 < _heapCount && HtHTimerEntryPrecedes(&_heap[child + 1], &_heap[child])) { child++; }
+        if (!HtHTimerEntryPrecedes(&_heap[child], &last)) { break; }
+        _heap[index] = _heap[child];
+        index = child;
+    }
+    if (_heapCount) { _heap[index] = last; }
+    return result;
+}
+
+@end
@@ -0,0 +1,57 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract Configuration fields and the Wunderbar characteristic each one is written to.
+ *  @discussion Frequencies are <code>NSNumber</code> milliseconds (written as 32-bit little endian), the LED state an <code>NSNumber</code> boolean (one byte), and the threshold and config fields <code>NSData</code> written as they are.
+ */
+FOUNDATION_EXPORT NSString* const kHtHConfigurationKeyBeaconFrequency;  // Characteristic 2011
+FOUNDATION_EXPORT NSString* const kHtHConfigurationKeyFrequency;        // Characteristic 2012
+FOUNDATION_EXPORT NSString* const kHtHConfigurationKeyLEDState;         // Characteristic 2013
+FOUNDATION_EXPORT NSString* const kHtHConfigurationKeyThreshold;        // Characteristic 2014
+FOUNDATION_EXPORT NSString* const kHtHConfigurationKeyConfig;           // Characteristic 2015
+
+/*!
+ *  @abstract Keeps the configuration of Wunderbar sensors in sync with a desired configuration, writing only the fields that changed.
+ *  @discussion The configuration last confirmed on every device is remembered (starting with <code>RelayrFirmware.configuration</code>), so applying a desired configuration diffs it field by field and devices without differences are not even connected. Every device that needs changes gets a single BLE connection (to its direct service): all changed fields are written in a batch, then read back once and compared. Only a verified write updates the remembered configuration, so a failed or partial sync is retried on the next apply.
+ *  Peripherals are matched to devices through their sensor ID characteristic and remembered, so later syncs skip the scan; devices whose identifier is not a UUID can't be matched and fail without connecting. Fields are only written once all their characteristics have been found on the sensor. All methods must be called from the main queue; completion blocks are executed on the main queue.
+ */
+@interface HtHConfigurationSync : NSObject
+
++ (instancetype)sharedSync;
+
+/*!
+ *  @abstract Maximum devices being configured at once. Default: 3.
+ */
+@property (atomic) NSUInteger maximumConnections;
+
+/*!
+ *  @abstract Seconds allowed for every device (scan, connection, writes and read-back). Default: 20.
+ */
+@property (atomic) NSTimeInterval timeout;
+
+/*!
+ *  @abstract Configuration last confirmed on the device (or the firmware's one if it was never synced).
+ */
+- (NSDictionary*)currentConfigurationOfDevice:(RelayrDevice*)device;
+
+/*!
+ *  @abstract Fields of the desired configuration that differ from the current one of the device. Unsupported fields are left out.
+ */
+- (NSDictionary*)deltaForDevice:(RelayrDevice*)device desiredConfiguration:(NSDictionary*)desired;
+
+/*!
+ *  @abstract Applies a configuration to a set of devices, writing only the fields that changed on each one.
+ *
+ *  @param desired Fields to set (see the <code>kHtHConfigurationKey...</code> constants). Fields not mentioned are left untouched.
+ *  @param devices Array of <code>RelayrDevice</code> objects.
+ *  @param completion Block with the errors of the devices that failed (<code>NSString</code> device identifier -> <code>NSError</code>). It can be <code>nil</code>.
+ */
+- (void)applyConfiguration:(NSDictionary*)desired toDevices:(NSArray*)devices completion:(void (^)(NSDictionary* errors))completion;
+
+/*!
+ *  @abstract Counters: devices synced, skipped (no changes) and failed, fields and bytes written and fields verified.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,413 @@
+#import "HtHConfigurationSync.h"    // Header
+@import CoreBluetooth;              // Apple
+
+#define HtHConfiguration_maximumConnections     3
+#define HtHConfiguration_timeout                20.0
+#define HtHConfiguration_file                   @"Configurations.plist"
+#define HtHConfiguration_directService          @"2002"
+#define HtHConfiguration_sensorID               @"2010"
+
+NSString* const kHtHConfigurationKeyBeaconFrequency = @"beaconFrequency";
+NSString* const kHtHConfigurationKeyFrequency       = @"frequency";
+NSString* const kHtHConfigurationKeyLEDState        = @"LEDState";
+NSString* const kHtHConfigurationKeyThreshold       = @"threshold";
+NSString* const kHtHConfigurationKeyConfig          = @"config";
+
+static NSString* const kHtHConfigurationRecordConfiguration = @"configuration";
+static NSString* const kHtHConfigurationRecordPeripheral    = @"peripheral";
+
+#pragma mark - Configuration session
+
+// Connects to a sensor, writes a batch of characteristics and reads all of them back once.
+@interface HtHConfigurationSession : NSObject <CBCentralManagerDelegate,CBPeripheralDelegate>
+- (instancetype)initWithSensorID:(NSData*)sensorID peripheralID:(NSUUID*)peripheralID writes:(NSDictionary*)writes timeout:(NSTimeInterval)timeout completion:(void (^)(NSError* error, NSUUID* peripheralID))completion;
+- (void)start;
+@end
+
+@implementation HtHConfigurationSession
+{
+    NSData* _sensorID;
+    NSUUID* _peripheralID;
+    NSDictionary* _writes;          // CBUUID -> NSData
+    NSMutableSet* _pendingWrites;   // CBUUID
+    NSMutableSet* _pendingReads;    // CBUUID
+    NSMutableSet* _rejected;        // NSUUID of peripherals that turned out to be other sensors
+    NSTimeInterval _timeout;
+    void (^_completion)(NSError* error, NSUUID* peripheralID);
+    CBCentralManager* _central;
+    CBPeripheral* _peripheral;
+    BOOL _identified;
+}
+
+- (instancetype)initWithSensorID:(NSData*)sensorID peripheralID:(NSUUID*)peripheralID writes:(NSDictionary*)writes timeout:(NSTimeInterval)timeout completion:(void (^)(NSError* error, NSUUID* peripheralID))completion
+{
+    self = [super init];
+    if (self)
+    {
+        _sensorID = sensorID;
+        _peripheralID = peripheralID;
+        _writes = writes.copy;
+        _pendingWrites = [NSMutableSet setWithArray:writes.allKeys];
+        _pendingReads = [[NSMutableSet alloc] init];
+        _rejected = [[NSMutableSet alloc] init];
+        _timeout = timeout;
+        _completion = [completion copy];
+    }
+    return self;
+}
+
+- (void)start
+{
+    _central = [[CBCentralManager alloc] initWithDelegate:self queue:nil];
+
+    __weak HtHConfigurationSession* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_timeout * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [weakSelf finishWithError:RelayrErrorTimeoutExpired];
+    });
+}
+
+- (void)finishWithError:(NSError*)error
+{
+    if (!_completion) { return; }
+    void (^completion)(NSError*, NSUUID*) = _completion;
+    _completion = nil;
+
+    [_central stopScan];
+    if (_peripheral) { [_central cancelPeripheralConnection:_peripheral]; }
+    completion(error, (_identified) ? _peripheral.identifier : nil);
+}
+
+- (void)centralManagerDidUpdateState:(CBCentralManager*)central
+{
+    if (central.state == CBCentralManagerStateUnknown || central.state == CBCentralManagerStateResetting) { return; }
+    if (central.state != CBCentralManagerStatePoweredOn) { return [self finishWithError:RelayrErrorSystemNotSupported]; }
+
+    // A remembered sensor needs no scan at all.
+    CBPeripheral* known = (_peripheralID) ? [central retrievePeripheralsWithIdentifiers:@[_peripheralID]].firstObject : nil;
+    if (known) { return [self connectPeripheral:known]; }
+    [self scan];
+}
+
+- (void)scan
+{
+    [_central scanForPeripheralsWithServices:@[[CBUUID UUIDWithString:HtHConfiguration_directService]] options:nil];
+}
+
+- (void)centralManager:(CBCentralManager*)central didDiscoverPeripheral:(CBPeripheral*)peripheral advertisementData:(NSDictionary*)advertisementData RSSI:(NSNumber*)RSSI
+{
+    if (_peripheral || [_rejected containsObject:peripheral.identifier]) { return; }
+    [central stopScan];
+    [self connectPeripheral:peripheral];
+}
+
+- (void)connectPeripheral:(CBPeripheral*)peripheral
+{
+    _peripheral = peripheral;
+    _peripheral.delegate = self;
+    [_central connectPeripheral:peripheral options:nil];
+}
+
+// The peripheral is another sensor (or unreachable): it is skipped and the scan goes on.
+- (void)rejectPeripheral
+{
+    CBPeripheral* peripheral = _peripheral;
+    _peripheral = nil;
+    if (!peripheral) { return; }
+
+    [_rejected addObject:peripheral.identifier];
+    [_central cancelPeripheralConnection:peripheral];
+    [self scan];
+}
+
+- (void)centralManager:(CBCentralManager*)central didConnectPeripheral:(CBPeripheral*)peripheral
+{
+    [peripheral discoverServices:@[[CBUUID UUIDWithString:HtHConfiguration_directService]]];
+}
+
+- (void)centralManager:(CBCentralManager*)central didFailToConnectPeripheral:(CBPeripheral*)peripheral error:(NSError*)error
+{
+    if (peripheral == _peripheral) { [self rejectPeripheral]; }
+}
+
+- (void)centralManager:(CBCentralManager*)central didDisconnectPeripheral:(CBPeripheral*)peripheral error:(NSError*)error
+{
+    if (peripheral != _peripheral) { return; }
+    if (_identified) { return [self finishWithError:(error) ? error : RelayrErrorUnknwon]; }
+    [self rejectPeripheral];
+}
+
+- (void)peripheral:(CBPeripheral*)peripheral didDiscoverServices:(NSError*)error
+{
+    CBService* service = peripheral.services.firstObject;
+    if (error || !service) { return [self rejectPeripheral]; }
+    [peripheral discoverCharacteristics:[_writes.allKeys arrayByAddingObject:[CBUUID UUIDWithString:HtHConfiguration_sensorID]] forService:service];
+}
+
+- (void)peripheral:(CBPeripheral*)peripheral didDiscoverCharacteristicsForService:(CBService*)service error:(NSError*)error
+{
+    if (error) { return [self rejectPeripheral]; }
+
+    CBUUID* sensorID = [CBUUID UUIDWithString:HtHConfiguration_sensorID];
+    for (CBCharacteristic* characteristic in service.characteristics)
+    {
+        if ([characteristic.UUID isEqual:sensorID]) { return [peripheral readValueForCharacteristic:characteristic]; }
+    }
+    [self rejectPeripheral];
+}
+
+- (void)peripheral:(CBPeripheral*)peripheral didUpdateValueForCharacteristic:(CBCharacteristic*)characteristic error:(NSError*)error
+{
+    if (!_identified)
+    {
+        if (error || ![characteristic.UUID isEqual:[CBUUID UUIDWithString:HtHConfiguration_sensorID]]) { return [self rejectPeripheral]; }
+        if (!_sensorID || ![characteristic.value isEqualToData:_sensorID]) { return [self rejectPeripheral]; }
+        _identified = YES;
+        return [self writeCharacteristicsOfService:characteristic.service];
+    }
+
+    if (![_pendingReads containsObject:characteristic.UUID]) { return; }
+    if (error) { return [self finishWithError:error]; }
+    if (![characteristic.value isEqualToData:_writes[characteristic.UUID]]) { return [self finishWithError:RelayrErrorMissingExpectedValue]; }
+
+    [_pendingReads removeObject:characteristic.UUID];
+    if (!_pendingReads.count) { [self finishWithError:nil]; }
+}
+
+// Nothing is written unless every target characteristic is there, so a sensor never ends up with half a configuration.
+- (void)writeCharacteristicsOfService:(CBService*)service
+{
+    NSMutableArray* targets = [[NSMutableArray alloc] initWithCapacity:_writes.count];
+    for (CBCharacteristic* characteristic in service.characteristics)
+    {
+        if (_writes[characteristic.UUID]) { [targets addObject:characteristic]; }
+    }
+    if (targets.count < _writes.count) { return [self finishWithError:RelayrErrorNoServiceAvailable]; }
+
+    for (CBCharacteristic* characteristic in targets)
+    {
+        [_peripheral writeValue:_writes[characteristic.UUID] forCharacteristic:characteristic type:CBCharacteristicWriteWithResponse];
+    }
+}
+
+- (void)peripheral:(CBPeripheral*)peripheral didWriteValueForCharacteristic:(CBCharacteristic*)characteristic error:(NSError*)error
+{
+    if (error) { return [self finishWithError:error]; }
+    [_pendingWrites removeObject:characteristic.UUID];
+    if (_pendingWrites.count) { return; }
+
+    // The whole batch is acknowledged; it is verified with one read-back pass.
+    for (CBCharacteristic* written in characteristic.service.characteristics)
+    {
+        if (!_writes[written.UUID]) { continue; }
+        [_pendingReads addObject:written.UUID];
+        [peripheral readValueForCharacteristic:written];
+    }
+}
+
+@end
+
+#pragma mark - Configuration sync
+
+@implementation HtHConfigurationSync
+{
+    NSURL* _fileURL;
+    NSMutableDictionary* _records;  // deviceID -> NSDictionary (configuration and peripheral)
+    NSMutableArray* _queued;        // Blocks starting a session
+    NSUInteger _activeCount;
+
+    NSUInteger _syncedCount;
+    NSUInteger _skippedCount;
+    NSUInteger _failedCount;
+    NSUInteger _fieldsCount;
+    NSUInteger _bytesCount;
+    NSUInteger _verifiedCount;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedSync
+{
+    static HtHConfigurationSync* sync;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ sync = [[HtHConfigurationSync alloc] init]; });
+    return sync;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        NSURL* support = [[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask].firstObject;
+        [[NSFileManager defaultManager] createDirectoryAtURL:support withIntermediateDirectories:YES attributes:nil error:nil];
+        _fileURL = [support URLByAppendingPathComponent:HtHConfiguration_file];
+        NSMutableDictionary* records = [[NSDictionary dictionaryWithContentsOfURL:_fileURL] mutableCopy];
+        _records = (records) ? records : [[NSMutableDictionary alloc] init];
+        _queued = [[NSMutableArray alloc] init];
+        _maximumConnections = HtHConfiguration_maximumConnections;
+        _timeout = HtHConfiguration_timeout;
+    }
+    return self;
+}
+
+- (NSDictionary*)currentConfigurationOfDevice:(RelayrDevice*)device
+{
+    if (!device.uid) { return @{}; }
+
+    NSDictionary* configuration = _records[device.uid][kHtHConfigurationRecordConfiguration];
+    if (!configuration) { configuration = device.firmware.configuration; }
+    return (configuration) ? configuration : @{};
+}
+
+- (NSDictionary*)deltaForDevice:(RelayrDevice*)device desiredConfiguration:(NSDictionary*)desired
+{
+    NSDictionary* current = [self currentConfigurationOfDevice:device];
+    NSMutableDictionary* result = [[NSMutableDictionary alloc] init];
+    [desired enumerateKeysAndObjectsUsingBlock:^(NSString* key, id value, BOOL* stop) {
+        if (![HtHConfigurationSync dataForValue:value key:key]) { return; }
+        if (![current[key] isEqual:value]) { result[key] = value; }
+    }];
+    return result;
+}
+
+- (void)applyConfiguration:(NSDictionary*)desired toDevices:(NSArray*)devices completion:(void (^)(NSDictionary* errors))completion
+{
+    NSMutableDictionary* errors = [[NSMutableDictionary alloc] init];
+    dispatch_group_t group = dispatch_group_create();
+
+    for (RelayrDevice* device in devices)
+    {
+        NSString* deviceID = device.uid;
+        NSDictionary* current = [self currentConfigurationOfDevice:device];
+        NSDictionary* delta = (deviceID) ? [self deltaForDevice:device desiredConfiguration:desired] : nil;
+        if (!delta.count) { _skippedCount++; continue; }
+
+        // Peripherals are identified by the device identifier; without it any sensor in range would be taken for the device.
+        NSUUID* uuid = [[NSUUID alloc] initWithUUIDString:deviceID];
+        if (!uuid)
+        {
+            _failedCount++;
+            errors[deviceID] = [RelayrErrors errorWithCode:kRelayrErrorCodeMissingExpectedValue localizedDescription:dRelayrErrorMessageMissingExpectedValue failureReason:@"The device identifier is not a UUID, so its sensor can't be recognised." userInfo:RelayrErrorUserInfoLocal];
+            continue;
+        }
+        uuid_t bytes;
+        [uuid getUUIDBytes:bytes];
+        NSData* sensorID = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+
+        NSMutableDictionary* writes = [[NSMutableDictionary alloc] init];
+        [delta enumerateKeysAndObjectsUsingBlock:^(NSString* key, id value, BOOL* stop) {
+            writes[[CBUUID UUIDWithString:[HtHConfigurationSync characteristics][key]]] = [HtHConfigurationSync dataForValue:value key:key];
+        }];
+        NSString* peripheral = _records[deviceID][kHtHConfigurationRecordPeripheral];
+        NSUUID* peripheralID = (peripheral) ? [[NSUUID alloc] initWithUUIDString:peripheral] : nil;
+
+        dispatch_group_enter(group);
+        __weak HtHConfigurationSync* weakSelf = self;
+        [_queued addObject:^{
+            __block HtHConfigurationSession* session = [[HtHConfigurationSession alloc] initWithSensorID:sensorID peripheralID:peripheralID writes:writes timeout:weakSelf.timeout completion:^(NSError* error, NSUUID* identifier) {
+                session = nil;  // The session keeps itself alive until it finishes.
+                HtHConfigurationSync* strongSelf = weakSelf;
+                if (strongSelf) { [strongSelf finishDeviceID:deviceID current:current delta:delta writes:writes peripheralID:identifier error:error]; }
+                if (error) { errors[deviceID] = error; }
+                dispatch_group_leave(group);
+            }];
+            [session start];
+        }];
+    }
+
+    [self pump];
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        if (completion) { completion(errors); }
+    });
+}
+
+- (NSDictionary*)metrics
+{
+    return @{
+        @"config.synced"    : @(_syncedCount),
+        @"config.skipped"   : @(_skippedCount),
+        @"config.failed"    : @(_failedCount),
+        @"config.fields"    : @(_fieldsCount),
+        @"config.bytes"     : @(_bytesCount),
+        @"config.verified"  : @(_verifiedCount)
+    };
+}
+
+#pragma mark - Private functionality
+
+// Characteristics of the sensors' direct service (the same identifiers as the SDK's Wunderbar_device_directCharacteristic_* constants, which live in a private header the app can't import).
++ (NSDictionary*)characteristics
+{
+    return @{
+        kHtHConfigurationKeyBeaconFrequency : @"2011",
+        kHtHConfigurationKeyFrequency       : @"2012",
+        kHtHConfigurationKeyLEDState        : @"2013",
+        kHtHConfigurationKeyThreshold       : @"2014",
+        kHtHConfigurationKeyConfig          : @"2015"
+    };
+}
+
+// Wire representation of a field or nil if the field is not supported.
+// The SDK only publishes the characteristic identifiers, not their formats, so the encodings are assumptions: frequencies are milliseconds as a little-endian uint32 (the byte order of the sensors' ARM cores), the LED state is a single byte (0 or 1), and threshold and config are opaque blobs passed through unchanged.
+// Every session reads the characteristics back after writing them, so a sensor that stores a different format shows up as a failed verification instead of a silent misconfiguration.
++ (NSData*)dataForValue:(id)value key:(NSString*)key
+{
+    if ([key isEqualToString:kHtHConfigurationKeyFrequency] || [key isEqualToString:kHtHConfigurationKeyBeaconFrequency])
+    {
+        if (![value isKindOfClass:[NSNumber class]]) { return nil; }
+        uint32_t const milliseconds = CFSwapInt32HostToLittle(((NSNumber*)value).unsignedIntValue);
+        return [NSData dataWithBytes:&milliseconds length:sizeof(milliseconds)];
+    }
+    if ([key isEqualToString:kHtHConfigurationKeyLEDState])
+    {
+        if (![value isKindOfClass:[NSNumber class]]) { return nil; }
+        uint8_t const state = ((NSNumber*)value).boolValue;
+        return [NSData dataWithBytes:&state length:sizeof(state)];
+    }
+    if ([key isEqualToString:kHtHConfigurationKeyThreshold] || [key isEqualToString:kHtHConfigurationKeyConfig])
+    {
+        return ([value isKindOfClass:[NSData class]] && ((NSData*)value).length) ? value : nil;
+    }
+    return nil;
+}
+
+- (void)pump
+{
+    NSUInteger const maximum = MAX(self.maximumConnections, (NSUInteger)1);
+    while (_activeCount < maximum && _queued.count)
+    {
+        void (^start)(void) = _queued.firstObject;
+        [_queued removeObjectAtIndex:0];
+        _activeCount++;
+        start();
+    }
+}
+
+- (void)finishDeviceID:(NSString*)deviceID current:(NSDictionary*)current delta:(NSDictionary*)delta writes:(NSDictionary*)writes peripheralID:(NSUUID*)peripheralID error:(NSError*)error
+{
+    _activeCount--;
+    _fieldsCount += writes.count;
+    for (NSData* data in writes.allValues) { _bytesCount += data.length; }
+
+    if (error)
+    {
+        _failedCount++;
+    }
+    else
+    {
+        NSMutableDictionary* record = [NSMutableDictionary dictionaryWithDictionary:(_records[deviceID]) ? _records[deviceID] : @{}];
+        NSMutableDictionary* configuration = [NSMutableDictionary dictionaryWithDictionary:(record[kHtHConfigurationRecordConfiguration]) ? record[kHtHConfigurationRecordConfiguration] : current];
+        [configuration addEntriesFromDictionary:delta];
+        record[kHtHConfigurationRecordConfiguration] = configuration;
+        if (peripheralID) { record[kHtHConfigurationRecordPeripheral] = peripheralID.UUIDString; }
+        _records[deviceID] = record;
+        [_records writeToURL:_fileURL atomically:YES];
+
+        _syncedCount++;
+        _verifiedCount += writes.count;
+    }
+
+    [self pump];
+}
+
+@end
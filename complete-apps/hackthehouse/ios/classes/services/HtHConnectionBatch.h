@@ -0,0 +1,59 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract Change of the connection state of a single device.
+ */
+@interface HtHConnectionTransition : NSObject
+
+- (instancetype)initWithDeviceID:(NSString*)deviceID previousState:(RelayrConnectionState)previousState currentState:(RelayrConnectionState)currentState date:(NSDate*)date;
+
+@property (readonly,nonatomic) NSString* deviceID;
+@property (readonly,nonatomic) RelayrConnectionState previousState;
+@property (readonly,nonatomic) RelayrConnectionState currentState;
+
+/*!
+ *  @abstract Date of the last change coalesced into this transition.
+ */
+@property (readonly,nonatomic) NSDate* date;
+
+@end
+
+/*!
+ *  @abstract Group of connection transitions of a fleet coalesced over a short period of time.
+ *  @discussion Every device appears at most once, going from the state it had before the batch to the state it has at the end of it. Devices that went back to their original state within the batch (flapping) are only counted.
+ */
+@interface HtHConnectionBatch : NSObject
+
+- (instancetype)initWithTransitions:(NSArray*)transitions flapCount:(NSUInteger)flapCount fleetSize:(NSUInteger)fleetSize massDisconnectRatio:(double)massDisconnectRatio;
+
+/*!
+ *  @abstract Array of <code>HtHConnectionTransition</code> objects.
+ */
+@property (readonly,nonatomic) NSArray* transitions;
+
+/*!
+ *  @abstract Number of transitions per current state (<code>NSNumber</code> with a <code>RelayrConnectionState</code> -> <code>NSNumber</code>).
+ */
+@property (readonly,nonatomic) NSDictionary* countsByState;
+
+@property (readonly,nonatomic) NSUInteger connectedCount;
+@property (readonly,nonatomic) NSUInteger disconnectedCount;
+@property (readonly,nonatomic) NSUInteger flapCount;
+
+/*!
+ *  @abstract Number of devices monitored when the batch was produced.
+ */
+@property (readonly,nonatomic) NSUInteger fleetSize;
+
+/*!
+ *  @abstract Whether the devices disconnected in this batch are, at least, the mass disconnect ratio of the fleet (e.g.: a broker outage).
+ */
+@property (readonly,nonatomic,getter=isMassDisconnect) BOOL massDisconnect;
+
+/*!
+ *  @abstract One line human readable summary of the batch.
+ */
+@property (readonly,nonatomic) NSString* summary;
+
+@end
@@ -0,0 +1,71 @@
+#import "HtHConnectionBatch.h"  // Header
+
+@implementation HtHConnectionTransition
+
+- (instancetype)initWithDeviceID:(NSString*)deviceID previousState:(RelayrConnectionState)previousState currentState:(RelayrConnectionState)currentState date:(NSDate*)date
+{
+    if (!deviceID.length) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _deviceID = deviceID.copy;
+        _previousState = previousState;
+        _currentState = currentState;
+        _date = (date) ? date : [NSDate date];
+    }
+    return self;
+}
+
+- (NSString*)description
+{
+    return [NSString stringWithFormat:@"%@: %lu -> %lu", _deviceID, (unsigned long)_previousState, (unsigned long)_currentState];
+}
+
+@end
+
+@implementation HtHConnectionBatch
+
+- (instancetype)initWithTransitions:(NSArray*)transitions flapCount:(NSUInteger)flapCount fleetSize:(NSUInteger)fleetSize massDisconnectRatio:(double)massDisconnectRatio
+{
+    self = [super init];
+    if (self)
+    {
+        _transitions = (transitions) ? transitions.copy : @[];
+        _flapCount = flapCount;
+        _fleetSize = fleetSize;
+
+        NSUInteger counts[RelayrConnectionStateDisconnected + 1] = { 0 };
+        for (HtHConnectionTransition* transition in _transitions)
+        {
+            if (transition.currentState <= RelayrConnectionStateDisconnected) { counts[transition.currentState]++; }
+        }
+
+        NSMutableDictionary* countsByState = [[NSMutableDictionary alloc] init];
+        for (NSUInteger state = 0; state <= RelayrConnectionStateDisconnected; ++state)
+        {
+            if (counts[state]) { countsByState[@(state)] = @(counts[state]); }
+        }
+        _countsByState = countsByState;
+        _connectedCount = counts[RelayrConnectionStateConnected];
+        _disconnectedCount = counts[RelayrConnectionStateDisconnected];
+
+        // A single device going down is never a "mass" event, however small the fleet is.
+        _massDisconnect = (_disconnectedCount > 1 && fleetSize && (double)_disconnectedCount >= massDisconnectRatio * fleetSize);
+    }
+    return self;
+}
+
+- (NSString*)summary
+{
+    return [NSString stringWithFormat:@"%@%lu transitions in a fleet of %lu: %lu connected, %lu disconnected, %lu flapping",
+        (_massDisconnect) ? @"Mass disconnect! " : @"",
+        (unsigned long)_transitions.count, (unsigned long)_fleetSize, (unsigned long)_connectedCount, (unsigned long)_disconnectedCount, (unsigned long)_flapCount];
+}
+
+- (NSString*)description
+{
+    return self.summary;
+}
+
+@end
@@ -0,0 +1,70 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+#import "HtHDeviceShadow.h" // HtH
+
+/*!
+ *  @abstract Aggregated result of a command sent to a group.
+ */
+@interface HtHGroupResult : NSObject
+
+/*!
+ *  @abstract <code>deviceID</code> -> <code>NSNumber</code> with the <code>HtHShadowOutcome</code> of every member.
+ */
+@property (readonly,nonatomic) NSDictionary* outcomes;
+
+/*!
+ *  @abstract <code>deviceID</code> -> <code>NSError</code> of the members that failed.
+ */
+@property (readonly,nonatomic) NSDictionary* errors;
+
+@property (readonly,nonatomic) NSUInteger succeededCount;
+@property (readonly,nonatomic) NSUInteger suppressedCount;
+@property (readonly,nonatomic) NSUInteger failedCount;
+
+/*!
+ *  @abstract Seconds from the moment the command was sent to the outcome of the slowest member.
+ */
+@property (readonly,nonatomic) NSTimeInterval latency;
+
+@end
+
+/*!
+ *  @abstract Named set of devices that receive commands as a unit.
+ *  @discussion A command is sent to all members concurrently through their <code>HtHDeviceShadow</code> (so members already in the desired state are skipped). Members are identified by their <code>uid</code>: devices without one are left out and devices sharing one count as a single member.
+ *  Completion blocks are executed on the main queue.
+ */
+@interface HtHDeviceGroup : NSObject
+
+- (instancetype)initWithName:(NSString*)name devices:(NSSet*)devices;
+
+/*!
+ *  @abstract Group with all devices of a user able to execute a command meaning (e.g.: all LEDs).
+ */
++ (instancetype)groupWithName:(NSString*)name user:(RelayrUser*)user commandMeaning:(NSString*)meaning;
+
+@property (readonly,nonatomic) NSString* name;
+
+/*!
+ *  @abstract Set of <code>RelayrDevice</code> objects.
+ */
+@property (readonly,nonatomic) NSSet* devices;
+
+- (void)addDevice:(RelayrDevice*)device;
+
+- (void)removeDevice:(RelayrDevice*)device;
+
+/*!
+ *  @abstract Maximum number of commands in flight when sending per device. Default: 16.
+ */
+@property (atomic) NSUInteger maximumConcurrency;
+
+/*!
+ *  @abstract Sends a command to all members.
+ *
+ *  @param meaning Command meaning.
+ *  @param value Command value.
+ *  @param completion Block executed once all members have an outcome. It can be <code>nil</code>.
+ */
+- (void)sendCommandWithMeaning:(NSString*)meaning value:(id)value completion:(void (^)(HtHGroupResult* result))completion;
+
+@end
@@ -0,0 +1,171 @@
+#import "HtHDeviceGroup.h"  // Header
+
+#define HtHDeviceGroup_maximumConcurrency   16
+
+@implementation HtHGroupResult
+
+- (instancetype)initWithOutcomes:(NSDictionary*)outcomes errors:(NSDictionary*)errors latency:(NSTimeInterval)latency
+{
+    self = [super init];
+    if (self)
+    {
+        _outcomes = outcomes.copy;
+        _errors = errors.copy;
+        _latency = latency;
+
+        for (NSNumber* outcome in _outcomes.allValues)
+        {
+            switch (outcome.unsignedIntegerValue)
+            {
+                case HtHShadowOutcomeSuppressed: _suppressedCount++; break;
+                case HtHShadowOutcomeFailed: _failedCount++; break;
+                default: _succeededCount++; break;
+            }
+        }
+    }
+    return self;
+}
+
+- (NSString*)description
+{
+    return [NSString stringWithFormat:@"%lu succeeded, %lu suppressed, %lu failed in %.3f s", (unsigned long)_succeededCount, (unsigned long)_suppressedCount, (unsigned long)_failedCount, _latency];
+}
+
+@end
+
+// State of a command being sent to every member of a group.
+@interface HtHFanOut : NSObject
+@property (strong,nonatomic) NSString* meaning;
+@property (strong,nonatomic) id value;
+@property (strong,nonatomic) NSMutableArray* queued;
+@property (nonatomic) NSUInteger total;
+@property (nonatomic) NSUInteger completed;
+@property (strong,nonatomic) NSMutableDictionary* outcomes;
+@property (strong,nonatomic) NSMutableDictionary* errors;
+@property (nonatomic) CFAbsoluteTime start;
+@property (copy,nonatomic) void (^completion)(HtHGroupResult* result);
+@end
+
+@implementation HtHFanOut
+@end
+
+@implementation HtHDeviceGroup
+{
+    dispatch_queue_t _queue;
+    NSMutableSet* _devices;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithName:(NSString*)name devices:(NSSet*)devices
+{
+    if (!name.length) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _name = name.copy;
+        _devices = [[NSMutableSet alloc] init];
+        for (RelayrDevice* device in devices) { if (device.uid) { [_devices addObject:device]; } }
+        _queue = dispatch_queue_create("io.relayr.hth.group", DISPATCH_QUEUE_SERIAL);
+        _maximumConcurrency = HtHDeviceGroup_maximumConcurrency;
+    }
+    return self;
+}
+
++ (instancetype)groupWithName:(NSString*)name user:(RelayrUser*)user commandMeaning:(NSString*)meaning
+{
+    if (!user || !meaning.length) { return nil; }
+    return [[HtHDeviceGroup alloc] initWithName:name devices:[user devicesWithCommandMeanings:@[meaning]]];
+}
+
+- (NSSet*)devices
+{
+    __block NSSet* result;
+    dispatch_sync(_queue, ^{ result = _devices.copy; });
+    return result;
+}
+
+- (void)addDevice:(RelayrDevice*)device
+{
+    if (!device.uid) { return; }
+    dispatch_async(_queue, ^{ [_devices addObject:device]; });
+}
+
+- (void)removeDevice:(RelayrDevice*)device
+{
+    if (!device) { return; }
+    dispatch_async(_queue, ^{ [_devices removeObject:device]; });
+}
+
+- (void)sendCommandWithMeaning:(NSString*)meaning value:(id)value completion:(void (^)(HtHGroupResult* result))completion
+{
+    if (!meaning.length || !value) { return; }
+
+    CFAbsoluteTime const start = CFAbsoluteTimeGetCurrent();
+    dispatch_async(_queue, ^{
+        // Distinct device objects may share a uid; every uid gets a single command and a single outcome.
+        NSMutableDictionary* members = [[NSMutableDictionary alloc] initWithCapacity:_devices.count];
+        for (RelayrDevice* device in _devices) { if (device.uid) { members[device.uid] = device; } }
+
+        NSArray* devices = members.allValues;
+        if (!devices.count)
+        {
+            if (completion) { dispatch_async(dispatch_get_main_queue(), ^{ completion([[HtHGroupResult alloc] initWithOutcomes:@{} errors:@{} latency:0.0]); }); }
+            return;
+        }
+        [self fanOutMeaning:meaning value:value devices:devices start:start completion:completion];
+    });
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the group's queue.
+- (void)fanOutMeaning:(NSString*)meaning value:(id)value devices:(NSArray*)devices start:(CFAbsoluteTime)start completion:(void (^)(HtHGroupResult* result))completion
+{
+    HtHFanOut* fanOut = [[HtHFanOut alloc] init];
+    fanOut.meaning = meaning;
+    fanOut.value = value;
+    fanOut.queued = devices.mutableCopy;
+    fanOut.total = devices.count;
+    fanOut.outcomes = [[NSMutableDictionary alloc] initWithCapacity:devices.count];
+    fanOut.errors = [[NSMutableDictionary alloc] init];
+    fanOut.start = start;
+    fanOut.completion = completion;
+
+    NSUInteger const concurrency = MAX(self.maximumConcurrency, (NSUInteger)1);
+    for (NSUInteger i = 0; i < concurrency; ++i) { [self sendNext:fanOut]; }
+}
+
+// It must be called from the group's queue.
+- (void)sendNext:(HtHFanOut*)fanOut
+{
+    RelayrDevice* device = fanOut.queued.lastObject;
+    if (!device) { return; }
+    [fanOut.queued removeLastObject];
+
+    NSString* deviceID = device.uid;
+    HtHDeviceShadow* shadow = [HtHDeviceShadow shadowForDevice:device];
+    if (!shadow) { return [self recordOutcome:HtHShadowOutcomeFailed error:RelayrErrorMissingObjectPointer deviceID:deviceID fanOut:fanOut]; }
+
+    // Every outcome starts the next queued device, keeping at most "maximumConcurrency" commands in flight.
+    [shadow setDesiredValue:fanOut.value forMeaning:fanOut.meaning completion:^(HtHShadowOutcome outcome, NSTimeInterval latency, NSError* error) {
+        dispatch_async(_queue, ^{ [self recordOutcome:outcome error:error deviceID:deviceID fanOut:fanOut]; });
+    }];
+}
+
+// It must be called from the group's queue.
+- (void)recordOutcome:(HtHShadowOutcome)outcome error:(NSError*)error deviceID:(NSString*)deviceID fanOut:(HtHFanOut*)fanOut
+{
+    fanOut.completed++;
+    if (deviceID) { fanOut.outcomes[deviceID] = @(outcome); }
+    if (deviceID && error) { fanOut.errors[deviceID] = error; }
+
+    if (fanOut.completed < fanOut.total) { return [self sendNext:fanOut]; }
+
+    HtHGroupResult* result = [[HtHGroupResult alloc] initWithOutcomes:fanOut.outcomes errors:fanOut.errors latency:CFAbsoluteTimeGetCurrent() - fanOut.start];
+    void (^completion)(HtHGroupResult*) = fanOut.completion;
+    if (completion) { dispatch_async(dispatch_get_main_queue(), ^{ completion(result); }); }
+}
+
+@end
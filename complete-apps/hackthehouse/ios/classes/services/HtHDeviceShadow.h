@@ -0,0 +1,88 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract What happened to a desired value.
+ *
+ *  @constant HtHShadowOutcomeSuppressed The value was already reported (or already on its way) so no command was sent.
+ *  @constant HtHShadowOutcomeConfirmed The command was sent and the device reported the value.
+ *  @constant HtHShadowOutcomeAcknowledged The command was accepted by the cloud, but the device has no reading to confirm it.
+ *  @constant HtHShadowOutcomeSuperseded A newer desired value replaced this one before it was confirmed.
+ *  @constant HtHShadowOutcomeFailed The command couldn't be sent.
+ */
+typedef NS_ENUM(NSUInteger, HtHShadowOutcome) {
+    HtHShadowOutcomeSuppressed,
+    HtHShadowOutcomeConfirmed,
+    HtHShadowOutcomeAcknowledged,
+    HtHShadowOutcomeSuperseded,
+    HtHShadowOutcomeFailed
+};
+
+/*!
+ *  @abstract Block executed (on the main queue) once a desired value reaches a final outcome.
+ *
+ *  @param outcome The final outcome.
+ *  @param latency Seconds from the moment the value was desired to its outcome.
+ *  @param error The error when the outcome is <code>HtHShadowOutcomeFailed</code>.
+ */
+typedef void (^HtHShadowCompletionBlock)(HtHShadowOutcome outcome, NSTimeInterval latency, NSError* error);
+
+/*!
+ *  @abstract Desired and reported state of a device.
+ *  @discussion The reported state is fed by the shared <code>HtHReadingHub</code>. Setting a desired state only sends commands for the meanings whose desired value differs from the reported (or in flight) one.
+ *  Desired values that are property lists are persisted (others are kept in memory only), thus <code>reconcile</code> can re-send whatever hasn't been applied after a relaunch or reconnection.
+ */
+@interface HtHDeviceShadow : NSObject
+
+/*!
+ *  @abstract Shadow shared by everybody driving the device passed.
+ *  @discussion The shadow (and its hub subscription, which feeds the reported state in the <code>HtHSubscriptionClassRules</code> class) lives while somebody holds it or while any value is in flight; afterwards it is released and a later call creates a new one from the persisted desired state and the last reading values the SDK holds for the device. Hold the returned object to keep the reported state between commands.
+ */
++ (instancetype)shadowForDevice:(RelayrDevice*)device;
+
+@property (readonly,weak,nonatomic) RelayrDevice* device;
+
+/*!
+ *  @abstract Reading meaning that reports each command meaning (e.g.: <code>@{ @"led" : @"ledState" }</code>). Command meanings not listed are reported by a reading with the same meaning.
+ */
+@property (copy,atomic) NSDictionary* reportedMeanings;
+
+/*!
+ *  @abstract Seconds to wait for the device to report a sent value. Default: 10.
+ */
+@property (atomic) NSTimeInterval confirmationTimeout;
+
+/*!
+ *  @abstract <code>meaning</code> -> value dictionaries.
+ */
+@property (readonly,nonatomic) NSDictionary* desiredState;
+@property (readonly,nonatomic) NSDictionary* reportedState;
+
+/*!
+ *  @abstract Meanings whose desired value hasn't been reported yet.
+ */
+@property (readonly,nonatomic) NSDictionary* delta;
+
+/*!
+ *  @abstract Sets the desired value of a command meaning and sends the command if needed.
+ *
+ *  @param completion Block executed with the outcome. It can be <code>nil</code>.
+ */
+- (void)setDesiredValue:(id)value forMeaning:(NSString*)meaning completion:(HtHShadowCompletionBlock)completion;
+
+/*!
+ *  @abstract Sets several desired values at once (<code>meaning</code> -> value). Only the differences are sent.
+ */
+- (void)setDesiredState:(NSDictionary*)state completion:(HtHShadowCompletionBlock)completion;
+
+/*!
+ *  @abstract Sends again the desired values that were neither reported nor are in flight.
+ */
+- (void)reconcile;
+
+/*!
+ *  @abstract Counters per outcome, desired values that couldn't be persisted, and latency statistics (mean, median and 95th percentile) of the confirmed values.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
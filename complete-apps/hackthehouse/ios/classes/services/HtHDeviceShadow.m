@@ -0,0 +1,341 @@
+#import "HtHDeviceShadow.h"     // Header
+#import "HtHReadingHub.h"       // HtH
+
+#define HtHDeviceShadow_confirmationTimeout 10.0
+#define HtHDeviceShadow_latencyCapacity     128
+#define HtHDeviceShadow_directory           @"Shadows"
+
+@interface HtHShadowRequest : NSObject
+@property (strong,nonatomic) id value;
+@property (nonatomic) CFAbsoluteTime started;
+@property (strong,nonatomic) NSMutableArray* completions;
+@end
+
+@implementation HtHShadowRequest
+@end
+
+// Numbers are compared by value, so 1, 1.0 and YES are the same desired state.
+static BOOL HtHShadowValuesEqual(id a, id b)
+{
+    if (a == b) { return YES; }
+    if ([a isKindOfClass:[NSNumber class]] && [b isKindOfClass:[NSNumber class]]) { return [a doubleValue] == [b doubleValue]; }
+    return [a isEqual:b];
+}
+
+@implementation HtHDeviceShadow
+{
+    dispatch_queue_t _queue;
+    NSString* _deviceID;
+    NSURL* _fileURL;
+    HtHSubscription* _subscription;
+    NSMutableDictionary* _desired;      // command meaning -> value
+    NSMutableDictionary* _reported;     // reading meaning -> value
+    NSMutableDictionary* _inflight;     // command meaning -> HtHShadowRequest
+    NSUInteger _counts[HtHShadowOutcomeFailed + 1];
+    NSUInteger _sentCount;
+    NSUInteger _unpersistedCount;
+    NSUInteger _persistFailuresCount;
+    double _latencies[HtHDeviceShadow_latencyCapacity];
+    NSUInteger _latenciesCount;
+}
+
+#pragma mark - Public API
+
++ (instancetype)shadowForDevice:(RelayrDevice*)device
+{
+    if (!device.uid) { return nil; }
+
+    NSMapTable* shadows = [HtHDeviceShadow shadows];
+    @synchronized(shadows)
+    {
+        HtHDeviceShadow* shadow = [shadows objectForKey:device.uid];
+        if (!shadow) { shadow = [[HtHDeviceShadow alloc] initWithDevice:device]; [shadows setObject:shadow forKey:device.uid]; }
+        return shadow;
+    }
+}
+
+- (instancetype)initWithDevice:(RelayrDevice*)device
+{
+    if (!device.uid) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _device = device;
+        _deviceID = device.uid;
+        _queue = dispatch_queue_create("io.relayr.hth.shadow", DISPATCH_QUEUE_SERIAL);
+        _confirmationTimeout = HtHDeviceShadow_confirmationTimeout;
+        _reported = [HtHDeviceShadow reportedStateOfDevice:device];
+        _inflight = [[NSMutableDictionary alloc] init];
+
+        NSURL* support = [[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask].firstObject;
+        NSURL* directory = [support URLByAppendingPathComponent:HtHDeviceShadow_directory isDirectory:YES];
+        [[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        _fileURL = [directory URLByAppendingPathComponent:[_deviceID stringByAppendingPathExtension:@"plist"]];
+        NSDictionary* desired = [NSDictionary dictionaryWithContentsOfURL:_fileURL];
+        _desired = (desired) ? desired.mutableCopy : [[NSMutableDictionary alloc] init];
+
+        __weak HtHDeviceShadow* weakSelf = self;
+        _subscription = [[HtHReadingHub sharedHub] subscribeToDevice:device meaning:nil subscriptionClass:HtHSubscriptionClassRules withBlock:^(HtHSample* sample, BOOL* unsubscribe) {
+            HtHDeviceShadow* strongSelf = weakSelf;
+            if (!strongSelf) { *unsubscribe = YES; return; }
+            [strongSelf reportSample:sample];
+        } error:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[HtHReadingHub sharedHub] unsubscribe:_subscription];
+}
+
+- (NSDictionary*)desiredState
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{ result = _desired.copy; });
+    return result;
+}
+
+- (NSDictionary*)reportedState
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{ result = _reported.copy; });
+    return result;
+}
+
+- (NSDictionary*)delta
+{
+    NSMutableDictionary* result = [[NSMutableDictionary alloc] init];
+    dispatch_sync(_queue, ^{
+        [_desired enumerateKeysAndObjectsUsingBlock:^(NSString* meaning, id value, BOOL* stop) {
+            if (!HtHShadowValuesEqual(value, _reported[[self reportedMeaningForMeaning:meaning]])) { result[meaning] = value; }
+        }];
+    });
+    return result;
+}
+
+- (void)setDesiredValue:(id)value forMeaning:(NSString*)meaning completion:(HtHShadowCompletionBlock)completion
+{
+    if (!value || !meaning.length) { return; }
+    [self setDesiredState:@{ meaning : value } completion:completion];
+}
+
+- (void)setDesiredState:(NSDictionary*)state completion:(HtHShadowCompletionBlock)completion
+{
+    if (!state.count) { return; }
+
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+    dispatch_async(_queue, ^{
+        [_desired addEntriesFromDictionary:state];
+        [self persistDesired];
+
+        [state enumerateKeysAndObjectsUsingBlock:^(NSString* meaning, id value, BOOL* stop) {
+            [self applyValue:value forMeaning:meaning since:now completion:completion];
+        }];
+    });
+}
+
+- (void)reconcile
+{
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+    dispatch_async(_queue, ^{
+        [_desired enumerateKeysAndObjectsUsingBlock:^(NSString* meaning, id value, BOOL* stop) {
+            if (!_inflight[meaning]) { [self applyValue:value forMeaning:meaning since:now completion:nil]; }
+        }];
+    });
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        NSUInteger const count = MIN(_latenciesCount, (NSUInteger)HtHDeviceShadow_latencyCapacity);
+        double sorted[HtHDeviceShadow_latencyCapacity];
+        memcpy(sorted, _latencies, count * sizeof(double));
+        qsort_b(sorted, count, sizeof(double), ^int(void const* a, void const* b) {
+            double const x = *(double const*)a, y = *(double const*)b;
+            return (x > y) - (x < y);
+        });
+
+        double mean = 0.0;
+        for (NSUInteger i = 0; i < count; ++i) { mean += sorted[i]; }
+
+        result = @{
+            @"shadow.sent"            : @(_sentCount),
+            @"shadow.suppressed"      : @(_counts[HtHShadowOutcomeSuppressed]),
+            @"shadow.confirmed"       : @(_counts[HtHShadowOutcomeConfirmed]),
+            @"shadow.acknowledged"    : @(_counts[HtHShadowOutcomeAcknowledged]),
+            @"shadow.superseded"      : @(_counts[HtHShadowOutcomeSuperseded]),
+            @"shadow.failed"          : @(_counts[HtHShadowOutcomeFailed]),
+            @"shadow.latency.mean"    : @((count) ? mean / count : 0.0),
+            @"shadow.latency.p50"     : @((count) ? sorted[count / 2] : 0.0),
+            @"shadow.latency.p95"     : @((count) ? sorted[MIN((NSUInteger)(count * 0.95), count - 1)] : 0.0),
+            @"shadow.persist.skipped" : @(_unpersistedCount),
+            @"shadow.persist.failed"  : @(_persistFailuresCount)
+        };
+    });
+    return result;
+}
+
+#pragma mark - Private functionality
+
+// Live shadows (device uid -> shadow). Values are weak: a shadow (and its hub subscription) goes away once nobody holds it and nothing is in flight.
++ (NSMapTable*)shadows
+{
+    static NSMapTable* shadows;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ shadows = [NSMapTable strongToWeakObjectsMapTable]; });
+    return shadows;
+}
+
+// Shadows with values in flight, which must outlive their callers until the values reach an outcome.
++ (NSMutableSet*)busyShadows
+{
+    static NSMutableSet* busy;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ busy = [[NSMutableSet alloc] init]; });
+    return busy;
+}
+
+// It must be called from the shadow's queue.
+- (void)updateBusy
+{
+    NSMutableSet* busy = [HtHDeviceShadow busyShadows];
+    @synchronized(busy)
+    {
+        if (_inflight.count) { [busy addObject:self]; } else { [busy removeObject:self]; }
+    }
+}
+
+// It must be called from the shadow's queue. Values that aren't property lists are kept in memory only.
+- (void)persistDesired
+{
+    NSMutableDictionary* persistable = [[NSMutableDictionary alloc] initWithCapacity:_desired.count];
+    [_desired enumerateKeysAndObjectsUsingBlock:^(NSString* meaning, id value, BOOL* stop) {
+        if ([NSPropertyListSerialization propertyList:value isValidForFormat:NSPropertyListBinaryFormat_v1_0]) { persistable[meaning] = value; } else { _unpersistedCount++; }
+    }];
+    if (![persistable writeToURL:_fileURL atomically:YES]) { _persistFailuresCount++; }
+}
+
+- (NSString*)reportedMeaningForMeaning:(NSString*)meaning
+{
+    NSString* reported = self.reportedMeanings[meaning];
+    return (reported) ? reported : meaning;
+}
+
+// It must be called from the shadow's queue.
+- (void)applyValue:(id)value forMeaning:(NSString*)meaning since:(CFAbsoluteTime)since completion:(HtHShadowCompletionBlock)completion
+{
+    HtHShadowRequest* request = _inflight[meaning];
+    if (request && HtHShadowValuesEqual(request.value, value))
+    {
+        if (completion) { [request.completions addObject:[completion copy]]; }
+        return;
+    }
+
+    if (HtHShadowValuesEqual(value, _reported[[self reportedMeaningForMeaning:meaning]]))
+    {
+        if (request) { [self finishMeaning:meaning outcome:HtHShadowOutcomeSuperseded error:nil]; }
+        return [self completeBlocks:(completion) ? @[completion] : nil outcome:HtHShadowOutcomeSuppressed latency:CFAbsoluteTimeGetCurrent() - since error:nil];
+    }
+
+    if (request) { [self finishMeaning:meaning outcome:HtHShadowOutcomeSuperseded error:nil]; }
+
+    request = [[HtHShadowRequest alloc] init];
+    request.value = value;
+    request.started = since;
+    request.completions = (completion) ? [NSMutableArray arrayWithObject:[completion copy]] : [[NSMutableArray alloc] init];
+    _inflight[meaning] = request;
+    [self updateBusy];
+    [self sendRequest:request forMeaning:meaning];
+}
+
+// It must be called from the shadow's queue.
+- (void)sendRequest:(HtHShadowRequest*)request forMeaning:(NSString*)meaning
+{
+    RelayrDevice* device = _device;
+    RelayrCommand* command = [device commandsWithMeanings:@[meaning]].anyObject;
+    if (!command) { return [self finishMeaning:meaning outcome:HtHShadowOutcomeFailed error:RelayrErrorMissingExpectedValue]; }
+
+    BOOL const confirmable = ([device readingsWithMeanings:@[[self reportedMeaningForMeaning:meaning]]].count > 0);
+    NSTimeInterval const timeout = self.confirmationTimeout;
+    _sentCount++;
+
+    __weak HtHDeviceShadow* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [command sendValue:request.value withCompletion:^(NSError* error) {
+            HtHDeviceShadow* strongSelf = weakSelf;
+            if (!strongSelf) { return; }
+
+            dispatch_async(strongSelf->_queue, ^{
+                if (strongSelf->_inflight[meaning] != request) { return; }
+                if (error) { return [strongSelf finishMeaning:meaning outcome:HtHShadowOutcomeFailed error:error]; }
+                if (!confirmable) { return [strongSelf finishMeaning:meaning outcome:HtHShadowOutcomeAcknowledged error:nil]; }
+
+                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC)), strongSelf->_queue, ^{
+                    if (strongSelf->_inflight[meaning] == request) { [strongSelf finishMeaning:meaning outcome:HtHShadowOutcomeFailed error:RelayrErrorTimeoutExpired]; }
+                });
+            });
+        }];
+    });
+}
+
+// The last values the SDK holds for the device's readings (the newest one per meaning), so a fresh shadow doesn't start with an empty reported state.
++ (NSMutableDictionary*)reportedStateOfDevice:(RelayrDevice*)device
+{
+    NSMutableDictionary* result = [[NSMutableDictionary alloc] init];
+    NSMutableDictionary* dates = [[NSMutableDictionary alloc] init];
+    for (RelayrReading* reading in device.readings)
+    {
+        if (!reading.meaning || !reading.value) { continue; }
+
+        NSDate* date = dates[reading.meaning];
+        if (date && reading.date && [reading.date compare:date] != NSOrderedDescending) { continue; }
+        result[reading.meaning] = reading.value;
+        if (reading.date) { dates[reading.meaning] = reading.date; }
+    }
+    return result;
+}
+
+- (void)reportSample:(HtHSample*)sample
+{
+    if (!sample.meaning || !sample.value) { return; }
+
+    dispatch_async(_queue, ^{
+        _reported[sample.meaning] = sample.value;
+
+        for (NSString* meaning in _inflight.allKeys)
+        {
+            HtHShadowRequest* request = _inflight[meaning];
+            if (![[self reportedMeaningForMeaning:meaning] isEqualToString:sample.meaning] || !HtHShadowValuesEqual(request.value, sample.value)) { continue; }
+            [self finishMeaning:meaning outcome:HtHShadowOutcomeConfirmed error:nil];
+        }
+    });
+}
+
+// It must be called from the shadow's queue.
+- (void)finishMeaning:(NSString*)meaning outcome:(HtHShadowOutcome)outcome error:(NSError*)error
+{
+    HtHShadowRequest* request = _inflight[meaning];
+    if (!request) { return; }
+    [_inflight removeObjectForKey:meaning];
+    [self updateBusy];
+
+    NSTimeInterval const latency = CFAbsoluteTimeGetCurrent() - request.started;
+    if (outcome == HtHShadowOutcomeConfirmed) { _latencies[_latenciesCount++ % HtHDeviceShadow_latencyCapacity] = latency; }
+    [self completeBlocks:request.completions outcome:outcome latency:latency error:error];
+}
+
+// It must be called from the shadow's queue.
+- (void)completeBlocks:(NSArray*)blocks outcome:(HtHShadowOutcome)outcome latency:(NSTimeInterval)latency error:(NSError*)error
+{
+    _counts[outcome]++;
+    if (!blocks.count) { return; }
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        for (HtHShadowCompletionBlock block in blocks) { block(outcome, latency, error); }
+    });
+}
+
+@end
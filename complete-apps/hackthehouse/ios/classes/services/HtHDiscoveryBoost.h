@@ -0,0 +1,34 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract Temporarily raises the beacon frequency of known sensors so scans find them sooner.
+ *  @discussion Boosts are reference counted per device: the first <code>beginBoostForDevices:</code> lowers the beacon interval of a device, and the last matching <code>endBoost:</code> restores it. A boost never outlives <code>maximumDuration</code>, to protect the sensors' batteries.
+ *  The new interval is sent over whichever path reaches the device: its <code>HtHDeviceShadow</code> if the device model has a beacon frequency command, or the generic command API otherwise. The interval restored afterwards is the one the device was running with (the shadow's desired or reported value, or the firmware configuration). Devices without a cloud connection, or whose interval is unknown, are left untouched: the new interval can only reach a sensor through the cloud (i.e. through the transmitter it is paired with).
+ */
+@interface HtHDiscoveryBoost : NSObject
+
++ (instancetype)sharedBoost;
+
+/*!
+ *  @abstract Beacon interval (in milliseconds) while boosted. Default: 100.
+ */
+@property (atomic) NSUInteger boostedInterval;
+
+/*!
+ *  @abstract Maximum seconds a device stays boosted. Default: 60.
+ */
+@property (atomic) NSTimeInterval maximumDuration;
+
+/*!
+ *  @abstract Boosts a set of <code>RelayrDevice</code> objects.
+ *  @discussion Scans should start from the completion block, so they don't race the commands lowering the beacon interval.
+ *
+ *  @param completion Block executed on the main queue once the boost commands of the devices have been acknowledged (or have failed/timed out). Devices that can't be boosted don't delay it. It can be <code>nil</code>.
+ *	@return An opaque token to end the boost.
+ */
+- (id)beginBoostForDevices:(NSSet*)devices completion:(void (^)(void))completion;
+
+- (void)endBoost:(id)token;
+
+@end
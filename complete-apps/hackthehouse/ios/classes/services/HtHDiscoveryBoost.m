@@ -0,0 +1,190 @@
+#import "HtHDiscoveryBoost.h"   // Header
+#import "HtHDeviceShadow.h"     // HtH
+
+#define HtHDiscoveryBoost_meaning           @"beaconFrequency"
+#define HtHDiscoveryBoost_boostedInterval   100
+#define HtHDiscoveryBoost_maximumDuration   60.0
+
+@interface HtHBoostEntry : NSObject
+@property (weak,nonatomic) RelayrDevice* device;
+@property (nonatomic) NSUInteger count;
+@property (nonatomic) NSUInteger generation;
+@property (strong,nonatomic) NSNumber* restoreInterval;
+@property (strong,nonatomic) NSMutableArray* waiters;   // Blocks run once the boost command is out (nil afterwards).
+@end
+
+@implementation HtHBoostEntry
+@end
+
+@implementation HtHDiscoveryBoost
+{
+    dispatch_queue_t _queue;
+    NSMutableDictionary* _entries;  // deviceID -> HtHBoostEntry
+    NSMutableDictionary* _tokens;   // token -> NSDictionary (deviceID -> NSNumber generation of the boost it holds)
+    NSUInteger _lastGeneration;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedBoost
+{
+    static HtHDiscoveryBoost* boost;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ boost = [[HtHDiscoveryBoost alloc] init]; });
+    return boost;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _queue = dispatch_queue_create("io.relayr.hth.boost", DISPATCH_QUEUE_SERIAL);
+        _entries = [[NSMutableDictionary alloc] init];
+        _tokens = [[NSMutableDictionary alloc] init];
+        _boostedInterval = HtHDiscoveryBoost_boostedInterval;
+        _maximumDuration = HtHDiscoveryBoost_maximumDuration;
+    }
+    return self;
+}
+
+- (id)beginBoostForDevices:(NSSet*)devices completion:(void (^)(void))completion
+{
+    BOOL hasDevices = NO;
+    for (RelayrDevice* device in devices) { if (device.uid) { hasDevices = YES; break; } }
+    if (!hasDevices) { if (completion) { dispatch_async(dispatch_get_main_queue(), completion); } return nil; }
+
+    NSUUID* token = [NSUUID UUID];
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_group_enter(group);
+    dispatch_async(_queue, ^{
+        NSMutableDictionary* generations = [[NSMutableDictionary alloc] initWithCapacity:devices.count];
+        for (RelayrDevice* device in devices)
+        {
+            if (!device.uid) { continue; }
+
+            HtHBoostEntry* entry = _entries[device.uid];
+            if (!entry)
+            {
+                if (device.connection.type != RelayrConnectionTypeCloud) { continue; }
+
+                // The value to restore is captured before boosting, since boosting through the shadow overwrites its desired state.
+                NSNumber* interval = [self currentIntervalOfDevice:device];
+                if (!interval) { continue; }
+
+                entry = [[HtHBoostEntry alloc] init];
+                entry.device = device;
+                entry.restoreInterval = interval;
+                entry.generation = ++_lastGeneration;
+                entry.waiters = [[NSMutableArray alloc] init];
+                _entries[device.uid] = entry;
+                [self sendInterval:self.boostedInterval toDevice:device completion:[self flushBlockForDeviceID:device.uid generation:entry.generation]];
+                [self scheduleExpirationForDeviceID:device.uid generation:entry.generation];
+            }
+            entry.count++;
+            generations[device.uid] = @(entry.generation);
+
+            // A boost started by an earlier token may still be on its way.
+            if (entry.waiters) { dispatch_group_enter(group); [entry.waiters addObject:^{ dispatch_group_leave(group); }]; }
+        }
+        _tokens[token] = generations;
+        dispatch_group_leave(group);
+    });
+
+    if (completion) { dispatch_group_notify(group, dispatch_get_main_queue(), completion); }
+    return token;
+}
+
+- (void)endBoost:(id)token
+{
+    if (!token) { return; }
+
+    dispatch_async(_queue, ^{
+        NSDictionary* generations = _tokens[token];
+        [_tokens removeObjectForKey:token];
+
+        [generations enumerateKeysAndObjectsUsingBlock:^(NSString* deviceID, NSNumber* generation, BOOL* stop) {
+            // Tokens of a boost that already expired don't count against a newer boost of the same device.
+            HtHBoostEntry* entry = _entries[deviceID];
+            if (!entry || entry.generation != generation.unsignedIntegerValue || --entry.count) { return; }
+            [self restoreDeviceID:deviceID];
+        }];
+    });
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the boost's queue.
+- (void)scheduleExpirationForDeviceID:(NSString*)deviceID generation:(NSUInteger)generation
+{
+    __weak HtHDiscoveryBoost* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.maximumDuration * NSEC_PER_SEC)), _queue, ^{
+        HtHDiscoveryBoost* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+
+        HtHBoostEntry* entry = strongSelf->_entries[deviceID];
+        if (entry && entry.generation == generation) { [strongSelf restoreDeviceID:deviceID]; }
+    });
+}
+
+// Block to be called (from any queue) once the boost command of an entry is out. It releases whoever waits on the boost.
+- (void (^)(void))flushBlockForDeviceID:(NSString*)deviceID generation:(NSUInteger)generation
+{
+    __weak HtHDiscoveryBoost* weakSelf = self;
+    return ^{
+        HtHDiscoveryBoost* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+
+        dispatch_async(strongSelf->_queue, ^{
+            HtHBoostEntry* entry = strongSelf->_entries[deviceID];
+            if (entry && entry.generation == generation) { [strongSelf flushWaitersOfEntry:entry]; }
+        });
+    };
+}
+
+// It must be called from the boost's queue.
+- (void)flushWaitersOfEntry:(HtHBoostEntry*)entry
+{
+    NSArray* waiters = entry.waiters;
+    entry.waiters = nil;
+    for (void (^waiter)(void) in waiters) { waiter(); }
+}
+
+// It must be called from the boost's queue. Outstanding tokens keep the generation of the removed entry, so ending them later does nothing.
+- (void)restoreDeviceID:(NSString*)deviceID
+{
+    HtHBoostEntry* entry = _entries[deviceID];
+    [_entries removeObjectForKey:deviceID];
+    [self flushWaitersOfEntry:entry];
+
+    RelayrDevice* device = entry.device;
+    if (device) { [self sendInterval:entry.restoreInterval.unsignedIntegerValue toDevice:device completion:nil]; }
+}
+
+// Beacon interval the device runs with: the shadow's desired value, then its reported value, then the firmware configuration. It is nil when unknown.
+- (NSNumber*)currentIntervalOfDevice:(RelayrDevice*)device
+{
+    HtHDeviceShadow* shadow = ([device commandsWithMeanings:@[HtHDiscoveryBoost_meaning]].count) ? [HtHDeviceShadow shadowForDevice:device] : nil;
+    id interval = shadow.desiredState[HtHDiscoveryBoost_meaning];
+    if (![interval isKindOfClass:[NSNumber class]]) { interval = shadow.reportedState[HtHDiscoveryBoost_meaning]; }
+    if (![interval isKindOfClass:[NSNumber class]]) { interval = device.firmware.configuration[HtHDiscoveryBoost_meaning]; }
+    return ([interval isKindOfClass:[NSNumber class]]) ? interval : nil;
+}
+
+// The completion is called once the shadow has the outcome of the command, or once the generic command has been sent (it isn't acknowledged).
+- (void)sendInterval:(NSUInteger)interval toDevice:(RelayrDevice*)device completion:(void (^)(void))completion
+{
+    if ([device commandsWithMeanings:@[HtHDiscoveryBoost_meaning]].count)
+    {
+        return [[HtHDeviceShadow shadowForDevice:device] setDesiredValue:@(interval) forMeaning:HtHDiscoveryBoost_meaning completion:^(HtHShadowOutcome outcome, NSTimeInterval latency, NSError* error) {
+            if (completion) { completion(); }
+        }];
+    }
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [device sendCommandToPath:nil meaning:HtHDiscoveryBoost_meaning value:@(interval)];
+        if (completion) { completion(); }
+    });
+}
+
+@end
@@ -0,0 +1,65 @@
+@import Foundation;     // Apple
+@class HtHReadingLog;   // HtH
+
+/*!
+ *  @abstract A Block executed with every batch of samples read from the log.
+ *
+ *  @param samples Array of <code>HtHSample</code> objects in log order.
+ *  @param offset Offset following the last sample of the batch (it is committed as the cursor once the block returns).
+ */
+typedef void (^HtHDurableSamplesBlock)(NSArray* samples, uint64_t offset);
+
+/*!
+ *  @abstract Named subscription over an <code>HtHReadingLog</code> whose position survives app restarts.
+ *  @discussion While resumed, the subscription reads the log from its cursor as fast as the block consumes the batches, and then keeps following new records.
+ *  After each batch the cursor is committed under the subscription name; a new subscription with the same name starts where the previous one left off.
+ *  A name never seen before starts at the end of the log (only new records are delivered).
+ */
+@interface HtHDurableSubscription : NSObject
+
+- (instancetype)initWithName:(NSString*)name log:(HtHReadingLog*)log;
+
+@property (readonly,nonatomic) NSString* name;
+@property (readonly,nonatomic) HtHReadingLog* log;
+
+/*!
+ *  @abstract Maximum number of samples per batch. Default: 512.
+ */
+@property (nonatomic) NSUInteger batchSize;
+
+/*!
+ *  @abstract Current position in the log.
+ */
+@property (readonly,atomic) uint64_t offset;
+
+@property (readonly,atomic,getter=isResumed) BOOL resumed;
+
+/*!
+ *  @abstract Starts (or restarts) delivering samples from the cursor.
+ *
+ *  @param queue Queue where the block is executed. If <code>nil</code>, the main queue is used.
+ *  @param block Block receiving the batches.
+ */
+- (void)resumeOnQueue:(dispatch_queue_t)queue withBlock:(HtHDurableSamplesBlock)block;
+
+/*!
+ *  @abstract Stops delivering samples. The cursor is kept.
+ */
+- (void)pause;
+
+/*!
+ *  @abstract Moves the cursor to the first record at or after the date.
+ */
+- (void)rewindToDate:(NSDate*)date;
+
+/*!
+ *  @abstract Moves the cursor to a specific offset.
+ */
+- (void)seekToOffset:(uint64_t)offset;
+
+/*!
+ *  @abstract Pauses the subscription and forgets its persisted cursor.
+ */
+- (void)remove;
+
+@end
@@ -0,0 +1,134 @@
+#import "HtHDurableSubscription.h"  // Header
+#import "HtHReadingLog.h"           // HtH
+
+#define HtHDurableSubscription_batchSize    512
+
+@interface HtHDurableSubscription ()
+@property (readwrite,atomic) uint64_t offset;
+@property (readwrite,atomic,getter=isResumed) BOOL resumed;
+@end
+
+@implementation HtHDurableSubscription
+{
+    dispatch_queue_t _readQueue;
+    dispatch_queue_t _deliveryQueue;
+    HtHDurableSamplesBlock _block;
+    id _observer;
+    BOOL _draining;     // Accessed only from _readQueue.
+    NSUInteger _generation;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithName:(NSString*)name log:(HtHReadingLog*)log
+{
+    if (!name.length || !log) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _name = name.copy;
+        _log = log;
+        _batchSize = HtHDurableSubscription_batchSize;
+        _readQueue = dispatch_queue_create("io.relayr.hth.durable", DISPATCH_QUEUE_SERIAL);
+
+        uint64_t cursor;
+        self.offset = ([log getCursor:&cursor forName:name]) ? cursor : log.nextOffset;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_log removeAppendObserver:_observer];
+}
+
+- (void)resumeOnQueue:(dispatch_queue_t)queue withBlock:(HtHDurableSamplesBlock)block
+{
+    if (!block) { return; }
+    [self pause];
+
+    dispatch_async(_readQueue, ^{
+        _block = [block copy];
+        _deliveryQueue = (queue) ? queue : dispatch_get_main_queue();
+        _generation++;
+        self.resumed = YES;
+
+        __weak HtHDurableSubscription* weakSelf = self;
+        _observer = [_log addAppendObserver:^(uint64_t nextOffset) {
+            HtHDurableSubscription* strongSelf = weakSelf;
+            if (strongSelf) { dispatch_async(strongSelf->_readQueue, ^{ [strongSelf drain]; }); }
+        }];
+        [self drain];
+    });
+}
+
+- (void)pause
+{
+    self.resumed = NO;
+    dispatch_async(_readQueue, ^{
+        [_log removeAppendObserver:_observer];
+        _observer = nil;
+        _block = nil;
+        _generation++;
+        _draining = NO;
+    });
+}
+
+- (void)rewindToDate:(NSDate*)date
+{
+    if (!date) { return; }
+    [self seekToOffset:[_log offsetForDate:date]];
+}
+
+- (void)seekToOffset:(uint64_t)offset
+{
+    dispatch_async(_readQueue, ^{
+        self.offset = offset;
+        [_log commitCursor:offset forName:_name];
+        _generation++;          // Any batch in flight belongs to the old position.
+        _draining = NO;
+        [self drain];
+    });
+}
+
+- (void)remove
+{
+    [self pause];
+    [_log removeCursorForName:_name];
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the read queue. Only one batch is in flight at a time; the next one is read when the block returns, so replay runs as fast as the consumer.
+- (void)drain
+{
+    if (_draining || !_block) { return; }
+
+    uint64_t next;
+    NSArray* samples = [_log samplesFromOffset:self.offset limit:_batchSize nextOffset:&next];
+    if (!samples.count)
+    {
+        // Skip the gap left by retention (or unreadable records) without delivering anything.
+        if (next != self.offset) { self.offset = next; [_log commitCursor:next forName:_name]; }
+        return;
+    }
+
+    _draining = YES;
+    NSUInteger const generation = _generation;
+    HtHDurableSamplesBlock block = _block;
+
+    dispatch_async(_deliveryQueue, ^{
+        block(samples, next);
+
+        dispatch_async(_readQueue, ^{
+            if (generation != _generation) { return; }
+            self.offset = next;
+            [_log commitCursor:next forName:_name];
+            _draining = NO;
+            [self drain];
+        });
+    });
+}
+
+@end
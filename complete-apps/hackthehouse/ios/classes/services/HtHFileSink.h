@@ -0,0 +1,28 @@
+@import Foundation;     // Apple
+#import "HtHSink.h"     // HtH
+
+/*!
+ *  @abstract Sink writing samples as newline delimited JSON files.
+ *  @discussion A new file is started when the current one reaches <code>maximumFileSize</code> bytes or <code>maximumFileAge</code> seconds. Files can be gzip compressed and only the newest <code>maximumFiles</code> files are kept in the directory.
+ */
+@interface HtHFileSink : NSObject <HtHSink>
+
+/*!
+ *  @abstract Creates a file sink.
+ *
+ *  @param directory Directory where the files are written. It is created if it doesn't exist.
+ *  @param compressed Whether the files are gzip compressed (<code>.jsonl.gz</code>) or plain text (<code>.jsonl</code>).
+ */
+- (instancetype)initWithDirectory:(NSURL*)directory compressed:(BOOL)compressed;
+
+@property (readonly,nonatomic) NSURL* directory;
+@property (readonly,nonatomic,getter=isCompressed) BOOL compressed;
+
+/*!
+ *  @abstract Defaults: 8 MB, one hour and 24 files.
+ */
+@property (atomic) unsigned long long maximumFileSize;
+@property (atomic) NSTimeInterval maximumFileAge;
+@property (atomic) NSUInteger maximumFiles;
+
+@end
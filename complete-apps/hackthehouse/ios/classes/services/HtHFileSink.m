@@ -0,0 +1,134 @@
+#import "HtHFileSink.h"     // Header
+#import "HtHSample.h"       // HtH
+#import <zlib.h>            // libz
+
+#define HtHFileSink_maximumFileSize (8 * 1024 * 1024)
+#define HtHFileSink_maximumFileAge  3600.0
+#define HtHFileSink_maximumFiles    24
+
+@implementation HtHFileSink
+{
+    NSURL* _fileURL;
+    FILE* _file;            // Used for plain files.
+    gzFile _gzFile;         // Used for compressed files.
+    unsigned long long _fileSize;
+    CFAbsoluteTime _fileCreated;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithDirectory:(NSURL*)directory compressed:(BOOL)compressed
+{
+    if (!directory.isFileURL) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        if (![[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil]) { return nil; }
+
+        _directory = directory;
+        _compressed = compressed;
+        _maximumFileSize = HtHFileSink_maximumFileSize;
+        _maximumFileAge = HtHFileSink_maximumFileAge;
+        _maximumFiles = HtHFileSink_maximumFiles;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self close];
+}
+
+- (BOOL)writeSamples:(NSArray*)samples error:(NSError**)error
+{
+    if (![self rollFileIfNeeded:error]) { return NO; }
+
+    NSMutableData* data = [[NSMutableData alloc] initWithCapacity:samples.count * 128];
+    for (HtHSample* sample in samples)
+    {
+        NSData* line = [NSJSONSerialization dataWithJSONObject:sample.dictionaryRepresentation options:kNilOptions error:nil];
+        if (!line) { continue; }
+        [data appendData:line];
+        [data appendBytes:"\n" length:1];
+    }
+    if (!data.length) { return YES; }
+
+    BOOL written;
+    if (_gzFile)
+    {
+        written = (gzwrite(_gzFile, data.bytes, (unsigned)data.length) == (int)data.length) && (gzflush(_gzFile, Z_SYNC_FLUSH) == Z_OK);
+    }
+    else
+    {
+        written = (fwrite(data.bytes, 1, data.length, _file) == data.length) && (fflush(_file) == 0);
+    }
+
+    if (!written)
+    {
+        // The file may be half written; the batch is retried in a fresh file.
+        int const code = errno;
+        [self close];
+        if (error) { *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:@{ NSFilePathErrorKey : (_fileURL.path) ? _fileURL.path : @"" }]; }
+        return NO;
+    }
+
+    _fileSize += data.length;
+    return YES;
+}
+
+- (void)close
+{
+    if (_gzFile) { gzclose(_gzFile); _gzFile = NULL; }
+    if (_file) { fclose(_file); _file = NULL; }
+}
+
+#pragma mark - Private functionality
+
+- (BOOL)rollFileIfNeeded:(NSError**)error
+{
+    if (_file || _gzFile)
+    {
+        if (_fileSize < self.maximumFileSize && CFAbsoluteTimeGetCurrent() - _fileCreated < self.maximumFileAge) { return YES; }
+        [self close];
+    }
+
+    NSDateFormatter* formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.timeZone = [NSTimeZone timeZoneWithName:@"UTC"];
+    formatter.dateFormat = @"yyyyMMdd'T'HHmmss.SSS";
+    NSString* name = [NSString stringWithFormat:@"%@.%@", [formatter stringFromDate:[NSDate date]], (_compressed) ? @"jsonl.gz" : @"jsonl"];
+    _fileURL = [_directory URLByAppendingPathComponent:name];
+
+    char const* path = _fileURL.fileSystemRepresentation;
+    if (_compressed) { _gzFile = gzopen(path, "ab"); } else { _file = fopen(path, "ab"); }
+    if (!_file && !_gzFile)
+    {
+        if (error) { *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{ NSFilePathErrorKey : _fileURL.path }]; }
+        return NO;
+    }
+
+    _fileSize = 0;
+    _fileCreated = CFAbsoluteTimeGetCurrent();
+    [self removeOldFiles];
+    return YES;
+}
+
+- (void)removeOldFiles
+{
+    NSFileManager* manager = [NSFileManager defaultManager];
+    NSArray* urls = [manager contentsOfDirectoryAtURL:_directory includingPropertiesForKeys:nil options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    NSString* extension = (_compressed) ? @".jsonl.gz" : @".jsonl";
+    urls = [urls filteredArrayUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(NSURL* url, NSDictionary* bindings) {
+        return [url.lastPathComponent hasSuffix:extension];
+    }]];
+
+    NSUInteger const maximumFiles = MAX(self.maximumFiles, (NSUInteger)1);
+    if (urls.count <= maximumFiles) { return; }
+
+    // File names are UTC timestamps, so lexicographic order is chronological order.
+    urls = [urls sortedArrayUsingComparator:^NSComparisonResult(NSURL* a, NSURL* b) { return [a.lastPathComponent compare:b.lastPathComponent]; }];
+    for (NSUInteger i = 0; i < urls.count - maximumFiles; ++i) { [manager removeItemAtURL:urls[i] error:nil]; }
+}
+
+@end
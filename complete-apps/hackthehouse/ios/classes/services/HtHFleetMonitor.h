@@ -0,0 +1,58 @@
+@import Foundation;             // Apple
+#import <Relayr/Relayr.h>       // Relayr.framework
+#import "HtHConnectionBatch.h"  // HtH
+
+/*!
+ *  @abstract Block executed with every batch of connection transitions of the fleet.
+ */
+typedef void (^HtHConnectionBatchBlock)(HtHConnectionBatch* batch);
+
+/*!
+ *  @abstract Connection state stream for all the devices of a user.
+ *  @discussion The monitor holds a single connection state subscription per device (only while it has observers) and coalesces the transitions: a batch is delivered once no new transition arrived for <code>coalescingInterval</code> seconds, or <code>maximumDelay</code> seconds after its first transition. Thus a broker outage arrives as one batch instead of a callback per device.
+ *  Observer blocks are executed on the main queue.
+ */
+@interface HtHFleetMonitor : NSObject
+
+/*!
+ *  @abstract Monitor shared by everybody observing the fleet of the user passed.
+ */
++ (instancetype)monitorForUser:(RelayrUser*)user;
+
+- (instancetype)initWithUser:(RelayrUser*)user;
+
+@property (readonly,weak,nonatomic) RelayrUser* user;
+
+/*!
+ *  @abstract Defaults: 0.5 and 2 seconds.
+ */
+@property (atomic) NSTimeInterval coalescingInterval;
+@property (atomic) NSTimeInterval maximumDelay;
+
+/*!
+ *  @abstract Fraction of the fleet that must disconnect within a batch to flag it as a mass disconnect. Default: 0.5.
+ */
+@property (atomic) double massDisconnectRatio;
+
+/*!
+ *  @abstract Last known connection state of every monitored device (<code>deviceID</code> -> <code>NSNumber</code> with a <code>RelayrConnectionState</code>).
+ */
+@property (readonly,nonatomic) NSDictionary* states;
+
+/*!
+ *  @abstract Registers a block executed with every batch of transitions.
+ *	@return An opaque token to remove the observer.
+ */
+- (id)addObserverWithBlock:(HtHConnectionBatchBlock)block;
+
+/*!
+ *  @abstract Removes an observer. When the last observer is removed, the device subscriptions are dropped.
+ */
+- (void)removeObserver:(id)token;
+
+/*!
+ *  @abstract Subscribes to the devices the user got since the monitor started (e.g.: after <code>queryCloudForIoTs:</code>) and forgets the ones removed.
+ */
+- (void)refreshDevices;
+
+@end
@@ -0,0 +1,197 @@
+#import "HtHFleetMonitor.h"     // Header
+
+#define HtHFleetMonitor_coalescingInterval  0.5
+#define HtHFleetMonitor_maximumDelay        2.0
+#define HtHFleetMonitor_massDisconnectRatio 0.5
+
+@interface HtHFleetEntry : NSObject
+@property (atomic,getter=isActive) BOOL active;
+@end
+
+@implementation HtHFleetEntry
+@end
+
+@implementation HtHFleetMonitor
+{
+    dispatch_queue_t _queue;
+    NSMutableDictionary* _observers;    // token -> HtHConnectionBatchBlock
+    NSMutableDictionary* _entries;      // deviceID -> HtHFleetEntry
+    NSMutableDictionary* _states;       // deviceID -> NSNumber (RelayrConnectionState)
+    NSMutableDictionary* _pending;      // deviceID -> HtHConnectionTransition
+    CFAbsoluteTime _firstPending;
+    NSUInteger _generation;
+}
+
+#pragma mark - Public API
+
++ (instancetype)monitorForUser:(RelayrUser*)user
+{
+    if (!user) { return nil; }
+
+    static NSMapTable* monitors;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ monitors = [NSMapTable weakToStrongObjectsMapTable]; });
+
+    @synchronized(monitors)
+    {
+        HtHFleetMonitor* monitor = [monitors objectForKey:user];
+        if (!monitor) { monitor = [[HtHFleetMonitor alloc] initWithUser:user]; [monitors setObject:monitor forKey:user]; }
+        return monitor;
+    }
+}
+
+- (instancetype)initWithUser:(RelayrUser*)user
+{
+    if (!user) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _user = user;
+        _queue = dispatch_queue_create("io.relayr.hth.fleet", DISPATCH_QUEUE_SERIAL);
+        _observers = [[NSMutableDictionary alloc] init];
+        _entries = [[NSMutableDictionary alloc] init];
+        _states = [[NSMutableDictionary alloc] init];
+        _pending = [[NSMutableDictionary alloc] init];
+        _coalescingInterval = HtHFleetMonitor_coalescingInterval;
+        _maximumDelay = HtHFleetMonitor_maximumDelay;
+        _massDisconnectRatio = HtHFleetMonitor_massDisconnectRatio;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (HtHFleetEntry* entry in _entries.allValues) { entry.active = NO; }
+}
+
+- (NSDictionary*)states
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{ result = _states.copy; });
+    return result;
+}
+
+- (id)addObserverWithBlock:(HtHConnectionBatchBlock)block
+{
+    if (!block) { return nil; }
+
+    NSUUID* token = [NSUUID UUID];
+    dispatch_async(_queue, ^{
+        _observers[token] = [block copy];
+        if (_observers.count == 1) { [self synchronizeDevices]; }
+    });
+    return token;
+}
+
+- (void)removeObserver:(id)token
+{
+    if (!token) { return; }
+
+    dispatch_async(_queue, ^{
+        if (!_observers[token]) { return; }
+        [_observers removeObjectForKey:token];
+        if (_observers.count) { return; }
+
+        // Without observers there is no reason to keep thousands of subscriptions alive.
+        for (HtHFleetEntry* entry in _entries.allValues) { entry.active = NO; }
+        [_entries removeAllObjects];
+        [_pending removeAllObjects];
+        _generation++;
+    });
+}
+
+- (void)refreshDevices
+{
+    dispatch_async(_queue, ^{
+        if (_observers.count) { [self synchronizeDevices]; }
+    });
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the monitor's queue.
+- (void)synchronizeDevices
+{
+    NSMutableDictionary* devices = [[NSMutableDictionary alloc] init];
+    for (RelayrDevice* device in self.user.devices) { if (device.uid) { devices[device.uid] = device; } }
+
+    for (NSString* deviceID in _entries.allKeys)
+    {
+        if (devices[deviceID]) { continue; }
+        ((HtHFleetEntry*)_entries[deviceID]).active = NO;
+        [_entries removeObjectForKey:deviceID];
+        [_states removeObjectForKey:deviceID];
+        [_pending removeObjectForKey:deviceID];
+    }
+
+    [devices enumerateKeysAndObjectsUsingBlock:^(NSString* deviceID, RelayrDevice* device, BOOL* stop) {
+        if (_entries[deviceID]) { return; }
+
+        HtHFleetEntry* entry = [[HtHFleetEntry alloc] init];
+        entry.active = YES;
+        _entries[deviceID] = entry;
+        if (!_states[deviceID]) { _states[deviceID] = @(device.connection.state); }
+
+        __weak HtHFleetMonitor* weakSelf = self;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [device.connection subscribeToStateChangesWithBlock:^(RelayrConnection* connection, RelayrConnectionState currentState, RelayrConnectionState previousState, BOOL* unsubscribe) {
+                HtHFleetMonitor* strongSelf = weakSelf;
+                if (!strongSelf || !entry.active) { *unsubscribe = YES; return; }
+                [strongSelf recordDeviceID:deviceID previousState:previousState currentState:currentState];
+            } error:nil];
+        });
+    }];
+}
+
+- (void)recordDeviceID:(NSString*)deviceID previousState:(RelayrConnectionState)previousState currentState:(RelayrConnectionState)currentState
+{
+    NSDate* date = [NSDate date];
+    dispatch_async(_queue, ^{
+        if (!_entries[deviceID]) { return; }
+        _states[deviceID] = @(currentState);
+
+        // Coalescing keeps the state the device had before the batch started.
+        HtHConnectionTransition* pending = _pending[deviceID];
+        RelayrConnectionState const originalState = (pending) ? pending.previousState : previousState;
+        _pending[deviceID] = [[HtHConnectionTransition alloc] initWithDeviceID:deviceID previousState:originalState currentState:currentState date:date];
+
+        CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+        if (_pending.count == 1 && !pending) { _firstPending = now; }
+        NSTimeInterval const delay = MIN(self.coalescingInterval, MAX(_firstPending + self.maximumDelay - now, 0.0));
+        [self scheduleFlushAfter:delay];
+    });
+}
+
+// It must be called from the monitor's queue.
+- (void)scheduleFlushAfter:(NSTimeInterval)delay
+{
+    NSUInteger const generation = ++_generation;
+    __weak HtHFleetMonitor* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), _queue, ^{
+        HtHFleetMonitor* strongSelf = weakSelf;
+        if (strongSelf && generation == strongSelf->_generation) { [strongSelf flush]; }
+    });
+}
+
+// It must be called from the monitor's queue.
+- (void)flush
+{
+    if (!_pending.count) { return; }
+
+    NSMutableArray* transitions = [[NSMutableArray alloc] initWithCapacity:_pending.count];
+    NSUInteger flapCount = 0;
+    for (HtHConnectionTransition* transition in _pending.allValues)
+    {
+        if (transition.previousState == transition.currentState) { flapCount++; } else { [transitions addObject:transition]; }
+    }
+    [_pending removeAllObjects];
+
+    HtHConnectionBatch* batch = [[HtHConnectionBatch alloc] initWithTransitions:transitions flapCount:flapCount fleetSize:_entries.count massDisconnectRatio:self.massDisconnectRatio];
+    NSArray* blocks = _observers.allValues;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        for (HtHConnectionBatchBlock block in blocks) { block(batch); }
+    });
+}
+
+@end
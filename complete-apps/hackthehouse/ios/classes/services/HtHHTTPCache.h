@@ -0,0 +1,83 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Response stored in an <code>HtHHTTPCache</code>.
+ */
+@interface HtHCachedResponse : NSObject
+@property (readonly,nonatomic) NSData* data;
+@property (readonly,nonatomic) NSString* entityTag;
+@property (readonly,nonatomic) NSString* lastModified;
+
+/*!
+ *  @abstract Whether the response can be used without asking the server.
+ */
+@property (readonly,nonatomic,getter=isFresh) BOOL fresh;
+
+/*!
+ *  @abstract Whether a stale response can still be used while it is revalidated in the background.
+ */
+@property (readonly,nonatomic,getter=isUsableWhileRevalidating) BOOL usableWhileRevalidating;
+
+/*!
+ *  @abstract Adds the conditional headers (<code>If-None-Match</code>, <code>If-Modified-Since</code>) to a request revalidating this response.
+ */
+- (void)addConditionalHeadersToRequest:(NSMutableURLRequest*)request;
+@end
+
+/*!
+ *  @abstract Disk backed HTTP response cache with revalidation.
+ *  @discussion Responses are fresh for their <code>Cache-Control: max-age</code> (or <code>defaultLifetime</code> if the server doesn't say, which by default means they are always revalidated). Stale responses are revalidated with their <code>ETag</code> / <code>Last-Modified</code> validators, and, only when the server allows it with <code>Cache-Control: stale-while-revalidate</code>, they are still served during that window while revalidation happens (never for <code>no-cache</code> responses). The least recently used responses are evicted once the cache grows over its capacity.
+ *  All methods are thread safe and none of them touches the disk on the caller's thread.
+ */
+@interface HtHHTTPCache : NSObject
+
+/*!
+ *  @abstract Cache in the Caches directory (20 MB) shared by all REST calls of the app.
+ */
++ (instancetype)sharedCache;
+
+- (instancetype)initWithDirectory:(NSURL*)directory capacity:(unsigned long long)capacity;
+
+@property (readonly,nonatomic) NSURL* directory;
+@property (readonly,nonatomic) unsigned long long capacity;
+
+/*!
+ *  @abstract Lifetime of responses without <code>max-age</code>. Default: 0 (they are revalidated on every request, so mutable collections are never served stale).
+ */
+@property (atomic) NSTimeInterval defaultLifetime;
+
+/*!
+ *  @abstract Seconds a stale response can be served while revalidating when the server doesn't send <code>stale-while-revalidate</code>. It never applies to <code>no-cache</code> responses. Default: 0.
+ */
+@property (atomic) NSTimeInterval staleWhileRevalidate;
+
+/*!
+ *  @abstract Key identifying a request (its URL plus the credentials, so users never share responses).
+ */
++ (NSString*)keyForRequest:(NSURLRequest*)request;
+
+/*!
+ *  @abstract Looks up a stored response.
+ *
+ *  @param completion Block executed on a background queue with the response, or <code>nil</code> if none is stored. It shouldn't block.
+ */
+- (void)responseForKey:(NSString*)key completion:(void (^)(HtHCachedResponse* response))completion;
+
+/*!
+ *  @abstract Stores a <code>200</code> response (unless it says <code>Cache-Control: no-store</code>).
+ */
+- (void)storeData:(NSData*)data response:(NSHTTPURLResponse*)response forKey:(NSString*)key;
+
+/*!
+ *  @abstract Marks a stored response as fresh again after the server answered <code>304 Not Modified</code>.
+ */
+- (void)refreshResponse:(NSHTTPURLResponse*)response forKey:(NSString*)key;
+
+- (void)removeAllResponses;
+
+/*!
+ *  @abstract Counters: hits, stale hits, revalidations (304), misses, evictions and current size.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,329 @@
+#import "HtHHTTPCache.h"                // Header
+#import "HtHMemoryAccounting.h"         // HtH
+#import <CommonCrypto/CommonDigest.h>   // Apple
+
+#define HtHHTTPCache_sharedDirectory    @"HTTPCache"
+#define HtHHTTPCache_sharedCapacity     (20 * 1024 * 1024)
+#define HtHHTTPCache_defaultLifetime    0.0
+#define HtHHTTPCache_staleRevalidate    0.0
+#define HtHHTTPCache_indexFile          @"index.plist"
+#define HtHHTTPCache_indexDelay         1.0
+
+#define HtHHTTPCacheKey_entityTag       @"etag"
+#define HtHHTTPCacheKey_lastModified    @"lastModified"
+#define HtHHTTPCacheKey_stored          @"stored"
+#define HtHHTTPCacheKey_lifetime        @"lifetime"
+#define HtHHTTPCacheKey_staleWindow     @"staleWindow"
+#define HtHHTTPCacheKey_size            @"size"
+#define HtHHTTPCacheKey_accessed        @"accessed"
+
+// Approximate bytes of an index entry, accounted under HtHMemorySubsystemHTTPCache.
+static int64_t HtHHTTPCacheEntryFootprint(NSString* key, NSDictionary* entry)
+{
+    return (int64_t)(HtHMemoryObjectSize(key) + HtHMemoryObjectSize(entry) + HtHMemoryObjectSize(entry[HtHHTTPCacheKey_entityTag]) + HtHMemoryObjectSize(entry[HtHHTTPCacheKey_lastModified]));
+}
+
+@implementation HtHCachedResponse
+
+- (instancetype)initWithData:(NSData*)data entityTag:(NSString*)entityTag lastModified:(NSString*)lastModified fresh:(BOOL)fresh usableWhileRevalidating:(BOOL)usable
+{
+    self = [super init];
+    if (self)
+    {
+        _data = data;
+        _entityTag = entityTag;
+        _lastModified = lastModified;
+        _fresh = fresh;
+        _usableWhileRevalidating = usable;
+    }
+    return self;
+}
+
+- (void)addConditionalHeadersToRequest:(NSMutableURLRequest*)request
+{
+    if (_entityTag) { [request setValue:_entityTag forHTTPHeaderField:@"If-None-Match"]; }
+    if (_lastModified) { [request setValue:_lastModified forHTTPHeaderField:@"If-Modified-Since"]; }
+}
+
+@end
+
+@implementation HtHHTTPCache
+{
+    dispatch_queue_t _queue;        // Guards the index and counters; it never touches the disk.
+    dispatch_queue_t _ioQueue;      // Reads and writes the stored responses and the index, in the order the index changed.
+    NSMutableDictionary* _index;    // key -> NSMutableDictionary (HtHHTTPCacheKey_* entries)
+    unsigned long long _size;
+    BOOL _indexSaveScheduled;
+
+    NSUInteger _hitsCount;
+    NSUInteger _staleHitsCount;
+    NSUInteger _revalidationsCount;
+    NSUInteger _missesCount;
+    NSUInteger _evictionsCount;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedCache
+{
+    static HtHHTTPCache* cache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSURL* caches = [[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask].firstObject;
+        cache = [[HtHHTTPCache alloc] initWithDirectory:[caches URLByAppendingPathComponent:HtHHTTPCache_sharedDirectory isDirectory:YES] capacity:HtHHTTPCache_sharedCapacity];
+    });
+    return cache;
+}
+
+- (instancetype)initWithDirectory:(NSURL*)directory capacity:(unsigned long long)capacity
+{
+    if (!directory || !capacity) { return nil; }
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil]) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _directory = directory;
+        _capacity = capacity;
+        _queue = dispatch_queue_create("io.relayr.hth.httpcache", DISPATCH_QUEUE_SERIAL);
+        _ioQueue = dispatch_queue_create("io.relayr.hth.httpcache.io", DISPATCH_QUEUE_SERIAL);
+        _defaultLifetime = HtHHTTPCache_defaultLifetime;
+        _staleWhileRevalidate = HtHHTTPCache_staleRevalidate;
+
+        NSDictionary* index = [NSDictionary dictionaryWithContentsOfURL:[directory URLByAppendingPathComponent:HtHHTTPCache_indexFile]];
+        _index = [[NSMutableDictionary alloc] initWithCapacity:index.count];
+        [index enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSDictionary* entry, BOOL* stop) {
+            NSMutableDictionary* mutableEntry = entry.mutableCopy;
+            _index[key] = mutableEntry;
+            _size += [entry[HtHHTTPCacheKey_size] unsignedLongLongValue];
+            HtHMemoryAccount(HtHMemorySubsystemHTTPCache, HtHHTTPCacheEntryFootprint(key, mutableEntry), 1);
+        }];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_index writeToURL:[_directory URLByAppendingPathComponent:HtHHTTPCache_indexFile] atomically:YES];
+    [_index enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSDictionary* entry, BOOL* stop) {
+        HtHMemoryAccount(HtHMemorySubsystemHTTPCache, -HtHHTTPCacheEntryFootprint(key, entry), -1);
+    }];
+}
+
++ (NSString*)keyForRequest:(NSURLRequest*)request
+{
+    NSString* identity = [NSString stringWithFormat:@"%@\n%@", request.URL.absoluteString, ([request valueForHTTPHeaderField:@"Authorization"]) ? [request valueForHTTPHeaderField:@"Authorization"] : @""];
+    NSData* data = [identity dataUsingEncoding:NSUTF8StringEncoding];
+
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+
+    NSMutableString* result = [NSMutableString stringWithCapacity:2 * CC_SHA256_DIGEST_LENGTH];
+    for (NSUInteger i = 0; i < CC_SHA256_DIGEST_LENGTH; ++i) { [result appendFormat:@"%02x", digest[i]]; }
+    return result;
+}
+
+- (void)responseForKey:(NSString*)key completion:(void (^)(HtHCachedResponse* response))completion
+{
+    if (!completion) { return; }
+    if (!key) { return dispatch_async(_ioQueue, ^{ completion(nil); }); }
+
+    dispatch_async(_queue, ^{
+        NSMutableDictionary* entry = _index[key];
+        if (!entry) { _missesCount++; return dispatch_async(_ioQueue, ^{ completion(nil); }); }
+
+        NSTimeInterval const now = [NSDate date].timeIntervalSince1970;
+        NSTimeInterval const age = now - [entry[HtHHTTPCacheKey_stored] doubleValue];
+        NSTimeInterval const lifetime = [entry[HtHHTTPCacheKey_lifetime] doubleValue];
+        BOOL const fresh = age < lifetime;
+        BOOL const usable = fresh || age < lifetime + [entry[HtHHTTPCacheKey_staleWindow] doubleValue];
+        NSString* entityTag = entry[HtHHTTPCacheKey_entityTag];
+        NSString* lastModified = entry[HtHHTTPCacheKey_lastModified];
+
+        if (fresh) { _hitsCount++; } else if (usable) { _staleHitsCount++; } else { _missesCount++; }
+        entry[HtHHTTPCacheKey_accessed] = @(now);
+        [self scheduleIndexSave];
+
+        // The file is read after every write queued by earlier index changes, so it matches the entry just looked at.
+        NSURL* fileURL = [_directory URLByAppendingPathComponent:key];
+        dispatch_async(_ioQueue, ^{
+            NSData* data = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedIfSafe error:nil];
+            if (!data) { [self removeEntry:entry forKey:key]; return completion(nil); }
+            completion([[HtHCachedResponse alloc] initWithData:data entityTag:entityTag lastModified:lastModified fresh:fresh usableWhileRevalidating:usable]);
+        });
+    });
+}
+
+- (void)storeData:(NSData*)data response:(NSHTTPURLResponse*)response forKey:(NSString*)key
+{
+    if (!data || !key || response.statusCode != 200) { return; }
+
+    NSTimeInterval lifetime, staleWindow;
+    if (![self getLifetime:&lifetime staleWindow:&staleWindow fromResponse:response]) { return; }
+
+    dispatch_async(_queue, ^{
+        [self removeKey:key];
+        if (data.length > _capacity) { return; }
+
+        NSTimeInterval const now = [NSDate date].timeIntervalSince1970;
+        NSMutableDictionary* entry = [NSMutableDictionary dictionaryWithDictionary:@{
+            HtHHTTPCacheKey_stored      : @(now),
+            HtHHTTPCacheKey_accessed    : @(now),
+            HtHHTTPCacheKey_lifetime    : @(lifetime),
+            HtHHTTPCacheKey_staleWindow : @(staleWindow),
+            HtHHTTPCacheKey_size        : @(data.length)
+        }];
+        NSDictionary* headers = response.allHeaderFields;
+        if (headers[@"ETag"]) { entry[HtHHTTPCacheKey_entityTag] = headers[@"ETag"]; }
+        if (headers[@"Last-Modified"]) { entry[HtHHTTPCacheKey_lastModified] = headers[@"Last-Modified"]; }
+
+        _index[key] = entry;
+        _size += data.length;
+        HtHMemoryAccount(HtHMemorySubsystemHTTPCache, HtHHTTPCacheEntryFootprint(key, entry), 1);
+
+        NSURL* fileURL = [_directory URLByAppendingPathComponent:key];
+        dispatch_async(_ioQueue, ^{
+            if (![data writeToURL:fileURL atomically:YES]) { [self removeEntry:entry forKey:key]; }
+        });
+        [self evictIfNeeded];
+        [self scheduleIndexSave];
+    });
+}
+
+- (void)refreshResponse:(NSHTTPURLResponse*)response forKey:(NSString*)key
+{
+    if (!key) { return; }
+
+    NSTimeInterval lifetime, staleWindow;
+    BOOL const storable = [self getLifetime:&lifetime staleWindow:&staleWindow fromResponse:response];
+
+    dispatch_async(_queue, ^{
+        NSMutableDictionary* entry = _index[key];
+        if (!entry) { return; }
+        if (!storable) { return [self removeKey:key]; }
+
+        _revalidationsCount++;
+        int64_t const footprint = HtHHTTPCacheEntryFootprint(key, entry);
+        entry[HtHHTTPCacheKey_stored] = @([NSDate date].timeIntervalSince1970);
+        entry[HtHHTTPCacheKey_lifetime] = @(lifetime);
+        entry[HtHHTTPCacheKey_staleWindow] = @(staleWindow);
+        NSString* entityTag = response.allHeaderFields[@"ETag"];
+        if (entityTag) { entry[HtHHTTPCacheKey_entityTag] = entityTag; }
+        HtHMemoryAccount(HtHMemorySubsystemHTTPCache, HtHHTTPCacheEntryFootprint(key, entry) - footprint, 0);
+        [self scheduleIndexSave];
+    });
+}
+
+- (void)removeAllResponses
+{
+    dispatch_async(_queue, ^{
+        for (NSString* key in _index.allKeys) { [self removeKey:key]; }
+        [self saveIndex];
+    });
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        result = @{
+            @"httpcache.hits"           : @(_hitsCount),
+            @"httpcache.staleHits"      : @(_staleHitsCount),
+            @"httpcache.revalidations"  : @(_revalidationsCount),
+            @"httpcache.misses"         : @(_missesCount),
+            @"httpcache.evictions"      : @(_evictionsCount),
+            @"httpcache.size"           : @(_size),
+            @"httpcache.entries"        : @(_index.count)
+        };
+    });
+    return result;
+}
+
+#pragma mark - Private functionality
+
+// It returns NO when the response must not be stored. Stale responses are only served while revalidating when the server allows it (and never for "no-cache").
+- (BOOL)getLifetime:(NSTimeInterval*)lifetime staleWindow:(NSTimeInterval*)staleWindow fromResponse:(NSHTTPURLResponse*)response
+{
+    *lifetime = self.defaultLifetime;
+    *staleWindow = self.staleWhileRevalidate;
+    BOOL noCache = NO;
+
+    NSString* control = [response.allHeaderFields[@"Cache-Control"] lowercaseString];
+    for (NSString* component in [control componentsSeparatedByString:@","])
+    {
+        NSString* directive = [component stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if ([directive isEqualToString:@"no-store"]) { return NO; }
+        if ([directive isEqualToString:@"no-cache"]) { noCache = YES; }
+        else if ([directive hasPrefix:@"max-age="]) { *lifetime = MAX([directive substringFromIndex:8].doubleValue, 0.0); }
+        else if ([directive hasPrefix:@"stale-while-revalidate="]) { *staleWindow = MAX([directive substringFromIndex:23].doubleValue, 0.0); }
+    }
+
+    if (noCache) { *lifetime = 0.0; *staleWindow = 0.0; }
+    return YES;
+}
+
+// It must be called from the cache's queue.
+- (void)removeKey:(NSString*)key
+{
+    NSDictionary* entry = _index[key];
+    if (!entry) { return; }
+
+    _size -= MIN(_size, [entry[HtHHTTPCacheKey_size] unsignedLongLongValue]);
+    HtHMemoryAccount(HtHMemorySubsystemHTTPCache, -HtHHTTPCacheEntryFootprint(key, entry), -1);
+    [_index removeObjectForKey:key];
+
+    NSURL* fileURL = [_directory URLByAppendingPathComponent:key];
+    dispatch_async(_ioQueue, ^{ [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil]; });
+    [self scheduleIndexSave];
+}
+
+// It can be called from any queue. The key is only removed if it still holds the entry (a newer response may have replaced it).
+- (void)removeEntry:(NSDictionary*)entry forKey:(NSString*)key
+{
+    dispatch_async(_queue, ^{
+        if (_index[key] == entry) { [self removeKey:key]; }
+    });
+}
+
+// It must be called from the cache's queue.
+- (void)evictIfNeeded
+{
+    if (_size <= _capacity) { return; }
+
+    NSArray* keys = [_index keysSortedByValueUsingComparator:^NSComparisonResult(NSDictionary* a, NSDictionary* b) {
+        return [a[HtHHTTPCacheKey_accessed] compare:b[HtHHTTPCacheKey_accessed]];
+    }];
+    for (NSString* key in keys)
+    {
+        if (_size <= _capacity) { break; }
+        [self removeKey:key];
+        _evictionsCount++;
+    }
+}
+
+// It must be called from the cache's queue. The index is written at most once per second.
+- (void)scheduleIndexSave
+{
+    if (_indexSaveScheduled) { return; }
+    _indexSaveScheduled = YES;
+
+    __weak HtHHTTPCache* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(HtHHTTPCache_indexDelay * NSEC_PER_SEC)), _queue, ^{
+        HtHHTTPCache* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+        strongSelf->_indexSaveScheduled = NO;
+        [strongSelf saveIndex];
+    });
+}
+
+// It must be called from the cache's queue. A snapshot of the index is written on the I/O queue.
+- (void)saveIndex
+{
+    NSMutableDictionary* snapshot = [[NSMutableDictionary alloc] initWithCapacity:_index.count];
+    [_index enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSDictionary* entry, BOOL* stop) { snapshot[key] = entry.copy; }];
+
+    NSURL* fileURL = [_directory URLByAppendingPathComponent:HtHHTTPCache_indexFile];
+    dispatch_async(_ioQueue, ^{ [snapshot writeToURL:fileURL atomically:YES]; });
+}
+
+@end
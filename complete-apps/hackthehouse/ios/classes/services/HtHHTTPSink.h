@@ -0,0 +1,26 @@
+@import Foundation;     // Apple
+#import "HtHSink.h"     // HtH
+
+/*!
+ *  @abstract Sink posting every batch of samples as a JSON array to an HTTP endpoint.
+ *  @discussion Any response status outside the 2xx range (or no response within <code>timeout</code> seconds) fails the batch, so the connector retries it.
+ */
+@interface HtHHTTPSink : NSObject <HtHSink>
+
+/*!
+ *  @abstract Creates an HTTP sink.
+ *
+ *  @param url Endpoint receiving the <code>POST</code> requests.
+ *  @param headers Additional HTTP headers (e.g.: <code>Authorization</code>). It can be <code>nil</code>.
+ */
+- (instancetype)initWithURL:(NSURL*)url headers:(NSDictionary*)headers;
+
+@property (readonly,nonatomic) NSURL* url;
+@property (readonly,nonatomic) NSDictionary* headers;
+
+/*!
+ *  @abstract Seconds to wait for the server's response. Default: 30.
+ */
+@property (atomic) NSTimeInterval timeout;
+
+@end
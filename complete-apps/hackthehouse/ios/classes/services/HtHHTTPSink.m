@@ -0,0 +1,77 @@
+#import "HtHHTTPSink.h"     // Header
+#import <Relayr/Relayr.h>   // Relayr.framework
+#import "HtHSample.h"       // HtH
+
+#define HtHHTTPSink_timeout     30.0
+
+@implementation HtHHTTPSink
+{
+    NSURLSession* _session;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithURL:(NSURL*)url headers:(NSDictionary*)headers
+{
+    if (!url) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _url = url;
+        _headers = headers.copy;
+        _timeout = HtHHTTPSink_timeout;
+
+        NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+        configuration.HTTPMaximumConnectionsPerHost = 1;
+        _session = [NSURLSession sessionWithConfiguration:configuration];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_session invalidateAndCancel];
+}
+
+- (BOOL)writeSamples:(NSArray*)samples error:(NSError**)error
+{
+    NSMutableArray* objects = [[NSMutableArray alloc] initWithCapacity:samples.count];
+    for (HtHSample* sample in samples) { [objects addObject:sample.dictionaryRepresentation]; }
+
+    NSData* body = [NSJSONSerialization dataWithJSONObject:objects options:kNilOptions error:error];
+    if (!body) { return NO; }
+
+    NSTimeInterval const timeout = self.timeout;
+    NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:_url cachePolicy:NSURLRequestReloadIgnoringLocalCacheData timeoutInterval:timeout];
+    request.HTTPMethod = @"POST";
+    [request setValue:@"application/json" forHTTPHeaderField:@"Content-Type"];
+    [_headers enumerateKeysAndObjectsUsingBlock:^(NSString* field, NSString* value, BOOL* stop) { [request setValue:value forHTTPHeaderField:field]; }];
+
+    // Sinks are called from the connector's private queue, thus it is fine to block it until the server answers.
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSError* requestError;
+    __block NSInteger statusCode = 0;
+    NSURLSessionUploadTask* task = [_session uploadTaskWithRequest:request fromData:body completionHandler:^(NSData* data, NSURLResponse* response, NSError* taskError) {
+        requestError = taskError;
+        statusCode = ([response isKindOfClass:[NSHTTPURLResponse class]]) ? ((NSHTTPURLResponse*)response).statusCode : 0;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    [task resume];
+
+    if (dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)((timeout + 1.0) * NSEC_PER_SEC))))
+    {
+        [task cancel];
+        if (error) { *error = RelayrErrorTimeoutExpired; }
+        return NO;
+    }
+
+    if (statusCode < 200 || statusCode >= 300)
+    {
+        if (error) { *error = (requestError) ? requestError : RelayrErrorWebRequestFailure; }
+        return NO;
+    }
+    return YES;
+}
+
+@end
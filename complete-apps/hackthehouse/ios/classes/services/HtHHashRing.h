@@ -0,0 +1,41 @@
+@import Foundation; // Apple
+
+/*!
+ *  @abstract Immutable consistent hash ring.
+ *  @discussion Every member is placed on the ring <code>virtualNodes</code> times (hashing <code>member#index</code> with 64-bit FNV-1a plus a final avalanche) and a key belongs to the first member found clockwise from its hash. Adding or removing a member only moves the keys of the arcs it gains or loses (about <code>1/members</code> of them) and the virtual nodes keep the load balanced.
+ */
+@interface HtHHashRing : NSObject
+
+/*!
+ *  @abstract Creates a ring.
+ *
+ *  @param members Array of <code>NSString</code> member identifiers (duplicates are ignored).
+ *  @param virtualNodes Points per member. It must be greater than 0.
+ */
+- (instancetype)initWithMembers:(NSArray*)members virtualNodes:(NSUInteger)virtualNodes;
+
+@property (readonly,nonatomic) NSArray* members;
+@property (readonly,nonatomic) NSUInteger virtualNodes;
+
+/*!
+ *  @abstract Member owning the key passed or <code>nil</code> if the ring is empty.
+ */
+- (NSString*)memberForKey:(NSString*)key;
+
+/*!
+ *  @abstract Simulates a fleet partitioned across a cluster, to check the balance and the churn of a ring configuration.
+ *  @discussion Keys are random UUID strings (like device identifiers). The result holds the keys owned by the most and the least loaded members relative to the mean (<code>ring.maximumLoad</code>, <code>ring.minimumLoad</code>), and the fraction of the keys that move to another member when one member joins (<code>ring.movedOnJoin</code>, ideally <code>1/(members+1)</code>) or leaves (<code>ring.movedOnLeave</code>, ideally <code>1/members</code>).
+ *
+ *  @param membersCount Members of the cluster. It must be greater than 1.
+ *  @param keysCount Keys (devices) of the fleet. It must be greater than 0.
+ *  @param virtualNodes Points per member.
+ *	@return Dictionary with the figures above or <code>nil</code> if the arguments are not valid.
+ */
++ (NSDictionary*)simulateMembers:(NSUInteger)membersCount keys:(NSUInteger)keysCount virtualNodes:(NSUInteger)virtualNodes;
+
+/*!
+ *  @abstract Hash function of the ring: 64-bit FNV-1a of the UTF-8 representation of a string, with a final avalanche step.
+ */
++ (uint64_t)hashForString:(NSString*)string;
+
+@end
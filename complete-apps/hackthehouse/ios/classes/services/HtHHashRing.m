@@ -0,0 +1,129 @@
+#import "HtHHashRing.h" // Header
+
+#define HtHHashRing_FNVOffset   14695981039346656037ULL
+#define HtHHashRing_FNVPrime    1099511628211ULL
+
+typedef struct HtHRingPoint {
+    uint64_t hash;
+    NSUInteger member;
+} HtHRingPoint;
+
+@implementation HtHHashRing
+{
+    HtHRingPoint* _points;
+    NSUInteger _pointsCount;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithMembers:(NSArray*)members virtualNodes:(NSUInteger)virtualNodes
+{
+    if (!virtualNodes) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        // Members are sorted, so every instance builds the same ring whatever order it learnt them in.
+        _members = [[NSOrderedSet orderedSetWithArray:(members) ? members : @[]].array sortedArrayUsingSelector:@selector(compare:)];
+        _virtualNodes = virtualNodes;
+        _pointsCount = _members.count * virtualNodes;
+        _points = (_pointsCount) ? malloc(_pointsCount * sizeof(HtHRingPoint)) : NULL;
+        if (_pointsCount && !_points) { return nil; }
+
+        for (NSUInteger m = 0; m < _members.count; ++m)
+        {
+            for (NSUInteger v = 0; v < virtualNodes; ++v)
+            {
+                NSString* node = [NSString stringWithFormat:@"%@#%lu", _members[m], (unsigned long)v];
+                _points[m * virtualNodes + v] = (HtHRingPoint){ [HtHHashRing hashForString:node], m };
+            }
+        }
+
+        // Ties (extremely unlikely) are broken by member order.
+        qsort_b(_points, _pointsCount, sizeof(HtHRingPoint), ^int(void const* a, void const* b) {
+            HtHRingPoint const* x = a;
+            HtHRingPoint const* y = b;
+            if (x->hash != y->hash) { return (x->hash < y->hash) ? -1 : 1; }
+            return (x->member > y->member) - (x->member < y->member);
+        });
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_points);
+}
+
+- (NSString*)memberForKey:(NSString*)key
+{
+    if (!_pointsCount || !key) { return nil; }
+
+    uint64_t const hash = [HtHHashRing hashForString:key];
+    NSUInteger low = 0, high = _pointsCount;
+    while (low < high)
+    {
+        NSUInteger const middle = low + (high - low) / 2;
+        if (_points[middle].hash < hash) { low = middle + 1; } else { high = middle; }
+    }
+    return _members[_points[(low == _pointsCount) ? 0 : low].member];
+}
+
++ (NSDictionary*)simulateMembers:(NSUInteger)membersCount keys:(NSUInteger)keysCount virtualNodes:(NSUInteger)virtualNodes
+{
+    if (membersCount < 2 || !keysCount || !virtualNodes) { return nil; }
+
+    NSMutableArray* members = [[NSMutableArray alloc] initWithCapacity:membersCount + 1];
+    for (NSUInteger i = 0; i <= membersCount; ++i) { [members addObject:[NSString stringWithFormat:@"member-%lu", (unsigned long)i]]; }
+    NSMutableArray* keys = [[NSMutableArray alloc] initWithCapacity:keysCount];
+    for (NSUInteger i = 0; i < keysCount; ++i) { [keys addObject:[NSUUID UUID].UUIDString.lowercaseString]; }
+
+    // The base cluster, the cluster with one more member, and the cluster without its first member.
+    HtHHashRing* ring = [[HtHHashRing alloc] initWithMembers:[members subarrayWithRange:NSMakeRange(0, membersCount)] virtualNodes:virtualNodes];
+    HtHHashRing* joined = [[HtHHashRing alloc] initWithMembers:members virtualNodes:virtualNodes];
+    HtHHashRing* left = [[HtHHashRing alloc] initWithMembers:[members subarrayWithRange:NSMakeRange(1, membersCount - 1)] virtualNodes:virtualNodes];
+
+    NSCountedSet* loads = [[NSCountedSet alloc] init];
+    NSUInteger movedOnJoin = 0, movedOnLeave = 0;
+    for (NSString* key in keys)
+    {
+        NSString* owner = [ring memberForKey:key];
+        [loads addObject:owner];
+        if (![[joined memberForKey:key] isEqualToString:owner]) { movedOnJoin++; }
+        if (![[left memberForKey:key] isEqualToString:owner]) { movedOnLeave++; }
+    }
+
+    NSUInteger maximum = 0, minimum = NSUIntegerMax;
+    for (NSString* member in ring.members)
+    {
+        NSUInteger const load = [loads countForObject:member];
+        maximum = MAX(maximum, load);
+        minimum = MIN(minimum, load);
+    }
+
+    double const mean = (double)keysCount / membersCount;
+    return @{
+        @"ring.members"         : @(membersCount),
+        @"ring.keys"            : @(keysCount),
+        @"ring.virtualNodes"    : @(virtualNodes),
+        @"ring.maximumLoad"     : @(maximum / mean),
+        @"ring.minimumLoad"     : @(minimum / mean),
+        @"ring.movedOnJoin"     : @((double)movedOnJoin / keysCount),
+        @"ring.movedOnLeave"    : @((double)movedOnLeave / keysCount)
+    };
+}
+
++ (uint64_t)hashForString:(NSString*)string
+{
+    char const* bytes = string.UTF8String;
+    uint64_t hash = HtHHashRing_FNVOffset;
+    for (size_t i = 0; bytes && bytes[i]; ++i) { hash = (hash ^ (uint8_t)bytes[i]) * HtHHashRing_FNVPrime; }
+
+    // Final avalanche: virtual node names only differ in their last characters.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+@end
@@ -0,0 +1,52 @@
+@import Foundation;         // Apple
+#import "HtHReadingStage.h" // HtH
+
+/*!
+ *  @abstract Comparisons available to filter devices by their latest value.
+ */
+typedef NS_ENUM(NSUInteger, HtHComparison) {
+    HtHComparisonLess,
+    HtHComparisonLessOrEqual,
+    HtHComparisonEqual,
+    HtHComparisonGreaterOrEqual,
+    HtHComparisonGreater
+};
+
+/*!
+ *  @abstract Latest numeric value of every device and meaning, stored as a struct of arrays.
+ *  @discussion Every meaning has its own columns (device identifiers, values and timestamps), so filters and aggregates over a meaning scan contiguous <code>double</code> buffers with vectorised (Accelerate) kernels.
+ *  As a pipeline stage it records every numeric sample (live or backfilled) and passes the samples through untouched; a sample older than the value stored for its series is ignored. Queries are thread safe.
+ */
+@interface HtHLatestValueTable : NSObject <HtHReadingStage>
+
+/*!
+ *  @abstract Table used by the shared <code>HtHReadingHub</code>.
+ */
++ (instancetype)sharedTable;
+
+/*!
+ *  @abstract Meanings with at least one value.
+ */
+@property (readonly,nonatomic) NSArray* meanings;
+
+/*!
+ *  @abstract Identifiers of the devices whose latest value for a meaning satisfies the comparison.
+ */
+- (NSSet*)deviceIDsWithMeaning:(NSString*)meaning comparison:(HtHComparison)comparison value:(double)value;
+
+/*!
+ *  @abstract Copies the columns of a meaning.
+ *
+ *  @param deviceIDs Pointer where the array of device identifiers (row order) is written. It can be <code>NULL</code>.
+ *  @param values Pointer where the values (<code>double</code> per row) are written. It can be <code>NULL</code>.
+ *  @param timestamps Pointer where the timestamps (<code>double</code> per row, seconds since 1970) are written. It can be <code>NULL</code>.
+ *	@return Number of rows.
+ */
+- (NSUInteger)snapshotMeaning:(NSString*)meaning deviceIDs:(NSArray**)deviceIDs values:(NSData**)values timestamps:(NSData**)timestamps;
+
+/*!
+ *  @abstract Counters: meanings and rows.
+ */
+- (NSDictionary*)metrics;
+
+@end
@@ -0,0 +1,154 @@
+#import "HtHLatestValueTable.h" // Header
+#import "HtHSample.h"           // HtH
+@import Accelerate;             // Apple
+
+// Columns of a meaning. They are only touched on the table's queue.
+@interface HtHLatestColumns : NSObject
+@property (strong,nonatomic) NSMutableDictionary* rows;     // deviceID -> NSNumber (row)
+@property (strong,nonatomic) NSMutableArray* deviceIDs;
+@property (strong,nonatomic) NSMutableData* values;
+@property (strong,nonatomic) NSMutableData* timestamps;
+@end
+
+@implementation HtHLatestColumns
+@end
+
+@implementation HtHLatestValueTable
+{
+    dispatch_queue_t _queue;
+    NSMutableDictionary* _columns;  // meaning -> HtHLatestColumns
+    NSUInteger _rowsCount;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedTable
+{
+    static HtHLatestValueTable* table;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ table = [[HtHLatestValueTable alloc] init]; });
+    return table;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _queue = dispatch_queue_create("io.relayr.hth.latest", DISPATCH_QUEUE_SERIAL);
+        _columns = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void)stageSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    dispatch_sync(_queue, ^{
+        for (HtHSample* sample in samples)
+        {
+            double const value = sample.doubleValue;
+            if (isnan(value) || !sample.meaning) { continue; }
+
+            HtHLatestColumns* columns = _columns[sample.meaning];
+            if (!columns)
+            {
+                columns = [[HtHLatestColumns alloc] init];
+                columns.rows = [[NSMutableDictionary alloc] init];
+                columns.deviceIDs = [[NSMutableArray alloc] init];
+                columns.values = [[NSMutableData alloc] init];
+                columns.timestamps = [[NSMutableData alloc] init];
+                _columns[sample.meaning] = columns;
+            }
+
+            NSNumber* row = columns.rows[sample.deviceID];
+            if (!row)
+            {
+                row = @(columns.deviceIDs.count);
+                columns.rows[sample.deviceID] = row;
+                [columns.deviceIDs addObject:sample.deviceID];
+                columns.values.length += sizeof(double);
+                columns.timestamps.length += sizeof(double);
+                ((double*)columns.timestamps.mutableBytes)[row.unsignedIntegerValue] = -INFINITY;
+                _rowsCount++;
+            }
+
+            NSUInteger const index = row.unsignedIntegerValue;
+            double* timestamps = columns.timestamps.mutableBytes;
+            if (sample.timestamp < timestamps[index]) { continue; }
+            timestamps[index] = sample.timestamp;
+            ((double*)columns.values.mutableBytes)[index] = value;
+        }
+    });
+    output(samples);
+}
+
+// Values older than the row's timestamp are ignored, so a backfill never overwrites a newer live value.
+- (void)backfillSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    [self stageSamples:samples output:output];
+}
+
+- (NSArray*)meanings
+{
+    __block NSArray* result;
+    dispatch_sync(_queue, ^{ result = _columns.allKeys; });
+    return result;
+}
+
+- (NSSet*)deviceIDsWithMeaning:(NSString*)meaning comparison:(HtHComparison)comparison value:(double)value
+{
+    NSArray* deviceIDs;
+    NSData* values;
+    vDSP_Length const count = [self snapshotMeaning:meaning deviceIDs:&deviceIDs values:&values timestamps:NULL];
+    if (!count) { return [NSSet set]; }
+
+    // Differences against the threshold; the comparison is then a sign check.
+    NSMutableData* differences = [NSMutableData dataWithLength:count * sizeof(double)];
+    double* delta = differences.mutableBytes;
+    double const negativeValue = -value;
+    vDSP_vsaddD(values.bytes, 1, &negativeValue, delta, 1, count);
+
+    NSMutableSet* result = [[NSMutableSet alloc] init];
+    for (vDSP_Length i=0; i<count; ++i)
+    {
+        BOOL passes;
+        switch (comparison)
+        {
+            case HtHComparisonLess:             passes = delta[i] < 0.0; break;
+            case HtHComparisonLessOrEqual:      passes = delta[i] <= 0.0; break;
+            case HtHComparisonEqual:            passes = delta[i] == 0.0; break;
+            case HtHComparisonGreaterOrEqual:   passes = delta[i] >= 0.0; break;
+            case HtHComparisonGreater:          passes = delta[i] > 0.0; break;
+            default:                            passes = NO; break;
+        }
+        if (passes) { [result addObject:deviceIDs[i]]; }
+    }
+    return result;
+}
+
+- (NSUInteger)snapshotMeaning:(NSString*)meaning deviceIDs:(NSArray**)deviceIDs values:(NSData**)values timestamps:(NSData**)timestamps
+{
+    __block NSUInteger result = 0;
+    dispatch_sync(_queue, ^{
+        HtHLatestColumns* columns = (meaning) ? _columns[meaning] : nil;
+        result = columns.deviceIDs.count;
+        if (deviceIDs) { *deviceIDs = (columns) ? columns.deviceIDs.copy : @[]; }
+        if (values) { *values = (columns) ? columns.values.copy : [NSData data]; }
+        if (timestamps) { *timestamps = (columns) ? columns.timestamps.copy : [NSData data]; }
+    });
+    return result;
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        result = @{
+            @"latest.meanings"  : @(_columns.count),
+            @"latest.rows"      : @(_rowsCount)
+        };
+    });
+    return result;
+}
+
+@end
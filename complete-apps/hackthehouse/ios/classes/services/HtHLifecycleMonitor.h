@@ -0,0 +1,41 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract Suspends reading subscriptions while the app is in the background and backfills the gap when it comes back.
+ *  @discussion When the app enters the background, the <code>HtHReadingHub</code> upstreams are kept, downshifted or suspended following the <code>backgroundPolicy</code> of their subscriptions. On resume, the history of every suspended device is fetched (one request per device) and handed to the hub in a single batch, instead of replaying the samples one by one.
+ *  It must be called from the main queue.
+ */
+@interface HtHLifecycleMonitor : NSObject
+
++ (instancetype)sharedMonitor;
+
+/*!
+ *  @abstract Whether the app is in the background.
+ */
+@property (readonly,nonatomic,getter=isInBackground) BOOL inBackground;
+
+/*!
+ *  @abstract Gaps longer than this are only backfilled for their last part. Default: 1 day.
+ */
+@property (nonatomic) NSTimeInterval maximumBackfill;
+
+/*!
+ *  @abstract To be called from <code>applicationDidEnterBackground:</code>.
+ */
+- (void)enterBackground;
+
+/*!
+ *  @abstract To be called from <code>applicationWillEnterForeground:</code>.
+ *
+ *  @param user User whose credentials are used to fetch history. If <code>nil</code>, upstreams are resumed without backfill.
+ *  @param completion Block executed once the backfill has been handed to the hub with the number of samples recovered and the first error found (if any). It can be <code>nil</code>.
+ */
+- (void)enterForegroundWithUser:(RelayrUser*)user completion:(void (^)(NSError* error, NSUInteger backfilled))completion;
+
+/*!
+ *  @abstract Counters: background periods, devices backfilled, samples backfilled and failed history requests.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,88 @@
+#import "HtHLifecycleMonitor.h"     // Header
+#import "HtHReadingHub.h"           // HtH
+#import "HtHCloudClient.h"          // HtH
+
+#define HtHLifecycleMonitor_maximumBackfill 86400.0
+
+@implementation HtHLifecycleMonitor
+{
+    NSUInteger _backgroundCount;
+    NSUInteger _devicesCount;
+    NSUInteger _samplesCount;
+    NSUInteger _failuresCount;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedMonitor
+{
+    static HtHLifecycleMonitor* monitor;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ monitor = [[HtHLifecycleMonitor alloc] init]; });
+    return monitor;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _maximumBackfill = HtHLifecycleMonitor_maximumBackfill;
+    }
+    return self;
+}
+
+- (void)enterBackground
+{
+    if (_inBackground) { return; }
+    _inBackground = YES;
+    _backgroundCount++;
+
+    [[HtHReadingHub sharedHub] enterBackground];
+}
+
+- (void)enterForegroundWithUser:(RelayrUser*)user completion:(void (^)(NSError* error, NSUInteger backfilled))completion
+{
+    if (!_inBackground) { if (completion) { completion(nil, 0); } return; }
+    _inBackground = NO;
+
+    HtHCloudClient* client = [HtHCloudClient clientForUser:user];
+    NSTimeInterval const maximumBackfill = _maximumBackfill;
+
+    [[HtHReadingHub sharedHub] enterForegroundWithCompletion:^(NSDictionary* gaps) {
+        if (!client || !gaps.count) { if (completion) { completion(nil, 0); } return; }
+
+        NSDate* end = [NSDate date];
+        NSMutableArray* samples = [[NSMutableArray alloc] init];
+        __block NSError* firstError;
+        dispatch_group_t group = dispatch_group_create();
+
+        [gaps enumerateKeysAndObjectsUsingBlock:^(NSString* deviceID, NSDate* since, BOOL* stop) {
+            NSDate* start = [since laterDate:[end dateByAddingTimeInterval:-maximumBackfill]];
+            dispatch_group_enter(group);
+            [client queryHistoryOfDeviceID:deviceID from:start to:end completion:^(NSError* error, NSArray* deviceSamples) {
+                if (error) { _failuresCount++; if (!firstError) { firstError = error; } }
+                else { _devicesCount++; [samples addObjectsFromArray:deviceSamples]; }
+                dispatch_group_leave(group);
+            }];
+        }];
+
+        dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+            _samplesCount += samples.count;
+            [[HtHReadingHub sharedHub] backfillSamples:samples];
+            if (completion) { completion(firstError, samples.count); }
+        });
+    }];
+}
+
+- (NSDictionary*)metrics
+{
+    return @{
+        @"lifecycle.backgrounds"        : @(_backgroundCount),
+        @"lifecycle.backfilledDevices"  : @(_devicesCount),
+        @"lifecycle.backfilledSamples"  : @(_samplesCount),
+        @"lifecycle.failures"           : @(_failuresCount)
+    };
+}
+
+@end
@@ -0,0 +1,68 @@
+@import Foundation;         // Apple
+#import "HtHSubscription.h" // HtH
+
+/*!
+ *  @abstract How much the work of a subscription class is degraded.
+ *
+ *  @constant HtHShedLevelNone Every sample is delivered.
+ *  @constant HtHShedLevelCoalesce Only the latest sample of every series waiting for the main queue is delivered (samples arriving before the previous ones were delivered replace them).
+ *  @constant HtHShedLevelDownsample On top of coalescing, at most one sample per series every <code>downsampleInterval</code> is delivered.
+ *  @constant HtHShedLevelPause Nothing is delivered (archival is postponed; the log still keeps everything).
+ */
+typedef NS_ENUM(NSUInteger, HtHShedLevel) {
+    HtHShedLevelNone = 0,
+    HtHShedLevelCoalesce,
+    HtHShedLevelDownsample,
+    HtHShedLevelPause
+};
+
+/*!
+ *  @abstract Adaptive controller keeping dispatch latency within a target per subscription class.
+ *  @discussion The <code>HtHReadingHub</code> reports how long samples wait between leaving the pipeline and reaching their subscribers. When the smoothed latency of any class exceeds its target, the least important class that can still be degraded goes one level down (archive first, then rules; interactive subscriptions are coalesced at most). Once every class has met its target for <code>recoveryPeriod</code> seconds, the most important degraded class goes one level up.
+ *  All methods are thread safe.
+ */
+@interface HtHLoadShedder : NSObject
+
+/*!
+ *  @abstract Latency objective of a class in seconds. Defaults: 0.1 (interactive), 0.5 (rules) and 5 (archive).
+ */
+- (NSTimeInterval)targetForClass:(HtHSubscriptionClass)subscriptionClass;
+- (void)setTarget:(NSTimeInterval)target forClass:(HtHSubscriptionClass)subscriptionClass;
+
+/*!
+ *  @abstract Deepest degradation allowed for a class. Defaults: coalesce (interactive), downsample (rules) and pause (archive).
+ */
+- (HtHShedLevel)maximumLevelForClass:(HtHSubscriptionClass)subscriptionClass;
+- (void)setMaximumLevel:(HtHShedLevel)level forClass:(HtHSubscriptionClass)subscriptionClass;
+
+/*!
+ *  @abstract Current degradation of a class.
+ */
+- (HtHShedLevel)levelForClass:(HtHSubscriptionClass)subscriptionClass;
+
+/*!
+ *  @abstract Seconds between samples of a series delivered to downsampled classes. Default: 1 second.
+ */
+@property (atomic) NSTimeInterval downsampleInterval;
+
+/*!
+ *  @abstract Seconds every class must meet its target before degradation is relaxed one step. Default: 5 seconds.
+ */
+@property (atomic) NSTimeInterval recoveryPeriod;
+
+/*!
+ *  @abstract Reports the dispatch latency measured for a class.
+ */
+- (void)recordLatency:(NSTimeInterval)latency forClass:(HtHSubscriptionClass)subscriptionClass;
+
+/*!
+ *  @abstract Reports samples not delivered to a class because of its current level.
+ */
+- (void)recordShedSamples:(NSUInteger)count level:(HtHShedLevel)level forClass:(HtHSubscriptionClass)subscriptionClass;
+
+/*!
+ *  @abstract Counters per class (e.g.: <code>shed.archive.level</code>, <code>shed.archive.latency</code>, <code>shed.archive.paused</code>) and the number of level changes.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,156 @@
+#import "HtHLoadShedder.h"  // Header
+
+#define HtHLoadShedder_downsampleInterval   1.0
+#define HtHLoadShedder_recoveryPeriod       5.0
+#define HtHLoadShedder_evaluationInterval   0.5
+#define HtHLoadShedder_latencyWeight        0.2
+
+@implementation HtHLoadShedder
+{
+    NSTimeInterval _targets[HtHSubscriptionClassCount];
+    HtHShedLevel _maximumLevels[HtHSubscriptionClassCount];
+    HtHShedLevel _levels[HtHSubscriptionClassCount];
+    double _latencies[HtHSubscriptionClassCount];   // Exponentially weighted moving average
+    NSUInteger _shed[HtHSubscriptionClassCount][HtHShedLevelPause + 1];
+    CFAbsoluteTime _evaluationTime;
+    CFAbsoluteTime _calmSince;                      // Last time a target was missed or a level changed.
+    NSUInteger _changesCount;
+}
+
+#pragma mark - Public API
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _targets[HtHSubscriptionClassInteractive] = 0.1;
+        _targets[HtHSubscriptionClassRules] = 0.5;
+        _targets[HtHSubscriptionClassArchive] = 5.0;
+        _maximumLevels[HtHSubscriptionClassInteractive] = HtHShedLevelCoalesce;
+        _maximumLevels[HtHSubscriptionClassRules] = HtHShedLevelDownsample;
+        _maximumLevels[HtHSubscriptionClassArchive] = HtHShedLevelPause;
+        _downsampleInterval = HtHLoadShedder_downsampleInterval;
+        _recoveryPeriod = HtHLoadShedder_recoveryPeriod;
+        _calmSince = CFAbsoluteTimeGetCurrent();
+    }
+    return self;
+}
+
+- (NSTimeInterval)targetForClass:(HtHSubscriptionClass)subscriptionClass
+{
+    if (subscriptionClass >= HtHSubscriptionClassCount) { return 0.0; }
+    @synchronized(self) { return _targets[subscriptionClass]; }
+}
+
+- (void)setTarget:(NSTimeInterval)target forClass:(HtHSubscriptionClass)subscriptionClass
+{
+    if (subscriptionClass >= HtHSubscriptionClassCount || target <= 0.0) { return; }
+    @synchronized(self) { _targets[subscriptionClass] = target; }
+}
+
+- (HtHShedLevel)maximumLevelForClass:(HtHSubscriptionClass)subscriptionClass
+{
+    if (subscriptionClass >= HtHSubscriptionClassCount) { return HtHShedLevelNone; }
+    @synchronized(self) { return _maximumLevels[subscriptionClass]; }
+}
+
+- (void)setMaximumLevel:(HtHShedLevel)level forClass:(HtHSubscriptionClass)subscriptionClass
+{
+    if (subscriptionClass >= HtHSubscriptionClassCount || level > HtHShedLevelPause) { return; }
+    @synchronized(self)
+    {
+        _maximumLevels[subscriptionClass] = level;
+        _levels[subscriptionClass] = MIN(_levels[subscriptionClass], level);
+    }
+}
+
+- (HtHShedLevel)levelForClass:(HtHSubscriptionClass)subscriptionClass
+{
+    if (subscriptionClass >= HtHSubscriptionClassCount) { return HtHShedLevelNone; }
+    @synchronized(self) { return _levels[subscriptionClass]; }
+}
+
+- (void)recordLatency:(NSTimeInterval)latency forClass:(HtHSubscriptionClass)subscriptionClass
+{
+    if (subscriptionClass >= HtHSubscriptionClassCount || latency < 0.0) { return; }
+
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+    @synchronized(self)
+    {
+        _latencies[subscriptionClass] += HtHLoadShedder_latencyWeight * (latency - _latencies[subscriptionClass]);
+        [self evaluateIfNeededAt:now];
+    }
+}
+
+- (void)recordShedSamples:(NSUInteger)count level:(HtHShedLevel)level forClass:(HtHSubscriptionClass)subscriptionClass
+{
+    if (subscriptionClass >= HtHSubscriptionClassCount || level > HtHShedLevelPause) { return; }
+    // Paused classes don't report latencies anymore, so shed samples also drive the evaluation (and the recovery).
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+    @synchronized(self)
+    {
+        _shed[subscriptionClass][level] += count;
+        [self evaluateIfNeededAt:now];
+    }
+}
+
+- (NSDictionary*)metrics
+{
+    static NSString* const names[HtHSubscriptionClassCount] = { @"interactive", @"rules", @"archive" };
+
+    NSMutableDictionary* result = [[NSMutableDictionary alloc] init];
+    @synchronized(self)
+    {
+        for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i)
+        {
+            result[[NSString stringWithFormat:@"shed.%@.level", names[i]]] = @(_levels[i]);
+            result[[NSString stringWithFormat:@"shed.%@.latency", names[i]]] = @(_latencies[i]);
+            result[[NSString stringWithFormat:@"shed.%@.target", names[i]]] = @(_targets[i]);
+            result[[NSString stringWithFormat:@"shed.%@.coalesced", names[i]]] = @(_shed[i][HtHShedLevelCoalesce]);
+            result[[NSString stringWithFormat:@"shed.%@.downsampled", names[i]]] = @(_shed[i][HtHShedLevelDownsample]);
+            result[[NSString stringWithFormat:@"shed.%@.paused", names[i]]] = @(_shed[i][HtHShedLevelPause]);
+        }
+        result[@"shed.changes"] = @(_changesCount);
+    }
+    return result;
+}
+
+#pragma mark - Private functionality
+
+// It must be called while synchronized on self. Degradation goes one step at a time: bottom-up when a target is missed, top-down when things are calm.
+- (void)evaluateIfNeededAt:(CFAbsoluteTime)now
+{
+    if (now - _evaluationTime < HtHLoadShedder_evaluationInterval) { return; }
+    _evaluationTime = now;
+
+    // The latency of a paused class is stale (nothing is delivered to it).
+    BOOL missed = NO;
+    for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i) { if (_levels[i] != HtHShedLevelPause && _latencies[i] > _targets[i]) { missed = YES; break; } }
+
+    if (missed)
+    {
+        _calmSince = now;
+        for (NSInteger i = HtHSubscriptionClassCount - 1; i >= 0; --i)
+        {
+            if (_levels[i] >= _maximumLevels[i]) { continue; }
+            _levels[i]++;
+            _changesCount++;
+            return;
+        }
+        return;
+    }
+
+    if (now - _calmSince < _recoveryPeriod) { return; }
+    for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i)
+    {
+        if (_levels[i] == HtHShedLevelNone) { continue; }
+        if (_levels[i] == HtHShedLevelPause) { _latencies[i] = 0.0; }
+        _levels[i]--;
+        _changesCount++;
+        _calmSince = now;
+        return;
+    }
+}
+
+@end
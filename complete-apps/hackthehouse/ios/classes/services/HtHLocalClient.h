@@ -0,0 +1,72 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Thin client of an <code>HtHLocalServer</code> running in another process of the same machine.
+ *  @discussion It doesn't sign in nor hold any SDK state: the device graph, subscriptions and commands are served by the daemon through its Unix socket. Completion and subscription blocks are executed on the main queue.
+ */
+@interface HtHLocalClient : NSObject
+
+/*!
+ *  @abstract Creates a client.
+ *
+ *  @param path Socket of the server. If <code>nil</code>, <code>HtHLocalDefaultSocketPath()</code> is used.
+ */
+- (instancetype)initWithSocketPath:(NSString*)path;
+
+@property (readonly,nonatomic) NSString* socketPath;
+
+@property (readonly,atomic,getter=isConnected) BOOL connected;
+
+/*!
+ *  @abstract Connects to the server.
+ */
+- (BOOL)connect:(NSError**)error;
+
+/*!
+ *  @abstract Closes the connection. Pending requests fail and subscriptions stop.
+ */
+- (void)disconnect;
+
+/*!
+ *  @abstract Fetches the devices of the daemon's user.
+ *
+ *  @param completion Block with an array of dictionaries (keys: id, name, model, transmitter, readings and commands).
+ */
+- (void)queryDevicesWithCompletion:(void (^)(NSError* error, NSArray* devices))completion;
+
+/*!
+ *  @abstract Opens a streaming subscription to a device.
+ *
+ *  @param deviceID Identifier of the device.
+ *  @param meaning Meaning to receive or <code>nil</code> for all of them.
+ *  @param interval Seconds between batches (0 for the server's default).
+ *  @param block Block executed with every batch of <code>HtHSample</code> objects.
+ *  @param completion Block executed with the subscription identifier (to be passed to <code>unsubscribe:</code>). It can be <code>nil</code>.
+ */
+- (void)subscribeToDeviceID:(NSString*)deviceID meaning:(NSString*)meaning interval:(NSTimeInterval)interval block:(void (^)(NSArray* samples))block completion:(void (^)(NSError* error, NSNumber* subscription))completion;
+
+- (void)unsubscribe:(NSNumber*)subscription;
+
+/*!
+ *  @abstract Sends a command through the daemon's device shadow.
+ *
+ *  @param completion Block with the outcome (an <code>HtHShadowOutcome</code>) of the command.
+ */
+- (void)sendValue:(id)value toDeviceID:(NSString*)deviceID meaning:(NSString*)meaning completion:(void (^)(NSError* error, NSUInteger outcome))completion;
+
+/*!
+ *  @abstract Fetches the metrics of the daemon's reading hub and local server.
+ */
+- (void)queryMetricsWithCompletion:(void (^)(NSError* error, NSDictionary* metrics))completion;
+
+/*!
+ *  @abstract Measures the round trip of requests answered by the server's event loops (no SDK nor main queue involved).
+ *  @discussion Pings are timed on the client's queue as their responses are read and a new one is sent as soon as one is answered, so there are always <code>inFlight</code> of them outstanding. The measurement fails if the connection closes or the server doesn't know the operation.
+ *
+ *  @param count Number of requests to send.
+ *  @param inFlight Number of requests kept outstanding.
+ *  @param completion Block with the results: <code>roundtrip.requests</code>, <code>roundtrip.seconds</code>, <code>roundtrip.throughput</code> (requests per second), <code>roundtrip.meanLatency</code> and <code>roundtrip.maximumLatency</code> (seconds).
+ */
+- (void)measureRoundTrips:(NSUInteger)count inFlight:(NSUInteger)inFlight completion:(void (^)(NSError* error, NSDictionary* result))completion;
+
+@end
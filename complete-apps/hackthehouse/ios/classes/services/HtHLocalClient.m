@@ -0,0 +1,316 @@
+#import "HtHLocalClient.h"      // Header
+#import "HtHLocalFrame.h"       // HtH
+#import "HtHSample.h"           // HtH
+#import <Relayr/Relayr.h>       // Relayr.framework
+#include <sys/socket.h>         // POSIX
+#include <unistd.h>             // POSIX
+
+@interface HtHLocalClient ()
+@property (readwrite,atomic,getter=isConnected) BOOL connected;
+@end
+
+// Progress of a round trip measurement. It is only touched on the client's queue.
+@interface HtHRoundTripMeasurement : NSObject
+@property (nonatomic) NSUInteger count;
+@property (nonatomic) NSUInteger sentCount;
+@property (nonatomic) NSUInteger answeredCount;
+@property (nonatomic) CFAbsoluteTime start;
+@property (nonatomic) NSTimeInterval latencySum;
+@property (nonatomic) NSTimeInterval maximumLatency;
+@property (copy,nonatomic) void (^completion)(NSError* error, NSDictionary* result);
+@end
+
+@implementation HtHRoundTripMeasurement
+@end
+
+@implementation HtHLocalClient
+{
+    dispatch_queue_t _queue;
+    dispatch_io_t _channel;
+    NSMutableData* _input;
+    NSUInteger _nextRequest;
+    NSMutableDictionary* _requests;         // NSNumber -> completion block (NSError*, id result)
+    NSMutableDictionary* _handlers;         // NSNumber -> block (id result) executed on the client's queue before the completion
+    NSMutableDictionary* _subscriptions;    // NSNumber -> sample block
+    NSMutableSet* _measurements;            // HtHRoundTripMeasurement objects in progress
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithSocketPath:(NSString*)path
+{
+    self = [super init];
+    if (self)
+    {
+        _socketPath = (path.length) ? path.copy : HtHLocalDefaultSocketPath();
+        _queue = dispatch_queue_create("io.relayr.hth.localclient", DISPATCH_QUEUE_SERIAL);
+        _input = [[NSMutableData alloc] init];
+        _requests = [[NSMutableDictionary alloc] init];
+        _handlers = [[NSMutableDictionary alloc] init];
+        _subscriptions = [[NSMutableDictionary alloc] init];
+        _measurements = [[NSMutableSet alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_channel) { dispatch_io_close(_channel, DISPATCH_IO_STOP); }
+}
+
+- (BOOL)connect:(NSError**)error
+{
+    __block NSError* result;
+    dispatch_sync(_queue, ^{
+        if (self.isConnected) { return; }
+
+        struct sockaddr_un address;
+        if (!HtHLocalSocketAddress(_socketPath, &address)) { result = RelayrErrorMissingArgument; return; }
+
+        int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) { result = RelayrErrorNoServiceAvailable; return; }
+        if (connect(fd, (struct sockaddr const*)&address, sizeof(address)) != 0) { close(fd); result = RelayrErrorNoServiceAvailable; return; }
+
+        int const noSigPipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+
+        _channel = dispatch_io_create(DISPATCH_IO_STREAM, fd, _queue, ^(int error) { close(fd); });
+        dispatch_io_set_low_water(_channel, 1);
+        self.connected = YES;
+
+        __weak HtHLocalClient* weakSelf = self;
+        dispatch_io_t channel = _channel;
+        dispatch_io_read(channel, 0, SIZE_MAX, _queue, ^(bool done, dispatch_data_t data, int error) {
+            HtHLocalClient* strongSelf = weakSelf;
+            if (!strongSelf || strongSelf->_channel != channel) { return; }
+            [strongSelf receiveData:data done:done || error];
+        });
+    });
+
+    if (result && error) { *error = result; }
+    return !result;
+}
+
+- (void)disconnect
+{
+    dispatch_async(_queue, ^{ [self closeWithError:nil]; });
+}
+
+- (void)queryDevicesWithCompletion:(void (^)(NSError* error, NSArray* devices))completion
+{
+    [self sendRequest:@{ kHtHLocalKeyOperation : kHtHLocalOperationDevices } handler:nil completion:^(NSError* error, id result) {
+        if (completion) { completion(error, ([result isKindOfClass:[NSArray class]]) ? result : nil); }
+    }];
+}
+
+- (void)subscribeToDeviceID:(NSString*)deviceID meaning:(NSString*)meaning interval:(NSTimeInterval)interval block:(void (^)(NSArray* samples))block completion:(void (^)(NSError* error, NSNumber* subscription))completion
+{
+    if (!deviceID.length || !block) { if (completion) { completion(RelayrErrorMissingArgument, nil); } return; }
+
+    NSMutableDictionary* request = [NSMutableDictionary dictionaryWithDictionary:@{ kHtHLocalKeyOperation : kHtHLocalOperationSubscribe, kHtHLocalKeyDevice : deviceID }];
+    if (meaning) { request[kHtHLocalKeyMeaning] = meaning; }
+    if (interval > 0.0) { request[kHtHLocalKeyInterval] = @(interval); }
+
+    // The block is registered as soon as the response is read, so no batch arriving right after it is missed.
+    void (^samplesBlock)(NSArray*) = [block copy];
+    [self sendRequest:request handler:^(id result) {
+        if ([result isKindOfClass:[NSNumber class]]) { _subscriptions[result] = samplesBlock; }
+    } completion:^(NSError* error, id result) {
+        NSNumber* subscription = ([result isKindOfClass:[NSNumber class]]) ? result : nil;
+        if (completion) { completion((subscription || error) ? error : RelayrErrorUnknwon, subscription); }
+    }];
+}
+
+- (void)unsubscribe:(NSNumber*)subscription
+{
+    if (!subscription) { return; }
+    dispatch_async(_queue, ^{ [_subscriptions removeObjectForKey:subscription]; });
+    [self sendRequest:@{ kHtHLocalKeyOperation : kHtHLocalOperationUnsubscribe, kHtHLocalKeySubscription : subscription } handler:nil completion:nil];
+}
+
+- (void)sendValue:(id)value toDeviceID:(NSString*)deviceID meaning:(NSString*)meaning completion:(void (^)(NSError* error, NSUInteger outcome))completion
+{
+    if (!value || !deviceID.length || !meaning.length) { if (completion) { completion(RelayrErrorMissingArgument, 0); } return; }
+
+    NSDictionary* request = @{ kHtHLocalKeyOperation : kHtHLocalOperationCommand, kHtHLocalKeyDevice : deviceID, kHtHLocalKeyMeaning : meaning, kHtHLocalKeyValue : value };
+    [self sendRequest:request handler:nil completion:^(NSError* error, id result) {
+        NSNumber* outcome = ([result isKindOfClass:[NSDictionary class]]) ? result[@"outcome"] : nil;
+        if (completion) { completion(error, outcome.unsignedIntegerValue); }
+    }];
+}
+
+- (void)queryMetricsWithCompletion:(void (^)(NSError* error, NSDictionary* metrics))completion
+{
+    [self sendRequest:@{ kHtHLocalKeyOperation : kHtHLocalOperationMetrics } handler:nil completion:^(NSError* error, id result) {
+        if (completion) { completion(error, ([result isKindOfClass:[NSDictionary class]]) ? result : nil); }
+    }];
+}
+
+- (void)measureRoundTrips:(NSUInteger)count inFlight:(NSUInteger)inFlight completion:(void (^)(NSError* error, NSDictionary* result))completion
+{
+    if (!completion) { return; }
+    if (!count || !inFlight) { completion(RelayrErrorMissingArgument, nil); return; }
+
+    HtHRoundTripMeasurement* measurement = [[HtHRoundTripMeasurement alloc] init];
+    measurement.count = count;
+    measurement.completion = completion;
+
+    dispatch_async(_queue, ^{
+        if (!self.isConnected) { dispatch_async(dispatch_get_main_queue(), ^{ completion(RelayrErrorNoServiceAvailable, nil); }); return; }
+
+        [_measurements addObject:measurement];
+        measurement.start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0, n = MIN(count, inFlight); i < n; ++i) { [self sendPingOfMeasurement:measurement]; }
+    });
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the client's queue.
+- (void)sendPingOfMeasurement:(HtHRoundTripMeasurement*)measurement
+{
+    measurement.sentCount++;
+    CFAbsoluteTime const sent = CFAbsoluteTimeGetCurrent();
+
+    __weak HtHLocalClient* weakSelf = self;
+    void (^handler)(id) = ^(id result) {
+        HtHLocalClient* strongSelf = weakSelf;
+        if (!strongSelf || ![strongSelf->_measurements containsObject:measurement]) { return; }
+
+        NSTimeInterval const latency = CFAbsoluteTimeGetCurrent() - sent;
+        measurement.latencySum += latency;
+        measurement.maximumLatency = MAX(measurement.maximumLatency, latency);
+        measurement.answeredCount++;
+
+        if (measurement.sentCount < measurement.count) { return [strongSelf sendPingOfMeasurement:measurement]; }
+        if (measurement.answeredCount == measurement.count) { [strongSelf finishMeasurement:measurement error:nil]; }
+    };
+
+    // Handlers only run on success; the first ping also gets a completion, so a server not knowing the operation fails the measurement instead of stalling it. The rest don't, to keep the main queue out of the timing.
+    void (^completion)(NSError*, id) = (measurement.sentCount == 1) ? ^(NSError* error, id result) {
+        HtHLocalClient* strongSelf = weakSelf;
+        if (error && strongSelf) { dispatch_async(strongSelf->_queue, ^{ [strongSelf finishMeasurement:measurement error:error]; }); }
+    } : nil;
+
+    [self sendRequest:@{ kHtHLocalKeyOperation : kHtHLocalOperationPing } handler:handler completion:completion];
+}
+
+// It must be called from the client's queue.
+- (void)finishMeasurement:(HtHRoundTripMeasurement*)measurement error:(NSError*)error
+{
+    if (![_measurements containsObject:measurement]) { return; }
+    [_measurements removeObject:measurement];
+
+    void (^completion)(NSError*, NSDictionary*) = measurement.completion;
+    if (error) { dispatch_async(dispatch_get_main_queue(), ^{ completion(error, nil); }); return; }
+
+    NSTimeInterval const seconds = MAX(CFAbsoluteTimeGetCurrent() - measurement.start, 1e-6);
+    NSDictionary* result = @{
+        @"roundtrip.requests"       : @(measurement.answeredCount),
+        @"roundtrip.seconds"        : @(seconds),
+        @"roundtrip.throughput"     : @(measurement.answeredCount / seconds),
+        @"roundtrip.meanLatency"    : @(measurement.latencySum / measurement.answeredCount),
+        @"roundtrip.maximumLatency" : @(measurement.maximumLatency)
+    };
+    dispatch_async(dispatch_get_main_queue(), ^{ completion(nil, result); });
+}
+
+- (void)sendRequest:(NSDictionary*)request handler:(void (^)(id result))handler completion:(void (^)(NSError* error, id result))completion
+{
+    void (^block)(NSError*, id) = [completion copy];
+    void (^handlerBlock)(id) = [handler copy];
+    dispatch_async(_queue, ^{
+        if (!self.isConnected) { if (block) { dispatch_async(dispatch_get_main_queue(), ^{ block(RelayrErrorNoServiceAvailable, nil); }); } return; }
+
+        NSNumber* identifier = @(++_nextRequest);
+        NSMutableDictionary* message = request.mutableCopy;
+        message[kHtHLocalKeyID] = identifier;
+
+        NSData* frame = HtHLocalFrameEncode(message);
+        if (!frame) { if (block) { dispatch_async(dispatch_get_main_queue(), ^{ block(RelayrErrorMissingArgument, nil); }); } return; }
+        if (block) { _requests[identifier] = block; }
+        if (handlerBlock) { _handlers[identifier] = handlerBlock; }
+
+        __weak HtHLocalClient* weakSelf = self;
+        dispatch_data_t data = dispatch_data_create(frame.bytes, frame.length, _queue, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+        dispatch_io_write(_channel, 0, data, _queue, ^(bool done, dispatch_data_t remaining, int error) {
+            if (error) { [weakSelf closeWithError:RelayrErrorNoServiceAvailable]; }
+        });
+    });
+}
+
+// It must be called from the client's queue.
+- (void)receiveData:(dispatch_data_t)data done:(BOOL)done
+{
+    if (data) { dispatch_data_apply(data, ^bool(dispatch_data_t region, size_t offset, void const* bytes, size_t size) { [_input appendBytes:bytes length:size]; return true; }); }
+
+    BOOL valid;
+    for (NSDictionary* message in HtHLocalFrameDecode(_input, &valid))
+    {
+        if ([message[kHtHLocalKeyEvent] isEqualToString:kHtHLocalKeySamples]) { [self receiveSamplesEvent:message]; continue; }
+
+        id identifier = message[kHtHLocalKeyID];
+        if (!identifier) { continue; }
+
+        NSError* error = (message[kHtHLocalKeyError]) ? [self errorWithServerMessage:message[kHtHLocalKeyError]] : nil;
+        id result = message[kHtHLocalKeyResult];
+
+        void (^handler)(id) = _handlers[identifier];
+        [_handlers removeObjectForKey:identifier];
+        if (handler && !error) { handler(result); }
+
+        void (^block)(NSError*, id) = _requests[identifier];
+        if (!block) { continue; }
+        [_requests removeObjectForKey:identifier];
+        dispatch_async(dispatch_get_main_queue(), ^{ block(error, (result == [NSNull null]) ? nil : result); });
+    }
+
+    if (!valid || done) { [self closeWithError:RelayrErrorNoServiceAvailable]; }
+}
+
+// It must be called from the client's queue.
+- (void)receiveSamplesEvent:(NSDictionary*)event
+{
+    void (^block)(NSArray*) = _subscriptions[event[kHtHLocalKeySubscription]];
+    NSArray* representations = event[kHtHLocalKeySamples];
+    if (!block || ![representations isKindOfClass:[NSArray class]]) { return; }
+
+    NSMutableArray* samples = [[NSMutableArray alloc] initWithCapacity:representations.count];
+    for (NSDictionary* representation in representations)
+    {
+        if (![representation isKindOfClass:[NSDictionary class]] || ![representation[@"deviceID"] isKindOfClass:[NSString class]]) { continue; }
+        NSNumber* timestamp = representation[@"timestamp"];
+        HtHSample* sample = [[HtHSample alloc] initWithDeviceID:representation[@"deviceID"] meaning:representation[@"meaning"] path:representation[@"path"] unit:representation[@"unit"] value:representation[@"value"] date:([timestamp isKindOfClass:[NSNumber class]]) ? [NSDate dateWithTimeIntervalSince1970:timestamp.doubleValue] : nil];
+        if (sample) { [samples addObject:sample]; }
+    }
+    if (samples.count) { dispatch_async(dispatch_get_main_queue(), ^{ block(samples); }); }
+}
+
+// The server's message is kept as the failure reason, so callers can tell a missing device from a bad argument.
+- (NSError*)errorWithServerMessage:(id)message
+{
+    NSString* reason = ([message isKindOfClass:[NSString class]]) ? message : nil;
+    return [RelayrErrors errorWithCode:kRelayrErrorCodeWebRequestFailure localizedDescription:dRelayrErrorMessageWebRequestFailure failureReason:reason userInfo:RelayrErrorUserInfoLocal];
+}
+
+// It must be called from the client's queue.
+- (void)closeWithError:(NSError*)error
+{
+    if (!self.isConnected) { return; }
+    self.connected = NO;
+
+    dispatch_io_close(_channel, DISPATCH_IO_STOP);
+    _channel = nil;
+    [_input setLength:0];
+    [_subscriptions removeAllObjects];
+    [_handlers removeAllObjects];
+
+    NSError* result = (error) ? error : RelayrErrorNoServiceAvailable;
+    for (HtHRoundTripMeasurement* measurement in _measurements.allObjects) { [self finishMeasurement:measurement error:result]; }
+
+    NSArray* blocks = _requests.allValues;
+    [_requests removeAllObjects];
+    if (blocks.count) { dispatch_async(dispatch_get_main_queue(), ^{ for (void (^block)(NSError*, id) in blocks) { block(result, nil); } }); }
+}
+
+@end
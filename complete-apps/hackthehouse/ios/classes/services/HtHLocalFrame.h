@@ -0,0 +1,52 @@
+@import Foundation;     // Apple
+#include <sys/un.h>     // POSIX
+
+/*!
+ *  @abstract Wire format shared by <code>HtHLocalServer</code> and <code>HtHLocalClient</code>.
+ *  @discussion Every message is a JSON object preceded by its length (4 bytes, big endian). Requests carry an <code>id</code> and an <code>op</code>; responses echo the <code>id</code> with either a <code>result</code> or an <code>error</code>; streamed samples come in <code>samples</code> events with no <code>id</code>.
+ */
+
+#define HtHLocalFrame_maximumLength     (4 * 1024 * 1024)
+
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyID;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyOperation;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyResult;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyError;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyEvent;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeySubscription;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeySamples;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyDevice;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyMeaning;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyValue;
+FOUNDATION_EXPORT NSString* const kHtHLocalKeyInterval;
+
+FOUNDATION_EXPORT NSString* const kHtHLocalOperationDevices;
+FOUNDATION_EXPORT NSString* const kHtHLocalOperationSubscribe;
+FOUNDATION_EXPORT NSString* const kHtHLocalOperationUnsubscribe;
+FOUNDATION_EXPORT NSString* const kHtHLocalOperationCommand;
+FOUNDATION_EXPORT NSString* const kHtHLocalOperationMetrics;
+FOUNDATION_EXPORT NSString* const kHtHLocalOperationPing;
+
+/*!
+ *  @abstract Socket path used when none is given (in the temporary directory).
+ */
+FOUNDATION_EXPORT NSString* HtHLocalDefaultSocketPath(void);
+
+/*!
+ *  @abstract Fills a Unix socket address. It returns <code>NO</code> if the path doesn't fit.
+ */
+FOUNDATION_EXPORT BOOL HtHLocalSocketAddress(NSString* path, struct sockaddr_un* address);
+
+/*!
+ *  @abstract Serialises a message (with its length prefix). It returns <code>nil</code> if the object is not valid JSON.
+ */
+FOUNDATION_EXPORT NSData* HtHLocalFrameEncode(NSDictionary* message);
+
+/*!
+ *  @abstract Removes all complete messages from the head of the buffer.
+ *
+ *  @param buffer Bytes received so far. Incomplete messages are left in it.
+ *  @param valid Set to <code>NO</code> if the stream is corrupted (the connection must be closed).
+ *	@return Array of <code>NSDictionary</code> messages.
+ */
+FOUNDATION_EXPORT NSArray* HtHLocalFrameDecode(NSMutableData* buffer, BOOL* valid);
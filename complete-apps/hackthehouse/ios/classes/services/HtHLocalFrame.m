@@ -0,0 +1,77 @@
+#import "HtHLocalFrame.h"   // Header
+
+NSString* const kHtHLocalKeyID                  = @"id";
+NSString* const kHtHLocalKeyOperation           = @"op";
+NSString* const kHtHLocalKeyResult              = @"result";
+NSString* const kHtHLocalKeyError               = @"error";
+NSString* const kHtHLocalKeyEvent               = @"event";
+NSString* const kHtHLocalKeySubscription        = @"sub";
+NSString* const kHtHLocalKeySamples             = @"samples";
+NSString* const kHtHLocalKeyDevice              = @"device";
+NSString* const kHtHLocalKeyMeaning             = @"meaning";
+NSString* const kHtHLocalKeyValue               = @"value";
+NSString* const kHtHLocalKeyInterval            = @"interval";
+
+NSString* const kHtHLocalOperationDevices       = @"devices";
+NSString* const kHtHLocalOperationSubscribe     = @"subscribe";
+NSString* const kHtHLocalOperationUnsubscribe   = @"unsubscribe";
+NSString* const kHtHLocalOperationCommand       = @"command";
+NSString* const kHtHLocalOperationMetrics       = @"metrics";
+NSString* const kHtHLocalOperationPing          = @"ping";
+
+NSString* HtHLocalDefaultSocketPath(void)
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"io.relayr.hth.sock"];
+}
+
+BOOL HtHLocalSocketAddress(NSString* path, struct sockaddr_un* address)
+{
+    char const* cPath = path.fileSystemRepresentation;
+    if (!cPath || strlen(cPath) >= sizeof(address->sun_path)) { return NO; }
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    address->sun_len = sizeof(*address);
+    strlcpy(address->sun_path, cPath, sizeof(address->sun_path));
+    return YES;
+}
+
+NSData* HtHLocalFrameEncode(NSDictionary* message)
+{
+    if (![NSJSONSerialization isValidJSONObject:message]) { return nil; }
+
+    NSData* json = [NSJSONSerialization dataWithJSONObject:message options:kNilOptions error:nil];
+    if (!json || json.length > HtHLocalFrame_maximumLength) { return nil; }
+
+    uint32_t const length = CFSwapInt32HostToBig((uint32_t)json.length);
+    NSMutableData* result = [[NSMutableData alloc] initWithCapacity:sizeof(length) + json.length];
+    [result appendBytes:&length length:sizeof(length)];
+    [result appendData:json];
+    return result;
+}
+
+NSArray* HtHLocalFrameDecode(NSMutableData* buffer, BOOL* valid)
+{
+    *valid = YES;
+    NSMutableArray* messages = [[NSMutableArray alloc] init];
+    NSUInteger consumed = 0;
+
+    while (buffer.length - consumed >= sizeof(uint32_t))
+    {
+        uint32_t length;
+        memcpy(&length, (uint8_t const*)buffer.bytes + consumed, sizeof(length));
+        length = CFSwapInt32BigToHost(length);
+        if (length > HtHLocalFrame_maximumLength) { *valid = NO; break; }
+        if (buffer.length - consumed - sizeof(length) < length) { break; }
+
+        NSData* json = [NSData dataWithBytesNoCopy:(uint8_t*)buffer.mutableBytes + consumed + sizeof(length) length:length freeWhenDone:NO];
+        id message = [NSJSONSerialization JSONObjectWithData:json options:kNilOptions error:nil];
+        if (![message isKindOfClass:[NSDictionary class]]) { *valid = NO; break; }
+
+        [messages addObject:message];
+        consumed += sizeof(length) + length;
+    }
+
+    if (consumed) { [buffer replaceBytesInRange:NSMakeRange(0, consumed) withBytes:NULL length:0]; }
+    return messages;
+}
@@ -0,0 +1,64 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract Serves the SDK hosted by this process to other local processes through a Unix socket.
+ *  @discussion One process (the daemon) signs in, keeps the device graph, the caches and the MQTT session; any number of local consumers connect with an <code>HtHLocalClient</code>. Consumers can query the device graph, open streaming subscriptions (samples are batched per connection, one message every <code>interval</code> seconds) and send commands (through the device shadows). Resource use doesn't grow with the number of consumers and they don't need to sign in.
+ *  Connections are spread across one event loop per active core (a serial queue with read and write dispatch sources, i.e. kqueue readiness). Sockets are drained into a read buffer owned by the loop and all messages a connection produces during a turn of its loop are written with a single syscall. The unwritten output of a connection is bounded: a consumer that doesn't keep up loses sample batches, and is disconnected if not even a response fits.
+ */
+@interface HtHLocalServer : NSObject
+
+/*!
+ *  @abstract Creates a server on behalf of a user.
+ *
+ *  @param user Signed-in user whose devices are served.
+ *  @param path File system path of the socket. If <code>nil</code>, <code>HtHLocalDefaultSocketPath()</code> is used.
+ */
+- (instancetype)initWithUser:(RelayrUser*)user socketPath:(NSString*)path;
+
+@property (readonly,weak,nonatomic) RelayrUser* user;
+@property (readonly,nonatomic) NSString* socketPath;
+
+/*!
+ *  @abstract Default seconds between sample batches of a subscription that doesn't ask for a specific interval. Default: 0.1 seconds.
+ */
+@property (atomic) NSTimeInterval defaultBatchInterval;
+
+/*!
+ *  @abstract Block deciding which devices (by identifier) are served. If <code>nil</code>, all devices of the user are served.
+ *  @discussion An <code>HtHClusterNode</code> uses it to serve only the devices it owns. It is executed on the main queue.
+ */
+@property (copy,atomic) BOOL (^deviceFilter)(NSString* deviceID);
+
+/*!
+ *  @abstract Number of event loops connections are spread across (one per active core).
+ */
+@property (readonly,nonatomic) NSUInteger loopsCount;
+
+@property (readonly,atomic,getter=isRunning) BOOL running;
+
+/*!
+ *  @abstract Binds the socket (replacing any stale one) and starts accepting connections.
+ */
+- (BOOL)start:(NSError**)error;
+
+/*!
+ *  @abstract Closes all connections (dropping their subscriptions) and removes the socket.
+ */
+- (void)stop;
+
+/*!
+ *  @abstract Cancels the streaming subscriptions consumers opened on any of the devices passed (e.g.: devices no longer passing <code>deviceFilter</code>).
+ *  @discussion Consumers are not notified; their subscriptions simply stop streaming.
+ *
+ *  @param deviceIDs Set of <code>NSString</code> device identifiers.
+ */
+- (void)dropSubscriptionsOfDeviceIDs:(NSSet*)deviceIDs;
+
+/*!
+ *  @abstract Counters: event loops, connections open and accepted, requests served, subscriptions open, batches and samples streamed, samples dropped (not JSON or not fitting a slow consumer's output), connections closed for overflowing their output, and messages sent with the read and write syscalls it took.
+ *  @discussion Consumers get them (together with the reading hub's) from <code>-[HtHLocalClient queryMetricsWithCompletion:]</code>; comparing <code>local.messages</code> with <code>local.writes</code> around an <code>-[HtHLocalClient measureRoundTrips:inFlight:completion:]</code> run shows how many messages each write syscall carries.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
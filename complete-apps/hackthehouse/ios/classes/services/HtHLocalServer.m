@@ -0,0 +1,563 @@
+#import "HtHLocalServer.h"  // Header
+#import "HtHLocalFrame.h"   // HtH
+#import "HtHReadingHub.h"   // HtH
+#import "HtHDeviceShadow.h" // HtH
+#include <errno.h>          // POSIX
+#include <fcntl.h>          // POSIX
+#include <sys/socket.h>     // POSIX
+#include <unistd.h>         // POSIX
+
+#define HtHLocalServer_backlog          128
+#define HtHLocalServer_batchInterval    0.1
+#define HtHLocalServer_minimumInterval  0.01
+#define HtHLocalServer_maximumLoops     16
+#define HtHLocalServer_readBufferSize   (64 * 1024)
+#define HtHLocalServer_maximumOutput    (2 * HtHLocalFrame_maximumLength)
+
+@class HtHLocalServer;
+
+// An event loop: a serial queue servicing the sockets of its connections with readiness sources. Everything it owns is only touched on its queue.
+@interface HtHLocalLoop : NSObject
+@property (strong,nonatomic) dispatch_queue_t queue;
+@property (readonly,nonatomic) uint8_t* buffer;                     // Read buffer reused by every connection of the loop
+@property (strong,nonatomic) NSMutableSet* connections;
+@property (nonatomic) NSUInteger readsCount;
+@property (nonatomic) NSUInteger writesCount;
+@property (nonatomic) NSUInteger messagesCount;
+@property (nonatomic) NSUInteger requestsCount;
+@property (nonatomic) NSUInteger batchesCount;
+@property (nonatomic) NSUInteger samplesCount;
+@property (nonatomic) NSUInteger droppedCount;
+@property (nonatomic) NSUInteger overflowsCount;
+@end
+
+@implementation HtHLocalLoop
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _queue = dispatch_queue_create("io.relayr.hth.local.loop", DISPATCH_QUEUE_SERIAL);
+        _buffer = malloc(HtHLocalServer_readBufferSize);
+        _connections = [[NSMutableSet alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_buffer);
+}
+
+@end
+
+// A consumer connected to the server. It is only touched on the queue of its loop.
+@interface HtHLocalConnection : NSObject
+@property (strong,nonatomic) HtHLocalLoop* loop;
+@property (nonatomic) int fd;
+@property (strong,nonatomic) dispatch_source_t readSource;
+@property (strong,nonatomic) dispatch_source_t writeSource;
+@property (nonatomic,getter=isWriteSourceActive) BOOL writeSourceActive;
+@property (nonatomic,getter=isFlushScheduled) BOOL flushScheduled;
+@property (strong,nonatomic) NSMutableData* input;
+@property (strong,nonatomic) NSMutableData* output;                 // Frames waiting to be written in a single syscall
+@property (strong,nonatomic) NSMutableDictionary* subscriptions;    // NSNumber -> HtHSubscription
+@property (strong,nonatomic) NSMutableDictionary* intervals;        // NSNumber -> NSNumber (seconds between batches)
+@property (strong,nonatomic) NSMutableDictionary* pending;          // NSNumber -> NSMutableArray of sample dictionaries
+@property (strong,nonatomic) NSMutableDictionary* flushTimes;       // NSNumber -> NSNumber (CFAbsoluteTime of the scheduled flush)
+@property (nonatomic) NSUInteger nextSubscription;
+@property (nonatomic,getter=isClosed) BOOL closed;
+@end
+
+@implementation HtHLocalConnection
+@end
+
+@interface HtHLocalServer ()
+@property (readwrite,atomic,getter=isRunning) BOOL running;
+@end
+
+@implementation HtHLocalServer
+{
+    dispatch_queue_t _queue;
+    dispatch_source_t _acceptSource;
+    NSArray* _loops;
+
+    NSUInteger _acceptedCount;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithUser:(RelayrUser*)user socketPath:(NSString*)path
+{
+    if (!user) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _user = user;
+        _socketPath = (path.length) ? path.copy : HtHLocalDefaultSocketPath();
+        _queue = dispatch_queue_create("io.relayr.hth.local", DISPATCH_QUEUE_SERIAL);
+        _defaultBatchInterval = HtHLocalServer_batchInterval;
+
+        NSMutableArray* loops = [[NSMutableArray alloc] init];
+        NSUInteger const count = MIN(MAX([NSProcessInfo processInfo].activeProcessorCount, (NSUInteger)1), (NSUInteger)HtHLocalServer_maximumLoops);
+        for (NSUInteger i = 0; i < count; ++i) { [loops addObject:[[HtHLocalLoop alloc] init]]; }
+        _loops = loops;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_acceptSource) { dispatch_source_cancel(_acceptSource); }
+}
+
+- (BOOL)start:(NSError**)error
+{
+    __block NSError* result;
+    dispatch_sync(_queue, ^{
+        if (self.isRunning) { return; }
+
+        struct sockaddr_un address;
+        if (!HtHLocalSocketAddress(_socketPath, &address)) { result = RelayrErrorMissingArgument; return; }
+
+        int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) { result = RelayrErrorNoServiceAvailable; return; }
+
+        unlink(address.sun_path);
+        if (bind(fd, (struct sockaddr const*)&address, sizeof(address)) != 0 || listen(fd, HtHLocalServer_backlog) != 0)
+        {
+            close(fd);
+            result = RelayrErrorNoServiceAvailable;
+            return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        __weak HtHLocalServer* weakSelf = self;
+        _acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+        dispatch_source_set_event_handler(_acceptSource, ^{ [weakSelf acceptConnectionsFromSocket:fd]; });
+        dispatch_source_set_cancel_handler(_acceptSource, ^{ close(fd); });
+        dispatch_resume(_acceptSource);
+        self.running = YES;
+    });
+
+    if (result && error) { *error = result; }
+    return !result;
+}
+
+- (NSUInteger)loopsCount
+{
+    return _loops.count;
+}
+
+- (void)stop
+{
+    __block BOOL stopped = NO;
+    dispatch_sync(_queue, ^{
+        if (!self.isRunning) { return; }
+        self.running = NO;
+        stopped = YES;
+
+        dispatch_source_cancel(_acceptSource);
+        _acceptSource = nil;
+        unlink(_socketPath.fileSystemRepresentation);
+    });
+    if (!stopped) { return; }
+
+    for (HtHLocalLoop* loop in _loops)
+    {
+        dispatch_sync(loop.queue, ^{
+            for (HtHLocalConnection* connection in loop.connections.allObjects) { [self closeConnection:connection]; }
+        });
+    }
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSUInteger acceptedCount;
+    dispatch_sync(_queue, ^{ acceptedCount = _acceptedCount; });
+
+    __block NSUInteger connectionsCount = 0, subscriptionsCount = 0, readsCount = 0, writesCount = 0, messagesCount = 0, requestsCount = 0, batchesCount = 0, samplesCount = 0, droppedCount = 0, overflowsCount = 0;
+    for (HtHLocalLoop* loop in _loops)
+    {
+        dispatch_sync(loop.queue, ^{
+            connectionsCount += loop.connections.count;
+            for (HtHLocalConnection* connection in loop.connections) { subscriptionsCount += connection.subscriptions.count; }
+            readsCount += loop.readsCount;
+            writesCount += loop.writesCount;
+            messagesCount += loop.messagesCount;
+            requestsCount += loop.requestsCount;
+            batchesCount += loop.batchesCount;
+            samplesCount += loop.samplesCount;
+            droppedCount += loop.droppedCount;
+            overflowsCount += loop.overflowsCount;
+        });
+    }
+
+    return @{
+        @"local.loops"          : @(_loops.count),
+        @"local.connections"    : @(connectionsCount),
+        @"local.accepted"       : @(acceptedCount),
+        @"local.requests"       : @(requestsCount),
+        @"local.subscriptions"  : @(subscriptionsCount),
+        @"local.batches"        : @(batchesCount),
+        @"local.samples"        : @(samplesCount),
+        @"local.dropped"        : @(droppedCount),
+        @"local.overflows"      : @(overflowsCount),
+        @"local.messages"       : @(messagesCount),
+        @"local.reads"          : @(readsCount),
+        @"local.writes"         : @(writesCount)
+    };
+}
+
+- (void)dropSubscriptionsOfDeviceIDs:(NSSet*)deviceIDs
+{
+    if (!deviceIDs.count) { return; }
+
+    for (HtHLocalLoop* loop in _loops)
+    {
+        dispatch_async(loop.queue, ^{
+            for (HtHLocalConnection* connection in loop.connections)
+            {
+                [connection.subscriptions.copy enumerateKeysAndObjectsUsingBlock:^(NSNumber* identifier, HtHSubscription* subscription, BOOL* stop) {
+                    if (![deviceIDs containsObject:subscription.deviceID]) { return; }
+                    [[HtHReadingHub sharedHub] unsubscribe:subscription];
+                    [connection.subscriptions removeObjectForKey:identifier];
+                    [connection.intervals removeObjectForKey:identifier];
+                    [connection.pending removeObjectForKey:identifier];
+                    [connection.flushTimes removeObjectForKey:identifier];
+                }];
+            }
+        });
+    }
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the server's queue. Connections are spread round-robin across the loops.
+- (void)acceptConnectionsFromSocket:(int)listenFD
+{
+    while (YES)
+    {
+        int const fd = accept(listenFD, NULL, NULL);
+        if (fd < 0) { return; }
+
+        int const noSigPipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        HtHLocalLoop* loop = _loops[_acceptedCount++ % _loops.count];
+        HtHLocalConnection* connection = [[HtHLocalConnection alloc] init];
+        connection.loop = loop;
+        connection.fd = fd;
+        connection.input = [[NSMutableData alloc] init];
+        connection.output = [[NSMutableData alloc] init];
+        connection.subscriptions = [[NSMutableDictionary alloc] init];
+        connection.intervals = [[NSMutableDictionary alloc] init];
+        connection.pending = [[NSMutableDictionary alloc] init];
+        connection.flushTimes = [[NSMutableDictionary alloc] init];
+
+        // The descriptor is closed once both sources are cancelled.
+        dispatch_group_t sources = dispatch_group_create();
+        dispatch_group_enter(sources);
+        dispatch_group_enter(sources);
+        dispatch_group_notify(sources, loop.queue, ^{ close(fd); });
+
+        __weak HtHLocalServer* weakSelf = self;
+        connection.readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, loop.queue);
+        dispatch_source_set_event_handler(connection.readSource, ^{ [weakSelf readFromConnection:connection]; });
+        dispatch_source_set_cancel_handler(connection.readSource, ^{ dispatch_group_leave(sources); });
+
+        connection.writeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, (uintptr_t)fd, 0, loop.queue);
+        dispatch_source_set_event_handler(connection.writeSource, ^{ [weakSelf writeToConnection:connection]; });
+        dispatch_source_set_cancel_handler(connection.writeSource, ^{ dispatch_group_leave(sources); });
+
+        dispatch_async(loop.queue, ^{
+            [loop.connections addObject:connection];
+            dispatch_resume(connection.readSource);
+        });
+    }
+}
+
+// It must be called from the connection's loop. It drains the socket into the loop's buffer until it would block.
+- (void)readFromConnection:(HtHLocalConnection*)connection
+{
+    if (connection.isClosed) { return; }
+
+    HtHLocalLoop* loop = connection.loop;
+    BOOL done = NO;
+    while (YES)
+    {
+        ssize_t const count = read(connection.fd, loop.buffer, HtHLocalServer_readBufferSize);
+        loop.readsCount++;
+        if (count > 0) { [connection.input appendBytes:loop.buffer length:(NSUInteger)count]; }
+        if (count == HtHLocalServer_readBufferSize) { continue; }
+        if (count == 0 || (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) { done = YES; }
+        if (count < 0 && errno == EINTR) { continue; }
+        break;
+    }
+
+    BOOL valid;
+    for (NSDictionary* request in HtHLocalFrameDecode(connection.input, &valid)) { [self handleRequest:request fromConnection:connection]; }
+    if (!valid || done) { [self closeConnection:connection]; }
+}
+
+// It must be called from the connection's loop.
+- (void)closeConnection:(HtHLocalConnection*)connection
+{
+    if (connection.isClosed) { return; }
+    connection.closed = YES;
+
+    for (HtHSubscription* subscription in connection.subscriptions.allValues) { [[HtHReadingHub sharedHub] unsubscribe:subscription]; }
+    [connection.subscriptions removeAllObjects];
+    [connection.pending removeAllObjects];
+    connection.output.length = 0;
+
+    dispatch_source_cancel(connection.readSource);
+    dispatch_source_cancel(connection.writeSource);
+    if (!connection.isWriteSourceActive) { dispatch_resume(connection.writeSource); }
+    connection.readSource = nil;
+    connection.writeSource = nil;
+    [connection.loop.connections removeObject:connection];
+}
+
+// It must be called from the connection's loop. Messages are appended to the output buffer and every message produced during a turn of the loop leaves in a single write.
+// The output of a consumer that doesn't read is bounded: sample batches that don't fit are dropped and a response that doesn't fit closes the connection.
+- (void)sendMessage:(NSDictionary*)message toConnection:(HtHLocalConnection*)connection
+{
+    NSData* frame = HtHLocalFrameEncode(message);
+    if (!frame || connection.isClosed) { return; }
+
+    if (connection.output.length + frame.length > HtHLocalServer_maximumOutput)
+    {
+        if (message[kHtHLocalKeyEvent]) { connection.loop.droppedCount += [message[kHtHLocalKeySamples] count]; return; }
+        connection.loop.overflowsCount++;
+        return [self closeConnection:connection];
+    }
+
+    [connection.output appendData:frame];
+    connection.loop.messagesCount++;
+    if (connection.isFlushScheduled || connection.isWriteSourceActive) { return; }
+
+    connection.flushScheduled = YES;
+    __weak HtHLocalServer* weakSelf = self;
+    dispatch_async(connection.loop.queue, ^{
+        connection.flushScheduled = NO;
+        [weakSelf writeToConnection:connection];
+    });
+}
+
+// It must be called from the connection's loop. If the socket can't take the whole output, the write source finishes the job when it becomes writable.
+- (void)writeToConnection:(HtHLocalConnection*)connection
+{
+    if (connection.isClosed) { return; }
+
+    NSMutableData* output = connection.output;
+    while (output.length)
+    {
+        ssize_t const count = write(connection.fd, output.bytes, output.length);
+        connection.loop.writesCount++;
+        if (count > 0) { [output replaceBytesInRange:NSMakeRange(0, (NSUInteger)count) withBytes:NULL length:0]; continue; }
+        if (count < 0 && errno == EINTR) { continue; }
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { break; }
+        return [self closeConnection:connection];
+    }
+
+    BOOL const pending = (output.length > 0);
+    if (pending == connection.isWriteSourceActive) { return; }
+    connection.writeSourceActive = pending;
+    if (pending) { dispatch_resume(connection.writeSource); } else { dispatch_suspend(connection.writeSource); }
+}
+
+- (void)replyToRequest:(NSDictionary*)request connection:(HtHLocalConnection*)connection result:(id)result error:(NSError*)error
+{
+    NSMutableDictionary* response = [[NSMutableDictionary alloc] init];
+    if (request[kHtHLocalKeyID]) { response[kHtHLocalKeyID] = request[kHtHLocalKeyID]; }
+    NSString* message = (error.localizedFailureReason) ? error.localizedFailureReason : error.localizedDescription;
+    if (error) { response[kHtHLocalKeyError] = (message) ? message : @"Unknown error"; }
+    else { response[kHtHLocalKeyResult] = (result) ? result : [NSNull null]; }
+
+    dispatch_async(connection.loop.queue, ^{ [self sendMessage:response toConnection:connection]; });
+}
+
+// It must be called from the connection's loop.
+- (void)handleRequest:(NSDictionary*)request fromConnection:(HtHLocalConnection*)connection
+{
+    connection.loop.requestsCount++;
+    NSString* operation = request[kHtHLocalKeyOperation];
+
+    if ([operation isEqualToString:kHtHLocalOperationDevices])
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self replyToRequest:request connection:connection result:[self deviceGraph] error:nil];
+        });
+    }
+    else if ([operation isEqualToString:kHtHLocalOperationSubscribe])
+    {
+        [self subscribeWithRequest:request connection:connection];
+    }
+    else if ([operation isEqualToString:kHtHLocalOperationUnsubscribe])
+    {
+        NSNumber* identifier = request[kHtHLocalKeySubscription];
+        HtHSubscription* subscription = ([identifier isKindOfClass:[NSNumber class]]) ? connection.subscriptions[identifier] : nil;
+        if (subscription)
+        {
+            [[HtHReadingHub sharedHub] unsubscribe:subscription];
+            [connection.subscriptions removeObjectForKey:identifier];
+            [connection.intervals removeObjectForKey:identifier];
+            [connection.pending removeObjectForKey:identifier];
+            [connection.flushTimes removeObjectForKey:identifier];
+        }
+        [self replyToRequest:request connection:connection result:@(subscription != nil) error:nil];
+    }
+    else if ([operation isEqualToString:kHtHLocalOperationCommand])
+    {
+        [self commandWithRequest:request connection:connection];
+    }
+    else if ([operation isEqualToString:kHtHLocalOperationMetrics])
+    {
+        // The server's own counters synchronise with every loop, so they can't be gathered from this one.
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NSMutableDictionary* metrics = [NSMutableDictionary dictionaryWithDictionary:[HtHReadingHub sharedHub].metrics];
+            [metrics addEntriesFromDictionary:self.metrics];
+            [self replyToRequest:request connection:connection result:metrics error:nil];
+        });
+    }
+    else if ([operation isEqualToString:kHtHLocalOperationPing])
+    {
+        [self replyToRequest:request connection:connection result:@YES error:nil];
+    }
+    else
+    {
+        [self replyToRequest:request connection:connection result:nil error:RelayrErrorMissingArgument];
+    }
+}
+
+// It must be called on the main queue (SDK objects are not thread-safe).
+- (NSArray*)deviceGraph
+{
+    BOOL (^filter)(NSString*) = self.deviceFilter;
+    NSMutableArray* result = [[NSMutableArray alloc] init];
+    for (RelayrDevice* device in self.user.devices)
+    {
+        if (filter && (!device.uid || !filter(device.uid))) { continue; }
+
+        NSMutableArray* readings = [[NSMutableArray alloc] init];
+        for (RelayrReading* reading in device.readings)
+        {
+            NSMutableDictionary* entry = [[NSMutableDictionary alloc] init];
+            if (reading.meaning) { entry[@"meaning"] = reading.meaning; }
+            if (reading.path) { entry[@"path"] = reading.path; }
+            if (reading.unit) { entry[@"unit"] = reading.unit; }
+            [readings addObject:entry];
+        }
+
+        NSMutableArray* commands = [[NSMutableArray alloc] init];
+        for (RelayrCommand* command in device.commands)
+        {
+            if (command.meaning) { [commands addObject:command.meaning]; }
+        }
+
+        NSMutableDictionary* entry = [NSMutableDictionary dictionaryWithDictionary:@{ @"readings" : readings, @"commands" : commands }];
+        if (device.uid) { entry[@"id"] = device.uid; }
+        if (device.name) { entry[@"name"] = device.name; }
+        if (device.modelID) { entry[@"model"] = device.modelID; }
+        if (device.transmitter.uid) { entry[@"transmitter"] = device.transmitter.uid; }
+        [result addObject:entry];
+    }
+    return result;
+}
+
+- (RelayrDevice*)deviceWithID:(NSString*)deviceID
+{
+    if (![deviceID isKindOfClass:[NSString class]]) { return nil; }
+
+    BOOL (^filter)(NSString*) = self.deviceFilter;
+    if (filter && !filter(deviceID)) { return nil; }
+    for (RelayrDevice* device in self.user.devices) { if ([device.uid isEqualToString:deviceID]) { return device; } }
+    return nil;
+}
+
+// It must be called from the connection's loop.
+- (void)subscribeWithRequest:(NSDictionary*)request connection:(HtHLocalConnection*)connection
+{
+    NSNumber* identifier = @(++connection.nextSubscription);
+    NSNumber* interval = request[kHtHLocalKeyInterval];
+    connection.intervals[identifier] = @(MAX(([interval isKindOfClass:[NSNumber class]]) ? interval.doubleValue : self.defaultBatchInterval, HtHLocalServer_minimumInterval));
+
+    NSString* meaning = ([request[kHtHLocalKeyMeaning] isKindOfClass:[NSString class]]) ? request[kHtHLocalKeyMeaning] : nil;
+    __weak HtHLocalServer* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        RelayrDevice* device = [self deviceWithID:request[kHtHLocalKeyDevice]];
+        HtHSubscription* subscription = (!device) ? nil : [[HtHReadingHub sharedHub] subscribeToDevice:device meaning:meaning withBlock:^(HtHSample* sample, BOOL* unsubscribe) {
+            HtHLocalServer* strongSelf = weakSelf;
+            if (!strongSelf || connection.isClosed) { *unsubscribe = YES; return; }
+            NSDictionary* representation = sample.dictionaryRepresentation;
+            dispatch_async(connection.loop.queue, ^{ [strongSelf enqueueSample:representation forSubscription:identifier connection:connection]; });
+        } error:nil];
+
+        dispatch_async(connection.loop.queue, ^{
+            if (subscription && !connection.isClosed)
+            {
+                connection.subscriptions[identifier] = subscription;
+                return [self sendMessage:@{ kHtHLocalKeyID : (request[kHtHLocalKeyID]) ? request[kHtHLocalKeyID] : [NSNull null], kHtHLocalKeyResult : identifier } toConnection:connection];
+            }
+
+            [[HtHReadingHub sharedHub] unsubscribe:subscription];
+            [connection.intervals removeObjectForKey:identifier];
+            [self replyToRequest:request connection:connection result:nil error:(device) ? RelayrErrorMissingArgument : RelayrErrorMissingExpectedValue];
+        });
+    });
+}
+
+// It must be called from the connection's loop. Samples are batched per subscription and flushed every interval.
+// Samples that can't be represented in JSON (e.g.: binary or NaN values) are dropped one by one, so they don't take their batch with them.
+- (void)enqueueSample:(NSDictionary*)sample forSubscription:(NSNumber*)identifier connection:(HtHLocalConnection*)connection
+{
+    if (connection.isClosed || !connection.subscriptions[identifier]) { return; }
+    if (![NSJSONSerialization isValidJSONObject:sample]) { connection.loop.droppedCount++; return; }
+
+    NSMutableArray* pending = connection.pending[identifier];
+    if (!pending) { pending = [[NSMutableArray alloc] init]; connection.pending[identifier] = pending; }
+    [pending addObject:sample];
+    if (connection.flushTimes[identifier]) { return; }
+
+    NSTimeInterval const interval = [connection.intervals[identifier] doubleValue];
+    connection.flushTimes[identifier] = @(CFAbsoluteTimeGetCurrent() + interval);
+
+    __weak HtHLocalServer* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), connection.loop.queue, ^{
+        HtHLocalServer* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+
+        [connection.flushTimes removeObjectForKey:identifier];
+        NSArray* samples = connection.pending[identifier];
+        [connection.pending removeObjectForKey:identifier];
+        if (!samples.count || connection.isClosed) { return; }
+
+        connection.loop.batchesCount++;
+        connection.loop.samplesCount += samples.count;
+        [strongSelf sendMessage:@{ kHtHLocalKeyEvent : kHtHLocalKeySamples, kHtHLocalKeySubscription : identifier, kHtHLocalKeySamples : samples } toConnection:connection];
+    });
+}
+
+// It must be called from the connection's loop.
+- (void)commandWithRequest:(NSDictionary*)request connection:(HtHLocalConnection*)connection
+{
+    NSString* meaning = request[kHtHLocalKeyMeaning];
+    id value = request[kHtHLocalKeyValue];
+    if (![meaning isKindOfClass:[NSString class]] || !value) { return [self replyToRequest:request connection:connection result:nil error:RelayrErrorMissingArgument]; }
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        RelayrDevice* device = [self deviceWithID:request[kHtHLocalKeyDevice]];
+        HtHDeviceShadow* shadow = (device) ? [HtHDeviceShadow shadowForDevice:device] : nil;
+        if (!shadow) { return [self replyToRequest:request connection:connection result:nil error:RelayrErrorMissingExpectedValue]; }
+
+        [shadow setDesiredValue:value forMeaning:meaning completion:^(HtHShadowOutcome outcome, NSTimeInterval latency, NSError* error) {
+            [self replyToRequest:request connection:connection result:@{ @"outcome" : @(outcome), @"latency" : @(latency) } error:error];
+        }];
+    });
+}
+
+@end
@@ -0,0 +1,60 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Minimal blocking MQTT 3.1.1 client over plain TCP.
+ *  @discussion It only publishes (with QoS 1) and all calls block the calling thread until the broker answers or <code>timeout</code> expires. It is not thread safe; use it from a single serial queue.
+ */
+@interface HtHMQTTClient : NSObject
+
+/*!
+ *  @abstract Creates a client (it doesn't connect).
+ *
+ *  @param host Host name or address of the broker.
+ *  @param port TCP port of the broker (usually 1883).
+ *  @param clientID MQTT client identifier. It must be unique per broker.
+ */
+- (instancetype)initWithHost:(NSString*)host port:(uint16_t)port clientID:(NSString*)clientID;
+
+@property (readonly,nonatomic) NSString* host;
+@property (readonly,nonatomic) uint16_t port;
+@property (readonly,nonatomic) NSString* clientID;
+
+/*!
+ *  @abstract Credentials sent on connection. They can be <code>nil</code>.
+ */
+@property (copy,nonatomic) NSString* username;
+@property (copy,nonatomic) NSString* password;
+
+/*!
+ *  @abstract Keep alive announced to the broker. An idle connection is reopened before it is used again. Default: 60 seconds.
+ */
+@property (nonatomic) uint16_t keepAlive;
+
+/*!
+ *  @abstract Seconds to wait for any socket operation. Default: 10.
+ */
+@property (nonatomic) NSTimeInterval timeout;
+
+@property (readonly,nonatomic,getter=isConnected) BOOL connected;
+
+/*!
+ *  @abstract Opens the TCP connection and performs the MQTT handshake.
+ */
+- (BOOL)connect:(NSError**)error;
+
+/*!
+ *  @abstract Publishes several messages with QoS 1.
+ *  @discussion All <code>PUBLISH</code> packets are sent back to back and then the method waits for all acknowledgements. The client (re)connects if needed. If anything fails the connection is closed, so the next call starts afresh.
+ *
+ *  @param payloads Array of <code>NSData</code> objects.
+ *  @param topics Array of <code>NSString</code> topics, one per payload.
+ *	@return <code>YES</code> if the broker acknowledged all messages.
+ */
+- (BOOL)publishPayloads:(NSArray*)payloads toTopics:(NSArray*)topics error:(NSError**)error;
+
+/*!
+ *  @abstract Sends a <code>DISCONNECT</code> packet (if connected) and closes the socket.
+ */
+- (void)disconnect;
+
+@end
@@ -0,0 +1,250 @@
+#import "HtHMQTTClient.h"   // Header
+#import <Relayr/Relayr.h>   // Relayr.framework
+#include <netdb.h>          // POSIX
+#include <netinet/in.h>     // POSIX
+#include <netinet/tcp.h>    // POSIX
+#include <sys/socket.h>     // POSIX
+#include <unistd.h>         // POSIX
+
+#define HtHMQTTClient_keepAlive     60
+#define HtHMQTTClient_timeout       10.0
+
+#define HtHMQTTPacketConnect        0x10
+#define HtHMQTTPacketConnack        0x20
+#define HtHMQTTPacketPublishQoS1    0x32
+#define HtHMQTTPacketPuback         0x40
+#define HtHMQTTPacketDisconnect     0xE0
+
+@implementation HtHMQTTClient
+{
+    int _socket;
+    uint16_t _packetID;
+    CFAbsoluteTime _lastActivity;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithHost:(NSString*)host port:(uint16_t)port clientID:(NSString*)clientID
+{
+    if (!host.length || !port || !clientID.length) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _host = host.copy;
+        _port = port;
+        _clientID = clientID.copy;
+        _keepAlive = HtHMQTTClient_keepAlive;
+        _timeout = HtHMQTTClient_timeout;
+        _socket = -1;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self disconnect];
+}
+
+- (BOOL)isConnected
+{
+    return _socket >= 0;
+}
+
+- (BOOL)connect:(NSError**)error
+{
+    if (_socket >= 0) { return YES; }
+    if (![self openSocket]) { if (error) { *error = RelayrErrorMQTTUnableToConnect; } return NO; }
+
+    NSData* username = [_username dataUsingEncoding:NSUTF8StringEncoding];
+    NSData* password = [_password dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t flags = 0x02;   // Clean session.
+    if (username) { flags |= 0x80; }
+    if (username && password) { flags |= 0x40; }
+
+    NSMutableData* body = [[NSMutableData alloc] init];
+    [HtHMQTTClient appendString:[@"MQTT" dataUsingEncoding:NSUTF8StringEncoding] toData:body];
+    uint8_t const header[] = { 0x04, flags, (uint8_t)(_keepAlive >> 8), (uint8_t)(_keepAlive & 0xFF) };
+    [body appendBytes:header length:sizeof(header)];
+    [HtHMQTTClient appendString:[_clientID dataUsingEncoding:NSUTF8StringEncoding] toData:body];
+    if (flags & 0x80) { [HtHMQTTClient appendString:username toData:body]; }
+    if (flags & 0x40) { [HtHMQTTClient appendString:password toData:body]; }
+
+    NSMutableData* packet = [[NSMutableData alloc] init];
+    [HtHMQTTClient appendPacketType:HtHMQTTPacketConnect body:body toData:packet];
+
+    uint8_t type;
+    NSData* answer;
+    if (![self sendData:packet] || ![self receivePacketType:&type body:&answer] || type != HtHMQTTPacketConnack || answer.length != 2 || ((uint8_t const*)answer.bytes)[1] != 0)
+    {
+        [self closeSocket];
+        if (error) { *error = RelayrErrorMQTTUnableToConnect; }
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)publishPayloads:(NSArray*)payloads toTopics:(NSArray*)topics error:(NSError**)error
+{
+    if (payloads.count != topics.count) { if (error) { *error = RelayrErrorMissingArgument; } return NO; }
+    if (!payloads.count) { return YES; }
+
+    // The broker drops connections idle for longer than 1.5 times the keep alive; such a socket would only fail later.
+    if (_socket >= 0 && _keepAlive && CFAbsoluteTimeGetCurrent() - _lastActivity >= _keepAlive) { [self disconnect]; }
+    if (![self connect:error]) { return NO; }
+
+    NSMutableIndexSet* pending = [[NSMutableIndexSet alloc] init];
+    NSMutableData* packets = [[NSMutableData alloc] init];
+    NSMutableData* body = [[NSMutableData alloc] init];
+    for (NSUInteger i = 0; i < payloads.count; ++i)
+    {
+        // Packet identifiers must not be 0, so they wrap around to 1.
+        _packetID = (_packetID == UINT16_MAX) ? 1 : _packetID + 1;
+        [pending addIndex:_packetID];
+
+        body.length = 0;
+        [HtHMQTTClient appendString:[topics[i] dataUsingEncoding:NSUTF8StringEncoding] toData:body];
+        uint8_t const identifier[] = { (uint8_t)(_packetID >> 8), (uint8_t)(_packetID & 0xFF) };
+        [body appendBytes:identifier length:sizeof(identifier)];
+        [body appendData:payloads[i]];
+        [HtHMQTTClient appendPacketType:HtHMQTTPacketPublishQoS1 body:body toData:packets];
+    }
+
+    BOOL succeeded = [self sendData:packets];
+    while (succeeded && pending.count)
+    {
+        uint8_t type;
+        NSData* answer;
+        succeeded = [self receivePacketType:&type body:&answer];
+        if (succeeded && (type & 0xF0) == HtHMQTTPacketPuback && answer.length == 2)
+        {
+            uint8_t const* bytes = answer.bytes;
+            [pending removeIndex:((uint16_t)bytes[0] << 8) | bytes[1]];
+        }
+    }
+
+    if (!succeeded)
+    {
+        [self closeSocket];
+        if (error) { *error = RelayrErrorMQTTConnectionLost; }
+    }
+    return succeeded;
+}
+
+- (void)disconnect
+{
+    if (_socket < 0) { return; }
+    uint8_t const packet[] = { HtHMQTTPacketDisconnect, 0x00 };
+    [self sendData:[NSData dataWithBytesNoCopy:(void*)packet length:sizeof(packet) freeWhenDone:NO]];
+    [self closeSocket];
+}
+
+#pragma mark - Private functionality
+
+- (BOOL)openSocket
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_protocol = IPPROTO_TCP };
+    struct addrinfo* addresses;
+    if (getaddrinfo(_host.UTF8String, [NSString stringWithFormat:@"%u", _port].UTF8String, &hints, &addresses) != 0) { return NO; }
+
+    struct timeval const timeout = { .tv_sec = (time_t)_timeout, .tv_usec = (suseconds_t)((_timeout - floor(_timeout)) * 1e6) };
+    int const enabled = 1;
+
+    for (struct addrinfo* address = addresses; address && _socket < 0; address = address->ai_next)
+    {
+        int const fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) { continue; }
+
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+        if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) { _socket = fd; } else { close(fd); }
+    }
+
+    freeaddrinfo(addresses);
+    _lastActivity = CFAbsoluteTimeGetCurrent();
+    return _socket >= 0;
+}
+
+- (void)closeSocket
+{
+    if (_socket < 0) { return; }
+    close(_socket);
+    _socket = -1;
+}
+
+- (BOOL)sendData:(NSData*)data
+{
+    uint8_t const* bytes = data.bytes;
+    NSUInteger sent = 0;
+    while (sent < data.length)
+    {
+        ssize_t const result = send(_socket, bytes + sent, data.length - sent, 0);
+        if (result < 0 && errno == EINTR) { continue; }
+        if (result <= 0) { return NO; }
+        sent += (NSUInteger)result;
+    }
+    _lastActivity = CFAbsoluteTimeGetCurrent();
+    return YES;
+}
+
+- (BOOL)receiveBytes:(void*)buffer length:(size_t)length
+{
+    size_t received = 0;
+    while (received < length)
+    {
+        ssize_t const result = recv(_socket, (uint8_t*)buffer + received, length - received, 0);
+        if (result < 0 && errno == EINTR) { continue; }
+        if (result <= 0) { return NO; }
+        received += (size_t)result;
+    }
+    return YES;
+}
+
+- (BOOL)receivePacketType:(uint8_t*)type body:(NSData**)body
+{
+    if (![self receiveBytes:type length:1]) { return NO; }
+
+    // Remaining length: up to four bytes, seven bits each.
+    uint32_t length = 0;
+    uint8_t digit;
+    for (unsigned int shift = 0; ; shift += 7)
+    {
+        if (shift > 21 || ![self receiveBytes:&digit length:1]) { return NO; }
+        length |= (uint32_t)(digit & 0x7F) << shift;
+        if (!(digit & 0x80)) { break; }
+    }
+
+    NSMutableData* data = [[NSMutableData alloc] initWithLength:length];
+    if (length && ![self receiveBytes:data.mutableBytes length:length]) { return NO; }
+
+    _lastActivity = CFAbsoluteTimeGetCurrent();
+    *body = data;
+    return YES;
+}
+
++ (void)appendString:(NSData*)string toData:(NSMutableData*)data
+{
+    uint16_t const length = (uint16_t)MIN(string.length, (NSUInteger)UINT16_MAX);
+    uint8_t const prefix[] = { (uint8_t)(length >> 8), (uint8_t)(length & 0xFF) };
+    [data appendBytes:prefix length:sizeof(prefix)];
+    [data appendBytes:string.bytes length:length];
+}
+
++ (void)appendPacketType:(uint8_t)type body:(NSData*)body toData:(NSMutableData*)data
+{
+    [data appendBytes:&type length:1];
+
+    NSUInteger length = body.length;
+    do {
+        uint8_t digit = length & 0x7F;
+        length >>= 7;
+        if (length) { digit |= 0x80; }
+        [data appendBytes:&digit length:1];
+    } while (length);
+
+    [data appendData:body];
+}
+
+@end
@@ -0,0 +1,22 @@
+@import Foundation;     // Apple
+#import "HtHSink.h"     // HtH
+@class HtHMQTTClient;   // HtH
+
+/*!
+ *  @abstract Sink publishing every sample to an MQTT broker.
+ *  @discussion Each sample is published (with QoS 1) as a JSON object to the topic <code>topicPrefix/deviceID/meaning</code>. The whole batch is pipelined and the batch only succeeds when the broker acknowledged every message.
+ */
+@interface HtHMQTTSink : NSObject <HtHSink>
+
+/*!
+ *  @abstract Creates an MQTT sink.
+ *
+ *  @param client Client used to talk to the broker. The sink connects it when needed.
+ *  @param topicPrefix Prefix of all topics (e.g.: <code>home/readings</code>).
+ */
+- (instancetype)initWithClient:(HtHMQTTClient*)client topicPrefix:(NSString*)topicPrefix;
+
+@property (readonly,nonatomic) HtHMQTTClient* client;
+@property (readonly,nonatomic) NSString* topicPrefix;
+
+@end
@@ -0,0 +1,45 @@
+#import "HtHMQTTSink.h"     // Header
+#import "HtHMQTTClient.h"   // HtH
+#import "HtHSample.h"       // HtH
+
+@implementation HtHMQTTSink
+
+#pragma mark - Public API
+
+- (instancetype)initWithClient:(HtHMQTTClient*)client topicPrefix:(NSString*)topicPrefix
+{
+    if (!client) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _client = client;
+        _topicPrefix = ([topicPrefix hasSuffix:@"/"]) ? [topicPrefix substringToIndex:topicPrefix.length - 1] : topicPrefix.copy;
+    }
+    return self;
+}
+
+- (BOOL)writeSamples:(NSArray*)samples error:(NSError**)error
+{
+    NSMutableArray* payloads = [[NSMutableArray alloc] initWithCapacity:samples.count];
+    NSMutableArray* topics = [[NSMutableArray alloc] initWithCapacity:samples.count];
+
+    for (HtHSample* sample in samples)
+    {
+        NSData* payload = [NSJSONSerialization dataWithJSONObject:sample.dictionaryRepresentation options:kNilOptions error:nil];
+        if (!payload) { continue; }
+
+        NSString* topic = [NSString stringWithFormat:@"%@/%@", sample.deviceID, (sample.meaning.length) ? sample.meaning : @"unknown"];
+        [topics addObject:(_topicPrefix.length) ? [NSString stringWithFormat:@"%@/%@", _topicPrefix, topic] : topic];
+        [payloads addObject:payload];
+    }
+
+    return [_client publishPayloads:payloads toTopics:topics error:error];
+}
+
+- (void)close
+{
+    [_client disconnect];
+}
+
+@end
@@ -0,0 +1,49 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Parts of the app memory is attributed to.
+ *
+ *  @constant HtHMemorySubsystemDeviceGraph Cloud entities (<code>HtHCloudObject</code>).
+ *  @constant HtHMemorySubsystemSamples Live <code>HtHSample</code> objects, wherever they are.
+ *  @constant HtHMemorySubsystemQueues Samples held by pipeline stages before being delivered (e.g.: reorder buffers).
+ *  @constant HtHMemorySubsystemHistory Samples kept as history by pipeline stages (e.g.: virtual readings).
+ *  @constant HtHMemorySubsystemHTTPCache In-memory index of the HTTP response cache.
+ *  @constant HtHMemorySubsystemSubscribers Subscriptions and their blocks.
+ */
+typedef NS_ENUM(NSUInteger, HtHMemorySubsystem) {
+    HtHMemorySubsystemDeviceGraph = 0,
+    HtHMemorySubsystemSamples,
+    HtHMemorySubsystemQueues,
+    HtHMemorySubsystemHistory,
+    HtHMemorySubsystemHTTPCache,
+    HtHMemorySubsystemSubscribers,
+    HtHMemorySubsystemCount
+};
+
+/*!
+ *  @abstract Adds (or subtracts, with negative numbers) bytes and objects to a subsystem.
+ *  @discussion It is a couple of relaxed atomic additions, cheap enough to be called on every allocation. It can be called from any thread.
+ */
+FOUNDATION_EXPORT void HtHMemoryAccount(HtHMemorySubsystem subsystem, int64_t bytes, int64_t objects);
+
+/*!
+ *  @abstract Bytes allocated for an object (as reported by the allocator).
+ */
+FOUNDATION_EXPORT size_t HtHMemoryObjectSize(id object);
+
+/*!
+ *  @abstract Approximate memory accounting per subsystem.
+ *  @discussion Counters are kept by the subsystems themselves when they allocate and release what they hold. The figures are estimates meant to pin memory growth to a component rather than to match the process footprint: a sample sitting in a queue is counted both as a sample and as queued, so subsystems must not be added up.
+ */
+@interface HtHMemoryAccounting : NSObject
+
++ (int64_t)bytesForSubsystem:(HtHMemorySubsystem)subsystem;
+
++ (int64_t)objectsForSubsystem:(HtHMemorySubsystem)subsystem;
+
+/*!
+ *  @abstract Counters of all subsystems (e.g.: <code>memory.samples.bytes</code>, <code>memory.samples.objects</code>).
+ */
++ (NSDictionary*)metrics;
+
+@end
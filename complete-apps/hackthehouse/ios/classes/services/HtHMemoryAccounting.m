@@ -0,0 +1,47 @@
+#import "HtHMemoryAccounting.h" // Header
+#include <malloc/malloc.h>      // Apple
+#include <stdatomic.h>          // C11
+
+static _Atomic int64_t HtHMemoryBytes[HtHMemorySubsystemCount];
+static _Atomic int64_t HtHMemoryObjects[HtHMemorySubsystemCount];
+
+void HtHMemoryAccount(HtHMemorySubsystem subsystem, int64_t bytes, int64_t objects)
+{
+    if (subsystem >= HtHMemorySubsystemCount) { return; }
+    atomic_fetch_add_explicit(&HtHMemoryBytes[subsystem], bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&HtHMemoryObjects[subsystem], objects, memory_order_relaxed);
+}
+
+size_t HtHMemoryObjectSize(id object)
+{
+    return (object) ? malloc_size((__bridge void const*)object) : 0;
+}
+
+@implementation HtHMemoryAccounting
+
+#pragma mark - Public API
+
++ (int64_t)bytesForSubsystem:(HtHMemorySubsystem)subsystem
+{
+    return (subsystem < HtHMemorySubsystemCount) ? atomic_load_explicit(&HtHMemoryBytes[subsystem], memory_order_relaxed) : 0;
+}
+
++ (int64_t)objectsForSubsystem:(HtHMemorySubsystem)subsystem
+{
+    return (subsystem < HtHMemorySubsystemCount) ? atomic_load_explicit(&HtHMemoryObjects[subsystem], memory_order_relaxed) : 0;
+}
+
++ (NSDictionary*)metrics
+{
+    static NSString* const names[HtHMemorySubsystemCount] = { @"deviceGraph", @"samples", @"queues", @"history", @"httpCache", @"subscribers" };
+
+    NSMutableDictionary* result = [[NSMutableDictionary alloc] initWithCapacity:2 * HtHMemorySubsystemCount];
+    for (NSUInteger i = 0; i < HtHMemorySubsystemCount; ++i)
+    {
+        result[[NSString stringWithFormat:@"memory.%@.bytes", names[i]]] = @([self bytesForSubsystem:i]);
+        result[[NSString stringWithFormat:@"memory.%@.objects", names[i]]] = @([self objectsForSubsystem:i]);
+    }
+    return result;
+}
+
+@end
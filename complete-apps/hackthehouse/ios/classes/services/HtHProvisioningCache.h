@@ -0,0 +1,30 @@
+@import Foundation;     // Apple
+
+FOUNDATION_EXPORT NSString* const kHtHProvisioningFingerprint;  // NSString
+FOUNDATION_EXPORT NSString* const kHtHProvisioningWifiSalt;     // NSData
+FOUNDATION_EXPORT NSString* const kHtHProvisioningWifiHash;     // NSData
+
+/*!
+ *  @abstract What was last provisioned on every transmitter.
+ *  @discussion Records only keep a salted hash of the WiFi credentials (see <code>hashForWifiSSID:password:salt:</code>), never the password itself. They are still stored in the keychain (only accessible while the device is unlocked, and never migrated to other devices). Records written by older versions, which held the plaintext password, are deleted when read.
+ */
+@interface HtHProvisioningCache : NSObject
+
++ (NSDictionary*)recordForTransmitterID:(NSString*)transmitterID;
+
++ (BOOL)storeRecord:(NSDictionary*)record forTransmitterID:(NSString*)transmitterID;
+
++ (void)removeRecordForTransmitterID:(NSString*)transmitterID;
+
+/*!
+ *  @abstract Random salt for a new record.
+ */
++ (NSData*)newSalt;
+
+/*!
+ *  @abstract Salted hash (PBKDF2 with SHA-256) of a WiFi SSID and password.
+ *	@return The hash or <code>nil</code> if any argument is missing.
+ */
++ (NSData*)hashForWifiSSID:(NSString*)ssid password:(NSString*)password salt:(NSData*)salt;
+
+@end
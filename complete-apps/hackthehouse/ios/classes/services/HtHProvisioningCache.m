@@ -0,0 +1,96 @@
+#import "HtHProvisioningCache.h"                // Header
+@import Security;                               // Apple
+#import <CommonCrypto/CommonDigest.h>           // Apple
+#import <CommonCrypto/CommonKeyDerivation.h>    // Apple
+
+#define HtHProvisioningCache_service        @"io.relayr.hth.provisioning"
+#define HtHProvisioningCache_legacyPassword @"wifiPassword"
+#define HtHProvisioningCache_saltLength     16
+#define HtHProvisioningCache_hashRounds     10000
+
+NSString* const kHtHProvisioningFingerprint     = @"fingerprint";
+NSString* const kHtHProvisioningWifiSalt        = @"wifiSalt";
+NSString* const kHtHProvisioningWifiHash        = @"wifiHash";
+
+@implementation HtHProvisioningCache
+
+#pragma mark - Public API
+
++ (NSDictionary*)recordForTransmitterID:(NSString*)transmitterID
+{
+    if (!transmitterID.length) { return nil; }
+
+    NSMutableDictionary* query = [HtHProvisioningCache queryForTransmitterID:transmitterID];
+    query[(__bridge id)kSecReturnData] = @YES;
+    query[(__bridge id)kSecMatchLimit] = (__bridge id)kSecMatchLimitOne;
+
+    CFTypeRef data = NULL;
+    if (SecItemCopyMatching((__bridge CFDictionaryRef)query, &data) != errSecSuccess || !data) { return nil; }
+
+    id record = [NSPropertyListSerialization propertyListWithData:(__bridge_transfer NSData*)data options:NSPropertyListImmutable format:NULL error:nil];
+    if (![record isKindOfClass:[NSDictionary class]]) { return nil; }
+
+    // Older records kept the plaintext password; they are not trusted (nor kept) anymore.
+    if (record[HtHProvisioningCache_legacyPassword]) { [HtHProvisioningCache removeRecordForTransmitterID:transmitterID]; return nil; }
+    return record;
+}
+
++ (BOOL)storeRecord:(NSDictionary*)record forTransmitterID:(NSString*)transmitterID
+{
+    if (!transmitterID.length || !record) { return NO; }
+
+    NSData* data = [NSPropertyListSerialization dataWithPropertyList:record format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    if (!data) { return NO; }
+
+    NSMutableDictionary* query = [HtHProvisioningCache queryForTransmitterID:transmitterID];
+    NSDictionary* attributes = @{ (__bridge id)kSecValueData : data };
+    OSStatus status = SecItemUpdate((__bridge CFDictionaryRef)query, (__bridge CFDictionaryRef)attributes);
+    if (status != errSecItemNotFound) { return status == errSecSuccess; }
+
+    query[(__bridge id)kSecValueData] = data;
+    query[(__bridge id)kSecAttrAccessible] = (__bridge id)kSecAttrAccessibleWhenUnlockedThisDeviceOnly;
+    return SecItemAdd((__bridge CFDictionaryRef)query, NULL) == errSecSuccess;
+}
+
++ (void)removeRecordForTransmitterID:(NSString*)transmitterID
+{
+    if (!transmitterID.length) { return; }
+    SecItemDelete((__bridge CFDictionaryRef)[HtHProvisioningCache queryForTransmitterID:transmitterID]);
+}
+
++ (NSData*)newSalt
+{
+    NSMutableData* salt = [NSMutableData dataWithLength:HtHProvisioningCache_saltLength];
+    if (SecRandomCopyBytes(kSecRandomDefault, salt.length, salt.mutableBytes) != errSecSuccess) { return nil; }
+    return salt;
+}
+
++ (NSData*)hashForWifiSSID:(NSString*)ssid password:(NSString*)password salt:(NSData*)salt
+{
+    if (!ssid || !password || !salt.length) { return nil; }
+
+    // The SSID length goes first, so no other SSID/password split produces the same input.
+    NSData* ssidData = [ssid dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData* input = [NSMutableData dataWithCapacity:sizeof(uint32_t) + ssidData.length + password.length];
+    uint32_t const ssidLength = CFSwapInt32HostToBig((uint32_t)ssidData.length);
+    [input appendBytes:&ssidLength length:sizeof(ssidLength)];
+    [input appendData:ssidData];
+    [input appendData:[password dataUsingEncoding:NSUTF8StringEncoding]];
+
+    NSMutableData* result = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    int const status = CCKeyDerivationPBKDF(kCCPBKDF2, input.bytes, input.length, salt.bytes, salt.length, kCCPRFHmacAlgSHA256, HtHProvisioningCache_hashRounds, result.mutableBytes, result.length);
+    return (status == kCCSuccess) ? result : nil;
+}
+
+#pragma mark - Private functionality
+
++ (NSMutableDictionary*)queryForTransmitterID:(NSString*)transmitterID
+{
+    return [NSMutableDictionary dictionaryWithDictionary:@{
+        (__bridge id)kSecClass          : (__bridge id)kSecClassGenericPassword,
+        (__bridge id)kSecAttrService    : HtHProvisioningCache_service,
+        (__bridge id)kSecAttrAccount    : transmitterID
+    }];
+}
+
+@end
@@ -0,0 +1,107 @@
+@import Foundation;             // Apple
+#import <Relayr/Relayr.h>       // Relayr.framework
+#import "HtHLatestValueTable.h" // HtH
+@class HtHReadingLog;           // HtH
+
+/*!
+ *  @abstract Aggregate functions computed per group and time bucket.
+ */
+typedef NS_ENUM(NSUInteger, HtHQueryAggregate) {
+    HtHQueryAggregateCount,
+    HtHQueryAggregateSum,
+    HtHQueryAggregateMean,
+    HtHQueryAggregateMinimum,
+    HtHQueryAggregateMaximum
+};
+
+/*!
+ *  @abstract Columnar result of an <code>HtHQuery</code>: one row per group and time bucket with samples, sorted by group and bucket.
+ *  @discussion Numeric columns are contiguous C arrays owned by the result.
+ */
+@interface HtHQueryResult : NSObject
+
+@property (readonly,nonatomic) NSUInteger rowsCount;
+
+/*!
+ *  @abstract Group of every row (<code>NSString</code>).
+ */
+@property (readonly,nonatomic) NSArray* groups;
+
+/*!
+ *  @abstract Start of the bucket of every row (seconds since 1970). Queries over latest values have a single bucket starting at the oldest value aggregated.
+ */
+@property (readonly,nonatomic) double const* bucketStarts;
+
+/*!
+ *  @abstract Aggregated value of every row.
+ */
+@property (readonly,nonatomic) double const* values;
+
+/*!
+ *  @abstract Number of samples aggregated in every row.
+ */
+@property (readonly,nonatomic) NSUInteger const* counts;
+
+@end
+
+/*!
+ *  @abstract Ad hoc analysis over the local reading log (history) or the latest value table, e.g.: mean temperature per transmitter over the last 6 hours of the devices with humidity above 60.
+ *  @discussion Execution filters devices with the latest value table, scans the log gathering the samples of every device into its own columns, and then sorts and aggregates every device's columns in parallel (one concurrent block per device, spread across cores) with vectorised (Accelerate) kernels per time bucket. Partial aggregates are finally merged per group.
+ */
+@interface HtHQuery : NSObject
+
+/*!
+ *  @abstract Creates a query over a meaning.
+ */
+- (instancetype)initWithMeaning:(NSString*)meaning aggregate:(HtHQueryAggregate)aggregate;
+
+@property (readonly,nonatomic) NSString* meaning;
+@property (readonly,nonatomic) HtHQueryAggregate aggregate;
+
+/*!
+ *  @abstract Time range of the history scanned. If <code>from</code> is <code>nil</code>, the query aggregates the latest values instead. <code>to</code> defaults to now.
+ */
+@property (copy,nonatomic) NSDate* from;
+@property (copy,nonatomic) NSDate* to;
+
+/*!
+ *  @abstract Seconds per time bucket. 0 (default) aggregates the whole range in one bucket.
+ */
+@property (nonatomic) NSTimeInterval bucket;
+
+/*!
+ *  @abstract Group of every device (<code>NSString</code> device identifier -> <code>NSString</code> group). Devices missing from the dictionary are left out. If <code>nil</code>, every device is its own group.
+ */
+@property (copy,nonatomic) NSDictionary* groups;
+
+/*!
+ *  @abstract Device identifiers the query is restricted to. If <code>nil</code>, all devices are considered.
+ */
+@property (copy,nonatomic) NSSet* deviceIDs;
+
+/*!
+ *  @abstract Keeps only the devices whose latest value of a meaning satisfies the comparison. Conditions are combined with AND.
+ */
+- (void)addConditionWithMeaning:(NSString*)meaning comparison:(HtHComparison)comparison value:(double)value;
+
+/*!
+ *  @abstract Groups that put every device of a user under the identifier of its transmitter.
+ */
++ (NSDictionary*)transmitterGroupsOfUser:(RelayrUser*)user;
+
+/*!
+ *  @abstract Runs the query synchronously. It may take a while over long ranges, so it shouldn't be called from the main queue.
+ *
+ *  @param log Log with the history.
+ *  @param table Table with the latest values (used by conditions and latest value queries).
+ */
+- (HtHQueryResult*)resultWithLog:(HtHReadingLog*)log table:(HtHLatestValueTable*)table;
+
+/*!
+ *  @abstract Runs the query on a background queue over the shared log and latest value table.
+ *
+ *  @param completion Block executed on the main queue with the result.
+ */
+- (void)executeWithCompletion:(void (^)(HtHQueryResult* result))completion;
+
+@end
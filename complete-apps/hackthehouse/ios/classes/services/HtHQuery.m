@@ -0,0 +1,367 @@
+#import "HtHQuery.h"        // Header
+#import "HtHReadingLog.h"   // HtH
+#import "HtHSample.h"       // HtH
+@import Accelerate;         // Apple
+
+#define HtHQuery_pageSize           4096
+#define HtHQuery_maximumBuckets     100000
+
+typedef struct {
+    double timestamp;
+    double value;
+} HtHQueryPoint;
+
+static NSString* const kHtHQueryKeyMeaning      = @"meaning";
+static NSString* const kHtHQueryKeyComparison   = @"comparison";
+static NSString* const kHtHQueryKeyValue        = @"value";
+
+@interface HtHQueryResult ()
+- (instancetype)initWithGroups:(NSArray*)groups bucketStarts:(NSData*)bucketStarts values:(NSData*)values counts:(NSData*)counts;
+@end
+
+// Samples of a single device gathered by the scan and their partial aggregates per bucket.
+@interface HtHQuerySeries : NSObject
+@property (strong,nonatomic) NSString* group;
+@property (strong,nonatomic) NSMutableData* points;     // HtHQueryPoint array
+@property (strong,nonatomic) NSMutableData* sums;       // double per bucket
+@property (strong,nonatomic) NSMutableData* minimums;   // double per bucket
+@property (strong,nonatomic) NSMutableData* maximums;   // double per bucket
+@property (strong,nonatomic) NSMutableData* counts;     // NSUInteger per bucket
+@end
+
+@implementation HtHQuerySeries
+
+// Sorts the points by time and reduces every run of points falling in the same bucket with vectorised kernels.
+- (void)aggregateFrom:(double)from bucket:(double)bucket count:(NSUInteger)bucketsCount
+{
+    _sums = [NSMutableData dataWithLength:bucketsCount * sizeof(double)];
+    _minimums = [NSMutableData dataWithLength:bucketsCount * sizeof(double)];
+    _maximums = [NSMutableData dataWithLength:bucketsCount * sizeof(double)];
+    _counts = [NSMutableData dataWithLength:bucketsCount * sizeof(NSUInteger)];
+    double* sums = _sums.mutableBytes;
+    double* minimums = _minimums.mutableBytes;
+    double* maximums = _maximums.mutableBytes;
+    NSUInteger* counts = _counts.mutableBytes;
+
+    HtHQueryPoint* points = _points.mutableBytes;
+    NSUInteger const count = _points.length / sizeof(HtHQueryPoint);
+
+    BOOL sorted = YES;
+    for (NSUInteger i=1; i<count && sorted; ++i) { sorted = (points[i-1].timestamp <= points[i].timestamp); }
+    if (!sorted)
+    {
+        qsort_b(points, count, sizeof(HtHQueryPoint), ^int(void const* a, void const* b) {
+            double const x = ((HtHQueryPoint const*)a)->timestamp, y = ((HtHQueryPoint const*)b)->timestamp;
+            return (x > y) - (x < y);
+        });
+    }
+
+    // Values are interleaved with timestamps, hence the stride of 2.
+    NSUInteger start = 0;
+    while (start < count)
+    {
+        NSUInteger const index = MIN((NSUInteger)((points[start].timestamp - from) / bucket), bucketsCount - 1);
+        double const bucketEnd = from + (index + 1) * bucket;
+        NSUInteger end = start + 1;
+        while (end < count && (points[end].timestamp < bucketEnd || index == bucketsCount - 1)) { ++end; }
+
+        vDSP_Length const length = end - start;
+        double const* values = &points[start].value;
+        vDSP_sveD(values, 2, &sums[index], length);
+        vDSP_minvD(values, 2, &minimums[index], length);
+        vDSP_maxvD(values, 2, &maximums[index], length);
+        counts[index] = length;
+        start = end;
+    }
+}
+
+@end
+
+@implementation HtHQuery
+{
+    NSMutableArray* _conditions;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithMeaning:(NSString*)meaning aggregate:(HtHQueryAggregate)aggregate
+{
+    if (!meaning.length) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _meaning = meaning.copy;
+        _aggregate = aggregate;
+        _conditions = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+- (void)addConditionWithMeaning:(NSString*)meaning comparison:(HtHComparison)comparison value:(double)value
+{
+    if (!meaning.length) { return; }
+    [_conditions addObject:@{ kHtHQueryKeyMeaning : meaning.copy, kHtHQueryKeyComparison : @(comparison), kHtHQueryKeyValue : @(value) }];
+}
+
++ (NSDictionary*)transmitterGroupsOfUser:(RelayrUser*)user
+{
+    NSMutableDictionary* result = [[NSMutableDictionary alloc] init];
+    for (RelayrDevice* device in user.devices)
+    {
+        if (device.uid && device.transmitter.uid) { result[device.uid] = device.transmitter.uid; }
+    }
+    return result;
+}
+
+- (HtHQueryResult*)resultWithLog:(HtHReadingLog*)log table:(HtHLatestValueTable*)table
+{
+    NSSet* allowed = [self allowedDeviceIDsWithTable:table];
+    if (!self.from) { return [self latestResultWithTable:table allowed:allowed]; }
+    if (!log) { return [self emptyResult]; }
+
+    double const from = self.from.timeIntervalSince1970;
+    double const to = (self.to) ? self.to.timeIntervalSince1970 : [NSDate date].timeIntervalSince1970;
+    if (to <= from) { return [self emptyResult]; }
+
+    double bucket = (self.bucket > 0.0) ? self.bucket : to - from;
+    NSUInteger bucketsCount = (NSUInteger)ceil((to - from) / bucket);
+    if (bucketsCount > HtHQuery_maximumBuckets) { bucketsCount = HtHQuery_maximumBuckets; bucket = (to - from) / bucketsCount; }
+    bucketsCount = MAX(bucketsCount, (NSUInteger)1);
+
+    // Scan: gather the matching samples of every device into its own columns.
+    NSDictionary* groups = self.groups;
+    NSMutableDictionary* seriesByDevice = [[NSMutableDictionary alloc] init];
+    uint64_t offset = [log offsetForDate:self.from];
+    while (YES)
+    {
+        NSArray* samples = [log samplesFromOffset:offset limit:HtHQuery_pageSize nextOffset:&offset];
+        if (!samples.count) { break; }
+
+        for (HtHSample* sample in samples)
+        {
+            if (sample.timestamp < from || sample.timestamp >= to || ![sample.meaning isEqualToString:_meaning]) { continue; }
+            if (allowed && ![allowed containsObject:sample.deviceID]) { continue; }
+
+            double const value = sample.doubleValue;
+            if (isnan(value)) { continue; }
+
+            HtHQuerySeries* series = seriesByDevice[sample.deviceID];
+            if (!series)
+            {
+                NSString* group = (groups) ? groups[sample.deviceID] : sample.deviceID;
+                if (!group) { continue; }
+                series = [[HtHQuerySeries alloc] init];
+                series.group = group;
+                series.points = [[NSMutableData alloc] init];
+                seriesByDevice[sample.deviceID] = series;
+            }
+
+            HtHQueryPoint const point = { sample.timestamp, value };
+            [series.points appendBytes:&point length:sizeof(point)];
+        }
+    }
+
+    // Aggregate every device in parallel.
+    NSArray* allSeries = seriesByDevice.allValues;
+    dispatch_apply(allSeries.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [(HtHQuerySeries*)allSeries[i] aggregateFrom:from bucket:bucket count:bucketsCount];
+    });
+
+    // Merge the partial aggregates per group.
+    NSArray* groupNames = [[NSSet setWithArray:[allSeries valueForKey:@"group"]].allObjects sortedArrayUsingSelector:@selector(compare:)];
+    NSMutableDictionary* groupIndexes = [[NSMutableDictionary alloc] initWithCapacity:groupNames.count];
+    [groupNames enumerateObjectsUsingBlock:^(NSString* group, NSUInteger idx, BOOL* stop) { groupIndexes[group] = @(idx); }];
+
+    NSUInteger const cellsCount = groupNames.count * bucketsCount;
+    NSMutableData* sumsData = [NSMutableData dataWithLength:cellsCount * sizeof(double)];
+    NSMutableData* minimumsData = [NSMutableData dataWithLength:cellsCount * sizeof(double)];
+    NSMutableData* maximumsData = [NSMutableData dataWithLength:cellsCount * sizeof(double)];
+    NSMutableData* countsData = [NSMutableData dataWithLength:cellsCount * sizeof(NSUInteger)];
+    double* sums = sumsData.mutableBytes;
+    double* minimums = minimumsData.mutableBytes;
+    double* maximums = maximumsData.mutableBytes;
+    NSUInteger* counts = countsData.mutableBytes;
+
+    for (HtHQuerySeries* series in allSeries)
+    {
+        NSUInteger const base = [groupIndexes[series.group] unsignedIntegerValue] * bucketsCount;
+        double const* seriesSums = series.sums.bytes;
+        double const* seriesMinimums = series.minimums.bytes;
+        double const* seriesMaximums = series.maximums.bytes;
+        NSUInteger const* seriesCounts = series.counts.bytes;
+
+        vDSP_vaddD(&sums[base], 1, seriesSums, 1, &sums[base], 1, bucketsCount);
+        for (NSUInteger b=0; b<bucketsCount; ++b)
+        {
+            if (!seriesCounts[b]) { continue; }
+            minimums[base + b] = (counts[base + b]) ? MIN(minimums[base + b], seriesMinimums[b]) : seriesMinimums[b];
+            maximums[base + b] = (counts[base + b]) ? MAX(maximums[base + b], seriesMaximums[b]) : seriesMaximums[b];
+            counts[base + b] += seriesCounts[b];
+        }
+    }
+
+    NSMutableArray* rowGroups = [[NSMutableArray alloc] init];
+    NSMutableData* bucketStarts = [[NSMutableData alloc] init];
+    NSMutableData* values = [[NSMutableData alloc] init];
+    NSMutableData* rowCounts = [[NSMutableData alloc] init];
+    for (NSUInteger g=0; g<groupNames.count; ++g)
+    {
+        for (NSUInteger b=0; b<bucketsCount; ++b)
+        {
+            NSUInteger const cell = g * bucketsCount + b;
+            if (!counts[cell]) { continue; }
+
+            double const start = from + b * bucket;
+            double const value = [self valueWithSum:sums[cell] minimum:minimums[cell] maximum:maximums[cell] count:counts[cell]];
+            [rowGroups addObject:groupNames[g]];
+            [bucketStarts appendBytes:&start length:sizeof(double)];
+            [values appendBytes:&value length:sizeof(double)];
+            [rowCounts appendBytes:&counts[cell] length:sizeof(NSUInteger)];
+        }
+    }
+    return [[HtHQueryResult alloc] initWithGroups:rowGroups bucketStarts:bucketStarts values:values counts:rowCounts];
+}
+
+- (void)executeWithCompletion:(void (^)(HtHQueryResult* result))completion
+{
+    if (!completion) { return; }
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        HtHQueryResult* result = [self resultWithLog:[HtHReadingLog sharedLog] table:[HtHLatestValueTable sharedTable]];
+        dispatch_async(dispatch_get_main_queue(), ^{ completion(result); });
+    });
+}
+
+#pragma mark - Private functionality
+
+// Devices passing all conditions (and within deviceIDs) or nil if there are no restrictions.
+- (NSSet*)allowedDeviceIDsWithTable:(HtHLatestValueTable*)table
+{
+    NSMutableSet* result = (self.deviceIDs) ? self.deviceIDs.mutableCopy : nil;
+    for (NSDictionary* condition in _conditions)
+    {
+        NSSet* passing = [table deviceIDsWithMeaning:condition[kHtHQueryKeyMeaning] comparison:[condition[kHtHQueryKeyComparison] unsignedIntegerValue] value:[condition[kHtHQueryKeyValue] doubleValue]];
+        if (!passing) { passing = [NSSet set]; }
+        if (result) { [result intersectSet:passing]; } else { result = passing.mutableCopy; }
+    }
+    return result;
+}
+
+- (HtHQueryResult*)latestResultWithTable:(HtHLatestValueTable*)table allowed:(NSSet*)allowed
+{
+    NSArray* deviceIDs;
+    NSData* valuesData;
+    NSData* timestampsData;
+    NSUInteger const count = [table snapshotMeaning:_meaning deviceIDs:&deviceIDs values:&valuesData timestamps:&timestampsData];
+    if (!count) { return [self emptyResult]; }
+
+    double const* values = valuesData.bytes;
+    double const* timestamps = timestampsData.bytes;
+
+    NSDictionary* groups = self.groups;
+    NSMutableDictionary* rowsByGroup = [[NSMutableDictionary alloc] init];
+    for (NSUInteger i=0; i<count; ++i)
+    {
+        NSString* deviceID = deviceIDs[i];
+        NSString* group = (groups) ? groups[deviceID] : deviceID;
+        if (!group || (allowed && ![allowed containsObject:deviceID])) { continue; }
+
+        NSMutableIndexSet* rows = rowsByGroup[group];
+        if (!rows) { rows = [[NSMutableIndexSet alloc] init]; rowsByGroup[group] = rows; }
+        [rows addIndex:i];
+    }
+
+    // Gather every group into contiguous buffers and reduce them.
+    NSMutableData* gatheredValues = [NSMutableData dataWithLength:count * sizeof(double)];
+    NSMutableData* gatheredTimestamps = [NSMutableData dataWithLength:count * sizeof(double)];
+    double* groupValues = gatheredValues.mutableBytes;
+    double* groupTimestamps = gatheredTimestamps.mutableBytes;
+
+    NSMutableArray* rowGroups = [[NSMutableArray alloc] init];
+    NSMutableData* bucketStarts = [[NSMutableData alloc] init];
+    NSMutableData* results = [[NSMutableData alloc] init];
+    NSMutableData* rowCounts = [[NSMutableData alloc] init];
+    for (NSString* group in [rowsByGroup.allKeys sortedArrayUsingSelector:@selector(compare:)])
+    {
+        NSIndexSet* rows = rowsByGroup[group];
+        __block vDSP_Length length = 0;
+        [rows enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL* stop) {
+            groupValues[length] = values[idx];
+            groupTimestamps[length] = timestamps[idx];
+            length++;
+        }];
+
+        double sum, minimum, maximum, start;
+        vDSP_sveD(groupValues, 1, &sum, length);
+        vDSP_minvD(groupValues, 1, &minimum, length);
+        vDSP_maxvD(groupValues, 1, &maximum, length);
+        vDSP_minvD(groupTimestamps, 1, &start, length);
+
+        double const value = [self valueWithSum:sum minimum:minimum maximum:maximum count:length];
+        NSUInteger const rowCount = length;
+        [rowGroups addObject:group];
+        [bucketStarts appendBytes:&start length:sizeof(double)];
+        [results appendBytes:&value length:sizeof(double)];
+        [rowCounts appendBytes:&rowCount length:sizeof(NSUInteger)];
+    }
+    return [[HtHQueryResult alloc] initWithGroups:rowGroups bucketStarts:bucketStarts values:results counts:rowCounts];
+}
+
+- (double)valueWithSum:(double)sum minimum:(double)minimum maximum:(double)maximum count:(NSUInteger)count
+{
+    switch (_aggregate)
+    {
+        case HtHQueryAggregateCount:    return count;
+        case HtHQueryAggregateSum:      return sum;
+        case HtHQueryAggregateMean:     return (count) ? sum / count : NAN;
+        case HtHQueryAggregateMinimum:  return minimum;
+        case HtHQueryAggregateMaximum:  return maximum;
+        default:                        return NAN;
+    }
+}
+
+- (HtHQueryResult*)emptyResult
+{
+    return [[HtHQueryResult alloc] initWithGroups:@[] bucketStarts:[NSData data] values:[NSData data] counts:[NSData data]];
+}
+
+@end
+
+@implementation HtHQueryResult
+{
+    NSData* _bucketStartsData;
+    NSData* _valuesData;
+    NSData* _countsData;
+}
+
+- (instancetype)initWithGroups:(NSArray*)groups bucketStarts:(NSData*)bucketStarts values:(NSData*)values counts:(NSData*)counts
+{
+    self = [super init];
+    if (self)
+    {
+        _groups = groups.copy;
+        _rowsCount = _groups.count;
+        _bucketStartsData = bucketStarts.copy;
+        _valuesData = values.copy;
+        _countsData = counts.copy;
+    }
+    return self;
+}
+
+- (double const*)bucketStarts
+{
+    return _bucketStartsData.bytes;
+}
+
+- (double const*)values
+{
+    return _valuesData.bytes;
+}
+
+- (NSUInteger const*)counts
+{
+    return _countsData.bytes;
+}
+
+@end
@@ -0,0 +1,118 @@
+@import Foundation;             // Apple
+#import <Relayr/Relayr.h>       // Relayr.framework
+#import "HtHReadingStage.h"     // HtH
+#import "HtHSubscription.h"     // HtH
+#import "HtHSample.h"           // HtH
+@class HtHLoadShedder;          // HtH
+
+/*!
+ *  @abstract Single entry point for all reading data used by the app.
+ *  @discussion The hub holds at most one <code>RelayrDevice</code> subscription per device, snapshots every value received into an <code>HtHSample</code>, runs the samples through its <code>stages</code> and fans the result out to the subscribers.
+ *  Stages run on a private serial queue; subscription blocks are executed on the main queue.
+ */
+@interface HtHReadingHub : NSObject
+
+/*!
+ *  @abstract Hub shared by the whole app.
+ *  @discussion It is created with a <code>HtHReorderStage</code>, a <code>HtHTransformStage</code> configured with the <code>ReadingTransforms.plist</code> file of the main bundle (if present), a <code>HtHVirtualReadingStage</code> with the built-in virtual readings, a <code>HtHAnomalyStage</code>, and finally the <code>HtHReadingLog</code> shared log (which durable subscriptions read from).
+ */
++ (instancetype)sharedHub;
+
+/*!
+ *  @abstract Ordered list of objects conforming to <code>HtHReadingStage</code> that all samples go through.
+ */
+@property (copy,nonatomic) NSArray* stages;
+
+/*!
+ *  @abstract Subscribes a block to all readings of a device.
+ *
+ *  @param device The device producing the readings.
+ *  @param block Block executed for every sample leaving the pipeline.
+ *  @param errorBlock Block executed if the device subscription reports an error. It can be <code>nil</code>.
+ *	@return The subscription handle or <code>nil</code> if the arguments are not valid.
+ */
+- (HtHSubscription*)subscribeToDevice:(RelayrDevice*)device
+                            withBlock:(HtHSampleReceivedBlock)block
+                                error:(RelayrReadingErrorReceivedBlock)errorBlock;
+
+/*!
+ *  @abstract Subscribes a block to a single reading.
+ *  @discussion The reading must belong to a <code>RelayrDevice</code> (not only a <code>RelayrDeviceModel</code>).
+ */
+- (HtHSubscription*)subscribeToReading:(RelayrReading*)reading
+                             withBlock:(HtHSampleReceivedBlock)block
+                                 error:(RelayrReadingErrorReceivedBlock)errorBlock;
+
+/*!
+ *  @abstract Subscribes a block to a meaning of a device, whether it is a real reading or an <code>HtHVirtualReading</code>.
+ */
+- (HtHSubscription*)subscribeToDevice:(RelayrDevice*)device
+                              meaning:(NSString*)meaning
+                            withBlock:(HtHSampleReceivedBlock)block
+                                error:(RelayrReadingErrorReceivedBlock)errorBlock;
+
+/*!
+ *  @abstract Subscribes a block to a meaning of a device (or to all of them if <code>meaning</code> is <code>nil</code>) on behalf of a class of work.
+ *  @discussion The class is set before the subscription is registered, so none of its samples is delivered (or shed) as <code>HtHSubscriptionClassInteractive</code>.
+ */
+- (HtHSubscription*)subscribeToDevice:(RelayrDevice*)device
+                              meaning:(NSString*)meaning
+                    subscriptionClass:(HtHSubscriptionClass)subscriptionClass
+                            withBlock:(HtHSampleReceivedBlock)block
+                                error:(RelayrReadingErrorReceivedBlock)errorBlock;
+
+/*!
+ *  @abstract Cancels the subscription. When a device has no subscriptions left, its upstream subscription is dropped.
+ */
+- (void)unsubscribe:(HtHSubscription*)subscription;
+
+/*!
+ *  @abstract Pushes samples into the pipeline as if they had been received from the devices.
+ *
+ *  @param samples Array of <code>HtHSample</code> objects.
+ */
+- (void)ingestSamples:(NSArray*)samples;
+
+/*!
+ *  @abstract Controller degrading deliveries to lower subscription classes when dispatch latency exceeds their targets.
+ *  @discussion The hub measures how long deliveries wait for the main queue, delivers interactive subscriptions first, and coalesces, downsamples or pauses the samples of every class according to its current level.
+ */
+@property (readonly,nonatomic) HtHLoadShedder* loadShedder;
+
+/*!
+ *  @abstract Seconds between samples of the same series while in the background for downshifted upstreams. Default: 30 seconds.
+ *  @discussion A downshifted upstream drops the SDK subscription of a reading after every sample, and subscribes to it again once the interval elapses (or when the app comes back to the foreground).
+ */
+@property (atomic) NSTimeInterval downshiftInterval;
+
+/*!
+ *  @abstract Applies the <code>backgroundPolicy</code> of the subscriptions: upstreams are kept, downshifted or suspended.
+ *  @discussion Suspended upstreams are unsubscribed from the SDK right away.
+ */
+- (void)enterBackground;
+
+/*!
+ *  @abstract Restores all upstream subscriptions.
+ *
+ *  @param completion Block executed on the main queue with the devices whose upstream was suspended (<code>deviceID</code> -> <code>NSDate</code> when it happened). It can be <code>nil</code>.
+ */
+- (void)enterForegroundWithCompletion:(void (^)(NSDictionary* gaps))completion;
+
+/*!
+ *  @abstract Hands samples recovered from history to the stages implementing <code>backfillSamples:output:</code> and to the subscribers in a single batch.
+ *  @discussion Backfilled samples are older than what the stages have already seen, so they skip the stages that hold or derive samples (reordering, virtual readings, anomalies). They are still transformed, recorded in the log and offered to the latest value table (which keeps the newest value of every series).
+ */
+- (void)backfillSamples:(NSArray*)samples;
+
+/*!
+ *  @abstract Last samples of a series kept by any of the stages (e.g.: the history of a virtual reading).
+ *	@return Array of <code>HtHSample</code> (oldest first) or <code>nil</code> if no stage keeps the series.
+ */
+- (NSArray*)historicSamplesForDeviceID:(NSString*)deviceID meaning:(NSString*)meaning;
+
+/*!
+ *  @abstract Counters of the hub, all its stages and the memory accounted to every subsystem (see <code>HtHMemoryAccounting</code>).
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
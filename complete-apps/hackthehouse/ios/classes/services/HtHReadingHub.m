@@ -0,0 +1,677 @@
+#import "HtHReadingHub.h"           // Header
+#import "HtHReorderStage.h"         // HtH
+#import "HtHTransformStage.h"       // HtH
+#import "HtHVirtualReadingStage.h"  // HtH
+#import "HtHAnomalyStage.h"         // HtH
+#import "HtHLatestValueTable.h"     // HtH
+#import "HtHReadingLog.h"           // HtH
+#import "HtHMemoryAccounting.h"     // HtH
+#import "HtHLoadShedder.h"          // HtH
+
+#define HtHReadingHub_minFlushDelay     0.002
+#define HtHReadingHub_transformsFile    @"ReadingTransforms"
+#define HtHReadingHub_downshiftInterval 30.0
+
+@interface HtHReadingHub ()
+- (void)forwardError:(NSError*)error toDeviceID:(NSString*)deviceID;
+@end
+
+// SDK subscription of the hub to a device: one target/action subscription per reading, so every reading can be dropped and resumed on its own.
+// Unless stated otherwise, its methods must be called from the main queue (where the SDK delivers readings).
+@interface HtHUpstream : NSObject
+- (instancetype)initWithDevice:(RelayrDevice*)device hub:(HtHReadingHub*)hub;
+@property (readonly,nonatomic) RelayrDevice* device;
+@property (atomic,getter=isActive) BOOL active;                 // It can be read from any queue.
+@property (atomic) NSTimeInterval downshiftInterval;            // 0 when not downshifted. It can be set from any queue.
+- (void)subscribe;
+- (void)resume;
+- (void)unsubscribe;
+@end
+
+@implementation HtHUpstream
+{
+    __weak HtHReadingHub* _hub;
+    NSMutableDictionary* _lastPassed;   // seriesKey -> NSNumber (timestamp)
+    NSMutableSet* _parked;              // RelayrReading unsubscribed until the downshift interval elapses
+}
+
+- (instancetype)initWithDevice:(RelayrDevice*)device hub:(HtHReadingHub*)hub
+{
+    self = [super init];
+    if (self)
+    {
+        _device = device;
+        _hub = hub;
+        _active = YES;
+        _lastPassed = [[NSMutableDictionary alloc] init];
+        _parked = [[NSMutableSet alloc] init];
+    }
+    return self;
+}
+
+- (void)subscribe
+{
+    for (RelayrReading* reading in _device.readings) { [self subscribeReading:reading]; }
+}
+
+// Readings parked by a downshift are subscribed again right away.
+- (void)resume
+{
+    if (!self.isActive) { return; }
+    NSArray* parked = _parked.allObjects;
+    [_parked removeAllObjects];
+    for (RelayrReading* reading in parked) { [self subscribeReading:reading]; }
+}
+
+- (void)unsubscribe
+{
+    self.active = NO;
+    [_parked removeAllObjects];
+    for (RelayrReading* reading in _device.readings) { [reading unsubscribeTarget:self action:@selector(device:receivedReading:)]; }
+}
+
+#pragma mark - Private functionality
+
+- (void)subscribeReading:(RelayrReading*)reading
+{
+    NSString* deviceID = _device.uid;
+    __weak HtHUpstream* weakSelf = self;
+    [reading subscribeWithTarget:self action:@selector(device:receivedReading:) error:^(NSError* error) {
+        HtHUpstream* strongSelf = weakSelf;
+        if (strongSelf.isActive) { [strongSelf->_hub forwardError:error toDeviceID:deviceID]; }
+    }];
+}
+
+- (void)device:(RelayrDevice*)device receivedReading:(RelayrReading*)reading
+{
+    HtHReadingHub* hub = _hub;
+    if (!hub || !self.isActive) { return [reading unsubscribeTarget:self action:@selector(device:receivedReading:)]; }
+
+    HtHSample* sample = [[HtHSample alloc] initWithDevice:device reading:reading];
+    if (!sample) { return; }
+
+    // A resubscribed reading may hand over the value it already had.
+    NSNumber* last = _lastPassed[sample.seriesKey];
+    if (last && sample.timestamp <= last.doubleValue) { return; }
+    _lastPassed[sample.seriesKey] = @(sample.timestamp);
+    [hub ingestSamples:@[sample]];
+
+    // Downshifted readings are dropped upstream after every sample, and subscribed again once the interval elapses.
+    NSTimeInterval const interval = self.downshiftInterval;
+    if (interval <= 0.0) { return; }
+
+    [reading unsubscribeTarget:self action:@selector(device:receivedReading:)];
+    [_parked addObject:reading];
+
+    __weak HtHUpstream* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        HtHUpstream* strongSelf = weakSelf;
+        if (!strongSelf || !strongSelf.isActive || ![strongSelf->_parked containsObject:reading]) { return; }
+        [strongSelf->_parked removeObject:reading];
+        [strongSelf subscribeReading:reading];
+    });
+}
+
+@end
+
+@implementation HtHReadingHub
+{
+    dispatch_queue_t _queue;
+    NSArray* _stages;
+    NSMutableDictionary* _subscriptions;    // deviceID -> NSMutableArray of HtHSubscription
+    NSMutableDictionary* _upstreams;        // deviceID -> HtHUpstream
+    NSMutableDictionary* _suspended;        // deviceID -> HtHUpstream (inactive, kept to be resumed)
+    NSDate* _backgroundDate;
+    NSMapTable* _downsampled;               // HtHSubscription -> NSMutableDictionary (seriesKey -> timestamp of the last sample delivered)
+    NSMapTable* _coalesced;                 // HtHSubscription -> NSMutableDictionary (seriesKey -> latest HtHSample waiting for the main queue). Guarded by @synchronized(_coalesced).
+    BOOL _drainScheduled;                   // Whether a main queue block will drain _coalesced. Guarded by @synchronized(_coalesced).
+    CFAbsoluteTime _flushTime;
+    NSUInteger _ingestedCount;
+    NSUInteger _deliveredCount;
+    NSUInteger _backfilledCount;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedHub
+{
+    static HtHReadingHub* hub;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSURL* transformsURL = [[NSBundle mainBundle] URLForResource:HtHReadingHub_transformsFile withExtension:@"plist"];
+        NSDictionary* transforms = (transformsURL) ? [NSDictionary dictionaryWithContentsOfURL:transformsURL] : nil;
+
+        hub = [[HtHReadingHub alloc] init];
+        hub.stages = @[
+            [[HtHReorderStage alloc] init],
+            [[HtHTransformStage alloc] initWithConfiguration:transforms],
+            [[HtHVirtualReadingStage alloc] init],
+            [[HtHAnomalyStage alloc] init],
+            [HtHLatestValueTable sharedTable],
+            [HtHReadingLog sharedLog]
+        ];
+    });
+    return hub;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _queue = dispatch_queue_create("io.relayr.hth.hub", DISPATCH_QUEUE_SERIAL);
+        _stages = @[];
+        _subscriptions = [[NSMutableDictionary alloc] init];
+        _upstreams = [[NSMutableDictionary alloc] init];
+        _suspended = [[NSMutableDictionary alloc] init];
+        _downshiftInterval = HtHReadingHub_downshiftInterval;
+        _loadShedder = [[HtHLoadShedder alloc] init];
+        _downsampled = [NSMapTable weakToStrongObjectsMapTable];
+        _coalesced = [NSMapTable strongToStrongObjectsMapTable];
+        _flushTime = DBL_MAX;
+    }
+    return self;
+}
+
+- (NSArray*)stages
+{
+    __block NSArray* result;
+    dispatch_sync(_queue, ^{ result = _stages; });
+    return result;
+}
+
+- (void)setStages:(NSArray*)stages
+{
+    NSArray* result = (stages) ? stages.copy : @[];
+    dispatch_async(_queue, ^{ _stages = result; });
+}
+
+- (HtHSubscription*)subscribeToDevice:(RelayrDevice*)device withBlock:(HtHSampleReceivedBlock)block error:(RelayrReadingErrorReceivedBlock)errorBlock
+{
+    return [self subscribeToDevice:device meaning:nil path:nil subscriptionClass:HtHSubscriptionClassInteractive block:block error:errorBlock];
+}
+
+- (HtHSubscription*)subscribeToReading:(RelayrReading*)reading withBlock:(HtHSampleReceivedBlock)block error:(RelayrReadingErrorReceivedBlock)errorBlock
+{
+    if (![reading.deviceModel isKindOfClass:[RelayrDevice class]]) { return nil; }
+    return [self subscribeToDevice:(RelayrDevice*)reading.deviceModel meaning:reading.meaning path:reading.path subscriptionClass:HtHSubscriptionClassInteractive block:block error:errorBlock];
+}
+
+- (HtHSubscription*)subscribeToDevice:(RelayrDevice*)device meaning:(NSString*)meaning withBlock:(HtHSampleReceivedBlock)block error:(RelayrReadingErrorReceivedBlock)errorBlock
+{
+    return [self subscribeToDevice:device meaning:meaning path:nil subscriptionClass:HtHSubscriptionClassInteractive block:block error:errorBlock];
+}
+
+- (HtHSubscription*)subscribeToDevice:(RelayrDevice*)device meaning:(NSString*)meaning subscriptionClass:(HtHSubscriptionClass)subscriptionClass withBlock:(HtHSampleReceivedBlock)block error:(RelayrReadingErrorReceivedBlock)errorBlock
+{
+    return [self subscribeToDevice:device meaning:meaning path:nil subscriptionClass:subscriptionClass block:block error:errorBlock];
+}
+
+- (void)unsubscribe:(HtHSubscription*)subscription
+{
+    if (!subscription) { return; }
+    [subscription cancel];
+
+    dispatch_async(_queue, ^{
+        NSMutableArray* subscriptions = _subscriptions[subscription.deviceID];
+        [subscriptions removeObjectIdenticalTo:subscription];
+        if (subscriptions.count) { return; }
+
+        [_subscriptions removeObjectForKey:subscription.deviceID];
+        [_suspended removeObjectForKey:subscription.deviceID];
+        [self dropUpstream:_upstreams[subscription.deviceID]];
+        [_upstreams removeObjectForKey:subscription.deviceID];
+    });
+}
+
+- (void)ingestSamples:(NSArray*)samples
+{
+    if (!samples.count) { return; }
+
+    dispatch_async(_queue, ^{
+        _ingestedCount += samples.count;
+        [self pushSamples:samples fromStage:0];
+        if (_flushTime == DBL_MAX) { [self flushStages]; }
+    });
+}
+
+- (void)enterBackground
+{
+    NSTimeInterval const interval = self.downshiftInterval;
+    dispatch_async(_queue, ^{
+        if (_backgroundDate) { return; }
+        _backgroundDate = [NSDate date];
+
+        for (NSString* deviceID in _upstreams.allKeys)
+        {
+            HtHUpstream* upstream = _upstreams[deviceID];
+            HtHBackgroundPolicy policy = HtHBackgroundPolicySuspend;
+            for (HtHSubscription* subscription in _subscriptions[deviceID]) { policy = MAX(policy, subscription.backgroundPolicy); }
+
+            if (policy == HtHBackgroundPolicyDownshift) { upstream.downshiftInterval = interval; }
+            else if (policy == HtHBackgroundPolicySuspend)
+            {
+                [self dropUpstream:upstream];
+                [_upstreams removeObjectForKey:deviceID];
+                _suspended[deviceID] = upstream;
+            }
+        }
+    });
+}
+
+- (void)enterForegroundWithCompletion:(void (^)(NSDictionary* gaps))completion
+{
+    dispatch_async(_queue, ^{
+        NSDate* since = _backgroundDate;
+        _backgroundDate = nil;
+
+        NSArray* upstreams = _upstreams.allValues;
+        for (HtHUpstream* upstream in upstreams) { upstream.downshiftInterval = 0.0; }
+        dispatch_async(dispatch_get_main_queue(), ^{
+            for (HtHUpstream* upstream in upstreams) { [upstream resume]; }
+        });
+
+        NSMutableDictionary* gaps = [[NSMutableDictionary alloc] initWithCapacity:_suspended.count];
+        [_suspended enumerateKeysAndObjectsUsingBlock:^(NSString* deviceID, HtHUpstream* upstream, BOOL* stop) {
+            if (!_subscriptions[deviceID] || _upstreams[deviceID]) { return; }
+            [self subscribeUpstreamToDevice:upstream.device];
+            if (since) { gaps[deviceID] = since; }
+        }];
+        [_suspended removeAllObjects];
+
+        if (completion) { dispatch_async(dispatch_get_main_queue(), ^{ completion(gaps); }); }
+    });
+}
+
+- (void)backfillSamples:(NSArray*)samples
+{
+    if (!samples.count) { return; }
+
+    NSArray* sorted = [samples sortedArrayUsingComparator:^NSComparisonResult(HtHSample* a, HtHSample* b) {
+        return (a.timestamp < b.timestamp) ? NSOrderedAscending : (a.timestamp > b.timestamp) ? NSOrderedDescending : NSOrderedSame;
+    }];
+
+    dispatch_async(_queue, ^{
+        NSArray* batch = sorted;
+        for (id <HtHReadingStage> stage in _stages)
+        {
+            if (!batch.count) { return; }
+            if (![stage respondsToSelector:@selector(backfillSamples:output:)]) { continue; }
+
+            NSMutableArray* next = [[NSMutableArray alloc] initWithCapacity:batch.count];
+            [stage backfillSamples:batch output:^(NSArray* samples) { [next addObjectsFromArray:samples]; }];
+            batch = next;
+        }
+        [self deliverBackfill:batch];
+    });
+}
+
+- (NSArray*)historicSamplesForDeviceID:(NSString*)deviceID meaning:(NSString*)meaning
+{
+    for (id <HtHReadingStage> stage in self.stages)
+    {
+        if (![stage respondsToSelector:@selector(historicSamplesForDeviceID:meaning:)]) { continue; }
+
+        NSArray* samples = [stage historicSamplesForDeviceID:deviceID meaning:meaning];
+        if (samples) { return samples; }
+    }
+    return nil;
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSMutableDictionary* result;
+    dispatch_sync(_queue, ^{
+        NSUInteger subscriptionsCount = 0;
+        for (NSArray* subscriptions in _subscriptions.allValues) { subscriptionsCount += subscriptions.count; }
+
+        result = [NSMutableDictionary dictionaryWithDictionary:@{
+            @"hub.ingested"         : @(_ingestedCount),
+            @"hub.delivered"        : @(_deliveredCount),
+            @"hub.subscriptions"    : @(subscriptionsCount),
+            @"hub.upstreams"        : @(_upstreams.count),
+            @"hub.suspended"        : @(_suspended.count),
+            @"hub.backfilled"       : @(_backfilledCount)
+        }];
+        for (id <HtHReadingStage> stage in _stages)
+        {
+            if ([stage respondsToSelector:@selector(metrics)]) { [result addEntriesFromDictionary:[stage metrics]]; }
+        }
+        [result addEntriesFromDictionary:[HtHMemoryAccounting metrics]];
+        [result addEntriesFromDictionary:_loadShedder.metrics];
+    });
+    return result.copy;
+}
+
+#pragma mark - Private functionality
+
+- (HtHSubscription*)subscribeToDevice:(RelayrDevice*)device meaning:(NSString*)meaning path:(NSString*)path subscriptionClass:(HtHSubscriptionClass)subscriptionClass block:(HtHSampleReceivedBlock)block error:(RelayrReadingErrorReceivedBlock)errorBlock
+{
+    HtHSubscription* subscription = [[HtHSubscription alloc] initWithDeviceID:device.uid meaning:meaning path:path block:block errorBlock:errorBlock];
+    if (!subscription) { return nil; }
+    subscription.subscriptionClass = subscriptionClass;
+
+    dispatch_async(_queue, ^{
+        NSMutableArray* subscriptions = _subscriptions[device.uid];
+        if (!subscriptions) { subscriptions = [[NSMutableArray alloc] init]; _subscriptions[device.uid] = subscriptions; }
+        [subscriptions addObject:subscription];
+
+        if (!_upstreams[device.uid]) { [self subscribeUpstreamToDevice:device]; }
+    });
+    return subscription;
+}
+
+// It must be called from the hub's queue.
+- (void)subscribeUpstreamToDevice:(RelayrDevice*)device
+{
+    HtHUpstream* upstream = [[HtHUpstream alloc] initWithDevice:device hub:self];
+    _upstreams[device.uid] = upstream;
+    dispatch_async(dispatch_get_main_queue(), ^{ [upstream subscribe]; });
+}
+
+// It must be called from the hub's queue. The SDK subscriptions are removed right away (not when their next reading arrives).
+- (void)dropUpstream:(HtHUpstream*)upstream
+{
+    if (!upstream) { return; }
+    upstream.active = NO;
+    dispatch_async(dispatch_get_main_queue(), ^{ [upstream unsubscribe]; });
+}
+
+- (void)forwardError:(NSError*)error toDeviceID:(NSString*)deviceID
+{
+    dispatch_async(_queue, ^{
+        NSArray* subscriptions = [_subscriptions[deviceID] copy];
+        if (!subscriptions.count) { return; }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            for (HtHSubscription* subscription in subscriptions)
+            {
+                if (!subscription.isCancelled && subscription.errorBlock) { subscription.errorBlock(error); }
+            }
+        });
+    });
+}
+
+// It must be called from the hub's queue.
+- (void)pushSamples:(NSArray*)samples fromStage:(NSUInteger)index
+{
+    if (!samples.count) { return; }
+    if (index >= _stages.count) { return [self deliverSamples:samples]; }
+
+    [(id <HtHReadingStage>)_stages[index] stageSamples:samples output:^(NSArray* output) {
+        [self pushSamples:output fromStage:index+1];
+    }];
+}
+
+// It must be called from the hub's queue.
+- (void)flushStages
+{
+    NSTimeInterval nextFlush = -1.0;
+    NSArray* stages = _stages;
+
+    for (NSUInteger i=0; i<stages.count; ++i)
+    {
+        id <HtHReadingStage> stage = stages[i];
+        if (![stage respondsToSelector:@selector(flushWithOutput:)]) { continue; }
+
+        NSTimeInterval const delay = [stage flushWithOutput:^(NSArray* output) {
+            [self pushSamples:output fromStage:i+1];
+        }];
+        if (delay >= 0.0) { nextFlush = (nextFlush < 0.0) ? delay : MIN(nextFlush, delay); }
+    }
+
+    if (nextFlush >= 0.0) { [self scheduleFlushAfter:nextFlush]; }
+}
+
+// It must be called from the hub's queue.
+- (void)scheduleFlushAfter:(NSTimeInterval)delay
+{
+    delay = MAX(delay, HtHReadingHub_minFlushDelay);
+    CFAbsoluteTime const fireTime = CFAbsoluteTimeGetCurrent() + delay;
+    if (fireTime >= _flushTime) { return; }
+    _flushTime = fireTime;
+
+    __weak HtHReadingHub* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), _queue, ^{
+        HtHReadingHub* strongSelf = weakSelf;
+        if (!strongSelf || strongSelf->_flushTime != fireTime) { return; }
+        strongSelf->_flushTime = DBL_MAX;
+        [strongSelf flushStages];
+    });
+}
+
+// It must be called from the hub's queue. Subscriptions with a backfill block get the whole batch at once; the rest only the latest sample of every series.
+- (void)deliverBackfill:(NSArray*)samples
+{
+    NSMutableArray* deliveries = [[NSMutableArray alloc] init];   // Pairs of (subscription, samples)
+    for (NSArray* subscriptions in _subscriptions.allValues)
+    {
+        for (HtHSubscription* subscription in subscriptions)
+        {
+            NSMutableArray* matched = [[NSMutableArray alloc] init];
+            for (HtHSample* sample in samples) { if ([subscription matchesSample:sample]) { [matched addObject:sample]; } }
+            if (!matched.count) { continue; }
+
+            if (!subscription.backfillBlock)
+            {
+                NSMutableDictionary* latest = [[NSMutableDictionary alloc] init];
+                for (HtHSample* sample in matched) { latest[sample.seriesKey] = sample; }
+                matched = latest.allValues.mutableCopy;
+            }
+            [deliveries addObject:@[subscription, matched]];
+        }
+    }
+    _backfilledCount += samples.count;
+    if (!deliveries.count) { return; }
+
+    __weak HtHReadingHub* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        for (NSArray* delivery in deliveries)
+        {
+            HtHSubscription* subscription = delivery[0];
+            if (subscription.isCancelled) { continue; }
+
+            HtHSamplesBackfillBlock backfillBlock = subscription.backfillBlock;
+            if (backfillBlock) { backfillBlock(delivery[1]); continue; }
+
+            for (HtHSample* sample in delivery[1])
+            {
+                BOOL unsubscribe = NO;
+                subscription.block(sample, &unsubscribe);
+                if (unsubscribe) { [weakSelf unsubscribe:subscription]; break; }
+            }
+        }
+    });
+}
+
+// It must be called from the hub's queue.
+- (void)deliverSamples:(NSArray*)samples
+{
+    NSMutableArray* deliveries = [[NSMutableArray alloc] init];   // Pairs of (subscription, samples)
+    BOOL drain = NO;
+
+    NSMutableDictionary* samplesPerDevice = [[NSMutableDictionary alloc] init];
+    for (HtHSample* sample in samples)
+    {
+        NSMutableArray* deviceSamples = samplesPerDevice[sample.deviceID];
+        if (!deviceSamples) { deviceSamples = [[NSMutableArray alloc] init]; samplesPerDevice[sample.deviceID] = deviceSamples; }
+        [deviceSamples addObject:sample];
+    }
+
+    HtHLoadShedder* shedder = _loadShedder;
+    HtHShedLevel levels[HtHSubscriptionClassCount];
+    for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i) { levels[i] = [shedder levelForClass:i]; }
+
+    for (NSString* deviceID in samplesPerDevice)
+    {
+        NSArray* deviceSamples = samplesPerDevice[deviceID];
+        for (HtHSubscription* subscription in _subscriptions[deviceID])
+        {
+            NSMutableArray* matched = [[NSMutableArray alloc] init];
+            for (HtHSample* sample in deviceSamples) { if ([subscription matchesSample:sample]) { [matched addObject:sample]; } }
+            if (!matched.count) { continue; }
+
+            HtHSubscriptionClass const subscriptionClass = MIN(subscription.subscriptionClass, HtHSubscriptionClassArchive);
+            NSArray* kept = [self shedSamples:matched ofSubscription:subscription level:levels[subscriptionClass]];
+            if (!kept.count) { continue; }
+
+            // Coalesced samples wait in a latest value slot instead of a main queue block of their own, so they don't pile up while the main queue is behind.
+            if (levels[subscriptionClass] >= HtHShedLevelCoalesce) { if ([self coalesceSamples:kept ofSubscription:subscription]) { drain = YES; } continue; }
+            [deliveries addObject:@[subscription, kept]];
+        }
+    }
+    // The drain goes after the uncoalesced deliveries, which belong to the more latency sensitive classes.
+    if (!deliveries.count) { if (drain) { [self scheduleDrain]; } return; }
+
+    // The most latency sensitive subscriptions go first.
+    [deliveries sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(NSArray* a, NSArray* b) {
+        HtHSubscriptionClass const x = ((HtHSubscription*)a[0]).subscriptionClass, y = ((HtHSubscription*)b[0]).subscriptionClass;
+        return (x < y) ? NSOrderedAscending : (x > y) ? NSOrderedDescending : NSOrderedSame;
+    }];
+
+    CFAbsoluteTime const scheduled = CFAbsoluteTimeGetCurrent();
+    __weak HtHReadingHub* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        NSUInteger delivered = 0;
+        NSTimeInterval latencies[HtHSubscriptionClassCount];
+        for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i) { latencies[i] = -1.0; }
+        for (NSArray* delivery in deliveries)
+        {
+            HtHSubscription* subscription = delivery[0];
+            HtHSubscriptionClass const subscriptionClass = MIN(subscription.subscriptionClass, HtHSubscriptionClassArchive);
+            latencies[subscriptionClass] = MAX(latencies[subscriptionClass], CFAbsoluteTimeGetCurrent() - scheduled);
+
+            for (HtHSample* sample in delivery[1])
+            {
+                if (subscription.isCancelled) { break; }
+
+                BOOL unsubscribe = NO;
+                subscription.block(sample, &unsubscribe);
+                delivered++;
+                if (unsubscribe) { [weakSelf unsubscribe:subscription]; }
+            }
+        }
+        for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i) { if (latencies[i] >= 0.0) { [shedder recordLatency:latencies[i] forClass:i]; } }
+
+        HtHReadingHub* strongSelf = weakSelf;
+        if (strongSelf) { dispatch_async(strongSelf->_queue, ^{ strongSelf->_deliveredCount += delivered; }); }
+    });
+    if (drain) { [self scheduleDrain]; }
+}
+
+// It must be called from the hub's queue. The samples replace the ones of the same series still waiting, and a single main queue block delivers whatever is waiting when it runs.
+// It returns YES when no drain is scheduled yet (the caller must call scheduleDrain).
+- (BOOL)coalesceSamples:(NSArray*)samples ofSubscription:(HtHSubscription*)subscription
+{
+    NSUInteger replaced = 0;
+    BOOL schedule = NO;
+    @synchronized(_coalesced)
+    {
+        NSMutableDictionary* slot = [_coalesced objectForKey:subscription];
+        if (!slot) { slot = [[NSMutableDictionary alloc] init]; [_coalesced setObject:slot forKey:subscription]; }
+        for (HtHSample* sample in samples)
+        {
+            if (slot[sample.seriesKey]) { replaced++; }
+            slot[sample.seriesKey] = sample;
+        }
+        schedule = !_drainScheduled;
+        _drainScheduled = YES;
+    }
+
+    HtHSubscriptionClass const subscriptionClass = MIN(subscription.subscriptionClass, HtHSubscriptionClassArchive);
+    if (replaced) { [_loadShedder recordShedSamples:replaced level:HtHShedLevelCoalesce forClass:subscriptionClass]; }
+    return schedule;
+}
+
+// It must be called from the hub's queue.
+- (void)scheduleDrain
+{
+    CFAbsoluteTime const scheduled = CFAbsoluteTimeGetCurrent();
+    __weak HtHReadingHub* weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        HtHReadingHub* strongSelf = weakSelf;
+        if (strongSelf) { [strongSelf drainCoalescedSince:scheduled]; }
+    });
+}
+
+// It must be called from the main queue. The most latency sensitive subscriptions go first, and every series gets its latest sample in timestamp order.
+- (void)drainCoalescedSince:(CFAbsoluteTime)scheduled
+{
+    NSMutableArray* deliveries = [[NSMutableArray alloc] init];   // Pairs of (subscription, samples)
+    @synchronized(_coalesced)
+    {
+        for (HtHSubscription* subscription in _coalesced)
+        {
+            NSArray* samples = [[_coalesced objectForKey:subscription].allValues sortedArrayUsingComparator:^NSComparisonResult(HtHSample* a, HtHSample* b) {
+                return (a.timestamp < b.timestamp) ? NSOrderedAscending : (a.timestamp > b.timestamp) ? NSOrderedDescending : NSOrderedSame;
+            }];
+            [deliveries addObject:@[subscription, samples]];
+        }
+        [_coalesced removeAllObjects];
+        _drainScheduled = NO;
+    }
+    [deliveries sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(NSArray* a, NSArray* b) {
+        HtHSubscriptionClass const x = ((HtHSubscription*)a[0]).subscriptionClass, y = ((HtHSubscription*)b[0]).subscriptionClass;
+        return (x < y) ? NSOrderedAscending : (x > y) ? NSOrderedDescending : NSOrderedSame;
+    }];
+
+    NSUInteger delivered = 0;
+    NSTimeInterval latencies[HtHSubscriptionClassCount];
+    for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i) { latencies[i] = -1.0; }
+    for (NSArray* delivery in deliveries)
+    {
+        HtHSubscription* subscription = delivery[0];
+        HtHSubscriptionClass const subscriptionClass = MIN(subscription.subscriptionClass, HtHSubscriptionClassArchive);
+        latencies[subscriptionClass] = MAX(latencies[subscriptionClass], CFAbsoluteTimeGetCurrent() - scheduled);
+
+        for (HtHSample* sample in delivery[1])
+        {
+            if (subscription.isCancelled) { break; }
+
+            BOOL unsubscribe = NO;
+            subscription.block(sample, &unsubscribe);
+            delivered++;
+            if (unsubscribe) { [self unsubscribe:subscription]; }
+        }
+    }
+    for (NSUInteger i = 0; i < HtHSubscriptionClassCount; ++i) { if (latencies[i] >= 0.0) { [_loadShedder recordLatency:latencies[i] forClass:i]; } }
+    dispatch_async(_queue, ^{ _deliveredCount += delivered; });
+}
+
+// It must be called from the hub's queue. It returns the samples the subscription still gets at the level of its class.
+- (NSArray*)shedSamples:(NSArray*)samples ofSubscription:(HtHSubscription*)subscription level:(HtHShedLevel)level
+{
+    if (level == HtHShedLevelNone) { return samples; }
+
+    HtHSubscriptionClass const subscriptionClass = MIN(subscription.subscriptionClass, HtHSubscriptionClassArchive);
+    if (level >= HtHShedLevelPause)
+    {
+        [_loadShedder recordShedSamples:samples.count level:HtHShedLevelPause forClass:subscriptionClass];
+        return nil;
+    }
+
+    // Coalescing keeps the latest sample of every series (in their original order); coalesceSamples:ofSubscription: then merges them with the ones still waiting.
+    NSMutableDictionary* latest = [[NSMutableDictionary alloc] init];
+    for (HtHSample* sample in samples) { latest[sample.seriesKey] = sample; }
+    NSMutableArray* result = [[NSMutableArray alloc] initWithCapacity:latest.count];
+    for (HtHSample* sample in samples) { if (latest[sample.seriesKey] == sample) { [result addObject:sample]; } }
+    [_loadShedder recordShedSamples:samples.count - result.count level:HtHShedLevelCoalesce forClass:subscriptionClass];
+    if (level == HtHShedLevelCoalesce) { return result; }
+
+    NSMutableDictionary* delivered = [_downsampled objectForKey:subscription];
+    if (!delivered) { delivered = [[NSMutableDictionary alloc] init]; [_downsampled setObject:delivered forKey:subscription]; }
+
+    NSTimeInterval const interval = _loadShedder.downsampleInterval;
+    NSUInteger const coalesced = result.count;
+    for (NSUInteger i = result.count; i > 0; --i)
+    {
+        HtHSample* sample = result[i-1];
+        NSNumber* last = delivered[sample.seriesKey];
+        if (last && sample.timestamp - last.doubleValue < interval) { [result removeObjectAtIndex:i-1]; continue; }
+        delivered[sample.seriesKey] = @(sample.timestamp);
+    }
+    [_loadShedder recordShedSamples:coalesced - result.count level:HtHShedLevelDownsample forClass:subscriptionClass];
+    return result;
+}
+
+@end
@@ -0,0 +1,91 @@
+@import Foundation;         // Apple
+#import "HtHReadingStage.h" // HtH
+
+/*!
+ *  @abstract Local append-only log of all samples leaving the pipeline.
+ *  @discussion Samples are appended to segment files named after the offset of their first record. Segments are read through memory mapping and retention simply deletes whole segments.
+ *  Every record has a 64-bit offset (its position in the log since it was created) that never changes, thus consumers can store it as a cursor.
+ *  As a pipeline stage it appends every batch and passes the samples through untouched.
+ *  All methods are thread safe; I/O happens in a private serial queue.
+ */
+@interface HtHReadingLog : NSObject <HtHReadingStage>
+
+/*!
+ *  @abstract Log stored in the Application Support directory, used by the shared <code>HtHReadingHub</code>.
+ */
++ (instancetype)sharedLog;
+
+/*!
+ *  @abstract Opens (or creates) a log.
+ *  @discussion If the last segment ends in a partially written record (e.g.: the app was killed while writing), the segment is truncated to its last valid record.
+ *
+ *  @param directory Directory containing the segment files and the cursors file.
+ *  @param segmentSize Size in bytes after which a new segment is started.
+ *  @param retention Seconds a segment is kept after it is completely older than that age. A non positive number keeps all segments.
+ */
+- (instancetype)initWithDirectory:(NSURL*)directory segmentSize:(NSUInteger)segmentSize retention:(NSTimeInterval)retention;
+
+@property (readonly,nonatomic) NSURL* directory;
+
+/*!
+ *  @abstract Offset of the oldest record still retained.
+ */
+@property (readonly,nonatomic) uint64_t firstOffset;
+
+/*!
+ *  @abstract Offset the next appended record will have.
+ */
+@property (readonly,nonatomic) uint64_t nextOffset;
+
+- (void)appendSamples:(NSArray*)samples;
+
+/*!
+ *  @abstract Reads records starting at an offset.
+ *  @discussion Offsets older than <code>firstOffset</code> start reading at <code>firstOffset</code>.
+ *
+ *  @param offset Offset of the first record to read.
+ *  @param limit Maximum number of records returned.
+ *  @param nextOffset Pointer where the offset following the last record returned is written. It can be <code>NULL</code>.
+ *	@return Array of <code>HtHSample</code> objects (empty if there are no records at or after the offset).
+ */
+- (NSArray*)samplesFromOffset:(uint64_t)offset limit:(NSUInteger)limit nextOffset:(uint64_t*)nextOffset;
+
+/*!
+ *  @abstract Offset of the first record whose timestamp is equal or later than the date passed.
+ */
+- (uint64_t)offsetForDate:(NSDate*)date;
+
+/*!
+ *  @abstract Deletes the segments whose records are all older than the retention period.
+ */
+- (void)applyRetention;
+
+#pragma mark Cursors
+
+/*!
+ *  @abstract Reads the persisted cursor for a name.
+ *
+ *  @param offset Pointer where the cursor is written. It can be <code>NULL</code>.
+ *	@return <code>NO</code> if no cursor was ever committed for the name.
+ */
+- (BOOL)getCursor:(uint64_t*)offset forName:(NSString*)name;
+
+/*!
+ *  @abstract Stores the cursor for a name.
+ *  @discussion Cursors are written to disk at most once per second (and when the log is deallocated), thus, after a crash a consumer may receive again the last second of records.
+ */
+- (void)commitCursor:(uint64_t)offset forName:(NSString*)name;
+
+- (void)removeCursorForName:(NSString*)name;
+
+#pragma mark Observers
+
+/*!
+ *  @abstract Registers a block that is executed (in the log's queue) every time records are appended.
+ *	@return An opaque token to remove the observer.
+ */
+- (id)addAppendObserver:(void (^)(uint64_t nextOffset))block;
+
+- (void)removeAppendObserver:(id)token;
+
+@end
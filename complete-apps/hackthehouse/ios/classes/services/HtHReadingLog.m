@@ -0,0 +1,495 @@
+#import "HtHReadingLog.h"   // Header
+#import "HtHSample.h"       // HtH
+
+#define HtHReadingLog_extension         @"log"
+#define HtHReadingLog_cursorsFile       @"cursors.plist"
+#define HtHReadingLog_cursorsDelay      1.0
+#define HtHReadingLog_sharedDirectory   @"ReadingLog"
+#define HtHReadingLog_sharedSegmentSize (4 * 1024 * 1024)
+#define HtHReadingLog_sharedRetention   (7 * 24 * 3600)
+
+#define HtHReadingLog_keyDevice         @"d"
+#define HtHReadingLog_keyMeaning        @"m"
+#define HtHReadingLog_keyPath           @"p"
+#define HtHReadingLog_keyUnit           @"u"
+#define HtHReadingLog_keyValue          @"v"
+
+// Every record is a fixed header followed by a JSON payload.
+typedef struct {
+    uint32_t length;
+    uint32_t checksum;
+    double timestamp;
+} HtHLogRecordHeader;
+
+static uint32_t HtHLogChecksum(void const* bytes, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    uint8_t const* ptr = bytes;
+    for (size_t i=0; i<length; ++i) { hash = (hash ^ ptr[i]) * 16777619u; }
+    return hash;
+}
+
+@interface HtHLogSegment : NSObject
+@property (nonatomic) uint64_t baseOffset;
+@property (strong,nonatomic) NSURL* url;
+@property (nonatomic) NSTimeInterval firstTimestamp;    // NAN if unknown or empty.
+@property (strong,nonatomic) NSData* mapping;
+@property (nonatomic) uint64_t cachedOffset;            // Last position resolved (offset -> byte position).
+@property (nonatomic) NSUInteger cachedPosition;
+@end
+
+@implementation HtHLogSegment
+@end
+
+@implementation HtHReadingLog
+{
+    dispatch_queue_t _queue;
+    NSUInteger _segmentSize;
+    NSTimeInterval _retention;
+    NSMutableArray* _segments;      // HtHLogSegment sorted by baseOffset
+    NSFileHandle* _writer;
+    unsigned long long _writerSize;
+    uint64_t _nextOffset;
+    NSMutableDictionary* _cursors;
+    BOOL _cursorsSaveScheduled;
+    NSMutableDictionary* _observers;
+}
+
+#pragma mark - Public API
+
++ (instancetype)sharedLog
+{
+    static HtHReadingLog* log;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSURL* support = [[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask].firstObject;
+        log = [[HtHReadingLog alloc] initWithDirectory:[support URLByAppendingPathComponent:HtHReadingLog_sharedDirectory isDirectory:YES] segmentSize:HtHReadingLog_sharedSegmentSize retention:HtHReadingLog_sharedRetention];
+    });
+    return log;
+}
+
+- (instancetype)initWithDirectory:(NSURL*)directory segmentSize:(NSUInteger)segmentSize retention:(NSTimeInterval)retention
+{
+    if (!directory || !segmentSize) { return nil; }
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil]) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _directory = directory;
+        _segmentSize = segmentSize;
+        _retention = retention;
+        _queue = dispatch_queue_create("io.relayr.hth.log", DISPATCH_QUEUE_SERIAL);
+        _segments = [[NSMutableArray alloc] init];
+        _observers = [[NSMutableDictionary alloc] init];
+
+        NSDictionary* cursors = [NSDictionary dictionaryWithContentsOfURL:[directory URLByAppendingPathComponent:HtHReadingLog_cursorsFile]];
+        _cursors = (cursors) ? cursors.mutableCopy : [[NSMutableDictionary alloc] init];
+
+        [self loadSegments];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self saveCursors];
+    [_writer synchronizeFile];
+    [_writer closeFile];
+}
+
+- (uint64_t)firstOffset
+{
+    __block uint64_t result;
+    dispatch_sync(_queue, ^{ result = (_segments.count) ? ((HtHLogSegment*)_segments.firstObject).baseOffset : _nextOffset; });
+    return result;
+}
+
+- (uint64_t)nextOffset
+{
+    __block uint64_t result;
+    dispatch_sync(_queue, ^{ result = _nextOffset; });
+    return result;
+}
+
+- (void)stageSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    [self appendSamples:samples];
+    output(samples);
+}
+
+- (void)backfillSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    [self appendSamples:samples];
+    output(samples);
+}
+
+- (void)appendSamples:(NSArray*)samples
+{
+    if (!samples.count) { return; }
+
+    dispatch_async(_queue, ^{
+        NSMutableData* data = [[NSMutableData alloc] init];
+        NSUInteger count = 0;
+        NSTimeInterval firstTimestamp = NAN;
+
+        for (HtHSample* sample in samples)
+        {
+            NSData* record = [HtHReadingLog recordForSample:sample];
+            if (!record) { continue; }
+            [data appendData:record];
+            if (!count) { firstTimestamp = sample.timestamp; }
+            count++;
+        }
+        if (!count) { return; }
+
+        if (!_writer || (_writerSize && _writerSize + data.length > _segmentSize)) { [self rollSegment]; }
+        if (!_writer) { return; }
+
+        HtHLogSegment* segment = _segments.lastObject;
+        if (isnan(segment.firstTimestamp)) { segment.firstTimestamp = firstTimestamp; }
+
+        [_writer writeData:data];
+        _writerSize += data.length;
+        _nextOffset += count;
+
+        uint64_t const nextOffset = _nextOffset;
+        for (void (^observer)(uint64_t) in _observers.allValues)
+        {
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{ observer(nextOffset); });
+        }
+    });
+}
+
+- (NSArray*)samplesFromOffset:(uint64_t)offset limit:(NSUInteger)limit nextOffset:(uint64_t*)nextOffset
+{
+    __block NSMutableArray* result = [[NSMutableArray alloc] init];
+    __block uint64_t next = offset;
+
+    dispatch_sync(_queue, ^{
+        if (!_segments.count || !limit) { return; }
+
+        uint64_t current = MAX(offset, ((HtHLogSegment*)_segments.firstObject).baseOffset);
+        NSUInteger index = [self indexOfSegmentContainingOffset:current];
+
+        while (index < _segments.count && result.count < limit && current < _nextOffset)
+        {
+            HtHLogSegment* segment = _segments[index];
+            NSData* mapping = [self mappingOfSegment:segment];
+            NSUInteger position = [self positionOfOffset:current inSegment:segment mapping:mapping];
+
+            while (result.count < limit && position != NSNotFound)
+            {
+                HtHSample* sample;
+                NSUInteger const recordEnd = [HtHReadingLog readRecordInData:mapping atPosition:position sample:&sample timestamp:NULL];
+                if (recordEnd == NSNotFound) { break; }
+
+                if (sample) { [result addObject:sample]; }
+                position = recordEnd;
+                current++;
+                segment.cachedOffset = current;
+                segment.cachedPosition = position;
+            }
+
+            if (result.count < limit) { index++; if (index < _segments.count) { current = ((HtHLogSegment*)_segments[index]).baseOffset; } }
+        }
+        next = current;
+    });
+
+    if (nextOffset) { *nextOffset = next; }
+    return result;
+}
+
+- (uint64_t)offsetForDate:(NSDate*)date
+{
+    NSTimeInterval const timestamp = date.timeIntervalSince1970;
+    __block uint64_t result;
+
+    dispatch_sync(_queue, ^{
+        result = _nextOffset;
+        if (!_segments.count) { return; }
+
+        // Last segment starting at or before the date.
+        NSUInteger index = 0;
+        for (NSUInteger i=0; i<_segments.count; ++i)
+        {
+            NSTimeInterval const first = [self firstTimestampOfSegment:_segments[i]];
+            if (!isnan(first) && first > timestamp) { break; }
+            index = i;
+        }
+
+        for (; index < _segments.count; ++index)
+        {
+            HtHLogSegment* segment = _segments[index];
+            NSData* mapping = [self mappingOfSegment:segment];
+            uint64_t current = segment.baseOffset;
+            NSUInteger position = 0;
+
+            while (position != NSNotFound)
+            {
+                NSTimeInterval recordTimestamp;
+                NSUInteger const recordEnd = [HtHReadingLog readRecordInData:mapping atPosition:position sample:NULL timestamp:&recordTimestamp];
+                if (recordEnd == NSNotFound) { break; }
+                if (recordTimestamp >= timestamp) { result = current; return; }
+                position = recordEnd;
+                current++;
+            }
+        }
+    });
+    return result;
+}
+
+- (void)applyRetention
+{
+    dispatch_async(_queue, ^{ [self removeExpiredSegments]; });
+}
+
+#pragma mark Cursors
+
+- (BOOL)getCursor:(uint64_t*)offset forName:(NSString*)name
+{
+    __block NSNumber* cursor;
+    dispatch_sync(_queue, ^{ cursor = (name) ? _cursors[name] : nil; });
+    if (!cursor) { return NO; }
+    if (offset) { *offset = cursor.unsignedLongLongValue; }
+    return YES;
+}
+
+- (void)commitCursor:(uint64_t)offset forName:(NSString*)name
+{
+    if (!name.length) { return; }
+
+    dispatch_async(_queue, ^{
+        _cursors[name] = @(offset);
+        if (_cursorsSaveScheduled) { return; }
+        _cursorsSaveScheduled = YES;
+
+        __weak HtHReadingLog* weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(HtHReadingLog_cursorsDelay * NSEC_PER_SEC)), _queue, ^{
+            HtHReadingLog* strongSelf = weakSelf;
+            if (!strongSelf) { return; }
+            strongSelf->_cursorsSaveScheduled = NO;
+            [strongSelf saveCursors];
+        });
+    });
+}
+
+- (void)removeCursorForName:(NSString*)name
+{
+    if (!name.length) { return; }
+    dispatch_async(_queue, ^{
+        [_cursors removeObjectForKey:name];
+        [self saveCursors];
+    });
+}
+
+#pragma mark Observers
+
+- (id)addAppendObserver:(void (^)(uint64_t nextOffset))block
+{
+    if (!block) { return nil; }
+
+    NSUUID* token = [NSUUID UUID];
+    dispatch_async(_queue, ^{ _observers[token] = [block copy]; });
+    return token;
+}
+
+- (void)removeAppendObserver:(id)token
+{
+    if (!token) { return; }
+    dispatch_async(_queue, ^{ [_observers removeObjectForKey:token]; });
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        result = @{
+            @"log.segments"     : @(_segments.count),
+            @"log.nextOffset"   : @(_nextOffset),
+            @"log.cursors"      : @(_cursors.count)
+        };
+    });
+    return result;
+}
+
+#pragma mark - Private functionality
+
++ (NSData*)recordForSample:(HtHSample*)sample
+{
+    NSMutableDictionary* dict = [[NSMutableDictionary alloc] initWithCapacity:5];
+    dict[HtHReadingLog_keyDevice] = sample.deviceID;
+    if (sample.meaning) { dict[HtHReadingLog_keyMeaning] = sample.meaning; }
+    if (sample.path) { dict[HtHReadingLog_keyPath] = sample.path; }
+    if (sample.unit) { dict[HtHReadingLog_keyUnit] = sample.unit; }
+    dict[HtHReadingLog_keyValue] = (sample.value) ? sample.value : [NSNull null];
+    if (![NSJSONSerialization isValidJSONObject:dict]) { return nil; }
+
+    NSData* payload = [NSJSONSerialization dataWithJSONObject:dict options:kNilOptions error:nil];
+    if (!payload) { return nil; }
+
+    HtHLogRecordHeader header = { (uint32_t)payload.length, HtHLogChecksum(payload.bytes, payload.length), sample.timestamp };
+    NSMutableData* record = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+    [record appendData:payload];
+    return record;
+}
+
+// It returns the position right after the record or NSNotFound if there is no valid record at the position.
++ (NSUInteger)readRecordInData:(NSData*)data atPosition:(NSUInteger)position sample:(HtHSample* __autoreleasing*)sample timestamp:(NSTimeInterval*)timestamp
+{
+    if (position + sizeof(HtHLogRecordHeader) > data.length) { return NSNotFound; }
+
+    HtHLogRecordHeader header;
+    memcpy(&header, (uint8_t const*)data.bytes + position, sizeof(header));
+    NSUInteger const payloadStart = position + sizeof(header);
+    if (!header.length || payloadStart + header.length > data.length) { return NSNotFound; }
+
+    void const* payload = (uint8_t const*)data.bytes + payloadStart;
+    if (HtHLogChecksum(payload, header.length) != header.checksum) { return NSNotFound; }
+
+    if (timestamp) { *timestamp = header.timestamp; }
+    if (sample)
+    {
+        NSDictionary* dict = [NSJSONSerialization JSONObjectWithData:[NSData dataWithBytesNoCopy:(void*)payload length:header.length freeWhenDone:NO] options:kNilOptions error:nil];
+        id value = dict[HtHReadingLog_keyValue];
+        *sample = [[HtHSample alloc] initWithDeviceID:dict[HtHReadingLog_keyDevice] meaning:dict[HtHReadingLog_keyMeaning] path:dict[HtHReadingLog_keyPath] unit:dict[HtHReadingLog_keyUnit] value:(value != [NSNull null]) ? value : nil date:[NSDate dateWithTimeIntervalSince1970:header.timestamp]];
+    }
+    return payloadStart + header.length;
+}
+
+// It is called from init, before the log's queue is handed to anybody else.
+- (void)loadSegments
+{
+    NSArray* files = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:_directory includingPropertiesForKeys:nil options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    for (NSURL* file in files)
+    {
+        if (![file.pathExtension isEqualToString:HtHReadingLog_extension]) { continue; }
+
+        HtHLogSegment* segment = [[HtHLogSegment alloc] init];
+        segment.baseOffset = strtoull(file.lastPathComponent.stringByDeletingPathExtension.UTF8String, NULL, 10);
+        segment.url = file;
+        segment.firstTimestamp = NAN;
+        segment.cachedOffset = segment.baseOffset;
+        [_segments addObject:segment];
+    }
+    [_segments sortUsingComparator:^NSComparisonResult(HtHLogSegment* segment1, HtHLogSegment* segment2) {
+        return (segment1.baseOffset < segment2.baseOffset) ? NSOrderedAscending : (segment1.baseOffset > segment2.baseOffset) ? NSOrderedDescending : NSOrderedSame;
+    }];
+
+    HtHLogSegment* last = _segments.lastObject;
+    if (!last) { return; }
+
+    // Count the records of the last segment and cut any partially written record.
+    NSData* mapping = [self mappingOfSegment:last];
+    NSUInteger position = 0, count = 0;
+    while (YES)
+    {
+        NSUInteger const recordEnd = [HtHReadingLog readRecordInData:mapping atPosition:position sample:NULL timestamp:NULL];
+        if (recordEnd == NSNotFound) { break; }
+        position = recordEnd;
+        count++;
+    }
+    last.mapping = nil;
+
+    _nextOffset = last.baseOffset + count;
+    _writer = [NSFileHandle fileHandleForWritingToURL:last.url error:nil];
+    [_writer truncateFileAtOffset:position];
+    _writerSize = position;
+}
+
+// It must be called from the log's queue.
+- (void)rollSegment
+{
+    [_writer synchronizeFile];
+    [_writer closeFile];
+    _writer = nil;
+
+    HtHLogSegment* last = _segments.lastObject;
+    if (last && last.baseOffset == _nextOffset) { [_segments removeLastObject]; }   // Empty segment: reuse its name.
+
+    HtHLogSegment* segment = [[HtHLogSegment alloc] init];
+    segment.baseOffset = _nextOffset;
+    segment.url = [_directory URLByAppendingPathComponent:[NSString stringWithFormat:@"%020llu.%@", _nextOffset, HtHReadingLog_extension]];
+    segment.firstTimestamp = NAN;
+    segment.cachedOffset = _nextOffset;
+
+    if (![[NSFileManager defaultManager] createFileAtPath:segment.url.path contents:nil attributes:nil]) { return; }
+    _writer = [NSFileHandle fileHandleForWritingToURL:segment.url error:nil];
+    if (!_writer) { return; }
+
+    _writerSize = 0;
+    [_segments addObject:segment];
+    [self removeExpiredSegments];
+}
+
+// It must be called from the log's queue. The last (active) segment is never removed.
+- (void)removeExpiredSegments
+{
+    if (_retention <= 0.0) { return; }
+    NSTimeInterval const cutoff = [NSDate date].timeIntervalSince1970 - _retention;
+
+    while (_segments.count > 1)
+    {
+        // All records of a segment are older than the first record of the following one.
+        NSTimeInterval const nextFirst = [self firstTimestampOfSegment:_segments[1]];
+        if (isnan(nextFirst) || nextFirst >= cutoff) { break; }
+
+        [[NSFileManager defaultManager] removeItemAtURL:((HtHLogSegment*)_segments.firstObject).url error:nil];
+        [_segments removeObjectAtIndex:0];
+    }
+}
+
+// The active segment keeps growing, so its mapping is refreshed whenever the file is bigger than the mapped region.
+- (NSData*)mappingOfSegment:(HtHLogSegment*)segment
+{
+    BOOL const isActive = (segment == _segments.lastObject);
+    if (segment.mapping && (!isActive || segment.mapping.length >= _writerSize)) { return segment.mapping; }
+
+    segment.mapping = [NSData dataWithContentsOfURL:segment.url options:NSDataReadingMappedAlways error:nil];
+    return segment.mapping;
+}
+
+- (NSTimeInterval)firstTimestampOfSegment:(HtHLogSegment*)segment
+{
+    if (!isnan(segment.firstTimestamp)) { return segment.firstTimestamp; }
+
+    NSTimeInterval timestamp;
+    if ([HtHReadingLog readRecordInData:[self mappingOfSegment:segment] atPosition:0 sample:NULL timestamp:&timestamp] == NSNotFound) { return NAN; }
+    segment.firstTimestamp = timestamp;
+    return timestamp;
+}
+
+- (NSUInteger)indexOfSegmentContainingOffset:(uint64_t)offset
+{
+    NSUInteger low = 0, high = _segments.count;
+    while (high - low > 1)
+    {
+        NSUInteger const middle = (low + high) / 2;
+        if (((HtHLogSegment*)_segments[middle]).baseOffset <= offset) { low = middle; } else { high = middle; }
+    }
+    return low;
+}
+
+// Sequential readers hit the cached position; other offsets are found by walking the records from the closest known position.
+- (NSUInteger)positionOfOffset:(uint64_t)offset inSegment:(HtHLogSegment*)segment mapping:(NSData*)mapping
+{
+    uint64_t current = segment.baseOffset;
+    NSUInteger position = 0;
+    if (segment.cachedOffset <= offset && segment.cachedOffset >= segment.baseOffset) { current = segment.cachedOffset; position = segment.cachedPosition; }
+
+    while (current < offset)
+    {
+        position = [HtHReadingLog readRecordInData:mapping atPosition:position sample:NULL timestamp:NULL];
+        if (position == NSNotFound) { return NSNotFound; }
+        current++;
+    }
+    return position;
+}
+
+// It must be called from the log's queue.
+- (void)saveCursors
+{
+    [_cursors writeToURL:[_directory URLByAppendingPathComponent:HtHReadingLog_cursorsFile] atomically:YES];
+}
+
+@end
@@ -0,0 +1,52 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Block used by a stage to pass its output down the pipeline.
+ *
+ *  @param samples Array of <code>HtHSample</code> objects in the order they must be delivered.
+ */
+typedef void (^HtHSamplesBlock)(NSArray* samples);
+
+/*!
+ *  @abstract A step of the <code>HtHReadingHub</code> ingest pipeline.
+ *  @discussion Stages are always called from the hub's serial queue, thus they don't need to be thread-safe. A stage can hold samples back and release them later on.
+ */
+@protocol HtHReadingStage <NSObject>
+
+@required
+/*!
+ *  @abstract Processes a batch of samples.
+ *
+ *  @param samples Array of <code>HtHSample</code> objects.
+ *  @param output Block to be called (zero or more times) with the samples that go to the next stage.
+ */
+- (void)stageSamples:(NSArray*)samples output:(HtHSamplesBlock)output;
+
+@optional
+/*!
+ *  @abstract Releases the samples held by the stage whose deadline has expired.
+ *
+ *	@return Seconds until the next flush is needed or a negative number if the stage holds no samples.
+ */
+- (NSTimeInterval)flushWithOutput:(HtHSamplesBlock)output;
+
+/*!
+ *  @abstract Counters describing the work done by the stage (<code>NSString</code> keys, <code>NSNumber</code> values).
+ */
+- (NSDictionary*)metrics;
+
+/*!
+ *  @abstract Last samples (oldest first) of a series kept by the stage. It must be thread safe.
+ */
+- (NSArray*)historicSamplesForDeviceID:(NSString*)deviceID meaning:(NSString*)meaning;
+
+/*!
+ *  @abstract Processes samples recovered from history. Stages not implementing it let them through untouched.
+ *  @discussion Backfilled samples are older than what the stage may have already seen, so only stages that rewrite values (e.g.: the transforms) or keep records (e.g.: the log, the latest values) need to implement it.
+ *
+ *  @param samples Array of <code>HtHSample</code> objects (oldest first).
+ *  @param output Block that must be called (before returning) with the samples that go to the next stage.
+ */
+- (void)backfillSamples:(NSArray*)samples output:(HtHSamplesBlock)output;
+
+@end
@@ -0,0 +1,38 @@
+@import Foundation;         // Apple
+#import "HtHReadingStage.h" // HtH
+
+/*!
+ *  @abstract Puts the samples of every device in timestamp order and drops redelivered copies.
+ *  @discussion Each device has a small reorder window: samples are held until a sample newer than them by <code>window</code> seconds arrives, until they have waited <code>window</code> seconds, or until the buffer reaches its <code>capacity</code>.
+ *  Duplicates are detected with a fixed-size ring of recent sample fingerprints per device.
+ *  Samples arriving older than the last one emitted for that device cannot be ordered anymore and are dropped.
+ */
+@interface HtHReorderStage : NSObject <HtHReadingStage>
+
+/*!
+ *  @abstract Creates a reorder stage.
+ *
+ *  @param window Maximum seconds a sample is held back (it is also the maximum timestamp disorder tolerated).
+ *  @param capacity Maximum number of samples held per device.
+ */
+- (instancetype)initWithWindow:(NSTimeInterval)window capacity:(NSUInteger)capacity;
+
+@property (readonly,nonatomic) NSTimeInterval window;
+@property (readonly,nonatomic) NSUInteger capacity;
+
+/*!
+ *  @abstract Number of samples that arrived out of order and were put back in place.
+ */
+@property (readonly,nonatomic) NSUInteger reorderedCount;
+
+/*!
+ *  @abstract Number of samples dropped because an identical sample had been received recently.
+ */
+@property (readonly,nonatomic) NSUInteger duplicateCount;
+
+/*!
+ *  @abstract Number of samples dropped because they arrived after newer samples had already been emitted.
+ */
+@property (readonly,nonatomic) NSUInteger lateCount;
+
+@end
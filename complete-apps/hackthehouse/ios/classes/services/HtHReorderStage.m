@@ -0,0 +1,189 @@
+#import "HtHReorderStage.h"     // Header
+#import "HtHSample.h"           // HtH
+#import "HtHMemoryAccounting.h" // HtH
+
+#define HtHReorderStage_filterSize  64
+
+@interface HtHReorderEntry : NSObject
+- (instancetype)initWithSample:(HtHSample*)sample arrival:(CFAbsoluteTime)arrival;
+@property (readonly,nonatomic) HtHSample* sample;
+@property (readonly,nonatomic) CFAbsoluteTime arrival;
+@end
+
+// Held samples are accounted under HtHMemorySubsystemQueues for as long as their entry lives.
+@implementation HtHReorderEntry
+
+- (instancetype)initWithSample:(HtHSample*)sample arrival:(CFAbsoluteTime)arrival
+{
+    self = [super init];
+    if (self)
+    {
+        _sample = sample;
+        _arrival = arrival;
+        HtHMemoryAccount(HtHMemorySubsystemQueues, (int64_t)(HtHMemoryObjectSize(self) + sample.footprint), 1);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    HtHMemoryAccount(HtHMemorySubsystemQueues, -(int64_t)(HtHMemoryObjectSize(self) + _sample.footprint), -1);
+}
+
+@end
+
+@interface HtHReorderBuffer : NSObject
+@property (readonly,nonatomic) NSMutableArray* entries;
+@property (nonatomic) NSTimeInterval lastEmitted;
+@property (nonatomic) NSTimeInterval newestSeen;
+- (BOOL)containsFingerprint:(uint64_t)fingerprint;
+- (void)rememberFingerprint:(uint64_t)fingerprint;
+@end
+
+@implementation HtHReorderBuffer
+{
+    uint64_t _fingerprints[HtHReorderStage_filterSize];
+    NSUInteger _fingerprintsHead;
+    NSUInteger _fingerprintsCount;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _entries = [[NSMutableArray alloc] init];
+        _lastEmitted = -DBL_MAX;
+        _newestSeen = -DBL_MAX;
+    }
+    return self;
+}
+
+- (BOOL)containsFingerprint:(uint64_t)fingerprint
+{
+    for (NSUInteger i=0; i<_fingerprintsCount; ++i) { if (_fingerprints[i] == fingerprint) { return YES; } }
+    return NO;
+}
+
+- (void)rememberFingerprint:(uint64_t)fingerprint
+{
+    _fingerprints[_fingerprintsHead] = fingerprint;
+    _fingerprintsHead = (_fingerprintsHead + 1) % HtHReorderStage_filterSize;
+    if (_fingerprintsCount < HtHReorderStage_filterSize) { _fingerprintsCount++; }
+}
+
+@end
+
+@implementation HtHReorderStage
+{
+    NSMutableDictionary* _buffers;  // deviceID -> HtHReorderBuffer
+}
+
+#pragma mark - Public API
+
+- (instancetype)init
+{
+    return [self initWithWindow:0.25 capacity:32];
+}
+
+- (instancetype)initWithWindow:(NSTimeInterval)window capacity:(NSUInteger)capacity
+{
+    if (window < 0.0 || !capacity) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _window = window;
+        _capacity = capacity;
+        _buffers = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void)stageSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    NSMutableArray* result = [[NSMutableArray alloc] init];
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+
+    for (HtHSample* sample in samples)
+    {
+        HtHReorderBuffer* buffer = _buffers[sample.deviceID];
+        if (!buffer) { buffer = [[HtHReorderBuffer alloc] init]; _buffers[sample.deviceID] = buffer; }
+
+        if ([buffer containsFingerprint:sample.fingerprint]) { _duplicateCount++; continue; }
+        [buffer rememberFingerprint:sample.fingerprint];
+
+        if (sample.timestamp < buffer.lastEmitted) { _lateCount++; continue; }
+
+        // Most samples arrive in order, so the insertion point is searched from the end.
+        NSMutableArray* entries = buffer.entries;
+        NSUInteger index = entries.count;
+        while (index > 0 && ((HtHReorderEntry*)entries[index-1]).sample.timestamp > sample.timestamp) { index--; }
+        if (index != entries.count) { _reorderedCount++; }
+
+        HtHReorderEntry* entry = [[HtHReorderEntry alloc] initWithSample:sample arrival:now];
+        [entries insertObject:entry atIndex:index];
+        if (sample.timestamp > buffer.newestSeen) { buffer.newestSeen = sample.timestamp; }
+
+        [self releaseFromBuffer:buffer watermark:buffer.newestSeen - _window deadline:-DBL_MAX into:result];
+    }
+
+    if (result.count) { output(result); }
+}
+
+- (NSTimeInterval)flushWithOutput:(HtHSamplesBlock)output
+{
+    NSMutableArray* result = [[NSMutableArray alloc] init];
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+    CFAbsoluteTime nextArrival = DBL_MAX;
+
+    for (HtHReorderBuffer* buffer in _buffers.allValues)
+    {
+        [self releaseFromBuffer:buffer watermark:buffer.newestSeen - _window deadline:now - _window into:result];
+        for (HtHReorderEntry* entry in buffer.entries) { if (entry.arrival < nextArrival) { nextArrival = entry.arrival; } }
+    }
+
+    if (result.count) { output(result); }
+    return (nextArrival == DBL_MAX) ? -1.0 : MAX(nextArrival + _window - now, 0.0);
+}
+
+- (NSDictionary*)metrics
+{
+    NSUInteger held = 0;
+    for (HtHReorderBuffer* buffer in _buffers.allValues) { held += buffer.entries.count; }
+
+    return @{
+        @"reorder.reordered"    : @(_reorderedCount),
+        @"reorder.duplicates"   : @(_duplicateCount),
+        @"reorder.late"         : @(_lateCount),
+        @"reorder.held"         : @(held)
+    };
+}
+
+#pragma mark - Private functionality
+
+// Samples are kept sorted by timestamp, thus, releasing them from the head keeps the order.
+- (void)releaseFromBuffer:(HtHReorderBuffer*)buffer watermark:(NSTimeInterval)watermark deadline:(CFAbsoluteTime)deadline into:(NSMutableArray*)result
+{
+    NSMutableArray* entries = buffer.entries;
+    NSUInteger count = 0;
+
+    // A sample waiting past the deadline releases everything sorted before it as well.
+    NSUInteger expired = 0;
+    for (NSUInteger i=0; i<entries.count; ++i) { if (((HtHReorderEntry*)entries[i]).arrival <= deadline) { expired = i + 1; } }
+
+    while (count < entries.count)
+    {
+        HtHReorderEntry* entry = entries[count];
+        BOOL const overCapacity = (entries.count - count) > _capacity;
+        if (entry.sample.timestamp > watermark && count >= expired && !overCapacity) { break; }
+
+        [result addObject:entry.sample];
+        buffer.lastEmitted = entry.sample.timestamp;
+        count++;
+    }
+
+    if (count) { [entries removeObjectsInRange:NSMakeRange(0, count)]; }
+}
+
+@end
@@ -0,0 +1,69 @@
+@import Foundation;         // Apple
+@class RelayrDevice;        // Relayr.framework
+@class RelayrReading;       // Relayr.framework
+
+/*!
+ *  @abstract Immutable snapshot of a single value received from a <code>RelayrReading</code>.
+ *  @discussion <code>RelayrReading</code> only holds the latest value, so every sample entering the <code>HtHReadingHub</code> is copied into one of these objects before it goes through the pipeline stages.
+ */
+@interface HtHSample : NSObject <NSCopying>
+
+/*!
+ *  @abstract Snapshots the current value of the reading passed.
+ *
+ *  @param device The device producing the reading.
+ *  @param reading The reading whose <code>value</code> and <code>date</code> are copied.
+ *	@return Fully initialised sample or <code>nil</code> if the device has no <code>uid</code>.
+ */
+- (instancetype)initWithDevice:(RelayrDevice*)device reading:(RelayrReading*)reading;
+
+- (instancetype)initWithDeviceID:(NSString*)deviceID
+                         meaning:(NSString*)meaning
+                            path:(NSString*)path
+                            unit:(NSString*)unit
+                           value:(id)value
+                            date:(NSDate*)date;
+
+@property (readonly,nonatomic) NSString* deviceID;
+@property (readonly,nonatomic) NSString* meaning;
+@property (readonly,nonatomic) NSString* path;
+@property (readonly,nonatomic) NSString* unit;
+@property (readonly,nonatomic) id value;
+@property (readonly,nonatomic) NSDate* date;
+
+/*!
+ *  @abstract The sensor timestamp (seconds since 1970) of the sample.
+ */
+@property (readonly,nonatomic) NSTimeInterval timestamp;
+
+/*!
+ *  @abstract The value as a <code>double</code> or <code>NAN</code> if the value is not an <code>NSNumber</code>.
+ */
+@property (readonly,nonatomic) double doubleValue;
+
+/*!
+ *  @abstract String identifying the series this sample belongs to (<code>deviceID/path/meaning</code>).
+ */
+@property (readonly,nonatomic) NSString* seriesKey;
+
+/*!
+ *  @abstract 64-bit hash of the series, timestamp and value. Two redelivered copies of the same sample share the same fingerprint.
+ */
+@property (readonly,nonatomic) uint64_t fingerprint;
+
+/*!
+ *  @abstract JSON compatible representation (keys: deviceID, meaning, path, unit, value and timestamp).
+ */
+@property (readonly,nonatomic) NSDictionary* dictionaryRepresentation;
+
+/*!
+ *  @abstract Approximate bytes retained by the sample (the object and the strings it owns). It is accounted under <code>HtHMemorySubsystemSamples</code>.
+ */
+@property (readonly,nonatomic) NSUInteger footprint;
+
+/*!
+ *  @abstract Returns a copy of the sample (same series and timestamp) with a different value and unit.
+ */
+- (instancetype)sampleWithValue:(id)value unit:(NSString*)unit;
+
+@end
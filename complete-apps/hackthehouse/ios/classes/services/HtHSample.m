@@ -0,0 +1,104 @@
+#import "HtHSample.h"           // Header
+#import "HtHMemoryAccounting.h" // HtH
+#import <Relayr/Relayr.h>       // Relayr.framework
+
+#define HtHSample_FNVOffset     14695981039346656037ULL
+#define HtHSample_FNVPrime      1099511628211ULL
+
+static uint64_t HtHSampleFNV(uint64_t hash, void const* bytes, size_t length)
+{
+    uint8_t const* ptr = bytes;
+    for (size_t i=0; i<length; ++i) { hash = (hash ^ ptr[i]) * HtHSample_FNVPrime; }
+    return hash;
+}
+
+@implementation HtHSample
+
+#pragma mark - Public API
+
+- (instancetype)initWithDevice:(RelayrDevice*)device reading:(RelayrReading*)reading
+{
+    if (!device.uid.length || !reading) { return nil; }
+    return [self initWithDeviceID:device.uid meaning:reading.meaning path:reading.path unit:reading.unit value:reading.value date:(reading.date) ? reading.date : [NSDate date]];
+}
+
+- (instancetype)initWithDeviceID:(NSString*)deviceID meaning:(NSString*)meaning path:(NSString*)path unit:(NSString*)unit value:(id)value date:(NSDate*)date
+{
+    if (!deviceID.length || !date) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _deviceID = deviceID.copy;
+        _meaning = meaning.copy;
+        _path = path.copy;
+        _unit = unit.copy;
+        _value = value;
+        _date = date;
+        _timestamp = date.timeIntervalSince1970;
+        _seriesKey = [NSString stringWithFormat:@"%@/%@/%@", _deviceID, (_path) ? _path : @"", (_meaning) ? _meaning : @""];
+
+        NSData* keyData = [_seriesKey dataUsingEncoding:NSUTF8StringEncoding];
+        NSUInteger const valueHash = [(NSObject*)_value hash];
+        uint64_t hash = HtHSampleFNV(HtHSample_FNVOffset, keyData.bytes, keyData.length);
+        hash = HtHSampleFNV(hash, &_timestamp, sizeof(_timestamp));
+        _fingerprint = HtHSampleFNV(hash, &valueHash, sizeof(valueHash));
+
+        _footprint = HtHMemoryObjectSize(self) + HtHMemoryObjectSize(_deviceID) + HtHMemoryObjectSize(_meaning) + HtHMemoryObjectSize(_path) + HtHMemoryObjectSize(_unit) + HtHMemoryObjectSize(_seriesKey);
+        HtHMemoryAccount(HtHMemorySubsystemSamples, (int64_t)_footprint, 1);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    HtHMemoryAccount(HtHMemorySubsystemSamples, -(int64_t)_footprint, -1);
+}
+
+- (double)doubleValue
+{
+    return ([_value isKindOfClass:[NSNumber class]]) ? ((NSNumber*)_value).doubleValue : NAN;
+}
+
+- (NSDictionary*)dictionaryRepresentation
+{
+    NSMutableDictionary* result = [[NSMutableDictionary alloc] initWithCapacity:6];
+    result[@"deviceID"] = _deviceID;
+    if (_meaning) { result[@"meaning"] = _meaning; }
+    if (_path) { result[@"path"] = _path; }
+    if (_unit) { result[@"unit"] = _unit; }
+    result[@"value"] = (_value) ? _value : [NSNull null];
+    result[@"timestamp"] = @(_timestamp);
+    return result;
+}
+
+- (instancetype)sampleWithValue:(id)value unit:(NSString*)unit
+{
+    return [[[self class] alloc] initWithDeviceID:_deviceID meaning:_meaning path:_path unit:unit value:value date:_date];
+}
+
+- (id)copyWithZone:(NSZone*)zone
+{
+    return self;
+}
+
+- (NSUInteger)hash
+{
+    return (NSUInteger)_fingerprint;
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (self == object) { return YES; }
+    if (![object isKindOfClass:[HtHSample class]]) { return NO; }
+
+    HtHSample* sample = object;
+    return _fingerprint == sample.fingerprint && _timestamp == sample.timestamp && [_seriesKey isEqualToString:sample.seriesKey];
+}
+
+- (NSString*)description
+{
+    return [NSString stringWithFormat:@"<%@ %@ = %@ @ %@>", NSStringFromClass([self class]), _seriesKey, _value, _date];
+}
+
+@end
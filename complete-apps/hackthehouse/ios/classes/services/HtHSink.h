@@ -0,0 +1,26 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Destination where an <code>HtHSinkConnector</code> forwards the samples of the reading log.
+ *  @discussion Sinks are always called from the connector's private queue, one batch at a time, thus they may block while writing.
+ */
+@protocol HtHSink <NSObject>
+
+@required
+/*!
+ *  @abstract Writes a batch of samples.
+ *  @discussion When the method returns <code>NO</code> the connector retries the same batch later, thus sinks should tolerate receiving a batch more than once.
+ *
+ *  @param samples Array of <code>HtHSample</code> objects in log order.
+ *  @param error Pointer to an error object that is set when the write fails.
+ *	@return <code>YES</code> if the whole batch was written.
+ */
+- (BOOL)writeSamples:(NSArray*)samples error:(NSError**)error;
+
+@optional
+/*!
+ *  @abstract Releases any resource held by the sink (files, sockets, etc.). It is called when the connector stops.
+ */
+- (void)close;
+
+@end
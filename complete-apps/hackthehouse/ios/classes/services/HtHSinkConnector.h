@@ -0,0 +1,65 @@
+@import Foundation;     // Apple
+#import "HtHSink.h"     // HtH
+@class HtHReadingLog;   // HtH
+@class HtHLoadShedder;  // HtH
+
+/*!
+ *  @abstract Forwards the samples of an <code>HtHReadingLog</code> to an <code>HtHSink</code>.
+ *  @discussion The connector keeps a named cursor in the log, so the log itself is the disk spool: samples are never lost while the sink is unreachable (as long as the log retains them) and forwarding resumes where it left off after a restart.
+ *  Samples are grouped in batches of up to <code>batchSize</code> samples, waiting at most <code>lingerTime</code> for a batch to fill up. A failed batch is retried with exponential backoff (with jitter) and the cursor only moves forward after a successful write.
+ */
+@interface HtHSinkConnector : NSObject
+
+/*!
+ *  @abstract Creates a connector.
+ *
+ *  @param name Name of the connector; it is also the name of its cursor in the log.
+ *  @param sink The destination of the samples.
+ *  @param log The reading log samples are read from.
+ */
+- (instancetype)initWithName:(NSString*)name sink:(id <HtHSink>)sink log:(HtHReadingLog*)log;
+
+/*!
+ *  @abstract Creates a connector in gateway mode: the sink receives the window aggregates of an <code>HtHAggregatingSink</code> instead of the raw samples.
+ *  @discussion The aggregating sink is named after the connector and keeps the log for raw retrieval; it is the connector's <code>sink</code>.
+ *
+ *  @param window Length of the aggregation windows in seconds (e.g.: 60).
+ */
+- (instancetype)initWithName:(NSString*)name sink:(id <HtHSink>)sink aggregationWindow:(NSTimeInterval)window log:(HtHReadingLog*)log;
+
+@property (readonly,nonatomic) NSString* name;
+@property (readonly,nonatomic) id <HtHSink> sink;
+
+/*!
+ *  @abstract Maximum samples per batch. Default: 500.
+ */
+@property (atomic) NSUInteger batchSize;
+
+/*!
+ *  @abstract Maximum seconds a sample waits for its batch to fill up. Default: 1.
+ */
+@property (atomic) NSTimeInterval lingerTime;
+
+/*!
+ *  @abstract Seconds before the first retry; every consecutive failure doubles it up to <code>maximumBackoff</code>. Defaults: 0.5 and 60.
+ */
+@property (atomic) NSTimeInterval initialBackoff;
+@property (atomic) NSTimeInterval maximumBackoff;
+
+/*!
+ *  @abstract Controller whose archive level can pause forwarding under overload. Default: the <code>HtHReadingHub</code> shared hub's one.
+ */
+@property (weak,atomic) HtHLoadShedder* loadShedder;
+
+@property (readonly,atomic,getter=isRunning) BOOL running;
+
+- (void)start;
+
+- (void)stop;
+
+/*!
+ *  @abstract Counters of the connector: samples, batches, failures, pending samples (lag), pumps postponed by load shedding and delivered throughput (samples per second of wall-clock time, waiting and retries included).
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,194 @@
+#import "HtHSinkConnector.h"    // Header
+#import "HtHReadingLog.h"       // HtH
+#import "HtHReadingHub.h"       // HtH
+#import "HtHLoadShedder.h"      // HtH
+#import "HtHAggregatingSink.h"  // HtH
+
+#define HtHSinkConnector_batchSize          500
+#define HtHSinkConnector_lingerTime         1.0
+#define HtHSinkConnector_initialBackoff     0.5
+#define HtHSinkConnector_maximumBackoff     60.0
+#define HtHSinkConnector_throughputWeight   0.2
+
+@interface HtHSinkConnector ()
+@property (readwrite,atomic,getter=isRunning) BOOL running;
+@end
+
+@implementation HtHSinkConnector
+{
+    HtHReadingLog* _log;
+    dispatch_queue_t _queue;
+    id _observer;
+    uint64_t _offset;
+    NSUInteger _generation;         // Invalidates the timers scheduled before a stop.
+    BOOL _pumpScheduled;
+    CFAbsoluteTime _pendingSince;   // When the oldest unsent sample was noticed (0 if none).
+    NSTimeInterval _backoff;
+
+    NSUInteger _samplesCount;
+    NSUInteger _batchesCount;
+    NSUInteger _failuresCount;
+    NSUInteger _postponedCount;
+    double _throughput;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithName:(NSString*)name sink:(id <HtHSink>)sink log:(HtHReadingLog*)log
+{
+    if (!name.length || !sink || !log) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _name = name.copy;
+        _sink = sink;
+        _log = log;
+        _queue = dispatch_queue_create("io.relayr.hth.sink", DISPATCH_QUEUE_SERIAL);
+        _batchSize = HtHSinkConnector_batchSize;
+        _lingerTime = HtHSinkConnector_lingerTime;
+        _initialBackoff = HtHSinkConnector_initialBackoff;
+        _maximumBackoff = HtHSinkConnector_maximumBackoff;
+        _loadShedder = [HtHReadingHub sharedHub].loadShedder;
+    }
+    return self;
+}
+
+- (instancetype)initWithName:(NSString*)name sink:(id <HtHSink>)sink aggregationWindow:(NSTimeInterval)window log:(HtHReadingLog*)log
+{
+    HtHAggregatingSink* aggregatingSink = (log) ? [[HtHAggregatingSink alloc] initWithName:name sink:sink window:window log:log] : nil;
+    return [self initWithName:name sink:aggregatingSink log:log];
+}
+
+- (void)dealloc
+{
+    [_log removeAppendObserver:_observer];
+}
+
+- (void)start
+{
+    dispatch_async(_queue, ^{
+        if (self.isRunning) { return; }
+        self.running = YES;
+        _generation++;
+        _backoff = 0.0;
+
+        uint64_t cursor;
+        _offset = ([_log getCursor:&cursor forName:_name]) ? cursor : _log.nextOffset;
+
+        __weak HtHSinkConnector* weakSelf = self;
+        _observer = [_log addAppendObserver:^(uint64_t nextOffset) {
+            HtHSinkConnector* strongSelf = weakSelf;
+            if (strongSelf) { dispatch_async(strongSelf->_queue, ^{ [strongSelf pump]; }); }
+        }];
+        [self pump];
+    });
+}
+
+- (void)stop
+{
+    dispatch_async(_queue, ^{
+        if (!self.isRunning) { return; }
+        self.running = NO;
+        _generation++;
+        _pumpScheduled = NO;
+
+        [_log removeAppendObserver:_observer];
+        _observer = nil;
+        if ([_sink respondsToSelector:@selector(close)]) { [_sink close]; }
+    });
+}
+
+- (NSDictionary*)metrics
+{
+    __block NSDictionary* result;
+    dispatch_sync(_queue, ^{
+        uint64_t const nextOffset = _log.nextOffset;
+        result = @{
+            [NSString stringWithFormat:@"sink.%@.samples", _name]       : @(_samplesCount),
+            [NSString stringWithFormat:@"sink.%@.batches", _name]       : @(_batchesCount),
+            [NSString stringWithFormat:@"sink.%@.failures", _name]      : @(_failuresCount),
+            [NSString stringWithFormat:@"sink.%@.pending", _name]       : @((nextOffset > _offset) ? nextOffset - _offset : 0),
+            [NSString stringWithFormat:@"sink.%@.postponed", _name]     : @(_postponedCount),
+            [NSString stringWithFormat:@"sink.%@.throughput", _name]    : @(_throughput)
+        };
+    });
+    return result;
+}
+
+#pragma mark - Private functionality
+
+// It must be called from the connector's queue.
+- (void)pump
+{
+    if (!self.isRunning || _pumpScheduled) { return; }
+
+    uint64_t const nextOffset = _log.nextOffset;
+    if (nextOffset <= _offset) { _pendingSince = 0.0; return; }
+
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+    if (_pendingSince == 0.0) { _pendingSince = now; }
+
+    NSUInteger const batchSize = MAX(self.batchSize, (NSUInteger)1);
+    NSTimeInterval const linger = self.lingerTime;
+
+    // While archival is paused the samples stay in the log; the connector catches up once it is resumed.
+    if ([self.loadShedder levelForClass:HtHSubscriptionClassArchive] >= HtHShedLevelPause)
+    {
+        _postponedCount++;
+        return [self schedulePumpAfter:linger];
+    }
+    if (nextOffset - _offset < batchSize && now - _pendingSince < linger)
+    {
+        return [self schedulePumpAfter:_pendingSince + linger - now];
+    }
+
+    uint64_t next;
+    NSArray* samples = [_log samplesFromOffset:_offset limit:batchSize nextOffset:&next];
+    if (!samples.count)
+    {
+        // Records removed by retention (or unreadable) are skipped.
+        if (next > _offset) { _offset = next; [_log commitCursor:next forName:_name]; dispatch_async(_queue, ^{ [self pump]; }); }
+        return;
+    }
+
+    NSError* error;
+    if (![_sink writeSamples:samples error:&error])
+    {
+        _failuresCount++;
+        _backoff = (_backoff > 0.0) ? MIN(_backoff * 2.0, self.maximumBackoff) : self.initialBackoff;
+        NSTimeInterval const jitter = _backoff * 0.2 * ((double)arc4random_uniform(1000) / 1000.0);
+        return [self schedulePumpAfter:_backoff + jitter];
+    }
+
+    // Throughput is measured over wall-clock time: from the moment the batch's first sample was waiting (lingering and retries included) until it was delivered.
+    NSTimeInterval const elapsed = MAX(CFAbsoluteTimeGetCurrent() - _pendingSince, 1e-6);
+    double const batchThroughput = samples.count / elapsed;
+    _throughput = (_batchesCount) ? (1.0 - HtHSinkConnector_throughputWeight) * _throughput + HtHSinkConnector_throughputWeight * batchThroughput : batchThroughput;
+
+    _backoff = 0.0;
+    _samplesCount += samples.count;
+    _batchesCount++;
+    _offset = next;
+    _pendingSince = 0.0;
+    [_log commitCursor:next forName:_name];
+
+    dispatch_async(_queue, ^{ [self pump]; });
+}
+
+// It must be called from the connector's queue.
+- (void)schedulePumpAfter:(NSTimeInterval)delay
+{
+    _pumpScheduled = YES;
+    NSUInteger const generation = _generation;
+
+    __weak HtHSinkConnector* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(delay, 0.0) * NSEC_PER_SEC)), _queue, ^{
+        HtHSinkConnector* strongSelf = weakSelf;
+        if (!strongSelf || generation != strongSelf->_generation) { return; }
+        strongSelf->_pumpScheduled = NO;
+        [strongSelf pump];
+    });
+}
+
+@end
@@ -0,0 +1,91 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+@class HtHSample;           // HtH
+
+/*!
+ *  @abstract A Block executed when a sample matching the subscription leaves the <code>HtHReadingHub</code> pipeline.
+ *
+ *  @param sample The sample delivered.
+ *  @param unsubscribe A boolean pointer that can be set to <code>YES</code> to stop the subscription.
+ */
+typedef void (^HtHSampleReceivedBlock)(HtHSample* sample, BOOL* unsubscribe);
+
+/*!
+ *  @abstract A Block executed once with all the samples recovered from history after the app comes back from the background.
+ *
+ *  @param samples Array of <code>HtHSample</code> objects (oldest first) matching the subscription.
+ */
+typedef void (^HtHSamplesBackfillBlock)(NSArray* samples);
+
+/*!
+ *  @abstract What happens to the upstream subscription of a device while the app is in the background.
+ *  @discussion A device keeps the most demanding policy of all its subscriptions.
+ *
+ *  @constant HtHBackgroundPolicySuspend The upstream subscription is dropped and the gap is backfilled from history on resume.
+ *  @constant HtHBackgroundPolicyDownshift The upstream subscription of every reading is dropped after each sample and made again once <code>HtHReadingHub</code>'s <code>downshiftInterval</code> elapses, so only one sample per series and interval goes through.
+ *  @constant HtHBackgroundPolicyKeep The upstream subscription is kept untouched.
+ */
+typedef NS_ENUM(NSUInteger, HtHBackgroundPolicy) {
+    HtHBackgroundPolicySuspend = 0,
+    HtHBackgroundPolicyDownshift,
+    HtHBackgroundPolicyKeep
+};
+
+/*!
+ *  @abstract Kind of work a subscription feeds, from the most to the least latency sensitive.
+ *  @discussion Each class has its own latency objective; under overload the <code>HtHLoadShedder</code> degrades the lower classes first.
+ *
+ *  @constant HtHSubscriptionClassInteractive Values shown in the user interface.
+ *  @constant HtHSubscriptionClassRules Automations reacting to values (rules, shadows, schedulers).
+ *  @constant HtHSubscriptionClassArchive Recording and forwarding of values.
+ */
+typedef NS_ENUM(NSUInteger, HtHSubscriptionClass) {
+    HtHSubscriptionClassInteractive = 0,
+    HtHSubscriptionClassRules,
+    HtHSubscriptionClassArchive,
+    HtHSubscriptionClassCount
+};
+
+/*!
+ *  @abstract Handle returned by <code>HtHReadingHub</code> every time a subscription is made.
+ *  @discussion A subscription matches all samples of a device, or only the ones of a specific meaning (and path) when those are not <code>nil</code>.
+ */
+@interface HtHSubscription : NSObject
+
+- (instancetype)initWithDeviceID:(NSString*)deviceID
+                         meaning:(NSString*)meaning
+                            path:(NSString*)path
+                           block:(HtHSampleReceivedBlock)block
+                      errorBlock:(RelayrReadingErrorReceivedBlock)errorBlock;
+
+@property (readonly,nonatomic) NSString* deviceID;
+@property (readonly,nonatomic) NSString* meaning;
+@property (readonly,nonatomic) NSString* path;
+@property (readonly,nonatomic) HtHSampleReceivedBlock block;
+@property (readonly,nonatomic) RelayrReadingErrorReceivedBlock errorBlock;
+
+/*!
+ *  @abstract Background behaviour of the subscription. Default: <code>HtHBackgroundPolicySuspend</code>.
+ */
+@property (atomic) HtHBackgroundPolicy backgroundPolicy;
+
+/*!
+ *  @abstract Class of work the subscription feeds. Default: <code>HtHSubscriptionClassInteractive</code>.
+ */
+@property (atomic) HtHSubscriptionClass subscriptionClass;
+
+/*!
+ *  @abstract Block receiving backfilled samples in a single batch. If <code>nil</code>, only the latest backfilled sample of every series is delivered to <code>block</code>.
+ */
+@property (copy,atomic) HtHSamplesBackfillBlock backfillBlock;
+
+/*!
+ *  @abstract Whether the subscription has been cancelled. Once cancelled, its blocks are not executed anymore.
+ */
+@property (readonly,atomic,getter=isCancelled) BOOL cancelled;
+
+- (BOOL)matchesSample:(HtHSample*)sample;
+
+- (void)cancel;
+
+@end
@@ -0,0 +1,56 @@
+#import "HtHSubscription.h"     // Header
+#import "HtHSample.h"           // HtH
+#import "HtHMemoryAccounting.h" // HtH
+
+@interface HtHSubscription ()
+@property (readwrite,atomic,getter=isCancelled) BOOL cancelled;
+@end
+
+@implementation HtHSubscription
+
+#pragma mark - Public API
+
+- (instancetype)initWithDeviceID:(NSString*)deviceID meaning:(NSString*)meaning path:(NSString*)path block:(HtHSampleReceivedBlock)block errorBlock:(RelayrReadingErrorReceivedBlock)errorBlock
+{
+    if (!deviceID.length || !block) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _deviceID = deviceID.copy;
+        _meaning = meaning.copy;
+        _path = path.copy;
+        _block = [block copy];
+        _errorBlock = [errorBlock copy];
+        HtHMemoryAccount(HtHMemorySubsystemSubscribers, (int64_t)self.footprint, 1);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    HtHMemoryAccount(HtHMemorySubsystemSubscribers, -(int64_t)self.footprint, -1);
+}
+
+- (BOOL)matchesSample:(HtHSample*)sample
+{
+    if (![_deviceID isEqualToString:sample.deviceID]) { return NO; }
+    if (_meaning && ![_meaning isEqualToString:sample.meaning]) { return NO; }
+    if (_path && ![_path isEqualToString:sample.path]) { return NO; }
+    return YES;
+}
+
+- (void)cancel
+{
+    self.cancelled = YES;
+}
+
+#pragma mark - Private functionality
+
+// Blocks are heap copies, so the allocator knows their size (captured variables included).
+- (NSUInteger)footprint
+{
+    return HtHMemoryObjectSize(self) + HtHMemoryObjectSize(_block) + HtHMemoryObjectSize(_errorBlock) + HtHMemoryObjectSize(_deviceID);
+}
+
+@end
@@ -0,0 +1,40 @@
+@import Foundation;         // Apple
+#import "HtHReadingStage.h" // HtH
+
+/*!
+ *  @abstract Configuration key with a dictionary mapping reading meanings to the unit their values must be delivered in (e.g.: <code>@{ @"temperature" : @"fahrenheit" }</code>).
+ */
+FOUNDATION_EXPORT NSString* const kHtHTransformUnits;
+
+/*!
+ *  @abstract Configuration key with a dictionary mapping device uids to dictionaries of meaning -> calibration polynomial.
+ *  @discussion A calibration polynomial is an array of <code>NSNumber</code> coefficients in ascending order (<code>@[c0, c1, c2]</code> means <code>c0 + c1*x + c2*x^2</code>). The calibration is applied in the unit the value was received in, before the unit conversion.
+ *  The device uid <code>*</code> applies to all devices without a specific calibration.
+ */
+FOUNDATION_EXPORT NSString* const kHtHTransformCalibrations;
+
+/*!
+ *  @abstract Applies unit conversion and per-device calibration to numeric samples.
+ *  @discussion Samples of a batch are grouped by the transform they need (calibration coefficients, scale, offset and target unit), so every series sharing a transform is handled in one pass of the vectorised (Accelerate) kernels.
+ *  Non numeric samples and samples without a transform go through untouched.
+ */
+@interface HtHTransformStage : NSObject <HtHReadingStage>
+
+/*!
+ *  @abstract Creates a transform stage.
+ *
+ *  @param configuration Dictionary with the keys <code>kHtHTransformUnits</code> and/or <code>kHtHTransformCalibrations</code>. It can be <code>nil</code>.
+ */
+- (instancetype)initWithConfiguration:(NSDictionary*)configuration;
+
+/*!
+ *  @abstract The current configuration. It can be replaced at any time; the following batches use the new configuration.
+ */
+@property (atomic,copy) NSDictionary* configuration;
+
+/*!
+ *  @abstract Number of samples whose value was changed by the stage.
+ */
+@property (readonly,nonatomic) NSUInteger transformedCount;
+
+@end
@@ -0,0 +1,184 @@
+#import "HtHTransformStage.h"   // Header
+#import "HtHSample.h"           // HtH
+#import "HtHUnits.h"            // HtH
+@import Accelerate;             // Apple
+
+NSString* const kHtHTransformUnits          = @"units";
+NSString* const kHtHTransformCalibrations   = @"calibrations";
+
+#define HtHTransformStage_anyDevice     @"*"
+
+// Compiled transform: value = polynomial(value) * scale + offset. Transforms with the same parameters are equal, so series sharing them are batched together.
+@interface HtHTransform : NSObject
+@property (strong,nonatomic) NSData* coefficients;  // doubles, highest degree first (as vDSP_vpolyD expects).
+@property (nonatomic) double scale;
+@property (nonatomic) double offset;
+@property (strong,nonatomic) NSString* unit;
+@property (readonly,nonatomic) BOOL isIdentity;
+@end
+
+@implementation HtHTransform
+
+- (BOOL)isIdentity
+{
+    return !_coefficients.length && _scale == 1.0 && _offset == 0.0;
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (object == self) { return YES; }
+    if (![object isKindOfClass:[HtHTransform class]]) { return NO; }
+
+    HtHTransform* transform = object;
+    return transform.scale == _scale && transform.offset == _offset
+        && (transform.coefficients == _coefficients || [transform.coefficients isEqualToData:_coefficients])
+        && (transform.unit == _unit || [transform.unit isEqualToString:_unit]);
+}
+
+- (NSUInteger)hash
+{
+    return _coefficients.hash ^ _unit.hash ^ @(_scale).hash ^ (@(_offset).hash << 1);
+}
+
+@end
+
+@implementation HtHTransformStage
+{
+    NSDictionary* _compiledConfiguration;   // The configuration the cache was built for.
+    NSMutableDictionary* _transforms;       // seriesKey + unit -> HtHTransform or NSNull
+}
+
+@synthesize configuration = _configuration;
+
+#pragma mark - Public API
+
+- (instancetype)init
+{
+    return [self initWithConfiguration:nil];
+}
+
+- (instancetype)initWithConfiguration:(NSDictionary*)configuration
+{
+    self = [super init];
+    if (self)
+    {
+        _configuration = (configuration) ? configuration.copy : @{};
+        _transforms = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void)stageSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    NSDictionary* configuration = self.configuration;
+    if (configuration != _compiledConfiguration) { [_transforms removeAllObjects]; _compiledConfiguration = configuration; }
+
+    // Group the indices of the numeric samples by the transform they need (series with the same coefficients, scale, offset and unit share a group).
+    NSMapTable* groups = [NSMapTable strongToStrongObjectsMapTable];   // HtHTransform -> NSMutableIndexSet
+    [samples enumerateObjectsUsingBlock:^(HtHSample* sample, NSUInteger idx, BOOL* stop) {
+        if (![sample.value isKindOfClass:[NSNumber class]]) { return; }
+
+        HtHTransform* transform = [self transformForSample:sample configuration:configuration];
+        if (!transform) { return; }
+
+        NSMutableIndexSet* indexes = [groups objectForKey:transform];
+        if (!indexes) { indexes = [[NSMutableIndexSet alloc] init]; [groups setObject:indexes forKey:transform]; }
+        [indexes addIndex:idx];
+    }];
+    if (!groups.count) { return output(samples); }
+
+    NSMutableArray* result = samples.mutableCopy;
+    NSMutableData* buffer = [[NSMutableData alloc] init];
+    NSMutableData* scratch = [[NSMutableData alloc] init];
+
+    for (HtHTransform* transform in groups)
+    {
+        NSIndexSet* indexes = [groups objectForKey:transform];
+        vDSP_Length const count = indexes.count;
+        buffer.length = count * sizeof(double);
+        scratch.length = count * sizeof(double);
+        double* values = buffer.mutableBytes;
+
+        __block vDSP_Length i = 0;
+        [indexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL* stop) { values[i++] = ((HtHSample*)samples[idx]).doubleValue; }];
+
+        [HtHTransformStage applyTransform:transform toValues:values scratch:scratch.mutableBytes count:count];
+
+        i = 0;
+        [indexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL* stop) {
+            result[idx] = [(HtHSample*)samples[idx] sampleWithValue:@(values[i++]) unit:transform.unit];
+        }];
+        _transformedCount += count;
+    }
+
+    output(result);
+}
+
+// Recovered samples are converted like live ones, so subscribers never mix units or calibrations.
+- (void)backfillSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    [self stageSamples:samples output:output];
+}
+
+- (NSDictionary*)metrics
+{
+    return @{ @"transform.transformed" : @(_transformedCount) };
+}
+
+#pragma mark - Private functionality
+
++ (void)applyTransform:(HtHTransform*)transform toValues:(double*)values scratch:(double*)scratch count:(vDSP_Length)count
+{
+    vDSP_Length const numCoefficients = transform.coefficients.length / sizeof(double);
+    if (numCoefficients)
+    {
+        vDSP_vpolyD(transform.coefficients.bytes, 1, values, 1, scratch, 1, count, numCoefficients - 1);
+        memcpy(values, scratch, count * sizeof(double));
+    }
+
+    if (transform.scale != 1.0 || transform.offset != 0.0)
+    {
+        double scale = transform.scale, offset = transform.offset;
+        vDSP_vsmsaD(values, 1, &scale, &offset, values, 1, count);
+    }
+}
+
+// Transforms are compiled the first time a series is seen and cached until the configuration changes.
+- (HtHTransform*)transformForSample:(HtHSample*)sample configuration:(NSDictionary*)configuration
+{
+    NSString* key = [NSString stringWithFormat:@"%@|%@", sample.seriesKey, (sample.unit) ? sample.unit : @""];
+    id cached = _transforms[key];
+    if (cached) { return (cached != [NSNull null]) ? cached : nil; }
+
+    HtHTransform* transform = [[HtHTransform alloc] init];
+    transform.scale = 1.0;
+    transform.unit = sample.unit;
+
+    NSDictionary* calibrations = configuration[kHtHTransformCalibrations];
+    NSArray* polynomial = calibrations[sample.deviceID][sample.meaning];
+    if (!polynomial) { polynomial = calibrations[HtHTransformStage_anyDevice][sample.meaning]; }
+    if ([polynomial isKindOfClass:[NSArray class]] && polynomial.count)
+    {
+        NSMutableData* coefficients = [NSMutableData dataWithLength:polynomial.count * sizeof(double)];
+        double* ptr = coefficients.mutableBytes;
+        [polynomial enumerateObjectsWithOptions:NSEnumerationReverse usingBlock:^(NSNumber* coefficient, NSUInteger idx, BOOL* stop) {
+            *ptr++ = coefficient.doubleValue;
+        }];
+        transform.coefficients = coefficients;
+    }
+
+    NSString* targetUnit = configuration[kHtHTransformUnits][sample.meaning];
+    double scale, offset;
+    if (targetUnit && [HtHUnits getScale:&scale offset:&offset fromUnit:sample.unit toUnit:targetUnit])
+    {
+        transform.scale = scale;
+        transform.offset = offset;
+        transform.unit = targetUnit;
+    }
+
+    BOOL const isIdentity = transform.isIdentity && (transform.unit == sample.unit || [transform.unit isEqualToString:sample.unit]);
+    _transforms[key] = (isIdentity) ? [NSNull null] : transform;
+    return (isIdentity) ? nil : transform;
+}
+
+@end
@@ -0,0 +1,30 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Unit conversion table used by the pipeline.
+ *  @discussion Units are grouped by dimension (temperature, ratio, etc.). Any two units of the same dimension can be converted with a linear <code>value * scale + offset</code> function.
+ *  Unit names are case insensitive and common aliases (e.g.: "ºC", "°C", "celsius") are accepted. Ambiguous abbreviations ("C", "F" and "g") are only accepted in conversions, when the other unit tells their dimension (e.g.: "g" to "m/s2" is standard gravity).
+ */
+@interface HtHUnits : NSObject
+
+/*!
+ *  @abstract Returns the canonical name of a unit or <code>nil</code> if the unit is unknown (or an ambiguous abbreviation).
+ */
++ (NSString*)canonicalUnit:(NSString*)unit;
+
+/*!
+ *  @abstract Returns the linear function converting values from one unit to another.
+ *
+ *  @param scale Pointer where the multiplier will be written.
+ *  @param offset Pointer where the addend will be written.
+ *	@return <code>NO</code> if any of the units is unknown or they belong to different dimensions.
+ */
++ (BOOL)getScale:(double*)scale offset:(double*)offset fromUnit:(NSString*)fromUnit toUnit:(NSString*)toUnit;
+
+/*!
+ *  @abstract Symbol used to display values measured in the unit passed (e.g.: "ºC" for "celsius").
+ *  @discussion If the unit is unknown, the unit string is returned.
+ */
++ (NSString*)symbolForUnit:(NSString*)unit;
+
+@end
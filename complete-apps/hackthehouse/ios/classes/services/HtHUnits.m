@@ -0,0 +1,118 @@
+#import "HtHUnits.h"    // Header
+
+#define HtHUnitKey_Dimension    @"dimension"
+#define HtHUnitKey_Scale        @"scale"
+#define HtHUnitKey_Offset       @"offset"
+#define HtHUnitKey_Symbol       @"symbol"
+
+@implementation HtHUnits
+
+#pragma mark - Public API
+
++ (NSString*)canonicalUnit:(NSString*)unit
+{
+    if (!unit.length) { return nil; }
+    NSString* lowercase = unit.lowercaseString;
+    NSString* alias = [HtHUnits aliases][lowercase];
+    NSString* result = (alias) ? alias : lowercase;
+    return ([HtHUnits table][result]) ? result : nil;
+}
+
++ (BOOL)getScale:(double*)scale offset:(double*)offset fromUnit:(NSString*)fromUnit toUnit:(NSString*)toUnit
+{
+    NSString* fromName = [HtHUnits canonicalUnit:fromUnit];
+    NSString* toName = [HtHUnits canonicalUnit:toUnit];
+
+    // Ambiguous abbreviations only resolve within the dimension of the other unit.
+    if (!fromName && toName) { fromName = [HtHUnits canonicalUnit:fromUnit dimension:[HtHUnits table][toName][HtHUnitKey_Dimension]]; }
+    if (!toName && fromName) { toName = [HtHUnits canonicalUnit:toUnit dimension:[HtHUnits table][fromName][HtHUnitKey_Dimension]]; }
+    if (!fromName && !toName)
+    {
+        for (NSString* dimension in [HtHUnits scopedAliases])
+        {
+            fromName = [HtHUnits canonicalUnit:fromUnit dimension:dimension];
+            toName = [HtHUnits canonicalUnit:toUnit dimension:dimension];
+            if (fromName && toName) { break; }
+        }
+    }
+
+    NSDictionary* from = (fromName) ? [HtHUnits table][fromName] : nil;
+    NSDictionary* to = (toName) ? [HtHUnits table][toName] : nil;
+    if (!from || !to || ![from[HtHUnitKey_Dimension] isEqualToString:to[HtHUnitKey_Dimension]]) { return NO; }
+
+    // Every unit is defined as: base = value * scale + offset.
+    double const fromScale = [from[HtHUnitKey_Scale] doubleValue], fromOffset = [from[HtHUnitKey_Offset] doubleValue];
+    double const toScale = [to[HtHUnitKey_Scale] doubleValue], toOffset = [to[HtHUnitKey_Offset] doubleValue];
+    if (scale) { *scale = fromScale / toScale; }
+    if (offset) { *offset = (fromOffset - toOffset) / toScale; }
+    return YES;
+}
+
++ (NSString*)symbolForUnit:(NSString*)unit
+{
+    NSString* symbol = [HtHUnits table][[HtHUnits canonicalUnit:unit]][HtHUnitKey_Symbol];
+    return (symbol) ? symbol : unit;
+}
+
+#pragma mark - Private functionality
+
++ (NSString*)canonicalUnit:(NSString*)unit dimension:(NSString*)dimension
+{
+    if (!unit.length || !dimension) { return nil; }
+    return [HtHUnits scopedAliases][dimension][unit.lowercaseString];
+}
+
++ (NSDictionary*)table
+{
+    static NSDictionary* table;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        table = @{
+            @"celsius"      : @{ HtHUnitKey_Dimension : @"temperature", HtHUnitKey_Scale : @1.0, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"ºC" },
+            @"fahrenheit"   : @{ HtHUnitKey_Dimension : @"temperature", HtHUnitKey_Scale : @(1.0/1.8), HtHUnitKey_Offset : @(-32.0/1.8), HtHUnitKey_Symbol : @"ºF" },
+            @"kelvin"       : @{ HtHUnitKey_Dimension : @"temperature", HtHUnitKey_Scale : @1.0, HtHUnitKey_Offset : @(-273.15), HtHUnitKey_Symbol : @"K" },
+            @"percent"      : @{ HtHUnitKey_Dimension : @"ratio", HtHUnitKey_Scale : @0.01, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"%" },
+            @"ratio"        : @{ HtHUnitKey_Dimension : @"ratio", HtHUnitKey_Scale : @1.0, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"" },
+            @"lux"          : @{ HtHUnitKey_Dimension : @"illuminance", HtHUnitKey_Scale : @1.0, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"lx" },
+            @"decibel"      : @{ HtHUnitKey_Dimension : @"sound", HtHUnitKey_Scale : @1.0, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"dB" },
+            @"gravity"      : @{ HtHUnitKey_Dimension : @"acceleration", HtHUnitKey_Scale : @9.80665, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"g" },
+            @"m/s2"         : @{ HtHUnitKey_Dimension : @"acceleration", HtHUnitKey_Scale : @1.0, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"m/s²" },
+            @"deg/s"        : @{ HtHUnitKey_Dimension : @"angularspeed", HtHUnitKey_Scale : @1.0, HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"º/s" },
+            @"rad/s"        : @{ HtHUnitKey_Dimension : @"angularspeed", HtHUnitKey_Scale : @(180.0/M_PI), HtHUnitKey_Offset : @0.0, HtHUnitKey_Symbol : @"rad/s" }
+        };
+    });
+    return table;
+}
+
++ (NSDictionary*)aliases
+{
+    static NSDictionary* aliases;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        aliases = @{
+            @"ºc" : @"celsius", @"°c" : @"celsius",
+            @"ºf" : @"fahrenheit", @"°f" : @"fahrenheit",
+            @"k" : @"kelvin",
+            @"%" : @"percent",
+            @"lx" : @"lux",
+            @"db" : @"decibel"
+        };
+    });
+    return aliases;
+}
+
+// Abbreviations that mean different things in different dimensions ("c" for centi-, "g" for gram), by the dimension where they are accepted.
++ (NSDictionary*)scopedAliases
+{
+    static NSDictionary* aliases;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        aliases = @{
+            @"temperature"  : @{ @"c" : @"celsius", @"f" : @"fahrenheit" },
+            @"acceleration" : @{ @"g" : @"gravity" }
+        };
+    });
+    return aliases;
+}
+
+@end
@@ -0,0 +1,43 @@
+@import Foundation;     // Apple
+
+/*!
+ *  @abstract Block computing the value of a virtual reading.
+ *
+ *  @param inputs Array with the latest <code>HtHSample</code> of each input meaning (in the order given by <code>inputMeanings</code>).
+ *	@return The new value or <code>nil</code> if it cannot be computed from the inputs passed.
+ */
+typedef id (^HtHVirtualReadingFormula)(NSArray* inputs);
+
+/*!
+ *  @abstract Definition of a reading that is not produced by a sensor, but derived from one or more readings of the same device.
+ *  @discussion Virtual readings are evaluated by the <code>HtHVirtualReadingStage</code>. Their samples have the device of the inputs, the <code>meaning</code> of the definition and no path.
+ */
+@interface HtHVirtualReading : NSObject
+
+- (instancetype)initWithMeaning:(NSString*)meaning
+                           unit:(NSString*)unit
+                  inputMeanings:(NSArray*)inputMeanings
+                        formula:(HtHVirtualReadingFormula)formula;
+
+@property (readonly,nonatomic) NSString* meaning;
+@property (readonly,nonatomic) NSString* unit;
+@property (readonly,nonatomic) NSArray* inputMeanings;
+@property (readonly,nonatomic) HtHVirtualReadingFormula formula;
+
+/*!
+ *  @abstract Dew point (in celsius) computed with the Magnus formula from the "temperature" and "humidity" readings.
+ *  @discussion Both inputs are normalised first (temperature to celsius, humidity to percent) when their unit is known; readings without a unit are taken as celsius and percent.
+ */
++ (instancetype)dewPoint;
+
+/*!
+ *  @abstract Illuminance (in lux) computed from the red, green and blue channels of the "color" reading.
+ */
++ (instancetype)lightLux;
+
+/*!
+ *  @abstract Sum of the squared axes of the "angularSpeed" reading.
+ */
++ (instancetype)motionEnergy;
+
+@end
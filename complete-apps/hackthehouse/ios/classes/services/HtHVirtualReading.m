@@ -0,0 +1,80 @@
+#import "HtHVirtualReading.h"   // Header
+#import "HtHSample.h"           // HtH
+#import "HtHUnits.h"            // HtH
+
+#define HtHVirtualReading_magnusA   17.62
+#define HtHVirtualReading_magnusB   243.12
+
+@implementation HtHVirtualReading
+
+#pragma mark - Public API
+
+- (instancetype)initWithMeaning:(NSString*)meaning unit:(NSString*)unit inputMeanings:(NSArray*)inputMeanings formula:(HtHVirtualReadingFormula)formula
+{
+    if (!meaning.length || !inputMeanings.count || !formula) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _meaning = meaning.copy;
+        _unit = unit.copy;
+        _inputMeanings = inputMeanings.copy;
+        _formula = [formula copy];
+    }
+    return self;
+}
+
++ (instancetype)dewPoint
+{
+    return [[HtHVirtualReading alloc] initWithMeaning:@"dewPoint" unit:@"celsius" inputMeanings:@[@"temperature", @"humidity"] formula:^id(NSArray* inputs) {
+        HtHSample* temperature = inputs[0];
+        HtHSample* humidity = inputs[1];
+
+        double celsius = temperature.doubleValue, scale, offset;
+        if (temperature.unit && [HtHUnits getScale:&scale offset:&offset fromUnit:temperature.unit toUnit:@"celsius"]) { celsius = celsius * scale + offset; }
+        double relative = humidity.doubleValue;
+        if (humidity.unit && [HtHUnits getScale:&scale offset:&offset fromUnit:humidity.unit toUnit:@"percent"]) { relative = relative * scale + offset; }
+        if (isnan(celsius) || isnan(relative) || relative <= 0.0) { return nil; }
+
+        double const gamma = log(relative / 100.0) + (HtHVirtualReading_magnusA * celsius) / (HtHVirtualReading_magnusB + celsius);
+        return @((HtHVirtualReading_magnusB * gamma) / (HtHVirtualReading_magnusA - gamma));
+    }];
+}
+
++ (instancetype)lightLux
+{
+    return [[HtHVirtualReading alloc] initWithMeaning:@"lux" unit:@"lux" inputMeanings:@[@"color"] formula:^id(NSArray* inputs) {
+        double rgb[3];
+        if (![HtHVirtualReading getComponents:rgb keys:@[@"red", @"green", @"blue"] fromValue:((HtHSample*)inputs[0]).value]) { return nil; }
+
+        // TCS3x7x luminance coefficients.
+        return @(MAX(-0.32466 * rgb[0] + 1.57837 * rgb[1] - 0.73191 * rgb[2], 0.0));
+    }];
+}
+
++ (instancetype)motionEnergy
+{
+    return [[HtHVirtualReading alloc] initWithMeaning:@"motionEnergy" unit:nil inputMeanings:@[@"angularSpeed"] formula:^id(NSArray* inputs) {
+        double xyz[3];
+        if (![HtHVirtualReading getComponents:xyz keys:@[@"x", @"y", @"z"] fromValue:((HtHSample*)inputs[0]).value]) { return nil; }
+        return @(xyz[0]*xyz[0] + xyz[1]*xyz[1] + xyz[2]*xyz[2]);
+    }];
+}
+
+#pragma mark - Private functionality
+
+// Multi-value readings arrive either as dictionaries (keyed by component) or as arrays (ordered like the keys).
++ (BOOL)getComponents:(double*)components keys:(NSArray*)keys fromValue:(id)value
+{
+    for (NSUInteger i=0; i<keys.count; ++i)
+    {
+        id component;
+        if ([value isKindOfClass:[NSDictionary class]]) { component = ((NSDictionary*)value)[keys[i]]; }
+        else if ([value isKindOfClass:[NSArray class]] && ((NSArray*)value).count > i) { component = ((NSArray*)value)[i]; }
+        if (![component isKindOfClass:[NSNumber class]]) { return NO; }
+        components[i] = ((NSNumber*)component).doubleValue;
+    }
+    return YES;
+}
+
+@end
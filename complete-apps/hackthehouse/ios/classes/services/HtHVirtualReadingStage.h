@@ -0,0 +1,27 @@
+@import Foundation;         // Apple
+#import "HtHReadingStage.h" // HtH
+
+/*!
+ *  @abstract Evaluates <code>HtHVirtualReading</code> definitions as their inputs arrive.
+ *  @discussion The stage caches the latest input samples per device. A definition is only re-evaluated when one of its inputs changes value, and the result is emitted right after the sample that triggered it. Every subscriber of the hub shares the same evaluation.
+ *  The last samples of every virtual reading are kept, the same way <code>RelayrReading</code> keeps its <code>historicValues</code>.
+ */
+@interface HtHVirtualReadingStage : NSObject <HtHReadingStage>
+
+/*!
+ *  @abstract Creates the stage.
+ *
+ *  @param virtualReadings Array of <code>HtHVirtualReading</code> definitions.
+ *  @param historySize Number of samples kept per virtual reading and device.
+ */
+- (instancetype)initWithVirtualReadings:(NSArray*)virtualReadings historySize:(NSUInteger)historySize;
+
+@property (readonly,nonatomic) NSArray* virtualReadings;
+
+/*!
+ *  @abstract Returns the last samples (oldest first) of a virtual reading for a specific device.
+ *  @discussion This method is thread safe.
+ */
+- (NSArray*)historicSamplesForDeviceID:(NSString*)deviceID meaning:(NSString*)meaning;
+
+@end
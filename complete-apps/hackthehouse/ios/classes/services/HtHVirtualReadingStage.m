@@ -0,0 +1,129 @@
+#import "HtHVirtualReadingStage.h"  // Header
+#import "HtHVirtualReading.h"       // HtH
+#import "HtHSample.h"               // HtH
+#import "HtHMemoryAccounting.h"     // HtH
+
+@implementation HtHVirtualReadingStage
+{
+    NSDictionary* _readingsByInput;     // input meaning -> NSArray of HtHVirtualReading
+    NSMutableDictionary* _inputs;       // deviceID -> (meaning -> HtHSample)
+    NSMutableDictionary* _history;      // deviceID/meaning -> NSMutableArray of HtHSample
+    NSUInteger _historySize;
+    NSUInteger _evaluationsCount;
+    NSUInteger _skippedCount;
+}
+
+#pragma mark - Public API
+
+- (instancetype)init
+{
+    return [self initWithVirtualReadings:@[[HtHVirtualReading dewPoint], [HtHVirtualReading lightLux], [HtHVirtualReading motionEnergy]] historySize:20];
+}
+
+- (instancetype)initWithVirtualReadings:(NSArray*)virtualReadings historySize:(NSUInteger)historySize
+{
+    self = [super init];
+    if (self)
+    {
+        _virtualReadings = (virtualReadings) ? virtualReadings.copy : @[];
+        _inputs = [[NSMutableDictionary alloc] init];
+        _history = [[NSMutableDictionary alloc] init];
+        _historySize = historySize;
+
+        NSMutableDictionary* readingsByInput = [[NSMutableDictionary alloc] init];
+        for (HtHVirtualReading* reading in _virtualReadings)
+        {
+            for (NSString* meaning in reading.inputMeanings)
+            {
+                NSArray* readings = readingsByInput[meaning];
+                readingsByInput[meaning] = (readings) ? [readings arrayByAddingObject:reading] : @[reading];
+            }
+        }
+        _readingsByInput = readingsByInput.copy;
+    }
+    return self;
+}
+
+- (void)stageSamples:(NSArray*)samples output:(HtHSamplesBlock)output
+{
+    NSMutableArray* result;
+
+    for (HtHSample* sample in samples)
+    {
+        [result addObject:sample];
+
+        NSArray* dependants = (sample.meaning) ? _readingsByInput[sample.meaning] : nil;
+        if (!dependants.count) { continue; }
+
+        NSMutableDictionary* deviceInputs = _inputs[sample.deviceID];
+        if (!deviceInputs) { deviceInputs = [[NSMutableDictionary alloc] init]; _inputs[sample.deviceID] = deviceInputs; }
+
+        HtHSample* previous = deviceInputs[sample.meaning];
+        deviceInputs[sample.meaning] = sample;
+        if (previous && (previous.value == sample.value || [previous.value isEqual:sample.value])) { _skippedCount++; continue; }
+
+        // The output array is only created when the stage actually adds samples.
+        if (!result) { result = [[samples subarrayWithRange:NSMakeRange(0, [samples indexOfObjectIdenticalTo:sample] + 1)] mutableCopy]; }
+
+        for (HtHVirtualReading* reading in dependants)
+        {
+            HtHSample* derived = [self evaluate:reading inputs:deviceInputs trigger:sample];
+            if (derived) { [result addObject:derived]; }
+        }
+    }
+
+    output((result) ? result : samples);
+}
+
+- (NSArray*)historicSamplesForDeviceID:(NSString*)deviceID meaning:(NSString*)meaning
+{
+    @synchronized(_history)
+    {
+        return [_history[[NSString stringWithFormat:@"%@/%@", deviceID, meaning]] copy];
+    }
+}
+
+- (NSDictionary*)metrics
+{
+    return @{
+        @"virtual.evaluations"  : @(_evaluationsCount),
+        @"virtual.skipped"      : @(_skippedCount)
+    };
+}
+
+#pragma mark - Private functionality
+
+- (HtHSample*)evaluate:(HtHVirtualReading*)reading inputs:(NSDictionary*)deviceInputs trigger:(HtHSample*)trigger
+{
+    NSMutableArray* inputs = [[NSMutableArray alloc] initWithCapacity:reading.inputMeanings.count];
+    for (NSString* meaning in reading.inputMeanings)
+    {
+        HtHSample* input = deviceInputs[meaning];
+        if (!input) { return nil; }
+        [inputs addObject:input];
+    }
+
+    _evaluationsCount++;
+    id value = reading.formula(inputs);
+    if (!value) { return nil; }
+
+    HtHSample* derived = [[HtHSample alloc] initWithDeviceID:trigger.deviceID meaning:reading.meaning path:nil unit:reading.unit value:value date:trigger.date];
+    if (!derived || !_historySize) { return derived; }
+
+    @synchronized(_history)
+    {
+        NSString* key = [NSString stringWithFormat:@"%@/%@", derived.deviceID, derived.meaning];
+        NSMutableArray* history = _history[key];
+        if (!history) { history = [[NSMutableArray alloc] initWithCapacity:_historySize]; _history[key] = history; }
+        if (history.count == _historySize)
+        {
+            HtHMemoryAccount(HtHMemorySubsystemHistory, -(int64_t)((HtHSample*)history.firstObject).footprint, -1);
+            [history removeObjectAtIndex:0];
+        }
+        [history addObject:derived];
+        HtHMemoryAccount(HtHMemorySubsystemHistory, (int64_t)derived.footprint, 1);
+    }
+    return derived;
+}
+
+@end
@@ -0,0 +1,79 @@
+@import UIKit;              // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+/*!
+ *  @abstract Block returning the <code>RelayrDevice</code>s shown by a row (e.g.: all devices of a transmitter).
+ */
+typedef NSArray* (^HtHDevicesForIndexPathBlock)(NSIndexPath* indexPath);
+
+/*!
+ *  @abstract Block executed (at most once per <code>updateInterval</code>) when the devices of a visible row have received new samples.
+ *
+ *  @param indexPath The visible row to update.
+ *  @param samples The latest <code>HtHSample</code> of every reading of the row's devices.
+ */
+typedef void (^HtHVisibleSamplesBlock)(NSIndexPath* indexPath, NSArray* samples);
+
+/*!
+ *  @abstract Ties <code>HtHReadingHub</code> subscriptions to the rows of a table view that are on screen.
+ *  @discussion Devices are subscribed when their rows become visible (or are within <code>prefetchDistance</code> rows of being visible) and released <code>lingerTime</code> seconds after they left, so scrolling back and forth doesn't churn subscriptions. Samples are coalesced: only the latest value per reading is kept and visible rows are refreshed at most once per <code>updateInterval</code>. Live values in a long list cost only what is on screen.
+ *  Wanted devices feed the <code>HtHSubscriptionClassInteractive</code> class; lingering ones are demoted to <code>HtHSubscriptionClassArchive</code>, so under overload they are shed before anything on screen.
+ *  It must be used from the main queue. Call <code>updateVisibility</code> when the rows are reloaded and <code>setNeedsUpdateVisibility</code> while scrolling.
+ */
+@interface HtHVisibleSubscriptions : NSObject
+
+- (instancetype)initWithTableView:(UITableView*)tableView devices:(HtHDevicesForIndexPathBlock)devicesBlock update:(HtHVisibleSamplesBlock)updateBlock;
+
+@property (readonly,weak,nonatomic) UITableView* tableView;
+
+/*!
+ *  @abstract Rows subscribed ahead of (and behind) the visible ones. Default: 4.
+ */
+@property (nonatomic) NSUInteger prefetchDistance;
+
+/*!
+ *  @abstract Seconds a device stays subscribed after its row has gone off screen. Default: 5 seconds.
+ */
+@property (nonatomic) NSTimeInterval lingerTime;
+
+/*!
+ *  @abstract Minimum seconds between updates of the same row. Default: 1 second.
+ */
+@property (nonatomic) NSTimeInterval updateInterval;
+
+/*!
+ *  @abstract Minimum seconds between visibility updates requested through <code>setNeedsUpdateVisibility</code>. Default: 0.1 seconds.
+ */
+@property (nonatomic) NSTimeInterval visibilityInterval;
+
+/*!
+ *  @abstract Recomputes the rows wanted and (un)subscribes devices accordingly.
+ */
+- (void)updateVisibility;
+
+/*!
+ *  @abstract Schedules <code>updateVisibility</code>. Calls made within <code>visibilityInterval</code> are coalesced into a single update (use it from <code>scrollViewDidScroll:</code>).
+ */
+- (void)setNeedsUpdateVisibility;
+
+/*!
+ *  @abstract Lets all subscriptions linger (e.g.: when the table view disappears). <code>updateVisibility</code> claims them back.
+ */
+- (void)releaseAll;
+
+/*!
+ *  @abstract Latest samples received for the devices of a row (useful when configuring cells).
+ */
+- (NSArray*)samplesForIndexPath:(NSIndexPath*)indexPath;
+
+/*!
+ *  @abstract Unsubscribes everything immediately. The object can't be used afterwards.
+ */
+- (void)invalidate;
+
+/*!
+ *  @abstract Counters: devices subscribed, subscriptions made and released, samples received and row updates.
+ */
+@property (readonly,nonatomic) NSDictionary* metrics;
+
+@end
@@ -0,0 +1,293 @@
+#import "HtHVisibleSubscriptions.h" // Header
+#import "HtHReadingHub.h"           // HtH
+
+#define HtHVisibleSubscriptions_prefetchDistance    4
+#define HtHVisibleSubscriptions_lingerTime          5.0
+#define HtHVisibleSubscriptions_updateInterval      1.0
+#define HtHVisibleSubscriptions_visibilityInterval  0.1
+
+@interface HtHVisibleEntry : NSObject
+@property (strong,nonatomic) HtHSubscription* subscription;
+@property (strong,nonatomic) NSMutableDictionary* latest;   // seriesKey -> HtHSample
+@property (nonatomic) CFAbsoluteTime releaseTime;           // 0 while the device is wanted
+@end
+
+@implementation HtHVisibleEntry
+@end
+
+@implementation HtHVisibleSubscriptions
+{
+    HtHDevicesForIndexPathBlock _devicesBlock;
+    HtHVisibleSamplesBlock _updateBlock;
+    NSMutableDictionary* _entries;          // deviceID -> HtHVisibleEntry
+    NSMutableDictionary* _indexPaths;       // deviceID -> NSMutableArray of wanted NSIndexPath
+    NSMutableDictionary* _rowDeviceIDs;     // NSIndexPath -> NSArray of deviceID
+    NSMutableSet* _dirtyDeviceIDs;
+    BOOL _updateScheduled;
+    BOOL _visibilityScheduled;
+    BOOL _sweepScheduled;
+    BOOL _invalidated;
+
+    NSUInteger _subscribedCount;
+    NSUInteger _releasedCount;
+    NSUInteger _samplesCount;
+    NSUInteger _updatesCount;
+}
+
+#pragma mark - Public API
+
+- (instancetype)initWithTableView:(UITableView*)tableView devices:(HtHDevicesForIndexPathBlock)devicesBlock update:(HtHVisibleSamplesBlock)updateBlock
+{
+    if (!tableView || !devicesBlock || !updateBlock) { return nil; }
+
+    self = [super init];
+    if (self)
+    {
+        _tableView = tableView;
+        _devicesBlock = [devicesBlock copy];
+        _updateBlock = [updateBlock copy];
+        _prefetchDistance = HtHVisibleSubscriptions_prefetchDistance;
+        _lingerTime = HtHVisibleSubscriptions_lingerTime;
+        _updateInterval = HtHVisibleSubscriptions_updateInterval;
+        _visibilityInterval = HtHVisibleSubscriptions_visibilityInterval;
+        _entries = [[NSMutableDictionary alloc] init];
+        _indexPaths = [[NSMutableDictionary alloc] init];
+        _rowDeviceIDs = [[NSMutableDictionary alloc] init];
+        _dirtyDeviceIDs = [[NSMutableSet alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self invalidate];
+}
+
+- (void)updateVisibility
+{
+    UITableView* tableView = _tableView;
+    if (_invalidated || !tableView) { return; }
+
+    [_indexPaths removeAllObjects];
+    [_rowDeviceIDs removeAllObjects];
+
+    for (NSIndexPath* indexPath in [self wantedIndexPathsOfTableView:tableView])
+    {
+        NSMutableArray* deviceIDs = [[NSMutableArray alloc] init];
+        for (RelayrDevice* device in _devicesBlock(indexPath))
+        {
+            if (![device isKindOfClass:[RelayrDevice class]] || !device.uid) { continue; }
+            [deviceIDs addObject:device.uid];
+
+            NSMutableArray* indexPaths = _indexPaths[device.uid];
+            if (!indexPaths) { indexPaths = [[NSMutableArray alloc] init]; _indexPaths[device.uid] = indexPaths; }
+            [indexPaths addObject:indexPath];
+
+            HtHVisibleEntry* entry = _entries[device.uid];
+            if (!entry) { [self subscribeToDevice:device]; } else if (entry.releaseTime != 0.0) { [self claimEntry:entry]; }
+        }
+        _rowDeviceIDs[indexPath] = deviceIDs;
+    }
+
+    CFAbsoluteTime const releaseTime = CFAbsoluteTimeGetCurrent() + _lingerTime;
+    [_entries enumerateKeysAndObjectsUsingBlock:^(NSString* deviceID, HtHVisibleEntry* entry, BOOL* stop) {
+        if (!_indexPaths[deviceID] && entry.releaseTime == 0.0) { [self lingerEntry:entry until:releaseTime]; }
+    }];
+    [self scheduleSweep];
+}
+
+- (void)setNeedsUpdateVisibility
+{
+    if (_visibilityScheduled || _invalidated) { return; }
+    _visibilityScheduled = YES;
+
+    __weak HtHVisibleSubscriptions* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_visibilityInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        HtHVisibleSubscriptions* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+        strongSelf->_visibilityScheduled = NO;
+        [strongSelf updateVisibility];
+    });
+}
+
+- (void)releaseAll
+{
+    [_indexPaths removeAllObjects];
+    [_rowDeviceIDs removeAllObjects];
+
+    CFAbsoluteTime const releaseTime = CFAbsoluteTimeGetCurrent() + _lingerTime;
+    for (HtHVisibleEntry* entry in _entries.allValues) { if (entry.releaseTime == 0.0) { [self lingerEntry:entry until:releaseTime]; } }
+    [self scheduleSweep];
+}
+
+- (NSArray*)samplesForIndexPath:(NSIndexPath*)indexPath
+{
+    NSArray* deviceIDs = _rowDeviceIDs[indexPath];
+    if (!deviceIDs)
+    {
+        NSMutableArray* result = [[NSMutableArray alloc] init];
+        for (RelayrDevice* device in _devicesBlock(indexPath)) { if ([device isKindOfClass:[RelayrDevice class]] && device.uid) { [result addObject:device.uid]; } }
+        deviceIDs = result;
+    }
+
+    NSMutableArray* samples = [[NSMutableArray alloc] init];
+    for (NSString* deviceID in deviceIDs) { [samples addObjectsFromArray:((HtHVisibleEntry*)_entries[deviceID]).latest.allValues]; }
+    [samples sortUsingDescriptors:@[[NSSortDescriptor sortDescriptorWithKey:@"seriesKey" ascending:YES]]];
+    return samples;
+}
+
+- (void)invalidate
+{
+    if (_invalidated) { return; }
+    _invalidated = YES;
+
+    for (HtHVisibleEntry* entry in _entries.allValues) { [[HtHReadingHub sharedHub] unsubscribe:entry.subscription]; }
+    _releasedCount += _entries.count;
+    [_entries removeAllObjects];
+    [_indexPaths removeAllObjects];
+    [_rowDeviceIDs removeAllObjects];
+    [_dirtyDeviceIDs removeAllObjects];
+}
+
+- (NSDictionary*)metrics
+{
+    return @{
+        @"visible.devices"      : @(_entries.count),
+        @"visible.subscribed"   : @(_subscribedCount),
+        @"visible.released"     : @(_releasedCount),
+        @"visible.samples"      : @(_samplesCount),
+        @"visible.updates"      : @(_updatesCount)
+    };
+}
+
+#pragma mark - Private functionality
+
+// Visible rows plus prefetchDistance rows at each side (within the same sections).
+- (NSArray*)wantedIndexPathsOfTableView:(UITableView*)tableView
+{
+    NSArray* visible = tableView.indexPathsForVisibleRows;
+    if (!visible.count) { return visible; }
+
+    NSMutableOrderedSet* result = [[NSMutableOrderedSet alloc] initWithArray:visible];
+    NSIndexPath* first = visible.firstObject;
+    NSIndexPath* last = visible.lastObject;
+    NSInteger const distance = (NSInteger)_prefetchDistance;
+
+    for (NSInteger row = MAX(first.row - distance, (NSInteger)0); row < first.row; ++row)
+    {
+        [result addObject:[NSIndexPath indexPathForRow:row inSection:first.section]];
+    }
+    NSInteger const rows = [tableView numberOfRowsInSection:last.section];
+    for (NSInteger row = last.row + 1; row < MIN(last.row + 1 + distance, rows); ++row)
+    {
+        [result addObject:[NSIndexPath indexPathForRow:row inSection:last.section]];
+    }
+    return result.array;
+}
+
+// Lingering devices are only kept for scrolling back; they give way to everything on screen.
+- (void)lingerEntry:(HtHVisibleEntry*)entry until:(CFAbsoluteTime)releaseTime
+{
+    entry.releaseTime = releaseTime;
+    entry.subscription.subscriptionClass = HtHSubscriptionClassArchive;
+}
+
+- (void)claimEntry:(HtHVisibleEntry*)entry
+{
+    entry.releaseTime = 0.0;
+    entry.subscription.subscriptionClass = HtHSubscriptionClassInteractive;
+}
+
+- (void)subscribeToDevice:(RelayrDevice*)device
+{
+    HtHVisibleEntry* entry = [[HtHVisibleEntry alloc] init];
+    entry.latest = [[NSMutableDictionary alloc] init];
+
+    __weak HtHVisibleSubscriptions* weakSelf = self;
+    entry.subscription = [[HtHReadingHub sharedHub] subscribeToDevice:device withBlock:^(HtHSample* sample, BOOL* unsubscribe) {
+        HtHVisibleSubscriptions* strongSelf = weakSelf;
+        if (!strongSelf) { *unsubscribe = YES; return; }
+        [strongSelf receiveSample:sample];
+    } error:nil];
+    if (!entry.subscription) { return; }
+
+    _entries[device.uid] = entry;
+    _subscribedCount++;
+}
+
+// The hub delivers samples on the main queue.
+- (void)receiveSample:(HtHSample*)sample
+{
+    HtHVisibleEntry* entry = _entries[sample.deviceID];
+    if (!entry || !sample.seriesKey) { return; }
+
+    _samplesCount++;
+    entry.latest[sample.seriesKey] = sample;
+    if (!_indexPaths[sample.deviceID]) { return; }
+
+    [_dirtyDeviceIDs addObject:sample.deviceID];
+    if (_updateScheduled) { return; }
+    _updateScheduled = YES;
+
+    __weak HtHVisibleSubscriptions* weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_updateInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        HtHVisibleSubscriptions* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+        strongSelf->_updateScheduled = NO;
+        [strongSelf deliverUpdates];
+    });
+}
+
+- (void)deliverUpdates
+{
+    NSSet* visible = [NSSet setWithArray:_tableView.indexPathsForVisibleRows];
+    NSMutableSet* indexPaths = [[NSMutableSet alloc] init];
+    for (NSString* deviceID in _dirtyDeviceIDs)
+    {
+        for (NSIndexPath* indexPath in _indexPaths[deviceID]) { if ([visible containsObject:indexPath]) { [indexPaths addObject:indexPath]; } }
+    }
+    [_dirtyDeviceIDs removeAllObjects];
+
+    for (NSIndexPath* indexPath in indexPaths)
+    {
+        if (_invalidated) { return; }
+        _updatesCount++;
+        _updateBlock(indexPath, [self samplesForIndexPath:indexPath]);
+    }
+}
+
+- (void)scheduleSweep
+{
+    if (_sweepScheduled || _invalidated) { return; }
+
+    CFAbsoluteTime next = DBL_MAX;
+    for (HtHVisibleEntry* entry in _entries.allValues) { if (entry.releaseTime > 0.0) { next = MIN(next, entry.releaseTime); } }
+    if (next == DBL_MAX) { return; }
+    _sweepScheduled = YES;
+
+    __weak HtHVisibleSubscriptions* weakSelf = self;
+    NSTimeInterval const delay = MAX(next - CFAbsoluteTimeGetCurrent(), 0.0);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        HtHVisibleSubscriptions* strongSelf = weakSelf;
+        if (!strongSelf) { return; }
+        strongSelf->_sweepScheduled = NO;
+        [strongSelf sweep];
+    });
+}
+
+- (void)sweep
+{
+    CFAbsoluteTime const now = CFAbsoluteTimeGetCurrent();
+    for (NSString* deviceID in _entries.allKeys)
+    {
+        HtHVisibleEntry* entry = _entries[deviceID];
+        if (entry.releaseTime == 0.0 || entry.releaseTime > now) { continue; }
+
+        [[HtHReadingHub sharedHub] unsubscribe:entry.subscription];
+        [_entries removeObjectForKey:deviceID];
+        _releasedCount++;
+    }
+    [self scheduleSweep];
+}
+
+@end
@@ -0,0 +1,24 @@
+@import Foundation;         // Apple
+#import <Relayr/Relayr.h>   // Relayr.framework
+
+// Onboarding options exported by Relayr.framework (they are declared in its private headers).
+FOUNDATION_EXPORT NSString* const kWunderbarOnboardingOptionsTransmitterWifiSSID;
+FOUNDATION_EXPORT NSString* const kWunderbarOnboardingOptionsTransmitterWifiPassword;
+
+// NSNumber (BOOL): the transmitter is put through the setup even if it was already provisioned with the same options (e.g. after a factory reset).
+FOUNDATION_EXPORT NSString* const kHtHReonboardingOptionsForceSetup;
+
+/*!
+ *  @abstract Wunderbar onboarding that remembers what was provisioned on every transmitter.
+ *  @discussion During the transmitter setup the phone is the BLE peripheral: the SDK's Wunderbar onboarding advertises the setup service and the transmitter connects and reads all of its characteristics (sensor passkeys, WiFi credentials and Wunderbar ID/security/URL). A transmitter can't be handed a subset of them, thus the setup is either skipped as a whole or run by the SDK's Wunderbar onboarding.
+ *  The WiFi credentials are validated before the transmitter is put through the setup (once UTF-8 encoded, they must fit their setup characteristics), and every successful onboarding records the transmitter's fingerprint and a salted hash of the WiFi credentials (see <code>HtHProvisioningCache</code>). When a transmitter is onboarded again with the same options, every setup characteristic would be served with the value already in place, thus the setup is skipped and the completion is called right away (unless <code>kHtHReonboardingOptionsForceSetup</code> is set).
+ *  It accepts the same options as the Wunderbar onboarding. Device onboarding is forwarded to the Wunderbar onboarding once the device beacon has been boosted (see <code>HtHDiscoveryBoost</code>); waiting for the boost takes at most the shadow's confirmation timeout and isn't counted in the onboarding timeout.
+ */
+@interface HtHWunderbarReonboarding : NSObject <RelayrOnboarding>
+
+/*!
+ *  @abstract Whether the transmitter was last onboarded (through this class) with the same devices, secrets and WiFi credentials as the options passed.
+ */
++ (BOOL)isTransmitter:(RelayrTransmitter*)transmitter provisionedWithOptions:(NSDictionary*)options;
+
+@end
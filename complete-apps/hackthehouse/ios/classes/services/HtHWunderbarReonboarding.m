@@ -0,0 +1,100 @@
+#import "HtHWunderbarReonboarding.h"    // Header
+#import "HtHProvisioningCache.h"        // HtH
+#import "HtHDiscoveryBoost.h"           // HtH
+#import <CommonCrypto/CommonDigest.h>   // Apple
+
+#define HtHWunderbar_onboardingClass        @"WunderbarOnboarding"
+#define HtHWunderbar_setupWifiSSIDLength    20  // Wunderbar_transmitter_setupCharacteristic_wifiSSID_length
+#define HtHWunderbar_setupWifiPasskeyLength 20  // Wunderbar_transmitter_setupCharacteristic_wifiPasskey_length
+
+NSString* const kHtHReonboardingOptionsForceSetup = @"io.relayr.hth.reonboarding.forceSetup";
+
+@implementation HtHWunderbarReonboarding
+
+#pragma mark - Public API
+
++ (BOOL)isTransmitter:(RelayrTransmitter*)transmitter provisionedWithOptions:(NSDictionary*)options
+{
+    NSDictionary* record = (transmitter.uid) ? [HtHProvisioningCache recordForTransmitterID:transmitter.uid] : nil;
+    if (!record || ![record[kHtHProvisioningFingerprint] isEqualToString:[HtHWunderbarReonboarding fingerprintForTransmitter:transmitter]]) { return NO; }
+
+    NSData* salt = record[kHtHProvisioningWifiSalt];
+    NSData* hash = record[kHtHProvisioningWifiHash];
+    if (![salt isKindOfClass:[NSData class]] || ![hash isKindOfClass:[NSData class]]) { return NO; }
+    return [hash isEqualToData:[HtHProvisioningCache hashForWifiSSID:options[kWunderbarOnboardingOptionsTransmitterWifiSSID] password:options[kWunderbarOnboardingOptionsTransmitterWifiPassword] salt:salt]];
+}
+
++ (void)launchOnboardingProcessForTransmitter:(RelayrTransmitter*)transmitter timeout:(NSNumber*)timeout options:(NSDictionary*)options completion:(void (^)(NSError* error))completion
+{
+    NSString* ssid = options[kWunderbarOnboardingOptionsTransmitterWifiSSID];
+    NSString* password = options[kWunderbarOnboardingOptionsTransmitterWifiPassword];
+    if (!transmitter.uid || !ssid.length || !password) { if (completion) { completion(RelayrErrorMissingArgument); } return; }
+    if (timeout && timeout.doubleValue < 0.0) { if (completion) { completion(RelayrErrorTimeoutExpired); } return; }
+
+    // The setup characteristics have a fixed length, so longer credentials can't be provisioned (cutting them could even split a UTF-8 character).
+    NSError* error = [HtHWunderbarReonboarding errorForCredential:@"WiFi SSID" value:ssid maximumLength:HtHWunderbar_setupWifiSSIDLength];
+    if (!error) { error = [HtHWunderbarReonboarding errorForCredential:@"WiFi password" value:password maximumLength:HtHWunderbar_setupWifiPasskeyLength]; }
+    if (error) { if (completion) { completion(error); } return; }
+
+    // Every setup characteristic already holds the value that would be served, so there is nothing to write.
+    if (![options[kHtHReonboardingOptionsForceSetup] boolValue] && [HtHWunderbarReonboarding isTransmitter:transmitter provisionedWithOptions:options]) { if (completion) { completion(nil); } return; }
+
+    Class <RelayrOnboarding> onboarding = NSClassFromString(HtHWunderbar_onboardingClass);
+    if (!onboarding) { if (completion) { completion(RelayrErrorSystemNotSupported); } return; }
+
+    NSData* salt = [HtHProvisioningCache newSalt];
+    NSData* hash = [HtHProvisioningCache hashForWifiSSID:ssid password:password salt:salt];
+    NSDictionary* record = (hash) ? @{ kHtHProvisioningFingerprint : [HtHWunderbarReonboarding fingerprintForTransmitter:transmitter], kHtHProvisioningWifiSalt : salt, kHtHProvisioningWifiHash : hash } : nil;
+    [onboarding launchOnboardingProcessForTransmitter:transmitter timeout:timeout options:options completion:^(NSError* error) {
+        // Without a hash, the previous record would no longer describe the transmitter.
+        if (!error && record) { [HtHProvisioningCache storeRecord:record forTransmitterID:transmitter.uid]; }
+        else if (!error) { [HtHProvisioningCache removeRecordForTransmitterID:transmitter.uid]; }
+        if (completion) { completion(error); }
+    }];
+}
+
++ (void)launchOnboardingProcessForDevice:(RelayrDevice*)device timeout:(NSNumber*)timeout options:(NSDictionary*)options completion:(void (^)(NSError* error))completion
+{
+    Class <RelayrOnboarding> onboarding = NSClassFromString(HtHWunderbar_onboardingClass);
+    if (!onboarding) { if (completion) { completion(RelayrErrorSystemNotSupported); } return; }
+    if (!device) { return [onboarding launchOnboardingProcessForDevice:device timeout:timeout options:options completion:completion]; }
+
+    // A sensor that was paired before may still be reachable through the cloud; boosting its beacon shortens the scan, which only starts once the boost is in place.
+    HtHDiscoveryBoost* boost = [HtHDiscoveryBoost sharedBoost];
+    __block id token;
+    token = [boost beginBoostForDevices:[NSSet setWithObject:device] completion:^{
+        [onboarding launchOnboardingProcessForDevice:device timeout:timeout options:options completion:^(NSError* error) {
+            [boost endBoost:token];
+            if (completion) { completion(error); }
+        }];
+    }];
+}
+
+#pragma mark - Private functionality
+
+// Everything the setup serves besides the WiFi credentials derives from the transmitter, its devices and their secrets.
++ (NSString*)fingerprintForTransmitter:(RelayrTransmitter*)transmitter
+{
+    NSMutableArray* components = [NSMutableArray arrayWithObject:[NSString stringWithFormat:@"%@:%@", transmitter.uid, transmitter.secret]];
+    for (RelayrDevice* device in transmitter.devices) { [components addObject:[NSString stringWithFormat:@"%@:%@", device.uid, device.secret]]; }
+    [components sortUsingSelector:@selector(compare:)];
+
+    NSData* data = [[components componentsJoinedByString:@"|"] dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+
+    NSMutableString* result = [NSMutableString stringWithCapacity:2 * CC_SHA256_DIGEST_LENGTH];
+    for (NSUInteger i = 0; i < CC_SHA256_DIGEST_LENGTH; ++i) { [result appendFormat:@"%02x", digest[i]]; }
+    return result;
+}
+
++ (NSError*)errorForCredential:(NSString*)name value:(NSString*)value maximumLength:(NSUInteger)maximumLength
+{
+    NSUInteger const length = [value lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    if (length <= maximumLength) { return nil; }
+
+    NSString* reason = [NSString stringWithFormat:@"The %@ takes %lu bytes in UTF-8, but the Wunderbar only accepts %lu.", name, (unsigned long)length, (unsigned long)maximumLength];
+    return [RelayrErrors errorWithCode:kRelayrErrorCodeMissingArgument localizedDescription:dRelayrErrorMessageMissingArgument failureReason:reason userInfo:RelayrErrorUserInfoLocal];
+}
+
+@end
@@ -1,5 +1,11 @@
-@import UIKit;      // Apple
+@import UIKit;              // Apple
+@class RelayrUser;          // Relayr.framework
 
 @interface IOSController : UIViewController
 
+/*!
+ *  @abstract User signed in (<code>nil</code> until the sign in finishes).
+ */
+@property (readonly,nonatomic) RelayrUser* user;
+
 @end
@@ -1,4 +1,5 @@
 #import "IOSController.h"   // Header
+#import "HtHReadingHub.h"   // HtH
 #import <Relayr/Relayr.h>   // Relayr.framework
 
 #define RelayrAppID             @"72b0e324-74bf-4e07-82a5-da53e0133a1e"
@@ -8,6 +9,7 @@
 @interface IOSController ()
 @property (weak,nonatomic) IBOutlet UILabel* currentTempLabel;
 @property (weak,nonatomic) IBOutlet UILabel* currentHumidLabel;
+@property (readwrite,nonatomic) RelayrUser* user;
 @end
 
 @implementation IOSController
@@ -27,6 +29,7 @@
         // Sign in an user into your Relayr App.
         [app signInUser:^(NSError* error, RelayrUser* user) {
             if (error) { return NSLog(@"There was an error signing the user: %@", error); }
+            self.user = user;
 
             // Retrieve the transmitters and devices owned by the user.
             [user queryCloudForIoTs:^(NSError* error) {
@@ -40,7 +43,8 @@
                 RelayrDevice* device = [transmitter devicesWithReadingMeanings:@[@"temperature"]].anyObject;
                 if (!device) { return NSLog(@"The user hasn't onboard the temperature sensor."); }
 
-                [device subscribeToAllReadingsWithBlock:^(RelayrDevice *device, RelayrReading* input, BOOL* unsubscribe) {
+                // The reading hub drops the subscription while the app is in the background (see the app delegate) and fills the gap from history on resume.
+                [[HtHReadingHub sharedHub] subscribeToDevice:device withBlock:^(HtHSample* input, BOOL* unsubscribe) {
                     if ([input.meaning isEqualToString:@"temperature"])
                     {
                         _currentTempLabel.text = [NSString stringWithFormat:@"%@ ºC", input.value];
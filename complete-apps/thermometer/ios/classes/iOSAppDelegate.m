@@ -1,4 +1,7 @@
 #import "IOSAppDelegate.h"      // Header
+#import "IOSController.h"       // Thermometer
+#import "HtHLifecycleMonitor.h" // HtH
+#import <Relayr/Relayr.h>       // Relayr.framework
 
 @interface IOSAppDelegate ()
 @end
@@ -10,4 +13,15 @@
     return YES;
 }
 
+- (void)applicationDidEnterBackground:(UIApplication*)application
+{
+    [[HtHLifecycleMonitor sharedMonitor] enterBackground];
+}
+
+- (void)applicationWillEnterForeground:(UIApplication*)application
+{
+    RelayrUser* user = ((IOSController*)self.window.rootViewController).user;
+    [[HtHLifecycleMonitor sharedMonitor] enterForegroundWithUser:user completion:nil];
+}
+
 @end